@@ -0,0 +1,81 @@
+#!/bin/bash
+
+g++ -std=c++11 -o mixing-harness \
+		src/harness/harness.cpp \
+		src/backend/core/AudioBlock.cpp \
+		src/backend/core/AudioSink.cpp \
+		src/backend/core/AudioFile.cpp \
+		src/backend/core/AudioRequest.cpp \
+		src/backend/core/RequestQueue.cpp \
+		src/backend/core/RequestList.cpp \
+		src/backend/core/receivers/AudioReceiver.cpp \
+		src/backend/core/stretch/AudioStretcher.cpp \
+		src/backend/core/stretch/AudioStretchInfo.cpp \
+		src/backend/core/stretch/AudioStretcherPool.cpp \
+		src/backend/core/stretch/RatioCurve.cpp \
+		src/backend/core/stretch/AudioStretchInfoRing.cpp \
+		src/backend/core/stretch/engines/StretchEngine.cpp \
+		src/backend/core/stretch/engines/RubberBandStretchEngine.cpp \
+		src/backend/core/stretch/engines/WSOLAStretchEngine.cpp \
+		src/backend/core/stretch/engines/VarispeedStretchEngine.cpp \
+		src/backend/core/xfade/Crossfader.cpp \
+		src/backend/core/xfade/CrossfadeCalculator.cpp \
+		src/backend/core/xfade/DJCrossfadeCalculator.cpp \
+		src/backend/core/xfade/DJCrossfadeCalculatorOld.cpp \
+		src/backend/core/xfade/CrossfadeSchedule.cpp \
+		src/backend/core/xfade/BandSplitter.cpp \
+		src/backend/core/xfade/fademaps/KneeFadeMap.cpp \
+		src/backend/core/xfade/fademaps/LinearFadeMap.cpp \
+		src/backend/core/xfade/fademaps/FadeMap.cpp \
+		src/backend/core/xfade/fademaps/FadeCurves.cpp \
+		src/backend/core/filters/Filter.cpp \
+		src/backend/core/filters/CubicInterpFilter.cpp \
+		src/backend/core/filters/TruePeakLimiter.cpp \
+		src/backend/core/filters/HoldBackQueue.cpp \
+		src/backend/core/xfade/bgfile/Beatgrid.cpp \
+		src/backend/core/xfade/bgfile/FadeSection.cpp \
+		src/backend/core/xfade/bgfile/BeatgridFileReader.cpp \
+		src/backend/core/xfade/bgfile/BeatgridCache.cpp \
+		src/backend/core/analysis/beat/OnsetStrengthEnvelope.cpp \
+		src/backend/core/analysis/beat/BeatTracker.cpp \
+		src/backend/core/analysis/beat/BeatAnalyzer.cpp \
+		src/backend/core/analysis/loudness/LoudnessMeter.cpp \
+		src/backend/core/analysis/key/KeyAnalyzer.cpp \
+		src/backend/core/analysis/key/MusicalKey.cpp \
+		src/backend/core/analysis/waveform/HarmPercProcessor.cpp \
+		src/backend/util/stft/SpectrumProcessor.cpp \
+		src/backend/util/firwindows/Window.cpp \
+		src/backend/util/firwindows/HannWindow.cpp \
+		src/backend/util/firwindows/HammingWindow.cpp \
+		src/backend/util/firwindows/BlackmanHarrisWindow.cpp \
+		src/backend/util/firwindows/KaiserWindow.cpp \
+		src/backend/util/firwindows/WindowCache.cpp \
+		src/backend/util/firfilter/FIRFilter.cpp \
+		src/backend/util/firfilter/LowPassFIRFilter.cpp \
+		src/backend/util/firfilter/HighPassFIRFilter.cpp \
+		src/backend/util/firfilter/BandPassFIRFilter.cpp \
+		src/backend/util/firfilter/FFTConvolver.cpp \
+		src/backend/util/firfilter/TruePeakDetector.cpp \
+		src/backend/util/firfilter/HalfRateDecimator.cpp \
+		src/backend/util/cqt/FrequencyList.cpp \
+		src/backend/util/cqt/ConstantQTransform.cpp \
+		src/backend/util/multiresolution/FilterBankProcessor.cpp \
+		src/backend/db/SettingsDB.cpp \
+		src/backend/db/entry/QueryEntry.cpp \
+		src/backend/db/entry/FileQueryEntry.cpp \
+		src/backend/db/entry/LoudnessQueryEntry.cpp \
+		src/backend/db/entry/KeyQueryEntry.cpp \
+		src/backend/db/intf/QueryInterface.cpp \
+		src/backend/db/intf/LoudnessQueryInterface.cpp \
+		src/backend/db/intf/KeyQueryInterface.cpp \
+		src/backend/db/intf/PreferenceQueryInterface.cpp \
+		src/backend/os/Path.cpp \
+		src/backend/os/MappedFile.cpp \
+		src/backend/program/ProgramInfo.cpp \
+		src/backend/util/AudioBufUtil.cpp \
+		src/backend/util/StrUtil.cpp \
+		src/backend/util/TaskScheduler.cpp \
+		src/backend/util/MathConstants.cpp \
+		src/backend/util/minfft.c \
+		-lsqlite3 -lrubberband -lportaudio -lavformat -lavcodec \
+		-lavutil -lavresample -lm
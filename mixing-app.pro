@@ -18,22 +18,77 @@ HEADERS += src/TheMainWindow.h \
 	src/backend/core/AudioFile.h \
 	src/backend/core/AudioRequest.h \
 	src/backend/core/RequestQueue.h \
+	src/backend/core/RequestList.h \
 	src/backend/core/stretch/AudioStretcher.h \
 	src/backend/core/stretch/AudioStretchInfo.h \
+	src/backend/core/stretch/AudioStretcherPool.h \
+	src/backend/core/stretch/RatioCurve.h \
+	src/backend/core/stretch/AudioStretchInfoRing.h \
+	src/backend/core/stretch/engines/StretchEngine.h \
+	src/backend/core/stretch/engines/RubberBandStretchEngine.h \
+	src/backend/core/stretch/engines/WSOLAStretchEngine.h \
+	src/backend/core/stretch/engines/VarispeedStretchEngine.h \
 	src/backend/core/xfade/Crossfader.h \
 	src/backend/core/xfade/CrossfadeCalculator.h \
 	src/backend/core/xfade/DJCrossfadeCalculator.h \
 	src/backend/core/xfade/DJCrossfadeCalculatorOld.h \
+	src/backend/core/xfade/CrossfadeSchedule.h \
+	src/backend/core/xfade/BandSplitter.h \
 	src/backend/core/xfade/fademaps/KneeFadeMap.h \
 	src/backend/core/xfade/fademaps/LinearFadeMap.h \
 	src/backend/core/xfade/fademaps/FadeMap.h \
+	src/backend/core/xfade/fademaps/FadeCurves.h \
+	src/backend/core/xfade/fademaps/CurveFadeMap.h \
 	src/backend/core/filters/Filter.h \
 	src/backend/core/filters/CubicInterpFilter.h \
+	src/backend/core/filters/TruePeakLimiter.h \
 	src/backend/core/filters/HoldBackQueue.h \
+	src/backend/core/xfade/bgfile/Beatgrid.h \
+	src/backend/core/xfade/bgfile/FadeSection.h \
+	src/backend/core/xfade/bgfile/BeatgridFileReader.h \
+	src/backend/core/xfade/bgfile/BeatgridCache.h \
+	src/backend/core/analysis/beat/OnsetStrengthEnvelope.h \
+	src/backend/core/analysis/beat/BeatTracker.h \
+	src/backend/core/analysis/beat/BeatAnalyzer.h \
+	src/backend/core/analysis/loudness/LoudnessMeter.h \
+	src/backend/core/analysis/key/KeyAnalyzer.h \
+	src/backend/core/analysis/key/MusicalKey.h \
+	src/backend/core/analysis/waveform/HarmPercProcessor.h \
+	src/backend/util/stft/SpectrumProcessor.h \
+	src/backend/util/firwindows/Window.h \
+	src/backend/util/firwindows/HannWindow.h \
+	src/backend/util/firwindows/HammingWindow.h \
+	src/backend/util/firwindows/BlackmanHarrisWindow.h \
+	src/backend/util/firwindows/KaiserWindow.h \
+	src/backend/util/firwindows/WindowCache.h \
+	src/backend/util/firfilter/FIRFilter.h \
+	src/backend/util/firfilter/LowPassFIRFilter.h \
+	src/backend/util/firfilter/HighPassFIRFilter.h \
+	src/backend/util/firfilter/BandPassFIRFilter.h \
+	src/backend/util/firfilter/FFTConvolver.h \
+	src/backend/util/firfilter/TruePeakDetector.h \
+	src/backend/util/firfilter/HalfRateDecimator.h \
+	src/backend/util/cqt/FrequencyList.h \
+	src/backend/util/cqt/ConstantQTransform.h \
+	src/backend/util/multiresolution/FilterBankProcessor.h \
+	src/backend/db/SettingsDB.h \
+	src/backend/db/entry/QueryEntry.h \
+	src/backend/db/entry/FileQueryEntry.h \
+	src/backend/db/entry/LoudnessQueryEntry.h \
+	src/backend/db/entry/KeyQueryEntry.h \
+	src/backend/db/intf/QueryInterface.h \
+	src/backend/db/intf/LoudnessQueryInterface.h \
+	src/backend/db/intf/KeyQueryInterface.h \
+	src/backend/db/intf/PreferenceQueryInterface.h \
 	src/backend/os/Path.h \
+	src/backend/os/MappedFile.h \
 	src/backend/program/ProgramInfo.h \
 	src/backend/util/AudioBufUtil.h \
-	src/backend/util/StrUtil.h
+	src/backend/util/StrUtil.h \
+	src/backend/util/TaskScheduler.h \
+	src/backend/util/WorkStealingPool.h \
+	src/backend/util/MathConstants.h \
+	src/backend/util/minfft.h
 FORMS += ui/mixing-app.ui
 RESOURCES = mixing-app.qrc
 SOURCES += src/main.cpp src/TheMainWindow.cpp \
@@ -42,19 +97,73 @@ SOURCES += src/main.cpp src/TheMainWindow.cpp \
 	src/backend/core/AudioFile.cpp \
 	src/backend/core/AudioRequest.cpp \
 	src/backend/core/RequestQueue.cpp \
+	src/backend/core/RequestList.cpp \
 	src/backend/core/stretch/AudioStretcher.cpp \
 	src/backend/core/stretch/AudioStretchInfo.cpp \
+	src/backend/core/stretch/AudioStretcherPool.cpp \
+	src/backend/core/stretch/RatioCurve.cpp \
+	src/backend/core/stretch/AudioStretchInfoRing.cpp \
+	src/backend/core/stretch/engines/StretchEngine.cpp \
+	src/backend/core/stretch/engines/RubberBandStretchEngine.cpp \
+	src/backend/core/stretch/engines/WSOLAStretchEngine.cpp \
+	src/backend/core/stretch/engines/VarispeedStretchEngine.cpp \
 	src/backend/core/xfade/Crossfader.cpp \
 	src/backend/core/xfade/CrossfadeCalculator.cpp \
 	src/backend/core/xfade/DJCrossfadeCalculator.cpp \
 	src/backend/core/xfade/DJCrossfadeCalculatorOld.cpp \
+	src/backend/core/xfade/CrossfadeSchedule.cpp \
+	src/backend/core/xfade/BandSplitter.cpp \
 	src/backend/core/xfade/fademaps/KneeFadeMap.cpp \
 	src/backend/core/xfade/fademaps/LinearFadeMap.cpp \
 	src/backend/core/xfade/fademaps/FadeMap.cpp \
+	src/backend/core/xfade/fademaps/FadeCurves.cpp \
 	src/backend/core/filters/Filter.cpp \
 	src/backend/core/filters/CubicInterpFilter.cpp \
+	src/backend/core/filters/TruePeakLimiter.cpp \
 	src/backend/core/filters/HoldBackQueue.cpp \
+	src/backend/core/xfade/bgfile/Beatgrid.cpp \
+	src/backend/core/xfade/bgfile/FadeSection.cpp \
+	src/backend/core/xfade/bgfile/BeatgridFileReader.cpp \
+	src/backend/core/xfade/bgfile/BeatgridCache.cpp \
+	src/backend/core/analysis/beat/OnsetStrengthEnvelope.cpp \
+	src/backend/core/analysis/beat/BeatTracker.cpp \
+	src/backend/core/analysis/beat/BeatAnalyzer.cpp \
+	src/backend/core/analysis/loudness/LoudnessMeter.cpp \
+	src/backend/core/analysis/key/KeyAnalyzer.cpp \
+	src/backend/core/analysis/key/MusicalKey.cpp \
+	src/backend/core/analysis/waveform/HarmPercProcessor.cpp \
+	src/backend/util/stft/SpectrumProcessor.cpp \
+	src/backend/util/firwindows/Window.cpp \
+	src/backend/util/firwindows/HannWindow.cpp \
+	src/backend/util/firwindows/HammingWindow.cpp \
+	src/backend/util/firwindows/BlackmanHarrisWindow.cpp \
+	src/backend/util/firwindows/KaiserWindow.cpp \
+	src/backend/util/firwindows/WindowCache.cpp \
+	src/backend/util/firfilter/FIRFilter.cpp \
+	src/backend/util/firfilter/LowPassFIRFilter.cpp \
+	src/backend/util/firfilter/HighPassFIRFilter.cpp \
+	src/backend/util/firfilter/BandPassFIRFilter.cpp \
+	src/backend/util/firfilter/FFTConvolver.cpp \
+	src/backend/util/firfilter/TruePeakDetector.cpp \
+	src/backend/util/firfilter/HalfRateDecimator.cpp \
+	src/backend/util/cqt/FrequencyList.cpp \
+	src/backend/util/cqt/ConstantQTransform.cpp \
+	src/backend/util/multiresolution/FilterBankProcessor.cpp \
+	src/backend/db/SettingsDB.cpp \
+	src/backend/db/entry/QueryEntry.cpp \
+	src/backend/db/entry/FileQueryEntry.cpp \
+	src/backend/db/entry/LoudnessQueryEntry.cpp \
+	src/backend/db/entry/KeyQueryEntry.cpp \
+	src/backend/db/intf/QueryInterface.cpp \
+	src/backend/db/intf/LoudnessQueryInterface.cpp \
+	src/backend/db/intf/KeyQueryInterface.cpp \
+	src/backend/db/intf/PreferenceQueryInterface.cpp \
 	src/backend/os/Path.cpp \
+	src/backend/os/MappedFile.cpp \
 	src/backend/program/ProgramInfo.cpp \
 	src/backend/util/AudioBufUtil.cpp \
-	src/backend/util/StrUtil.cpp
+	src/backend/util/StrUtil.cpp \
+	src/backend/util/TaskScheduler.cpp \
+	src/backend/util/WorkStealingPool.cpp \
+	src/backend/util/MathConstants.cpp \
+	src/backend/util/minfft.c
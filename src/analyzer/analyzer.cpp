@@ -0,0 +1,522 @@
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "../backend/core/AudioFile.h"
+#include "../backend/core/analysis/beat/BeatAnalyzer.h"
+#include "../backend/core/analysis/key/KeyAnalyzer.h"
+#include "../backend/core/analysis/loudness/LoudnessMeter.h"
+#include "../backend/core/xfade/bgfile/BeatgridFileReader.h"
+#include "../backend/db/SettingsDB.h"
+#include "../backend/db/intf/AnalysisQueryInterface.h"
+#include "../backend/db/intf/KeyQueryInterface.h"
+#include "../backend/db/intf/LoudnessQueryInterface.h"
+#include "../backend/os/Path.h"
+#include "../backend/util/StrUtil.h"
+#include "../backend/util/firfilter/HalfRateDecimator.h"
+#include "../backend/util/WorkStealingPool.h"
+
+// Analyzes every audio file in a directory tree and writes its beatgrid
+// file, estimates its key for harmonic mixing, and measures its loudness for
+// playback normalization.  Each file is decoded once for all three.  The
+// outcome of each analysis is recorded in the
+// settings database, so a run that is interrupted picks up where it left
+// off, and files are only analyzed again once they are modified.  Beatgrid
+// files that were edited by hand since they were last converted to the
+// binary format are converted again.
+
+typedef std::chrono::steady_clock Clock;
+
+static const char * const audioExtensions[] = {
+	"mp3", "flac", "wav", "ogg", "oga", "opus", "m4a", "aac", "wma", "aif",
+	"aiff", "ape", "wv", "mpc"
+};
+
+static bool IsAudioFile(const std::string & filename)
+{
+	bool rv = false;
+	size_t dotPos = filename.find_last_of('.');
+	if (dotPos != std::string::npos)
+	{
+		std::string ext = filename.substr(dotPos + 1);
+		std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+		for (size_t k = 0; !rv &&
+				k != sizeof(audioExtensions) / sizeof(*audioExtensions); ++k)
+		{
+			rv = ext == audioExtensions[k];
+		}
+	}
+	return rv;
+}
+
+// Files are decoded to what the player hears, which is stereo at the usual
+// rate of the sink, and their loudness is measured on that.  The beats are
+// found on a mono mix at half that rate (the rate of BeatAnalyzer), and the
+// key at a quarter of it (the rate of KeyAnalyzer).
+static const int decodeNumChannels = 2;
+static const int decodeSampleRate = 44100;
+
+static bool FileExists(const std::string & path)
+{
+	long long mtime;
+	return Path::GetModificationTime(path, mtime);
+}
+
+class BatchAnalyzer
+{
+	struct PendingFile
+	{
+		std::string m_Filename;
+		long long m_ModificationTime;
+		bool m_AnalyzeBeats;
+		bool m_DetectKey;
+		bool m_MeasureLoudness;
+	};
+
+	SettingsDB m_Db;
+	AnalysisQueryInterface m_Analyses;
+	KeyQueryInterface m_Keys;
+	LoudnessQueryInterface m_Loudnesses;
+
+	// Guards the database and the statistics below
+	std::mutex m_Mutex;
+
+	size_t m_NumQueued;
+	size_t m_NumFinished;
+	size_t m_NumFailed;
+	double m_AudioDuration;
+	double m_DecodeTime;
+	double m_OnsetTime;
+	double m_TrackingTime;
+	double m_WriteTime;
+	double m_KeyTime;
+	double m_LoudnessTime;
+
+	void RecordBeats(const std::string & filename, long long mtime,
+			BeatAnalyzer & analyzer, bool ok, double analysisTime)
+	{
+		Clock::time_point writeStart = Clock::now();
+		ok = ok && analyzer.WriteBeatgridFile(filename);
+		Clock::time_point end = Clock::now();
+		double writeTime =
+				std::chrono::duration<double>(end - writeStart).count();
+
+		AnalysisQueryEntry entry;
+		entry.setFilename(filename);
+		entry.setModificationTime(mtime);
+		entry.setStatus(ok ? AnalysisQueryEntry::STATUS_DONE :
+				AnalysisQueryEntry::STATUS_FAILED);
+		entry.setTempo(analyzer.getTempo());
+		entry.setDuration(analyzer.getDuration());
+		entry.setAnalysisTime(analysisTime + writeTime);
+
+		std::lock_guard<std::mutex> lck(m_Mutex);
+		++m_NumFinished;
+		if (!ok)
+		{
+			++m_NumFailed;
+		}
+		m_AudioDuration += analyzer.getDuration();
+		m_OnsetTime += analyzer.getOnsetTime();
+		m_TrackingTime += analyzer.getTrackingTime();
+		m_WriteTime += writeTime;
+
+		if (!m_Analyses.UpdateDbWithEntry(entry))
+		{
+			std::cerr << "Could not record the analysis of " << filename
+					<< ": " << m_Db.GetPreviousQueryError() << std::endl;
+		}
+
+		std::cout << StrUtil::format("[%zu/%zu] ", m_NumFinished, m_NumQueued);
+		if (ok)
+		{
+			std::cout << StrUtil::format("%6.2f BPM  ", analyzer.getTempo());
+		}
+		else
+		{
+			std::cout << "  FAILED    ";
+		}
+		std::cout << filename << std::endl;
+	}
+
+	void RecordKey(const std::string & filename, long long mtime,
+			const KeyAnalyzer & analyzer, bool ok)
+	{
+		std::lock_guard<std::mutex> lck(m_Mutex);
+		if (!ok)
+		{
+			std::cerr << "Could not estimate the key of " << filename
+					<< std::endl;
+		}
+		else
+		{
+			KeyQueryEntry entry;
+			entry.setFilename(filename);
+			entry.setModificationTime(mtime);
+			entry.setKey(analyzer.getKey());
+			entry.setStrength(analyzer.getStrength());
+			if (!m_Keys.UpdateDbWithEntry(entry))
+			{
+				std::cerr << "Could not record the key of " << filename
+						<< ": " << m_Db.GetPreviousQueryError() << std::endl;
+			}
+			else
+			{
+				std::cout << StrUtil::format("%3s %-9s %5.2f  ",
+						entry.getKey().GetCamelotCode().c_str(),
+						entry.getKey().GetName().c_str(),
+						entry.getStrength()) << filename << std::endl;
+			}
+		}
+	}
+
+	void RecordLoudness(const std::string & filename, long long mtime,
+			const LoudnessMeter & meter, bool ok)
+	{
+		std::lock_guard<std::mutex> lck(m_Mutex);
+		if (!ok)
+		{
+			std::cerr << "Could not measure the loudness of " << filename
+					<< std::endl;
+		}
+		else
+		{
+			LoudnessQueryEntry entry;
+			entry.setFilename(filename);
+			entry.setModificationTime(mtime);
+			entry.setIntegratedLoudness(meter.GetIntegratedLoudness());
+			entry.setLoudnessRange(meter.GetLoudnessRange());
+			entry.setTruePeak(meter.GetTruePeak());
+			entry.setDuration(meter.GetDuration());
+			if (!m_Loudnesses.UpdateDbWithEntry(entry))
+			{
+				std::cerr << "Could not record the loudness of " << filename
+						<< ": " << m_Db.GetPreviousQueryError() << std::endl;
+			}
+			else
+			{
+				std::cout << StrUtil::format(
+						"%7.2f LUFS %6.2f LU %6.2f dBTP  ",
+						entry.getIntegratedLoudness(),
+						entry.getLoudnessRange(), entry.getTruePeak())
+						<< filename << std::endl;
+			}
+		}
+	}
+
+	// Decodes the file once, and feeds the decoded audio to every analysis
+	// that the file is due for
+	void AnalyzeFile(const PendingFile & file)
+	{
+		BeatAnalyzer beatAnalyzer;
+		KeyAnalyzer keyAnalyzer;
+		LoudnessMeter meter(decodeNumChannels, decodeSampleRate);
+		HalfRateDecimator beatDecimator, keyDecimator;
+		std::vector<float> mono, beatSamples, keySamples;
+		double decodeTime = 0.0, keyTime = 0.0, loudnessTime = 0.0;
+
+		Clock::time_point analysisStart = Clock::now();
+		Clock::time_point start = analysisStart;
+		AudioFile audioFile(decodeNumChannels, decodeSampleRate);
+		audioFile.setFilename(file.m_Filename);
+		bool opened = audioFile.OpenFile();
+		decodeTime += std::chrono::duration<double>(
+				Clock::now() - start).count();
+		bool last = !opened || audioFile.isFileDone();
+		while (!last)
+		{
+			// The decimators are flushed along with the last block
+			start = Clock::now();
+			std::shared_ptr<AudioBlock> block = audioFile.getNextAudioBlock();
+			last = audioFile.isFileDone();
+			size_t count = block->getNumSamples();
+			decodeTime += std::chrono::duration<double>(
+					Clock::now() - start).count();
+
+			if (file.m_MeasureLoudness)
+			{
+				start = Clock::now();
+				const float * channels[decodeNumChannels];
+				for (int ch = 0; ch != decodeNumChannels; ++ch)
+				{
+					channels[ch] = block->getChannelData(ch);
+				}
+				meter.Process(channels, count);
+				loudnessTime += std::chrono::duration<double>(
+						Clock::now() - start).count();
+			}
+
+			if (file.m_AnalyzeBeats || file.m_DetectKey)
+			{
+				start = Clock::now();
+				mono.assign(block->getChannelData(0),
+						block->getChannelData(0) + count);
+				for (int ch = 1; ch != decodeNumChannels; ++ch)
+				{
+					const float * data = block->getChannelData(ch);
+					for (size_t k = 0; k != count; ++k)
+					{
+						mono[k] += data[k];
+					}
+				}
+				for (size_t k = 0; k != count; ++k)
+				{
+					mono[k] /= decodeNumChannels;
+				}
+				beatSamples.clear();
+				beatDecimator.ProcessBlock(mono.data(), count, beatSamples);
+				if (last)
+				{
+					beatDecimator.Finish(beatSamples);
+				}
+				keySamples.clear();
+				if (file.m_DetectKey)
+				{
+					keyDecimator.ProcessBlock(beatSamples.data(),
+							beatSamples.size(), keySamples);
+					if (last)
+					{
+						keyDecimator.Finish(keySamples);
+					}
+				}
+				decodeTime += std::chrono::duration<double>(
+						Clock::now() - start).count();
+
+				if (file.m_AnalyzeBeats)
+				{
+					beatAnalyzer.SubmitSamples(beatSamples.data(),
+							beatSamples.size());
+				}
+				if (file.m_DetectKey)
+				{
+					start = Clock::now();
+					keyAnalyzer.SubmitSamples(keySamples.data(),
+							keySamples.size());
+					keyTime += std::chrono::duration<double>(
+							Clock::now() - start).count();
+				}
+			}
+		}
+
+		if (file.m_AnalyzeBeats)
+		{
+			bool ok = false;
+			if (opened)
+			{
+				beatAnalyzer.Finish();
+				ok = !beatAnalyzer.getBeatTimes().empty();
+			}
+			RecordBeats(file.m_Filename, file.m_ModificationTime,
+					beatAnalyzer, ok, std::chrono::duration<double>(
+							Clock::now() - analysisStart).count());
+		}
+		if (file.m_DetectKey)
+		{
+			start = Clock::now();
+			if (opened)
+			{
+				keyAnalyzer.Finish();
+			}
+			keyTime += std::chrono::duration<double>(
+					Clock::now() - start).count();
+			RecordKey(file.m_Filename, file.m_ModificationTime, keyAnalyzer,
+					keyAnalyzer.getDuration() > 0.0);
+		}
+		if (file.m_MeasureLoudness)
+		{
+			RecordLoudness(file.m_Filename, file.m_ModificationTime, meter,
+					opened && meter.GetDuration() > 0.0);
+		}
+
+		std::lock_guard<std::mutex> lck(m_Mutex);
+		m_DecodeTime += decodeTime;
+		m_KeyTime += keyTime;
+		m_LoudnessTime += loudnessTime;
+	}
+
+	void PrintStage(const char * name, double time, double total)
+	{
+		std::cout << StrUtil::format("  %-10s %10.2f s  %5.1f%%", name, time,
+				total > 0.0 ? 100.0 * time / total : 0.0) << std::endl;
+	}
+public:
+	BatchAnalyzer()
+	: m_Analyses(m_Db), m_Keys(m_Db), m_Loudnesses(m_Db), m_NumQueued(0),
+	  m_NumFinished(0), m_NumFailed(0), m_AudioDuration(0.0),
+	  m_DecodeTime(0.0), m_OnsetTime(0.0), m_TrackingTime(0.0),
+	  m_WriteTime(0.0), m_KeyTime(0.0), m_LoudnessTime(0.0)
+	{
+	}
+
+	bool Open()
+	{
+		bool rv = m_Db.Open() && m_Analyses.EnsureTableExists() &&
+				m_Keys.EnsureTableExists() && m_Loudnesses.EnsureTableExists();
+		if (!rv)
+		{
+			std::cerr << "Could not open the settings database "
+					<< SettingsDB::GetDBFilename() << std::endl;
+		}
+		return rv;
+	}
+
+	bool Run(const std::string & directory, size_t numWorkers, bool force)
+	{
+		bool rv = false;
+		std::vector<std::string> files;
+		if (!Path::ListDirectory(directory, files))
+		{
+			std::cerr << "Could not read directory " << directory << std::endl;
+		}
+		else
+		{
+			files.erase(std::remove_if(files.begin(), files.end(),
+					[] (const std::string & f) { return !IsAudioFile(f); }),
+					files.end());
+			std::sort(files.begin(), files.end());
+
+			// Files that were analyzed since they were last modified are
+			// skipped, unless their beatgrid file has gone missing.  The key
+			// and the loudness are only estimated again once the file
+			// changes.
+			std::vector<PendingFile> pending;
+			size_t numBeatFiles = 0;
+			size_t numConverted = 0;
+			for (auto it = files.begin(); it != files.end(); ++it)
+			{
+				long long mtime = 0;
+				AnalysisQueryEntry entry;
+				KeyQueryEntry keyEntry;
+				LoudnessQueryEntry loudnessEntry;
+				bool known = Path::GetModificationTime(*it, mtime) && !force;
+				bool skipBeats = known && m_Analyses.GetEntry(*it, entry) &&
+					entry.getModificationTime() == mtime &&
+					(entry.getStatus() == AnalysisQueryEntry::STATUS_FAILED ||
+					 FileExists(BeatgridFileReader::GetTextFilename(*it)));
+				if (skipBeats &&
+						!BeatgridFileReader::IsBinaryFileCurrent(*it) &&
+						BeatgridFileReader::ConvertTextFile(*it))
+				{
+					++numConverted;
+				}
+				bool skipKey = known && m_Keys.GetEntry(*it, keyEntry) &&
+					keyEntry.getModificationTime() == mtime;
+				bool skipLoudness = known &&
+					m_Loudnesses.GetEntry(*it, loudnessEntry) &&
+					loudnessEntry.getModificationTime() == mtime;
+				if (!skipBeats || !skipKey || !skipLoudness)
+				{
+					PendingFile file = { *it, mtime, !skipBeats, !skipKey,
+							!skipLoudness };
+					pending.push_back(file);
+					numBeatFiles += !skipBeats;
+				}
+			}
+
+			if (numConverted != 0)
+			{
+				std::cout << "Converted " << numConverted
+						<< " edited beatgrid files" << std::endl;
+			}
+
+			Clock::time_point start = Clock::now();
+			WorkStealingPool pool(numWorkers);
+			m_NumQueued = numBeatFiles;
+			std::cout << "Analyzing " << pending.size() << " of "
+					<< files.size() << " audio files with "
+					<< pool.getNumWorkers() << " workers" << std::endl;
+
+			pool.Start();
+			for (auto it = pending.begin(); it != pending.end(); ++it)
+			{
+				PendingFile file = *it;
+				pool.Submit([this, file] { AnalyzeFile(file); });
+			}
+			pool.Wait();
+			pool.Stop();
+			double wallTime =
+					std::chrono::duration<double>(Clock::now() - start).count();
+
+			double stageTotal = m_DecodeTime + m_OnsetTime +
+					m_TrackingTime + m_WriteTime + m_KeyTime + m_LoudnessTime;
+			std::cout << std::endl << StrUtil::format(
+					"Analyzed %zu files (%zu failed) in %.1f s: "
+					"%.1f tracks/minute, %.1fx real time",
+					m_NumFinished, m_NumFailed, wallTime,
+					wallTime > 0.0 ? 60.0 * m_NumFinished / wallTime : 0.0,
+					wallTime > 0.0 ? m_AudioDuration / wallTime : 0.0)
+					<< std::endl;
+			std::cout << "Time per stage (summed over all workers):"
+					<< std::endl;
+			PrintStage("decode", m_DecodeTime, stageTotal);
+			PrintStage("onsets", m_OnsetTime, stageTotal);
+			PrintStage("tracking", m_TrackingTime, stageTotal);
+			PrintStage("write", m_WriteTime, stageTotal);
+			PrintStage("key", m_KeyTime, stageTotal);
+			PrintStage("loudness", m_LoudnessTime, stageTotal);
+
+			rv = m_NumFailed == 0;
+		}
+		return rv;
+	}
+};
+
+static void PrintUsage(const char * program)
+{
+	std::cerr << "Usage: " << program << " [-j workers] [-f] directory"
+			<< std::endl
+			<< "  -j workers  number of worker threads "
+			   "(default: one per CPU)" << std::endl
+			<< "  -f          analyze files again even if they were "
+			   "already analyzed" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+	int rv = EXIT_FAILURE;
+	size_t numWorkers = 0;
+	bool force = false;
+	std::string directory;
+	bool validArgs = true;
+
+	for (int k = 1; validArgs && k < argc; ++k)
+	{
+		if (strcmp(argv[k], "-j") == 0 && k + 1 < argc)
+		{
+			numWorkers = strtoul(argv[++k], nullptr, 10);
+		}
+		else if (strcmp(argv[k], "-f") == 0)
+		{
+			force = true;
+		}
+		else if (directory.empty() && argv[k][0] != '-')
+		{
+			directory = argv[k];
+		}
+		else
+		{
+			validArgs = false;
+		}
+	}
+
+	if (!validArgs || directory.empty())
+	{
+		PrintUsage(argv[0]);
+	}
+	else
+	{
+		AudioFile::InitializeAvformat();
+		BatchAnalyzer analyzer;
+		if (analyzer.Open() && analyzer.Run(directory, numWorkers, force))
+		{
+			rv = EXIT_SUCCESS;
+		}
+	}
+
+	return rv;
+}
@@ -53,6 +53,17 @@ public:
 		m_Samples.at(channel).at(position) = sample;
 	}
 
+	// For loops over many samples, which should not pay for bounds checks
+	float * getChannelData(int channel)
+	{
+		return m_Samples.at(channel).data();
+	}
+
+	const float * getChannelData(int channel) const
+	{
+		return m_Samples.at(channel).data();
+	}
+
 	size_t getNumSamples() const
 	{
 		return m_Samples.empty() ? 0 : m_Samples.at(0).size();
@@ -88,6 +99,18 @@ public:
 		m_Samples.at(channel).assign(data, data + count);
 	}
 
+	// Scales the samples on the way in, which costs no more than the copy
+	void setChannelData(int channel, const float * data, int count,
+			float gain)
+	{
+		std::vector<float> & samples = m_Samples.at(channel);
+		samples.resize(count);
+		for (int k = 0; k < count; ++k)
+		{
+			samples[k] = gain * data[k];
+		}
+	}
+
 	void setChannelData(int channel, const int16_t * data, int count)
 	{
 		std::vector<float> theData;
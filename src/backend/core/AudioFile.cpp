@@ -1,6 +1,8 @@
 #include "AudioFile.h"
 #include "AudioSink.h"
+#include "analysis/loudness/LoudnessMeter.h"
 #include "../os/Path.h"
+#include <cmath>
 #include <cstdint>
 #include <iostream>
 
@@ -25,7 +27,8 @@ AudioFile::AudioFile(int desiredNumChannels, int desiredSampleRate)
   m_Container(nullptr), m_StreamId(0), m_DecodedFrame(nullptr),
   m_SwrContext(nullptr), m_DestData(nullptr),
   m_DestNumChannels(desiredNumChannels), m_MaxDestNumSamples(0),
-  m_DestSampRate(desiredSampleRate), m_FileDone(false), m_DecodeDebug(false) {
+  m_DestSampRate(desiredSampleRate), m_FileDone(false), m_DecodeDebug(false),
+  m_Gain(1.0f), m_MeasureLoudness(false) {
 	m_InBuf.resize(m_AudioFileBufSize);
 }
 
@@ -177,6 +180,9 @@ bool AudioFile::OpenFile()
 		if (OpenResampler())
 		{
 			rv = true;
+			m_LoudnessMeter.reset(m_MeasureLoudness
+					? new LoudnessMeter(m_DestNumChannels, m_DestSampRate)
+					: nullptr);
 			{
 				lock_guard<mutex> lck(m_FileDoneMux);
 				m_FileDone = false;
@@ -251,6 +257,21 @@ void AudioFile::setFilename(const std::string & filename, bool loadMetadata)
 	}
 }
 
+double AudioFile::getGain() const
+{
+	return 20.0 * log10(m_Gain);
+}
+
+void AudioFile::setGain(double gain)
+{
+	m_Gain = (float) pow(10.0, gain / 20.0);
+}
+
+const LoudnessMeter * AudioFile::getLoudnessMeter() const
+{
+	return isFileDone() ? m_LoudnessMeter.get() : nullptr;
+}
+
 bool AudioFile::Decode()
 {
 	bool fileDone = false;
@@ -329,10 +350,15 @@ shared_ptr<AudioBlock> AudioFile::getNextAudioBlockAux()
 					m_Position += m_PrevDelta;
 				}
 				m_PrevDelta = timeDelta;
+				if (m_LoudnessMeter != nullptr)
+				{
+					m_LoudnessMeter->Process(
+							(const float * const *) m_DestData, destNumSamples);
+				}
 				for (int ch = 0; ch < m_DestNumChannels; ++ch)
 				{
 					newBlock->setChannelData(ch, (float *) m_DestData[ch],
-							destNumSamples);
+							destNumSamples, m_Gain);
 				}
 			}
 		}
@@ -446,6 +472,12 @@ bool AudioFile::seek(double newPosition)
 			AVCodecContext * codecContainer =
 					m_Container->streams[m_StreamId]->codec;
 			int srcSampRate = codecContainer->sample_rate;
+			// Skipping audio makes the measurement partial, so it is dropped.
+			// A seek that lands at or before the start of the file keeps it.
+			if (position < newPosition)
+			{
+				m_LoudnessMeter.reset();
+			}
 			while (position < newPosition && !Decode())
 			{
 				position += m_DecodedFrame->nb_samples / ((double) srcSampRate);
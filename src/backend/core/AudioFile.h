@@ -34,6 +34,8 @@ static inline void swr_close(SwrContext *ctx) {};
 #include <memory>
 #include <mutex>
 
+class LoudnessMeter;
+
 class AudioFile {
 	std::string m_Filename;
 
@@ -69,6 +71,14 @@ class AudioFile {
 
 	bool m_DecodeDebug;
 
+	// Linear gain applied to the decoded samples
+	float m_Gain;
+
+	// Measures the decoded samples (before the gain) while it is set.  It is
+	// dropped if part of the file is skipped.
+	bool m_MeasureLoudness;
+	std::unique_ptr<LoudnessMeter> m_LoudnessMeter;
+
 	bool OpenDecoder();
 	bool OpenResampler();
 	void LoadMetadata();
@@ -96,6 +106,19 @@ public:
 		return m_Position; }
 	double getDuration() const { return m_Duration; }
 
+	// In dB, applied as the samples are decoded
+	double getGain() const;
+	void setGain(double gain);
+
+	// Whether the loudness of the file is measured as it is decoded, which
+	// must be set before the file is opened
+	void setMeasuringLoudness(bool enable) { m_MeasureLoudness = enable; }
+
+	// The loudness of the whole file, once all of it has been decoded.  Null
+	// if it was not measured, or if it has not been decoded from start to
+	// end.
+	const LoudnessMeter * getLoudnessMeter() const;
+
 	bool isFileDone() const {
 		std::lock_guard<std::mutex> lck(m_FileDoneMux);
 		return m_FileDone; }
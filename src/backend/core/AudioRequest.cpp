@@ -1,11 +1,12 @@
 #include "AudioRequest.h"
 
+std::atomic<AudioRequest::ID> AudioRequest::m_NextID(1);
+
 AudioRequest::AudioRequest(const std::string & fileName)
-: m_FileName(fileName) {
+: m_ID(m_NextID++), m_FileName(fileName) {
 	// TODO Auto-generated constructor stub
 }
 
 AudioRequest::~AudioRequest() {
 	// TODO Auto-generated destructor stub
 }
-
@@ -1,14 +1,26 @@
 #ifndef SRC_CORE_AUDIOREQUEST_H_
 #define SRC_CORE_AUDIOREQUEST_H_
 
+#include <atomic>
 #include <string>
 
 class AudioRequest {
+public:
+	// Stable identifier of a request; never reused during the lifetime of
+	// the process, and never zero
+	typedef unsigned long long ID;
+
+private:
+	static std::atomic<ID> m_NextID;
+
+	ID m_ID;
 	std::string m_FileName;
 public:
 	AudioRequest(const std::string & fileName);
 	virtual ~AudioRequest();
 
+	ID getId() const { return m_ID; }
+
 	std::string getFilename() const { return m_FileName; }
 	void setFilename(const std::string & fileName) { m_FileName = fileName; }
 };
@@ -1,6 +1,6 @@
 #include "AudioSink.h"
 #include "filters/CubicInterpFilter.h"
-#include <cassert>
+#include "receivers/AudioReceiver.h"
 #include <chrono>
 
 /* Dry run allows us to debug the high-level code more quickly */
@@ -35,7 +35,8 @@ AudioSink::AudioSink(int sampleRate, int numChannels, int minPlaybackBufSize,
 : m_ClickRemovalFilter(new CubicInterpFilter), m_NumBlockQueueWaiters(0),
   m_SampleRate(sampleRate), m_NumChannels(numChannels),
   m_MinPlaybackBufSize(minPlaybackBufSize), m_Capacity(blockQueueCapacity),
-  m_Buffering(false), m_Stream(nullptr), m_SinkRunning(false) {
+  m_Buffering(false), m_Stream(nullptr), m_SinkRunning(false),
+  m_CaptureReceiver(nullptr) {
 }
 
 AudioSink::~AudioSink() {
@@ -64,6 +65,16 @@ void AudioSink::takeClickRemovalFilter(std::unique_ptr<Filter> && filter)
 	m_ClickRemovalFilter = std::move(filter);
 }
 
+void AudioSink::takeLimiter(std::unique_ptr<TruePeakLimiter> && limiter)
+{
+	m_Limiter = std::move(limiter);
+}
+
+size_t AudioSink::getLatency() const
+{
+	return m_Limiter != nullptr ? m_Limiter->GetLatency() : 0;
+}
+
 bool AudioSink::StartSink()
 {
 	PaError err = paStreamIsNotStopped;
@@ -77,6 +88,10 @@ bool AudioSink::StartSink()
 			if (err == paNoError)
 			{
 				m_Buffering = true;
+				if (m_Limiter != nullptr)
+				{
+					m_Limiter->Reset();
+				}
 				err = Pa_StartStream(m_Stream);
 				if (err != paNoError)
 				{
@@ -116,94 +131,86 @@ bool AudioSink::StopSink()
 	return err == paNoError;
 }
 
+bool AudioSink::StartCapture(AudioReceiver & receiver)
+{
+	bool rv = false;
+	if (m_Stream == nullptr && m_CaptureReceiver == nullptr)
+	{
+		m_CaptureReceiver = &receiver;
+		if (m_Limiter != nullptr)
+		{
+			m_Limiter->Reset();
+		}
+		rv = true;
+	}
+	return rv;
+}
+
+void AudioSink::StopCapture()
+{
+	unique_lock<mutex> lck(m_BlockQueueMutex);
+	if (m_CaptureReceiver != nullptr)
+	{
+		while (!m_HeldBackBlocks.IsEmpty())
+		{
+			OutputBlock(lck, m_HeldBackBlocks.Drain());
+		}
+		if (m_Limiter != nullptr)
+		{
+			m_CaptureReceiver->OnAudioInput(m_Limiter->Flush());
+		}
+		m_CaptureReceiver = nullptr;
+	}
+}
+
 void AudioSink::SubmitAudioBlock(const shared_ptr<AudioBlock> & block)
 {
 	// PRODUCER
 	if (block != nullptr && block->getNumSamples() != 0)
 	{
 		unique_lock<mutex> lck(m_BlockQueueMutex);
-		if (!m_HeldBackBlocks.IsEmpty())
-		{
-			int readyFlags;
-			if (m_HeldBackNextBlock)
-			{
-				m_HeldBackNextBlock->append(block);
-				readyFlags = m_ClickRemovalFilter->GetFilterReadyFlags(
-						m_HeldBackBlocks, *m_HeldBackNextBlock, 1);
-			}
-			else
-			{
-				readyFlags = m_ClickRemovalFilter->GetFilterReadyFlags(
-						m_HeldBackBlocks, *block, 1);
-			}
+		m_HeldBackBlocks.Add(block, *m_ClickRemovalFilter);
 
-			bool updateQueue = false;
-			if (readyFlags == 0)
-			{
-				assert(m_HeldBackNextBlock == nullptr);
-				m_HeldBackBlocks.Add(block);
-			}
-			else if (readyFlags == Filter::GetLeftBlockReadyFlag())
-			{
-				if (m_HeldBackNextBlock == nullptr &&
-						block->isClickRemovalSet())
-				{
-					m_HeldBackNextBlock = block;
-				}
-			}
-			else if (m_HeldBackNextBlock != nullptr)
-			{
-				assert(readyFlags == Filter::GetBothBlocksReadyFlag());
-				updateQueue = true;
-			}
-			else if (readyFlags == Filter::GetBothBlocksReadyFlag() &&
-					block->isClickRemovalSet())
-			{
-				updateQueue = true;
-				m_HeldBackNextBlock = block;
-			}
-
-			if (!updateQueue && m_HeldBackNextBlock == nullptr)
-			{
-				updateQueue =
-					m_ClickRemovalFilter->IsQueueReadyAfterQueueFetchAndAdd(
-							m_HeldBackBlocks, *block, 1);
-				m_HeldBackBlocks.Add(block);
-			}
+		// Blocks come out as they went in, once the seams that reach them
+		// have been filtered
+		std::shared_ptr<AudioBlock> oldBlk;
+		while ((oldBlk = m_HeldBackBlocks.Remove()) != nullptr)
+		{
+			OutputBlock(lck, oldBlk);
+		}
+	}
+}
 
-			if (updateQueue)
-			{
-				if (m_HeldBackNextBlock != nullptr)
-				{
-					assert(m_HeldBackNextBlock->isClickRemovalSet());
-					ApplyFilter(*m_ClickRemovalFilter,
-							m_HeldBackBlocks.CreateBlock(),
-							m_HeldBackNextBlock);
-					m_HeldBackBlocks.Add(m_HeldBackNextBlock);
-					m_HeldBackNextBlock.reset();
-				}
+void AudioSink::OutputBlock(unique_lock<mutex> & lck,
+		const shared_ptr<AudioBlock> & block)
+{
+	if (m_Limiter != nullptr)
+	{
+		m_Limiter->Process(*block);
+	}
 
-				std::shared_ptr<AudioBlock> oldBlk = m_HeldBackBlocks.Remove();
+	if (m_CaptureReceiver != nullptr)
+	{
+		m_CaptureReceiver->OnAudioInput(block);
+	}
 #ifndef DRY_RUN
-				// Wait while queue is full
-				m_NumBlockQueueWaiters++;
-				m_BlockQueueBelowCapacityCond.wait(lck,
-						[this]{ return !m_SinkRunning || m_BlockQueue.size() < m_Capacity; });
-				m_NumBlockQueueWaiters--;
-				// Add item to back of queue
-				if (m_SinkRunning)
-				{
-					m_BlockQueue.push(oldBlk);
-					m_BlockQueueWaitingForWaiters.notify_all();
-				}
-#endif
-			}
-		}
-		else
+	else
+	{
+		// Wait while queue is full
+		m_NumBlockQueueWaiters++;
+		m_BlockQueueBelowCapacityCond.wait(lck,
+				[this]{ return !m_SinkRunning || m_BlockQueue.size() < m_Capacity; });
+		m_NumBlockQueueWaiters--;
+		// Add item to back of queue
+		if (m_SinkRunning)
 		{
-			m_HeldBackBlocks.Add(block);
+			m_BlockQueue.push(block);
+			m_BlockQueueWaitingForWaiters.notify_all();
 		}
 	}
+#else
+	(void) lck;
+#endif
 }
 
 void AudioSink::DoPaCallback(float * outputBuffer,
@@ -260,6 +267,22 @@ void AudioSink::DoPaCallback(float * outputBuffer,
 	}
 }
 
+void AudioSink::TrimBlockQueue(size_t maxNumBlocks)
+{
+	lock_guard<mutex> lck(m_BlockQueueMutex);
+	if (m_BlockQueue.size() > maxNumBlocks)
+	{
+		queue<shared_ptr<AudioBlock> > keptBlocks;
+		while (keptBlocks.size() < maxNumBlocks)
+		{
+			keptBlocks.push(m_BlockQueue.front());
+			m_BlockQueue.pop();
+		}
+		m_BlockQueue.swap(keptBlocks);
+		m_BlockQueueBelowCapacityCond.notify_all();
+	}
+}
+
 void AudioSink::FlushBlockQueue()
 {
 	unique_lock<mutex> lck(m_BlockQueueMutex);
@@ -283,42 +306,3 @@ void AudioSink::FlushBlockQueue()
 	}
 	while (!done);
 }
-
-void AudioSink::ApplyFilter(Filter & filter,
-			const std::shared_ptr<AudioBlock> & block,
-			const std::shared_ptr<AudioBlock> & nextBlock)
-{
-	double timeInterval = filter.GetTimeInterval();
-	size_t numSamples = (size_t) (timeInterval * m_SampleRate);
-	size_t leftNumSamples = numSamples >> 1;
-	size_t rightNumSamples = (numSamples + 1) >> 1;
-	size_t leftBlockSize = block->getNumSamples();
-	//size_t rightBlockSize = nextBlock->getNumSamples();
-
-	for (size_t ch = 0; ch < (size_t) getNumChannels(); ++ch)
-	{
-		CubicInterpFilter * cif = dynamic_cast<CubicInterpFilter*>(&filter);
-		if (cif != nullptr && m_ClickRemovalFilter.get() == cif)
-		{
-			// Set up click removal
-			cif->Reset();
-			cif->GetLeftBlockInformation(*block, ch);
-			cif->GetRightBlockInformation(*nextBlock, ch);
-		}
-		size_t leftStart = leftBlockSize - leftNumSamples;
-		for (size_t k = leftStart; k < leftBlockSize; ++k)
-		{
-			float t = (k - leftStart) / ((double) numSamples);
-			block->setSampleAtPosition(ch, k,
-					filter.ProcessSample(
-							block->getSampleAtPosition(ch, k),
-							t));
-		}
-		for (size_t k = 0; k < rightNumSamples; ++k)
-		{
-			float t = (k + leftNumSamples) / ((double) numSamples);
-			nextBlock->setSampleAtPosition(ch, k, filter.ProcessSample(
-							nextBlock->getSampleAtPosition(ch, k), t));
-		}
-	}
-}
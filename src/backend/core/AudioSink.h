@@ -4,12 +4,15 @@
 #include "AudioBlock.h"
 #include "filters/Filter.h"
 #include "filters/HoldBackQueue.h"
+#include "filters/TruePeakLimiter.h"
 #include <memory>
 #include <mutex>
 #include <condition_variable>
 #include <queue>
 #include <portaudio.h>
 
+class AudioReceiver;
+
 class AudioSink {
 	std::mutex m_BlockQueueMutex;
 	std::queue<std::shared_ptr<AudioBlock> > m_BlockQueue;
@@ -17,9 +20,9 @@ class AudioSink {
 	std::condition_variable m_BlockQueueWaitingForWaiters;
 
 	HoldBackQueue m_HeldBackBlocks;
-	std::shared_ptr<AudioBlock> m_HeldBackNextBlock;
 	std::shared_ptr<AudioBlock> m_DequeuedBlock;
 	std::unique_ptr<Filter> m_ClickRemovalFilter;
+	std::unique_ptr<TruePeakLimiter> m_Limiter;
 
 	static const int m_DefaultSampleRate;
 	static const int m_DefaultNumChannels;
@@ -35,6 +38,7 @@ class AudioSink {
 	bool m_Buffering;
 	PaStream * m_Stream;
 	bool m_SinkRunning;
+	AudioReceiver * m_CaptureReceiver;
 
 	static int PaCallback(const void * inputBuffer, void * outputBuffer,
             unsigned long framesPerBuffer,
@@ -42,10 +46,8 @@ class AudioSink {
             PaStreamCallbackFlags statusFlags, void * userData);
 	void DoPaCallback(float * outputBuffer, unsigned long framesPerBuffer);
 	void FlushBlockQueue();
-
-	void ApplyFilter(Filter & filter,
-			const std::shared_ptr<AudioBlock> & block,
-			const std::shared_ptr<AudioBlock> & nextBlock);
+	void OutputBlock(std::unique_lock<std::mutex> & lck,
+			const std::shared_ptr<AudioBlock> & block);
 
 	// The constructor is private, since we can only have one instance of an
 	// AudioSink
@@ -61,6 +63,17 @@ public:
 	const Filter & getClickRemovalFilter() const;
 	void takeClickRemovalFilter(std::unique_ptr<Filter> && filter);
 
+	// The limiter that the blocks go through last, on their way out, or null
+	// if there is none, which costs nothing.  Mutator must not be called
+	// while blocks are being submitted.
+	TruePeakLimiter * getLimiter() { return m_Limiter.get(); }
+	void takeLimiter(std::unique_ptr<TruePeakLimiter> && limiter);
+
+	// Number of frames by which the processing in the sink delays the
+	// stream, not counting the blocks that are queued for playback, nor
+	// those held back for click removal
+	size_t getLatency() const;
+
 	// Accessor may be called at any time
 	int getSampleRate() const { return m_SampleRate; }
 	// Mutator must not be called while sink is running
@@ -87,8 +100,24 @@ public:
 	// WARNING:  This is not thread-safe!
 	bool StopSink();
 
+	// Instead of being played, blocks are handed to the given receiver as
+	// soon as they are through click removal and the limiter, without being
+	// paced in real time.  This is for rendering transitions offline.
+	// WARNING:  This is not thread-safe!
+	bool StartCapture(AudioReceiver & receiver);
+	// Hands over the blocks that are still held back for click removal (the
+	// last seam is left as it is) and what is left in the limiter, then stops
+	// capturing.
+	// WARNING:  This is not thread-safe!
+	void StopCapture();
+
 	// This IS thread safe.
 	void SubmitAudioBlock(const std::shared_ptr<AudioBlock> & block);
+
+	// Drops queued blocks that have not started playing yet, keeping at most
+	// the given number of blocks at the front of the queue.  This IS thread
+	// safe.
+	void TrimBlockQueue(size_t maxNumBlocks);
 };
 
 #endif /* SRC_CORE_AUDIOSINK_H_ */
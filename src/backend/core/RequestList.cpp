@@ -0,0 +1,327 @@
+#include "RequestList.h"
+
+using namespace std;
+
+RequestList::Node::Node(const shared_ptr<AudioRequest> & request,
+		unsigned int priority)
+: m_Request(request), m_Left(nullptr), m_Right(nullptr), m_Parent(nullptr),
+  m_Size(1), m_Priority(priority)
+{
+}
+
+RequestList::RequestList()
+: m_Root(nullptr)
+{
+}
+
+RequestList::~RequestList()
+{
+	Destroy(m_Root);
+}
+
+void RequestList::Update(Node * node)
+{
+	node->m_Size = 1 + SizeOf(node->m_Left) + SizeOf(node->m_Right);
+	if (node->m_Left != nullptr)
+	{
+		node->m_Left->m_Parent = node;
+	}
+	if (node->m_Right != nullptr)
+	{
+		node->m_Right->m_Parent = node;
+	}
+}
+
+RequestList::Node * RequestList::Merge(Node * left, Node * right)
+{
+	Node * rv;
+	if (left == nullptr)
+	{
+		rv = right;
+	}
+	else if (right == nullptr)
+	{
+		rv = left;
+	}
+	else if (left->m_Priority > right->m_Priority)
+	{
+		left->m_Right = Merge(left->m_Right, right);
+		Update(left);
+		rv = left;
+	}
+	else
+	{
+		right->m_Left = Merge(left, right->m_Left);
+		Update(right);
+		rv = right;
+	}
+	return rv;
+}
+
+void RequestList::Split(Node * node, size_t position, Node *& left,
+		Node *& right)
+{
+	if (node == nullptr)
+	{
+		left = right = nullptr;
+	}
+	else if (SizeOf(node->m_Left) < position)
+	{
+		// The node belongs to the left part
+		Split(node->m_Right, position - SizeOf(node->m_Left) - 1,
+				node->m_Right, right);
+		Update(node);
+		left = node;
+	}
+	else
+	{
+		// The node belongs to the right part
+		Split(node->m_Left, position, left, node->m_Left);
+		Update(node);
+		right = node;
+	}
+
+	if (left != nullptr)
+	{
+		left->m_Parent = nullptr;
+	}
+	if (right != nullptr)
+	{
+		right->m_Parent = nullptr;
+	}
+}
+
+void RequestList::Destroy(Node * node)
+{
+	if (node != nullptr)
+	{
+		Destroy(node->m_Left);
+		Destroy(node->m_Right);
+		delete node;
+	}
+}
+
+RequestList::Node * RequestList::NodeAt(size_t position) const
+{
+	Node * node = m_Root;
+	while (node != nullptr)
+	{
+		size_t leftSize = SizeOf(node->m_Left);
+		if (position < leftSize)
+		{
+			node = node->m_Left;
+		}
+		else if (position == leftSize)
+		{
+			break;
+		}
+		else
+		{
+			position -= leftSize + 1;
+			node = node->m_Right;
+		}
+	}
+	return node;
+}
+
+RequestList::Node * RequestList::Build(
+		const vector<shared_ptr<AudioRequest> > & requests)
+{
+	// Build a treap out of an already ordered sequence in linear time by
+	// maintaining the right spine of the tree on a stack
+	vector<Node *> rightSpine;
+	for (auto it = requests.begin(); it != requests.end(); ++it)
+	{
+		Node * node = new Node(*it, m_RandomGen());
+		m_Index[(*it)->getId()] = node;
+
+		Node * lastPopped = nullptr;
+		while (!rightSpine.empty() &&
+				rightSpine.back()->m_Priority < node->m_Priority)
+		{
+			lastPopped = rightSpine.back();
+			rightSpine.pop_back();
+		}
+		node->m_Left = lastPopped;
+		if (!rightSpine.empty())
+		{
+			rightSpine.back()->m_Right = node;
+		}
+		rightSpine.push_back(node);
+	}
+
+	Node * root = rightSpine.empty() ? nullptr : rightSpine.front();
+
+	// Fix up the subtree sizes and parent pointers in post-order
+	vector<pair<Node *, bool> > stack;
+	if (root != nullptr)
+	{
+		stack.push_back(make_pair(root, false));
+	}
+	while (!stack.empty())
+	{
+		pair<Node *, bool> & top = stack.back();
+		Node * node = top.first;
+		if (top.second)
+		{
+			Update(node);
+			stack.pop_back();
+		}
+		else
+		{
+			top.second = true;
+			if (node->m_Left != nullptr)
+			{
+				stack.push_back(make_pair(node->m_Left, false));
+			}
+			if (node->m_Right != nullptr)
+			{
+				stack.push_back(make_pair(node->m_Right, false));
+			}
+		}
+	}
+	return root;
+}
+
+void RequestList::Insert(size_t position, const shared_ptr<AudioRequest> & request)
+{
+	Node * node = new Node(request, m_RandomGen());
+	m_Index[request->getId()] = node;
+
+	Node * left, * right;
+	Split(m_Root, position, left, right);
+	m_Root = Merge(Merge(left, node), right);
+}
+
+void RequestList::InsertAll(size_t position,
+		const vector<shared_ptr<AudioRequest> > & requests)
+{
+	if (!requests.empty())
+	{
+		Node * middle = Build(requests);
+		Node * left, * right;
+		Split(m_Root, position, left, right);
+		m_Root = Merge(Merge(left, middle), right);
+	}
+}
+
+void RequestList::PushBack(const shared_ptr<AudioRequest> & request)
+{
+	Insert(size(), request);
+}
+
+void RequestList::PushFront(const shared_ptr<AudioRequest> & request)
+{
+	Insert(0, request);
+}
+
+bool RequestList::Remove(AudioRequest::ID id)
+{
+	bool rv = false;
+	size_t position = IndexOf(id);
+	if (position != string::npos)
+	{
+		Node * left, * middle, * right;
+		Split(m_Root, position, left, right);
+		Split(right, 1, middle, right);
+		m_Root = Merge(left, right);
+		m_Index.erase(id);
+		delete middle;
+		rv = true;
+	}
+	return rv;
+}
+
+void RequestList::PopFront()
+{
+	if (m_Root != nullptr)
+	{
+		Node * front, * rest;
+		Split(m_Root, 1, front, rest);
+		m_Root = rest;
+		m_Index.erase(front->m_Request->getId());
+		delete front;
+	}
+}
+
+void RequestList::Clear()
+{
+	Destroy(m_Root);
+	m_Root = nullptr;
+	m_Index.clear();
+}
+
+bool RequestList::Move(AudioRequest::ID id, size_t newPosition)
+{
+	bool rv = false;
+	size_t position = IndexOf(id);
+	if (position != string::npos)
+	{
+		Node * left, * middle, * right;
+		Split(m_Root, position, left, right);
+		Split(right, 1, middle, right);
+		Split(Merge(left, right), newPosition, left, right);
+		m_Root = Merge(Merge(left, middle), right);
+		rv = true;
+	}
+	return rv;
+}
+
+size_t RequestList::IndexOf(AudioRequest::ID id) const
+{
+	size_t rv = string::npos;
+	auto it = m_Index.find(id);
+	if (it != m_Index.end())
+	{
+		const Node * node = it->second;
+		rv = SizeOf(node->m_Left);
+		while (node->m_Parent != nullptr)
+		{
+			if (node == node->m_Parent->m_Right)
+			{
+				rv += SizeOf(node->m_Parent->m_Left) + 1;
+			}
+			node = node->m_Parent;
+		}
+	}
+	return rv;
+}
+
+shared_ptr<AudioRequest> RequestList::At(size_t position) const
+{
+	shared_ptr<AudioRequest> rv;
+	Node * node = NodeAt(position);
+	if (node != nullptr)
+	{
+		rv = node->m_Request;
+	}
+	return rv;
+}
+
+shared_ptr<AudioRequest> RequestList::Front() const
+{
+	return At(0);
+}
+
+vector<shared_ptr<AudioRequest> > RequestList::ToVector() const
+{
+	vector<shared_ptr<AudioRequest> > rv;
+	rv.reserve(size());
+
+	// In-order traversal
+	vector<Node *> stack;
+	Node * node = m_Root;
+	while (node != nullptr || !stack.empty())
+	{
+		while (node != nullptr)
+		{
+			stack.push_back(node);
+			node = node->m_Left;
+		}
+		node = stack.back();
+		stack.pop_back();
+		rv.push_back(node->m_Request);
+		node = node->m_Right;
+	}
+	return rv;
+}
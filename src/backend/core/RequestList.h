@@ -0,0 +1,94 @@
+#ifndef SRC_CORE_REQUESTLIST_H_
+#define SRC_CORE_REQUESTLIST_H_
+
+#include <cstddef>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "AudioRequest.h"
+
+// An ordered list of audio requests that supports positional insertion,
+// removal and movement in logarithmic time.  Requests are also indexed by
+// their IDs, so the position of any request can be looked up in
+// logarithmic time as well.
+//
+// Internally, this is an implicit treap (a randomized binary search tree
+// keyed by position), where each node keeps track of the size of its
+// subtree and its parent.
+class RequestList {
+	struct Node
+	{
+		std::shared_ptr<AudioRequest> m_Request;
+		Node * m_Left;
+		Node * m_Right;
+		Node * m_Parent;
+		size_t m_Size;
+		unsigned int m_Priority;
+
+		Node(const std::shared_ptr<AudioRequest> & request, unsigned int priority);
+	};
+
+	Node * m_Root;
+	std::unordered_map<AudioRequest::ID, Node *> m_Index;
+	std::minstd_rand m_RandomGen;
+
+	static size_t SizeOf(const Node * node)
+	{
+		return node == nullptr ? 0 : node->m_Size;
+	}
+
+	static void Update(Node * node);
+	static Node * Merge(Node * left, Node * right);
+	static void Split(Node * node, size_t position, Node *& left, Node *& right);
+	static void Destroy(Node * node);
+
+	Node * NodeAt(size_t position) const;
+	Node * Build(const std::vector<std::shared_ptr<AudioRequest> > & requests);
+
+	RequestList(const RequestList &) = delete;
+	RequestList & operator=(const RequestList &) = delete;
+
+public:
+	RequestList();
+	virtual ~RequestList();
+
+	size_t size() const
+	{
+		return SizeOf(m_Root);
+	}
+
+	bool empty() const
+	{
+		return m_Root == nullptr;
+	}
+
+	bool Contains(AudioRequest::ID id) const
+	{
+		return m_Index.find(id) != m_Index.end();
+	}
+
+	// Insertion (positions beyond the end of the list append to the list)
+	void Insert(size_t position, const std::shared_ptr<AudioRequest> & request);
+	void InsertAll(size_t position,
+			const std::vector<std::shared_ptr<AudioRequest> > & requests);
+	void PushBack(const std::shared_ptr<AudioRequest> & request);
+	void PushFront(const std::shared_ptr<AudioRequest> & request);
+
+	// Removal
+	bool Remove(AudioRequest::ID id);
+	void PopFront();
+	void Clear();
+
+	// Reordering
+	bool Move(AudioRequest::ID id, size_t newPosition);
+
+	// Lookup (std::string::npos is returned if the request is not present)
+	size_t IndexOf(AudioRequest::ID id) const;
+	std::shared_ptr<AudioRequest> At(size_t position) const;
+	std::shared_ptr<AudioRequest> Front() const;
+	std::vector<std::shared_ptr<AudioRequest> > ToVector() const;
+};
+
+#endif /* SRC_CORE_REQUESTLIST_H_ */
@@ -4,8 +4,16 @@
 #include "AudioFile.h"
 #include "AudioBlock.h"
 #include "AudioSink.h"
+#include "analysis/loudness/LoudnessMeter.h"
+#include "stretch/AudioStretcherPool.h"
 #include "xfade/Crossfader.h"
+#include "xfade/fademaps/CurveFadeMap.h"
 #include "xfade/fademaps/LinearFadeMap.h"
+#include "../db/SettingsDB.h"
+#include "../db/intf/LoudnessQueryInterface.h"
+#include "../db/intf/PreferenceQueryInterface.h"
+#include "../os/Path.h"
+#include <algorithm>
 #ifdef TEST_AUDIO_SINK
 #include <cmath>
 #include <cassert>
@@ -14,25 +22,77 @@
 using namespace std;
 
 const double RequestQueue::m_DefaultXfadeDuration = 5.0;
+const double RequestQueue::m_DefaultSkipXfadeDuration = 1.0;
+// The native engine is opt-in: by default it only passes unstretched tracks
+// through, and everything else goes to RubberBand
+const double RequestQueue::m_DefaultNativeStretchBand = 0.0;
+const size_t RequestQueue::m_SkipQueuedBlocks = 8;
+const size_t RequestQueue::m_NumPrewarmedStretchers = 2;
+
+// The level that the streaming services play at, in LUFS
+const double RequestQueue::m_DefaultLoudnessTarget = -14.0;
+
+// Most that a quiet track is turned up by, in dB, which keeps near-silent
+// tracks from being blown up
+const double RequestQueue::m_MaxLoudnessBoost = 12.0;
+
+// Name of the preference that holds the fade curve
+const string RequestQueue::m_FadeCurvePreference = "fade_curve";
+const string RequestQueue::m_DefaultFadeCurve = "knee";
 
 double RequestQueue::GetDefaultXfadeDuration()
 {
 	return m_DefaultXfadeDuration;
 }
 
+double RequestQueue::GetDefaultSkipXfadeDuration()
+{
+	return m_DefaultSkipXfadeDuration;
+}
+
+double RequestQueue::GetDefaultNativeStretchBand()
+{
+	return m_DefaultNativeStretchBand;
+}
+
+double RequestQueue::GetDefaultLoudnessTarget()
+{
+	return m_DefaultLoudnessTarget;
+}
+
+string RequestQueue::GetFadeCurveSetting()
+{
+	string rv = m_DefaultFadeCurve;
+	SettingsDB db;
+	PreferenceQueryInterface query(db);
+	if (db.Open() && query.EnsureTableExists())
+	{
+		// Leaves the default in place if the preference was never set
+		query.GetValue(m_FadeCurvePreference, rv);
+	}
+	return rv;
+}
+
 void RequestQueue::ProcessRequests(RequestQueue * reqQueue)
 {
 	reqQueue->DoProcessRequests();
 }
 
 RequestQueue::RequestQueue()
-: m_TerminateThread(false), m_ThreadRunning(false),
+: m_TerminateThread(false), m_ThreadRunning(false), m_Idle(false),
+  m_QueueRevision(0), m_SkipRequested(false),
   m_EnableNormalXfade(false), m_EnableDJXFade(false),
-  m_XfadeDuration(m_DefaultXfadeDuration), m_UseOptimisticTempoAdaptation(true)
+  m_XfadeDuration(m_DefaultXfadeDuration),
+  m_SkipXfadeDuration(m_DefaultSkipXfadeDuration),
+  m_NativeStretchBand(m_DefaultNativeStretchBand),
+  m_UseOptimisticTempoAdaptation(true), m_UseVarispeed(false),
+  m_UseBandSplit(false), m_NormalizeLoudness(false),
+  m_LoudnessTarget(m_DefaultLoudnessTarget)
 {
 	// TODO Auto-generated constructor stub
 	// Set default fade map to linear fade map
 	m_FadeMap.reset(new LinearFadeMap);
+	m_BandFadeMaps[BandSplitter::BAND_LOW].reset(new SwapFadeMap);
 }
 
 RequestQueue::~RequestQueue() {
@@ -60,20 +120,126 @@ void RequestQueue::TakeFadeMap(std::unique_ptr<FadeMap> && fadeMap)
 	m_FadeMap = std::move(fadeMap);
 }
 
-void RequestQueue::Play(const string & filename)
+const FadeMap * RequestQueue::GetBandFadeMap(BandSplitter::Band band) const
+{
+	return m_BandFadeMaps[band].get();
+}
+
+void RequestQueue::TakeBandFadeMap(BandSplitter::Band band,
+		std::unique_ptr<FadeMap> && fadeMap)
+{
+	m_BandFadeMaps[band] = std::move(fadeMap);
+}
+
+void RequestQueue::NotifyQueueChanged()
+{
+	// Must be called with m_ThreadMutex held
+	++m_QueueRevision;
+	m_QueueHasDataCond.notify_all();
+}
+
+AudioRequest::ID RequestQueue::Play(const string & filename)
 {
 	// Costs less (to the people) here.  Less rude.
+	shared_ptr<AudioRequest> request = make_shared<AudioRequest>(filename);
 	lock_guard<mutex> lck(m_ThreadMutex);
-	m_DEQueue.push_back(make_shared<AudioRequest>(filename));
-	m_DEQueueHasDataCond.notify_all();
+	m_Requests.PushBack(request);
+	NotifyQueueChanged();
+	return request->getId();
 }
 
-void RequestQueue::PlayNext(const string & filename)
+AudioRequest::ID RequestQueue::PlayNext(const string & filename)
 {
 	// Costs more (to the people) here.  More rude.
+	shared_ptr<AudioRequest> request = make_shared<AudioRequest>(filename);
+	lock_guard<mutex> lck(m_ThreadMutex);
+	m_Requests.PushFront(request);
+	NotifyQueueChanged();
+	return request->getId();
+}
+
+AudioRequest::ID RequestQueue::PlayAt(size_t position, const string & filename)
+{
+	shared_ptr<AudioRequest> request = make_shared<AudioRequest>(filename);
 	lock_guard<mutex> lck(m_ThreadMutex);
-	m_DEQueue.push_front(make_shared<AudioRequest>(filename));
-	m_DEQueueHasDataCond.notify_all();
+	m_Requests.Insert(position, request);
+	NotifyQueueChanged();
+	return request->getId();
+}
+
+vector<AudioRequest::ID> RequestQueue::PlayAll(const vector<string> & filenames)
+{
+	// Create the requests outside of the lock, then splice them all in at
+	// once
+	vector<shared_ptr<AudioRequest> > requests;
+	vector<AudioRequest::ID> ids;
+	requests.reserve(filenames.size());
+	ids.reserve(filenames.size());
+	for (auto it = filenames.begin(); it != filenames.end(); ++it)
+	{
+		requests.push_back(make_shared<AudioRequest>(*it));
+		ids.push_back(requests.back()->getId());
+	}
+
+	lock_guard<mutex> lck(m_ThreadMutex);
+	m_Requests.InsertAll(m_Requests.size(), requests);
+	NotifyQueueChanged();
+	return ids;
+}
+
+bool RequestQueue::Remove(AudioRequest::ID id)
+{
+	lock_guard<mutex> lck(m_ThreadMutex);
+	bool rv = m_Requests.Remove(id);
+	if (rv)
+	{
+		NotifyQueueChanged();
+	}
+	return rv;
+}
+
+bool RequestQueue::Move(AudioRequest::ID id, size_t newPosition)
+{
+	lock_guard<mutex> lck(m_ThreadMutex);
+	bool rv = m_Requests.Move(id, newPosition);
+	if (rv)
+	{
+		NotifyQueueChanged();
+	}
+	return rv;
+}
+
+void RequestQueue::Clear()
+{
+	lock_guard<mutex> lck(m_ThreadMutex);
+	m_Requests.Clear();
+	NotifyQueueChanged();
+}
+
+void RequestQueue::SkipCurrent()
+{
+	// Picked up by the request thread on its next block.  If a next track is
+	// queued up and skip crossfades are enabled, the skip quickly crossfades
+	// into that track; otherwise, the current track is simply cut off.
+	m_SkipRequested = true;
+}
+
+size_t RequestQueue::GetQueueLength() const
+{
+	lock_guard<mutex> lck(m_ThreadMutex);
+	return m_Requests.size();
+}
+
+size_t RequestQueue::GetQueuePosition(AudioRequest::ID id) const
+{
+	lock_guard<mutex> lck(m_ThreadMutex);
+	return m_Requests.IndexOf(id);
+}
+
+vector<shared_ptr<AudioRequest> > RequestQueue::GetQueueSnapshot() const
+{
+	lock_guard<mutex> lck(m_ThreadMutex);
+	return m_Requests.ToVector();
 }
 
 void RequestQueue::StartRequestProcessor()
@@ -81,6 +247,11 @@ void RequestQueue::StartRequestProcessor()
 	lock_guard<mutex> lck(m_ThreadMutex);
 	if (!m_ThreadRunning)
 	{
+		// Get the crossfade workers up and waiting before the first
+		// transition needs them
+		Crossfader::GetScheduler().Start();
+		AudioStretcherPool::Instance().Prewarm(m_NumPrewarmedStretchers);
+
 		m_ThreadRunning = true;
 		m_RequestThread.reset(new thread(ProcessRequests, this));
 	}
@@ -91,7 +262,7 @@ void RequestQueue::StopRequestProcessor()
 	{
 		lock_guard<mutex> lck(m_ThreadMutex);
 		m_TerminateThread = true;
-		m_DEQueueHasDataCond.notify_all();
+		m_QueueHasDataCond.notify_all();
 	}
 	m_RequestThread->join();
 }
@@ -105,10 +276,107 @@ void RequestQueue::StopRequestProcessorAndSink()
 	AudioSink::Instance().StopSink();
 	{
 		lock_guard<mutex> lck(m_ThreadMutex);
-		m_DEQueueHasDataCond.notify_all();
+		m_QueueHasDataCond.notify_all();
 	}
 	m_RequestThread->join();
-	m_DEQueue.clear();
+	m_Requests.Clear();
+}
+
+bool RequestQueue::OpenLoudnessDb()
+{
+	if (m_LoudnessDb == nullptr)
+	{
+		m_LoudnessDb.reset(new SettingsDB);
+		unique_ptr<LoudnessQueryInterface> query(
+				new LoudnessQueryInterface(*m_LoudnessDb));
+		if (m_LoudnessDb->Open() && query->EnsureTableExists())
+		{
+			m_LoudnessQuery = std::move(query);
+		}
+	}
+	return m_LoudnessQuery != nullptr;
+}
+
+AudioFile * RequestQueue::CreateAudioFile(
+		const shared_ptr<AudioRequest> & request)
+{
+	AudioFile * rv = new AudioFile(AudioSink::Instance().getNumChannels(),
+			AudioSink::Instance().getSampleRate());
+	rv->setFilename(request->getFilename(), true);
+	if (m_NormalizeLoudness && OpenLoudnessDb())
+	{
+		// The gain comes out of the decoder, so normalizing costs nothing at
+		// play time.  Tracks are never turned up past their true peak.
+		LoudnessQueryEntry entry;
+		long long mtime = 0;
+		if (Path::GetModificationTime(request->getFilename(), mtime) &&
+				m_LoudnessQuery->GetEntry(request->getFilename(), entry) &&
+				entry.getModificationTime() == mtime)
+		{
+			rv->setGain(std::min(std::min(
+					m_LoudnessTarget - entry.getIntegratedLoudness(),
+					-entry.getTruePeak()), m_MaxLoudnessBoost));
+		}
+		else
+		{
+			rv->setMeasuringLoudness(true);
+		}
+	}
+	return rv;
+}
+
+void RequestQueue::RecordLoudness(const AudioFile & audioFile)
+{
+	// Only files that were measured from start to end have a meter, which
+	// rules out both tracks of a DJ transition (see
+	// SetLoudnessNormalizationEnabled())
+	const LoudnessMeter * meter = audioFile.getLoudnessMeter();
+	long long mtime = 0;
+	if (meter != nullptr && OpenLoudnessDb() &&
+			Path::GetModificationTime(audioFile.getFilename(), mtime))
+	{
+		LoudnessQueryEntry entry;
+		entry.setFilename(audioFile.getFilename());
+		entry.setModificationTime(mtime);
+		entry.setIntegratedLoudness(meter->GetIntegratedLoudness());
+		entry.setLoudnessRange(meter->GetLoudnessRange());
+		entry.setTruePeak(meter->GetTruePeak());
+		entry.setDuration(meter->GetDuration());
+		m_LoudnessQuery->UpdateDbWithEntry(entry);
+	}
+}
+
+void RequestQueue::CreateCrossfader(const shared_ptr<AudioRequest> & request)
+{
+	m_NextAudioFile.reset(CreateAudioFile(request));
+	m_Crossfader.reset(new Crossfader(*m_AudioFile,
+			*m_NextAudioFile, *m_FadeMap));
+	m_Crossfader->setAllowingCrossfade(m_EnableNormalXfade);
+	m_Crossfader->setAllowingDJCrossfade(m_EnableDJXFade);
+	m_Crossfader->setCrossfadeTime(m_XfadeDuration);
+	m_Crossfader->setNativeStretchBand(m_NativeStretchBand);
+	m_Crossfader->setUsingVarispeed(m_UseVarispeed);
+	m_Crossfader->setUsingBandSplit(m_UseBandSplit);
+	for (size_t b = 0; b != BandSplitter::NUM_BANDS; ++b)
+	{
+		m_Crossfader->SetBandFadeMap((BandSplitter::Band) b,
+				m_BandFadeMaps[b].get());
+	}
+}
+
+void RequestQueue::PrepareCrossfade(const shared_ptr<AudioRequest> & request)
+{
+	CreateCrossfader(request);
+	m_Crossfader->InitializeCrossfade();
+	if (m_Crossfader->isEligible())
+	{
+		OnCrossfadePrepared(*m_Crossfader);
+	}
+	else
+	{
+		m_Crossfader.reset();
+		m_NextAudioFile.reset();
+	}
 }
 
 void RequestQueue::ProcessNextRequest()
@@ -119,25 +387,31 @@ void RequestQueue::ProcessNextRequest()
 	{
 		{
 			unique_lock<mutex> lck(m_ThreadMutex);
-			if (!m_TerminateThread && m_DEQueue.empty())
+			if (!m_TerminateThread && m_Requests.empty())
 			{
-				m_DEQueueHasNoDataCond.notify_all();
-				m_DEQueueHasDataCond.wait(lck,
-					[this] { return !m_DEQueue.empty() || m_TerminateThread; });
+				m_Idle = true;
+				m_QueueHasNoDataCond.notify_all();
+				m_QueueHasDataCond.wait(lck,
+					[this] { return !m_Requests.empty() || m_TerminateThread; });
+				m_Idle = false;
+
+				// A skip requested while idle has nothing to apply to
+				m_SkipRequested = false;
 			}
 			terminateThread = m_TerminateThread;
 			if (!terminateThread)
 			{
-				request = move(m_DEQueue.front());
-				m_DEQueue.pop_front();
+				request = m_Requests.Front();
+				m_Requests.PopFront();
 			}
 		}
 		if (!terminateThread)
 		{
-			m_AudioFile.reset(new AudioFile(
-					AudioSink::Instance().getNumChannels(),
-					AudioSink::Instance().getSampleRate()));
-			m_AudioFile->setFilename(request->getFilename(), true);
+			if (m_AudioFile != nullptr)
+			{
+				RecordLoudness(*m_AudioFile);
+			}
+			m_AudioFile.reset(CreateAudioFile(request));
 		}
 	}
 	if (!terminateThread)
@@ -177,6 +451,7 @@ void RequestQueue::ProcessNextRequest()
 			{
 				std::shared_ptr<AudioBlock> leftover;
 				m_Crossfader->WaitOnThreadsAndGiveXfadeLeftover(leftover);
+				OnCrossfadeFinished(*m_Crossfader);
 				if (leftover != nullptr)
 				{
 					leftover->setRemoveClick(removeClicks);
@@ -185,63 +460,98 @@ void RequestQueue::ProcessNextRequest()
 							leftover);
 				}
 				m_Crossfader.reset();
+				RecordLoudness(*m_AudioFile);
 				m_AudioFile.swap(m_NextAudioFile);
 				m_NextAudioFile.reset();
 			}
 
 			bool crossfadeFailed = false;
-			AudioRequest * frontRequest = nullptr;
+			shared_ptr<AudioRequest> frontRequest;
+			unsigned long seenRevision = m_QueueRevision - 1;
 			while (!terminateThread && !isCrossfading && !m_AudioFile->isFileDone())
 			{
-				std::string filename;
-
-				// Obtain next audio block
-				shared_ptr<AudioBlock> blk = m_AudioFile->getNextAudioBlock();
-				OnPositionUpdate(*m_AudioFile);
-
-				// Check crossfade conditions and do the crossfade at the
-				// right time
-
-				// LOTS OF LOCK CONTENTION HERE!
-				double backDelta = 0.0;
+				// Check whether the next track changed.  The lock is only
+				// taken when the queue has been changed since we last looked
+				// at it, and any heavy lifting happens outside of it.
+				unsigned long revision = m_QueueRevision;
+				if (revision != seenRevision)
 				{
-					unique_lock<mutex> lck(m_ThreadMutex);
-					AudioRequest * newFrontRequest = nullptr;
-					if (!m_DEQueue.empty())
+					seenRevision = revision;
+					shared_ptr<AudioRequest> newFrontRequest;
 					{
-						newFrontRequest = m_DEQueue.front().get();
+						lock_guard<mutex> lck(m_ThreadMutex);
+						newFrontRequest = m_Requests.Front();
 					}
 					if (newFrontRequest != frontRequest)
 					{
 						frontRequest = newFrontRequest;
+						m_Crossfader.reset();
+						m_NextAudioFile.reset();
+						crossfadeFailed = false;
 						if (newFrontRequest != nullptr)
 						{
-							m_NextAudioFile.reset(new AudioFile(
-									AudioSink::Instance().getNumChannels(),
-									AudioSink::Instance().getSampleRate()));
-							m_NextAudioFile->setFilename(
-									frontRequest->getFilename(), true);
-							m_Crossfader.reset(new Crossfader(*m_AudioFile,
-									*m_NextAudioFile, *m_FadeMap));
-							m_Crossfader->setAllowingCrossfade(m_EnableNormalXfade);
-							m_Crossfader->setAllowingDJCrossfade(m_EnableDJXFade);
-							m_Crossfader->setCrossfadeTime(m_XfadeDuration);
-							m_Crossfader->InitializeCrossfade();
-							crossfadeFailed = !m_Crossfader->isEligible();
-							if (crossfadeFailed)
-							{
-								m_Crossfader.reset();
-								m_NextAudioFile.reset();
-							}
+							PrepareCrossfade(newFrontRequest);
+							crossfadeFailed = m_Crossfader == nullptr;
 						}
 					}
+				}
 
-					if (m_Crossfader != nullptr)
+				if (m_SkipRequested.exchange(false))
+				{
+					// Cut down on what is already queued up for playback, so
+					// that the skip is heard right away
+					AudioSink::Instance().TrimBlockQueue(m_SkipQueuedBlocks);
+					removeClicks = true;
+					bool quickCrossfade = false;
+					if (frontRequest != nullptr && m_SkipXfadeDuration > 0.0)
 					{
-						isCrossfading = m_Crossfader->ReadyToCrossfade(backDelta);
-						if (isCrossfading)
+						// Quickly crossfade into the next track, starting
+						// from here, if both tracks last long enough
+						if (m_Crossfader == nullptr)
 						{
-							m_DEQueue.pop_front();
+							CreateCrossfader(frontRequest);
+						}
+						quickCrossfade = m_Crossfader->InitializeQuickCrossfade(
+								m_SkipXfadeDuration);
+					}
+					if (quickCrossfade)
+					{
+						OnCrossfadePrepared(*m_Crossfader);
+						crossfadeFailed = false;
+					}
+					else
+					{
+						// Abandon the current track (and any crossfade
+						// prepared for it); the front of the queue is played
+						// next
+						m_Crossfader.reset();
+						m_NextAudioFile.reset();
+						break;
+					}
+				}
+
+				// Obtain next audio block
+				shared_ptr<AudioBlock> blk = m_AudioFile->getNextAudioBlock();
+				OnPositionUpdate(*m_AudioFile);
+
+				// Do the crossfade at the right time
+				double backDelta = 0.0;
+				if (m_Crossfader != nullptr)
+				{
+					isCrossfading = m_Crossfader->ReadyToCrossfade(backDelta);
+					if (isCrossfading)
+					{
+						lock_guard<mutex> lck(m_ThreadMutex);
+						if (!m_Requests.empty() &&
+								m_Requests.Front() == frontRequest)
+						{
+							m_Requests.PopFront();
+						}
+						else
+						{
+							// The queue changed under us; pick up the new
+							// front of the queue on the next block
+							isCrossfading = false;
 						}
 					}
 				}
@@ -290,5 +600,12 @@ void RequestQueue::DoProcessRequests()
 void RequestQueue::WaitForEmptyQueue()
 {
 	unique_lock<mutex> lck(m_ThreadMutex);
-	m_DEQueueHasNoDataCond.wait(lck, [this] { return m_DEQueue.empty(); });
+	m_QueueHasNoDataCond.wait(lck, [this] { return m_Requests.empty(); });
+}
+
+void RequestQueue::WaitUntilIdle()
+{
+	unique_lock<mutex> lck(m_ThreadMutex);
+	m_QueueHasNoDataCond.wait(lck,
+			[this] { return m_Idle && m_Requests.empty(); });
 }
@@ -1,23 +1,29 @@
 #ifndef SRC_CORE_REQUESTQUEUE_H_
 #define SRC_CORE_REQUESTQUEUE_H_
 
-#include <deque>
+#include <atomic>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <condition_variable>
 #include <thread>
+#include <vector>
 #include "AudioRequest.h"
+#include "RequestList.h"
 #include "AudioSink.h"
+#include "xfade/BandSplitter.h"
 
 class AudioFile;
 class AudioBlock;
 class Crossfader;
 class FadeMap;
+class SettingsDB;
+class LoudnessQueryInterface;
 
 class RequestQueue {
-	std::condition_variable m_DEQueueHasDataCond;
-	std::condition_variable m_DEQueueHasNoDataCond;
-	std::deque<std::shared_ptr<AudioRequest> > m_DEQueue;
+	std::condition_variable m_QueueHasDataCond;
+	std::condition_variable m_QueueHasNoDataCond;
+	RequestList m_Requests;
 	std::unique_ptr<std::thread> m_RequestThread;
 	std::shared_ptr<AudioSink> m_AudioSink;
 	std::unique_ptr<AudioFile> m_AudioFile;
@@ -25,20 +31,57 @@ class RequestQueue {
 	std::unique_ptr<Crossfader> m_Crossfader;
 	std::shared_ptr<AudioBlock> m_CrossfadeLeftover;
 	std::unique_ptr<FadeMap> m_FadeMap;
+	// Null wherever the band follows the main fade map
+	std::unique_ptr<FadeMap> m_BandFadeMaps[BandSplitter::NUM_BANDS];
 
-	std::mutex m_ThreadMutex;
+	mutable std::mutex m_ThreadMutex;
 	bool m_TerminateThread;
 	bool m_ThreadRunning;
 
+	// Set while the request thread waits for requests, with nothing left to
+	// play
+	bool m_Idle;
+
+	// Bumped on every mutation of the request list, so that the request
+	// thread only needs to take the lock when the list actually changed
+	std::atomic<unsigned long> m_QueueRevision;
+	std::atomic<bool> m_SkipRequested;
+
 	static const double m_DefaultXfadeDuration;
+	static const double m_DefaultSkipXfadeDuration;
+	static const double m_DefaultNativeStretchBand;
+	static const size_t m_SkipQueuedBlocks;
+	static const size_t m_NumPrewarmedStretchers;
+	static const double m_DefaultLoudnessTarget;
+	static const double m_MaxLoudnessBoost;
+	static const std::string m_FadeCurvePreference;
+	static const std::string m_DefaultFadeCurve;
 
 	bool m_EnableNormalXfade;
 	bool m_EnableDJXFade;
 	double m_XfadeDuration;
+	double m_SkipXfadeDuration;
+	double m_NativeStretchBand;
 
 	bool m_UseOptimisticTempoAdaptation;
+	bool m_UseVarispeed;
+	bool m_UseBandSplit;
+
+	bool m_NormalizeLoudness;
+	double m_LoudnessTarget;
+
+	// Opened on first use.  The query stays null if the database cannot be
+	// opened, which leaves every track at its own level.
+	std::unique_ptr<SettingsDB> m_LoudnessDb;
+	std::unique_ptr<LoudnessQueryInterface> m_LoudnessQuery;
 
 	static void ProcessRequests(RequestQueue * reqQueue);
+	void NotifyQueueChanged();
+	bool OpenLoudnessDb();
+	AudioFile * CreateAudioFile(const std::shared_ptr<AudioRequest> & request);
+	void RecordLoudness(const AudioFile & audioFile);
+	void CreateCrossfader(const std::shared_ptr<AudioRequest> & request);
+	void PrepareCrossfade(const std::shared_ptr<AudioRequest> & request);
 	void ProcessNextRequest();
 	void DoProcessRequests();
 
@@ -81,22 +124,138 @@ public:
 		m_XfadeDuration = xfadeDuration;
 	}
 
+	static double GetDefaultSkipXfadeDuration();
+
+	double GetSkipXfadeDuration() const
+	{
+		return m_SkipXfadeDuration;
+	}
+
+	// A duration of zero makes skips cut off the current track
+	void SetSkipXfadeDuration(double skipXfadeDuration)
+	{
+		m_SkipXfadeDuration = skipXfadeDuration;
+	}
+
+	static double GetDefaultNativeStretchBand();
+
+	double GetNativeStretchBand() const
+	{
+		return m_NativeStretchBand;
+	}
+
+	// Crossfades whose time ratios all stay within this distance of unity
+	// are stretched with the native engine instead of RubberBand.  A
+	// negative band always uses RubberBand.
+	void SetNativeStretchBand(double nativeStretchBand)
+	{
+		m_NativeStretchBand = nativeStretchBand;
+	}
+
+	bool IsVarispeedEnabled() const
+	{
+		return m_UseVarispeed;
+	}
+
+	// Tempo-matches crossfades by resampling instead of time stretching
+	void SetVarispeedEnabled(bool enable)
+	{
+		m_UseVarispeed = enable;
+	}
+
+	bool IsBandSplitEnabled() const
+	{
+		return m_UseBandSplit;
+	}
+
+	// Fades the low, mid and high bands of the tracks with their own fade
+	// maps.  By default, the bass lines are swapped halfway through the
+	// crossfade, and the other bands follow the main fade map.
+	void SetBandSplitEnabled(bool enable)
+	{
+		m_UseBandSplit = enable;
+	}
+
+	bool IsLoudnessNormalizationEnabled() const
+	{
+		return m_NormalizeLoudness;
+	}
+
+	// Plays each track at the target loudness, by a gain worked out from its
+	// loudness in the settings database.  Tracks that were never measured
+	// are measured while they play, and normalized from then on, but only
+	// if they are played from start to end.  A DJ transition skips the start
+	// of the track that fades in and leaves the one that fades out before
+	// its end, so such tracks are left to the analyzer.
+	void SetLoudnessNormalizationEnabled(bool enable)
+	{
+		m_NormalizeLoudness = enable;
+	}
+
+	static double GetDefaultLoudnessTarget();
+
+	double GetLoudnessTarget() const
+	{
+		return m_LoudnessTarget;
+	}
+
+	// In LUFS
+	void SetLoudnessTarget(double loudnessTarget)
+	{
+		m_LoudnessTarget = loudnessTarget;
+	}
+
+	// Reads the fade curve that the user prefers from the settings database,
+	// in the form that FadeMap::CreateFromSetting() takes.  The knee is
+	// returned if no curve was set or the database cannot be opened.
+	static std::string GetFadeCurveSetting();
+
 	FadeMap & GetFadeMap();
 	const FadeMap & GetFadeMap() const;
 	void TakeFadeMap(std::unique_ptr<FadeMap> && fadeMap);
 
+	// Null if the band follows the main fade map
+	const FadeMap * GetBandFadeMap(BandSplitter::Band band) const;
+	// Passing null makes the band follow the main fade map
+	void TakeBandFadeMap(BandSplitter::Band band,
+			std::unique_ptr<FadeMap> && fadeMap);
+
 	void StartRequestProcessor();
 	void StopRequestProcessor();
 	void StopRequestProcessorAndSink();
 
-	void Play(const std::string & filename);
-	void PlayNext(const std::string & filename);
+	// Queue operations.  Each returns or takes the stable ID of a request,
+	// and costs logarithmic time in the length of the queue (or linear in
+	// the number of requests being added, for PlayAll).
+	AudioRequest::ID Play(const std::string & filename);
+	AudioRequest::ID PlayNext(const std::string & filename);
+	AudioRequest::ID PlayAt(size_t position, const std::string & filename);
+	std::vector<AudioRequest::ID> PlayAll(
+			const std::vector<std::string> & filenames);
+	bool Remove(AudioRequest::ID id);
+	bool Move(AudioRequest::ID id, size_t newPosition);
+	void Clear();
+	void SkipCurrent();
+
+	size_t GetQueueLength() const;
+	size_t GetQueuePosition(AudioRequest::ID id) const;
+	std::vector<std::shared_ptr<AudioRequest> > GetQueueSnapshot() const;
 
 	void WaitForEmptyQueue();
+
+	// Blocks until every queued request has been played out completely
+	void WaitUntilIdle();
+
 	virtual void OnMetadataLoaded(const AudioFile & audioFile)
 		{ (void) audioFile; }
 	virtual void OnPositionUpdate(const AudioFile & audioFile)
 		{ (void) audioFile; }
+	virtual void OnCrossfadePrepared(const Crossfader & crossfader)
+		{ (void) crossfader; }
+	// Called once all the crossfade tasks are done, just before the
+	// crossfader is destroyed
+	virtual void OnCrossfadeFinished(const Crossfader & crossfader)
+		{ (void) crossfader; }
 };
 
 #endif /* SRC_CORE_REQUESTQUEUE_H_ */
@@ -0,0 +1,187 @@
+#include "BeatAnalyzer.h"
+#include "BeatTracker.h"
+#include "OnsetStrengthEnvelope.h"
+#include "../../AudioFile.h"
+#include "../../xfade/bgfile/BeatgridFileReader.h"
+#include <chrono>
+
+typedef std::chrono::steady_clock Clock;
+
+static double SecondsSince(const Clock::time_point & start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+const int BeatAnalyzer::m_AnalysisSampleRate = 22050;
+const size_t BeatAnalyzer::m_DefaultFadeBeats = 32;
+
+BeatAnalyzer::BeatAnalyzer()
+: m_FadeBeats(m_DefaultFadeBeats), m_NumSamples(0), m_Duration(0.0),
+  m_Tempo(0.0), m_DecodeTime(0.0), m_OnsetTime(0.0), m_TrackingTime(0.0)
+{
+	Reset();
+}
+
+BeatAnalyzer::~BeatAnalyzer()
+{
+}
+
+void BeatAnalyzer::Reset()
+{
+	// The envelope cannot be reset, so it is replaced
+	m_Envelope.reset(new OnsetStrengthEnvelope(m_AnalysisSampleRate));
+	m_NumSamples = 0;
+	m_Duration = m_Tempo = 0.0;
+	m_DecodeTime = m_OnsetTime = m_TrackingTime = 0.0;
+	m_BeatTimes.clear();
+}
+
+void BeatAnalyzer::SubmitSamples(const float * samples, size_t numSamples)
+{
+	Clock::time_point start = Clock::now();
+	m_Envelope->SubmitSamples(samples, numSamples);
+	m_NumSamples += numSamples;
+	m_OnsetTime += SecondsSince(start);
+}
+
+void BeatAnalyzer::Finish()
+{
+	Clock::time_point start = Clock::now();
+	m_Envelope->Finish();
+	m_OnsetTime += SecondsSince(start);
+	m_Duration = m_NumSamples / ((double) m_AnalysisSampleRate);
+
+	start = Clock::now();
+	BeatTracker tracker(m_Envelope->GetFrameRate());
+	m_Tempo = tracker.EstimateTempo(m_Envelope->GetEnvelope());
+	std::vector<size_t> beats = tracker.TrackBeats(m_Envelope->GetEnvelope(),
+			m_Tempo);
+	m_BeatTimes.clear();
+	for (std::vector<size_t>::const_iterator it = beats.begin();
+			it != beats.end(); ++it)
+	{
+		m_BeatTimes.push_back(m_Envelope->GetFrameTime(*it));
+	}
+	m_TrackingTime = SecondsSince(start);
+}
+
+bool BeatAnalyzer::Analyze(const std::string & audioFilename)
+{
+	bool rv = false;
+
+	Reset();
+
+	// Decoding and onset detection are interleaved, so the time spent in
+	// each of them is accumulated block by block
+	Clock::time_point start = Clock::now();
+	AudioFile file(1, m_AnalysisSampleRate);
+	file.setFilename(audioFilename);
+	bool opened = file.OpenFile();
+	m_DecodeTime += SecondsSince(start);
+	if (opened)
+	{
+		while (!file.isFileDone())
+		{
+			start = Clock::now();
+			std::shared_ptr<AudioBlock> block = file.getNextAudioBlock();
+			m_DecodeTime += SecondsSince(start);
+			SubmitSamples(block->getChannelData(0), block->getNumSamples());
+		}
+		Finish();
+		rv = !m_BeatTimes.empty();
+	}
+
+	return rv;
+}
+
+bool BeatAnalyzer::BuildSection(size_t firstBeat, FadeSection & section) const
+{
+	bool rv = false;
+
+	// The section covers m_FadeBeats beats, which are delimited by
+	// m_FadeBeats + 1 beat positions
+	size_t numPoints = m_FadeBeats + 1;
+	if (m_FadeBeats != 0 && firstBeat + numPoints <= m_BeatTimes.size())
+	{
+		// Fit time = start + k * beatLength to the beat positions
+		double meanK = 0.5 * m_FadeBeats;
+		double meanTime = 0.0;
+		for (size_t k = 0; k != numPoints; ++k)
+		{
+			meanTime += m_BeatTimes[firstBeat + k];
+		}
+		meanTime /= numPoints;
+
+		double num = 0.0, denom = 0.0;
+		for (size_t k = 0; k != numPoints; ++k)
+		{
+			double dk = k - meanK;
+			num += dk * (m_BeatTimes[firstBeat + k] - meanTime);
+			denom += dk * dk;
+		}
+		double beatLength = num / denom;
+		double start = meanTime - beatLength * meanK;
+
+		if (beatLength > 0.0 && start >= 0.0)
+		{
+			double bpm = 60.0 / beatLength;
+			section.SetTime(start);
+			section.SetInstantaneousTempo(bpm);
+			section.GetBeatgrid().SetBPMBeatgrid(
+					std::vector<double>(m_FadeBeats, bpm));
+			section.GetBeatgrid().SetHasGrid(true);
+			rv = true;
+		}
+	}
+
+	return rv;
+}
+
+bool BeatAnalyzer::GetFadeSections(std::vector<FadeSection> & sections) const
+{
+	bool rv = false;
+
+	sections.clear();
+	sections.resize(2);
+	if (m_BeatTimes.size() > m_FadeBeats &&
+			BuildSection(0, sections[BeatgridFileReader::FADE_IN_SECTION]))
+	{
+		// The fade out is placed as late as possible, but it must end before
+		// the end of the track
+		FadeSection & fadeOut = sections[BeatgridFileReader::FADE_OUT_SECTION];
+		size_t lastStart = m_BeatTimes.size() - (m_FadeBeats + 1);
+		for (size_t start = lastStart + 1; !rv && start-- != 0;)
+		{
+			rv = BuildSection(start, fadeOut) && fadeOut.GetTime() +
+					fadeOut.GetBeatgrid().GetTimeOffsetAtBeat(m_FadeBeats)
+					< m_Duration;
+		}
+	}
+
+	if (!rv)
+	{
+		sections.clear();
+	}
+	return rv;
+}
+
+bool BeatAnalyzer::WriteBeatgridFile(const std::string & audioFilename) const
+{
+	bool rv = false;
+
+	std::vector<FadeSection> sections;
+	if (GetFadeSections(sections))
+	{
+		BeatgridFileReader writer;
+		writer.SetSections(std::move(sections));
+		rv = writer.WriteText(
+				BeatgridFileReader::GetTextFilename(audioFilename));
+		if (rv)
+		{
+			// Best effort; the player falls back on the text file
+			BeatgridFileReader::ConvertTextFile(audioFilename);
+		}
+	}
+
+	return rv;
+}
@@ -0,0 +1,75 @@
+#ifndef SRC_CORE_ANALYSIS_BEAT_BEATANALYZER_H_
+#define SRC_CORE_ANALYSIS_BEAT_BEATANALYZER_H_
+
+#include "../../xfade/bgfile/FadeSection.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class OnsetStrengthEnvelope;
+
+// Generates the beatgrid file of an audio file offline.  The file is decoded
+// to mono at a reduced sample rate, its beats are found with an
+// OnsetStrengthEnvelope and a BeatTracker, and fade sections are laid over
+// the first and the last beats of the track.
+//
+// Each fade section is given a constant tempo, fitted (by least squares) to
+// the beats it spans.  This keeps small errors in the beat positions from
+// turning into tempo fluctuations during a crossfade.
+class BeatAnalyzer
+{
+	static const int m_AnalysisSampleRate;
+	static const size_t m_DefaultFadeBeats;
+
+	size_t m_FadeBeats;
+	std::unique_ptr<OnsetStrengthEnvelope> m_Envelope;
+	size_t m_NumSamples;
+	double m_Duration;
+	double m_Tempo;
+	std::vector<double> m_BeatTimes;
+
+	// Wall-clock time (in seconds) spent in each stage of the last analysis
+	double m_DecodeTime;
+	double m_OnsetTime;
+	double m_TrackingTime;
+
+	bool BuildSection(size_t firstBeat, FadeSection & section) const;
+public:
+	BeatAnalyzer();
+	virtual ~BeatAnalyzer();
+
+	// Number of beats in each fade section
+	size_t getFadeBeats() const { return m_FadeBeats; }
+	void setFadeBeats(size_t fadeBeats) { m_FadeBeats = fadeBeats; }
+
+	// Forgets the samples so far
+	void Reset();
+
+	// Feeds samples at the analysis sample rate, and finds the beats of all
+	// of them so far once Finish() is called
+	void SubmitSamples(const float * samples, size_t numSamples);
+	void Finish();
+
+	// Analyzes the given audio file.  AudioFile::InitializeAvformat() must
+	// have been called beforehand.
+	bool Analyze(const std::string & audioFilename);
+
+	static int getAnalysisSampleRate() { return m_AnalysisSampleRate; }
+
+	double getDuration() const { return m_Duration; }
+	double getTempo() const { return m_Tempo; }
+	const std::vector<double> & getBeatTimes() const { return m_BeatTimes; }
+
+	double getDecodeTime() const { return m_DecodeTime; }
+	double getOnsetTime() const { return m_OnsetTime; }
+	double getTrackingTime() const { return m_TrackingTime; }
+
+	// Fade sections in the order in which they appear in beatgrid files
+	bool GetFadeSections(std::vector<FadeSection> & sections) const;
+
+	// Writes the beatgrid file of the analyzed audio file (in both the text
+	// and the binary formats)
+	bool WriteBeatgridFile(const std::string & audioFilename) const;
+};
+
+#endif /* SRC_CORE_ANALYSIS_BEAT_BEATANALYZER_H_ */
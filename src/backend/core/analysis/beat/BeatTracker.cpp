@@ -0,0 +1,223 @@
+#include "BeatTracker.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sys/types.h>
+
+const double BeatTracker::m_DefaultMinBPM = 60.0;
+const double BeatTracker::m_DefaultMaxBPM = 200.0;
+const double BeatTracker::m_DefaultPriorBPM = 120.0;
+const double BeatTracker::m_DefaultPriorWidth = 1.0;
+const double BeatTracker::m_DefaultTightness = 100.0;
+const double BeatTracker::m_TrimThreshold = 0.5;
+
+BeatTracker::BeatTracker(double frameRate)
+: m_FrameRate(frameRate), m_MinBPM(m_DefaultMinBPM),
+  m_MaxBPM(m_DefaultMaxBPM), m_PriorBPM(m_DefaultPriorBPM),
+  m_PriorWidth(m_DefaultPriorWidth), m_Tightness(m_DefaultTightness)
+{
+}
+
+BeatTracker::~BeatTracker()
+{
+}
+
+std::vector<double> BeatTracker::Normalize(const std::vector<float> & envelope)
+{
+	// Scale to unit standard deviation, so that the tightness means the same
+	// thing regardless of the loudness of the track
+	double sum = 0.0, sumSq = 0.0;
+	for (std::vector<float>::const_iterator it = envelope.begin();
+			it != envelope.end(); ++it)
+	{
+		sum += *it;
+		sumSq += *it * (double) *it;
+	}
+	double n = std::max((double) envelope.size(), 1.0);
+	double mean = sum / n;
+	double stdDev = sqrt(std::max(sumSq / n - mean * mean, 0.0));
+	double scale = stdDev > 0.0 ? 1.0 / stdDev : 0.0;
+
+	std::vector<double> normalized(envelope.size());
+	for (size_t k = 0; k != envelope.size(); ++k)
+	{
+		normalized[k] = envelope[k] * scale;
+	}
+	return normalized;
+}
+
+double BeatTracker::EstimateTempo(const std::vector<float> & envelope) const
+{
+	double bpm = 0.0;
+
+	size_t minLag = std::max((size_t) floor(60.0 * m_FrameRate / m_MaxBPM),
+			(size_t) 1);
+	size_t maxLag = (size_t) ceil(60.0 * m_FrameRate / m_MinBPM);
+	if (maxLag + 1 < envelope.size())
+	{
+		double mean = 0.0;
+		for (std::vector<float>::const_iterator it = envelope.begin();
+				it != envelope.end(); ++it)
+		{
+			mean += *it;
+		}
+		mean /= envelope.size();
+
+		std::vector<double> centered(envelope.size());
+		for (size_t k = 0; k != envelope.size(); ++k)
+		{
+			centered[k] = envelope[k] - mean;
+		}
+
+		// Weighted autocorrelation over the allowed range of lags (with one
+		// extra lag on each side for the interpolation below)
+		size_t firstLag = minLag > 1 ? minLag - 1 : minLag;
+		std::vector<double> scores(maxLag + 2);
+		size_t bestLag = 0;
+		for (size_t lag = firstLag; lag <= maxLag + 1; ++lag)
+		{
+			double acf = 0.0;
+			for (size_t k = lag; k < centered.size(); ++k)
+			{
+				acf += centered[k] * centered[k - lag];
+			}
+			double lagBPM = 60.0 * m_FrameRate / lag;
+			double octaves = log2(lagBPM / m_PriorBPM) / m_PriorWidth;
+			scores[lag] = acf * exp(-0.5 * octaves * octaves);
+			if (lag >= minLag && lag <= maxLag &&
+					(bestLag == 0 || scores[lag] > scores[bestLag]))
+			{
+				bestLag = lag;
+			}
+		}
+
+		if (bestLag != 0 && scores[bestLag] > 0.0)
+		{
+			// Refine the lag by fitting a parabola through the peak
+			double lag = bestLag;
+			if (bestLag > firstLag)
+			{
+				double left = scores[bestLag - 1];
+				double center = scores[bestLag];
+				double right = scores[bestLag + 1];
+				double denom = left - 2.0 * center + right;
+				if (denom < 0.0)
+				{
+					lag += std::min(std::max(0.5 * (left - right) / denom,
+							-0.5), 0.5);
+				}
+			}
+			bpm = 60.0 * m_FrameRate / lag;
+		}
+	}
+
+	return bpm;
+}
+
+void BeatTracker::TrimWeakBeats(const std::vector<double> & onsets,
+		std::vector<size_t> & beats) const
+{
+	// Leading and trailing beats over silence (or a fade) are dropped if the
+	// onset strength at them is weak compared to that of the typical beat
+	if (!beats.empty())
+	{
+		double sumSq = 0.0;
+		for (std::vector<size_t>::const_iterator it = beats.begin();
+				it != beats.end(); ++it)
+		{
+			sumSq += onsets[*it] * onsets[*it];
+		}
+		double threshold = m_TrimThreshold * sqrt(sumSq / beats.size());
+
+		size_t first = 0;
+		while (first < beats.size() && onsets[beats[first]] < threshold)
+		{
+			++first;
+		}
+		size_t last = beats.size();
+		while (last > first && onsets[beats[last - 1]] < threshold)
+		{
+			--last;
+		}
+		beats = std::vector<size_t>(beats.begin() + first,
+				beats.begin() + last);
+	}
+}
+
+std::vector<size_t> BeatTracker::TrackBeats(
+		const std::vector<float> & envelope, double bpm) const
+{
+	std::vector<size_t> beats;
+
+	double period = bpm > 0.0 ? 60.0 * m_FrameRate / bpm : 0.0;
+	if (period >= 2.0 && envelope.size() > 2.0 * period)
+	{
+		std::vector<double> onsets = Normalize(envelope);
+
+		// The predecessor of a beat is searched for between half a period
+		// and two periods back, with a penalty depending on how far the
+		// interval is from the period (on a log scale)
+		size_t minOffset = std::max((size_t) round(0.5 * period), (size_t) 1);
+		size_t maxOffset = (size_t) round(2.0 * period);
+		std::vector<double> penalties(maxOffset + 1);
+		for (size_t offset = minOffset; offset <= maxOffset; ++offset)
+		{
+			double logRatio = log(offset / period);
+			penalties[offset] = m_Tightness * logRatio * logRatio;
+		}
+
+		const ssize_t noPredecessor = -1;
+		std::vector<double> cumScores(onsets.size());
+		std::vector<ssize_t> predecessors(onsets.size(), noPredecessor);
+		for (size_t t = 0; t != onsets.size(); ++t)
+		{
+			double bestScore = -std::numeric_limits<double>::infinity();
+			ssize_t bestPredecessor = noPredecessor;
+			for (size_t offset = minOffset; offset <= maxOffset && offset <= t;
+					++offset)
+			{
+				double score = cumScores[t - offset] - penalties[offset];
+				if (score > bestScore)
+				{
+					bestScore = score;
+					bestPredecessor = (ssize_t) (t - offset);
+				}
+			}
+
+			// Starting a new sequence of beats is better than continuing one
+			// that is penalized more than it is worth
+			if (bestPredecessor != noPredecessor && bestScore > 0.0)
+			{
+				cumScores[t] = onsets[t] + bestScore;
+				predecessors[t] = bestPredecessor;
+			}
+			else
+			{
+				cumScores[t] = onsets[t];
+			}
+		}
+
+		// The last beat is the best-scoring frame within the last period
+		size_t lastBeat = onsets.size() - 1;
+		size_t searchStart = onsets.size() - std::min(onsets.size(),
+				(size_t) ceil(period));
+		for (size_t t = searchStart; t != onsets.size(); ++t)
+		{
+			if (cumScores[t] > cumScores[lastBeat])
+			{
+				lastBeat = t;
+			}
+		}
+
+		for (ssize_t t = (ssize_t) lastBeat; t != noPredecessor;
+				t = predecessors[t])
+		{
+			beats.push_back((size_t) t);
+		}
+		std::reverse(beats.begin(), beats.end());
+
+		TrimWeakBeats(onsets, beats);
+	}
+
+	return beats;
+}
@@ -0,0 +1,66 @@
+#ifndef SRC_CORE_ANALYSIS_BEAT_BEATTRACKER_H_
+#define SRC_CORE_ANALYSIS_BEAT_BEATTRACKER_H_
+
+#include <vector>
+#include <cstddef>
+
+// Estimates the tempo of an onset strength envelope and finds the beats in
+// it.
+//
+// The tempo is taken from the peak of the autocorrelation of the envelope,
+// weighted by a log-Gaussian preference for tempos near m_PriorBPM (this
+// makes the choice between a tempo and its double or half less arbitrary).
+//
+// The beats are then tracked by dynamic programming (D. Ellis, "Beat
+// Tracking by Dynamic Programming", 2007):  the best sequence of beats is the
+// one that maximizes the onset strength at the beats minus a penalty for
+// intervals between consecutive beats that stray from the beat period.
+class BeatTracker
+{
+	static const double m_DefaultMinBPM;
+	static const double m_DefaultMaxBPM;
+	static const double m_DefaultPriorBPM;
+	static const double m_DefaultPriorWidth;
+	static const double m_DefaultTightness;
+	static const double m_TrimThreshold;
+
+	double m_FrameRate;
+	double m_MinBPM;
+	double m_MaxBPM;
+	double m_PriorBPM;
+	double m_PriorWidth;
+	double m_Tightness;
+
+	static std::vector<double> Normalize(const std::vector<float> & envelope);
+	void TrimWeakBeats(const std::vector<double> & onsets,
+			std::vector<size_t> & beats) const;
+public:
+	BeatTracker(double frameRate);
+	virtual ~BeatTracker();
+
+	double getMinBPM() const { return m_MinBPM; }
+	void setMinBPM(double minBPM) { m_MinBPM = minBPM; }
+
+	double getMaxBPM() const { return m_MaxBPM; }
+	void setMaxBPM(double maxBPM) { m_MaxBPM = maxBPM; }
+
+	double getPriorBPM() const { return m_PriorBPM; }
+	void setPriorBPM(double priorBPM) { m_PriorBPM = priorBPM; }
+
+	// Width of the tempo preference, in octaves
+	double getPriorWidth() const { return m_PriorWidth; }
+	void setPriorWidth(double priorWidth) { m_PriorWidth = priorWidth; }
+
+	// How strongly the beat intervals are held to the beat period
+	double getTightness() const { return m_Tightness; }
+	void setTightness(double tightness) { m_Tightness = tightness; }
+
+	// Returns the estimated tempo in BPM, or zero if there is none
+	double EstimateTempo(const std::vector<float> & envelope) const;
+
+	// Returns the envelope frames at which the beats occur
+	std::vector<size_t> TrackBeats(const std::vector<float> & envelope,
+			double bpm) const;
+};
+
+#endif /* SRC_CORE_ANALYSIS_BEAT_BEATTRACKER_H_ */
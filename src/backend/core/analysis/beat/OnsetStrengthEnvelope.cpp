@@ -0,0 +1,104 @@
+#include "OnsetStrengthEnvelope.h"
+#include "../../../util/firwindows/HannWindow.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const size_t OnsetStrengthEnvelope::m_DefaultFFTSize = 1024;
+const size_t OnsetStrengthEnvelope::m_DefaultHopSize = 128;
+const size_t OnsetStrengthEnvelope::m_DefaultMedianFilterSize = 17;
+const float OnsetStrengthEnvelope::m_LogCompression = 100.0f;
+
+OnsetStrengthEnvelope::OnsetStrengthEnvelope(int sampleRate, size_t fftSize,
+		size_t hopSize, size_t medFilterSize)
+: m_SampleRate(sampleRate), m_FFTSize(fftSize), m_HopSize(hopSize),
+  m_HarmPercProcessor(fftSize, medFilterSize), m_FramePos(0),
+  m_NumFramesSubmitted(0)
+{
+	m_FFTData.resize(m_FFTSize);
+	m_FFTCache.resize(plan_cache_size(m_FFTSize));
+	setup_plan(&m_FFTPlan, m_FFTData.data(), m_FFTCache.data(), m_FFTSize);
+	m_Spectrum.resize(m_FFTSize);
+	HannWindow(m_FFTSize).AssignWindow(m_Window);
+	m_Frame.resize(m_FFTSize);
+	m_PrevLogMagnitudes.resize(SpectrumProcessor::GetNumMagnitudes(m_FFTSize));
+}
+
+OnsetStrengthEnvelope::~OnsetStrengthEnvelope()
+{
+}
+
+void OnsetStrengthEnvelope::ProcessSpectrum()
+{
+	// The percussive output lags the input by the median filter delay, so
+	// nothing comes out of the first few frames
+	m_HarmPercProcessor.Process(m_Spectrum);
+	if (m_NumFramesSubmitted++ >= m_HarmPercProcessor.GetProcessDelayPerStep())
+	{
+		// The magnitudes are normalized by the frame size so that the log
+		// compression behaves the same for any frame size
+		const std::vector<float> & percussive =
+				m_HarmPercProcessor.GetOutputSpectrum(1);
+		float scale = 2.0f / m_FFTSize;
+		float flux = 0.0f;
+		for (size_t k = 0; k != m_PrevLogMagnitudes.size(); ++k)
+		{
+			float mag = sqrtf(SpectrumProcessor::GetMagnitudeSquared(
+					percussive, k)) * scale;
+			float logMag = logf(1.0f + m_LogCompression * mag);
+			flux += std::max(0.0f, logMag - m_PrevLogMagnitudes[k]);
+			m_PrevLogMagnitudes[k] = logMag;
+		}
+		m_Envelope.push_back(m_Envelope.empty() ? 0.0f : flux);
+	}
+}
+
+void OnsetStrengthEnvelope::ProcessFrame()
+{
+	for (size_t k = 0; k != m_FFTSize; ++k)
+	{
+		m_FFTData[k] = m_Frame[k] * m_Window[k];
+	}
+	r2hc(&m_FFTPlan);
+	const float * spectrum = plan_samples(&m_FFTPlan);
+	m_Spectrum.assign(spectrum, spectrum + m_FFTSize);
+	ProcessSpectrum();
+}
+
+void OnsetStrengthEnvelope::SubmitSamples(const float * samples,
+		size_t numSamples)
+{
+	while (numSamples != 0)
+	{
+		size_t count = std::min(numSamples, m_FFTSize - m_FramePos);
+		memcpy(m_Frame.data() + m_FramePos, samples, count * sizeof(float));
+		m_FramePos += count;
+		samples += count;
+		numSamples -= count;
+
+		if (m_FramePos == m_FFTSize)
+		{
+			ProcessFrame();
+			memmove(m_Frame.data(), m_Frame.data() + m_HopSize,
+					(m_FFTSize - m_HopSize) * sizeof(float));
+			m_FramePos = m_FFTSize - m_HopSize;
+		}
+	}
+}
+
+void OnsetStrengthEnvelope::Finish()
+{
+	// Push out the partial frame, and then push silent frames through the
+	// median filters until the last real frame comes out
+	if (m_FramePos > m_FFTSize - m_HopSize)
+	{
+		std::fill(m_Frame.begin() + m_FramePos, m_Frame.end(), 0.0f);
+		ProcessFrame();
+	}
+	std::fill(m_Spectrum.begin(), m_Spectrum.end(), 0.0f);
+	for (size_t k = 0; k != m_HarmPercProcessor.GetProcessDelayPerStep(); ++k)
+	{
+		ProcessSpectrum();
+	}
+	m_FramePos = 0;
+}
@@ -0,0 +1,73 @@
+#ifndef SRC_CORE_ANALYSIS_BEAT_ONSETSTRENGTHENVELOPE_H_
+#define SRC_CORE_ANALYSIS_BEAT_ONSETSTRENGTHENVELOPE_H_
+
+#include "../waveform/HarmPercProcessor.h"
+#include "../../../util/minfft.h"
+#include <vector>
+
+// Computes an onset strength envelope from a mono signal.  The signal is
+// split into overlapping frames, the percussive part of each frame's
+// spectrum is extracted with a HarmPercProcessor (so that sustained notes do
+// not register as onsets), and the envelope is the half-wave rectified
+// difference between the log-compressed magnitudes of consecutive frames
+// (i.e., the spectral flux).
+class OnsetStrengthEnvelope
+{
+	static const size_t m_DefaultFFTSize;
+	static const size_t m_DefaultHopSize;
+	static const size_t m_DefaultMedianFilterSize;
+	static const float m_LogCompression;
+
+	int m_SampleRate;
+	size_t m_FFTSize;
+	size_t m_HopSize;
+
+	HarmPercProcessor m_HarmPercProcessor;
+	fft_plan_t m_FFTPlan;
+	std::vector<float> m_FFTData;
+	std::vector<float> m_FFTCache;
+	std::vector<float> m_Spectrum;
+	std::vector<float> m_Window;
+	std::vector<float> m_Frame;
+	size_t m_FramePos;
+	size_t m_NumFramesSubmitted;
+
+	std::vector<float> m_PrevLogMagnitudes;
+	std::vector<float> m_Envelope;
+
+	void ProcessSpectrum();
+	void ProcessFrame();
+
+	OnsetStrengthEnvelope(const OnsetStrengthEnvelope &) = delete;
+	OnsetStrengthEnvelope & operator=(const OnsetStrengthEnvelope &) = delete;
+public:
+	OnsetStrengthEnvelope(int sampleRate, size_t fftSize = m_DefaultFFTSize,
+			size_t hopSize = m_DefaultHopSize,
+			size_t medFilterSize = m_DefaultMedianFilterSize);
+	virtual ~OnsetStrengthEnvelope();
+
+	void SubmitSamples(const float * samples, size_t numSamples);
+
+	// Flushes the frames that are still held back by the median filters.
+	// No more samples may be submitted afterwards.
+	void Finish();
+
+	const std::vector<float> & GetEnvelope() const
+	{
+		return m_Envelope;
+	}
+
+	// Number of envelope values per second
+	double GetFrameRate() const
+	{
+		return m_SampleRate / ((double) m_HopSize);
+	}
+
+	// Time (in seconds) at the center of the frame of the given envelope value
+	double GetFrameTime(double frame) const
+	{
+		return (frame * m_HopSize + 0.5 * m_FFTSize) / m_SampleRate;
+	}
+};
+
+#endif /* SRC_CORE_ANALYSIS_BEAT_ONSETSTRENGTHENVELOPE_H_ */
@@ -0,0 +1,205 @@
+#include "KeyAnalyzer.h"
+#include "../../AudioFile.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+typedef std::chrono::steady_clock Clock;
+
+static double SecondsSince(const Clock::time_point & start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Enough for the five octaves above A1, which hold the bass lines and most
+// of the harmony, and low enough that decoding and transforming is cheap
+const int KeyAnalyzer::m_AnalysisSampleRate = 11025;
+
+// Three bins per semitone, starting a third of a semitone below A1, so that
+// each semitone is centered on its middle bin and slightly detuned
+// recordings still fall within it
+const size_t KeyAnalyzer::m_BinsPerSemitone = 3;
+const size_t KeyAnalyzer::m_NumOctaves = 5;
+const float KeyAnalyzer::m_LowestPitch = 53.951155f;
+
+// About a third of a second
+const size_t KeyAnalyzer::m_HopSize = 4096;
+
+// Krumhansl and Kessler's probe-tone ratings of each pitch class in C major
+// and C minor
+const double KeyAnalyzer::m_MajorProfile[12] = {
+	6.35, 2.23, 3.48, 2.33, 4.38, 4.09, 2.52, 5.19, 2.39, 3.66, 2.29, 2.88
+};
+const double KeyAnalyzer::m_MinorProfile[12] = {
+	6.33, 2.68, 3.52, 5.38, 2.60, 3.53, 2.54, 4.75, 3.98, 2.69, 3.34, 3.17
+};
+
+// The pitch class of A, which the lowest bin is tuned to
+static const size_t lowestPitchClass = 9;
+
+static double Correlation(const std::vector<double> & chroma,
+		const double * profile, int tonic)
+{
+	double chromaMean = 0.0;
+	double profileMean = 0.0;
+	for (size_t pc = 0; pc != 12; ++pc)
+	{
+		chromaMean += chroma[pc];
+		profileMean += profile[pc];
+	}
+	chromaMean /= 12.0;
+	profileMean /= 12.0;
+
+	double product = 0.0;
+	double chromaSquares = 0.0;
+	double profileSquares = 0.0;
+	for (size_t pc = 0; pc != 12; ++pc)
+	{
+		double c = chroma[pc] - chromaMean;
+		double p = profile[(pc + 12 - tonic) % 12] - profileMean;
+		product += c * p;
+		chromaSquares += c * c;
+		profileSquares += p * p;
+	}
+	return chromaSquares > 0.0 ? product / sqrt(chromaSquares * profileSquares)
+			: 0.0;
+}
+
+KeyAnalyzer::KeyAnalyzer()
+: m_Frequencies(m_LowestPitch, m_LowestPitch * (1 << m_NumOctaves),
+		12 * m_BinsPerSemitone, m_AnalysisSampleRate),
+  m_Transform(m_Frequencies)
+{
+	m_Frame.resize(m_Transform.GetFrameSize());
+	m_Magnitudes.resize(m_Transform.GetNumBins());
+	Reset();
+}
+
+KeyAnalyzer::~KeyAnalyzer()
+{
+}
+
+void KeyAnalyzer::Reset()
+{
+	// The first frame is centered on the first sample
+	std::fill(m_Frame.begin(), m_Frame.end(), 0.0f);
+	m_FrameFill = m_Frame.size() / 2;
+	m_Chroma.assign(12, 0.0);
+	m_Key = MusicalKey();
+	m_Strength = 0.0;
+	m_Duration = 0.0;
+}
+
+void KeyAnalyzer::ProcessFrame()
+{
+	m_Transform.Transform(m_Frame.data(), m_Magnitudes.data());
+	for (size_t b = 0; b != m_Magnitudes.size(); ++b)
+	{
+		// The lowest bin of each semitone is the one below its center
+		size_t semitone = b / m_BinsPerSemitone;
+		m_Chroma[(lowestPitchClass + semitone) % 12] += m_Magnitudes[b];
+	}
+	std::copy(m_Frame.begin() + m_HopSize, m_Frame.end(), m_Frame.begin());
+}
+
+void KeyAnalyzer::SubmitSamples(const float * samples, size_t numSamples)
+{
+	m_Duration += numSamples / ((double) m_AnalysisSampleRate);
+	while (numSamples != 0)
+	{
+		size_t count = std::min(numSamples, m_Frame.size() - m_FrameFill);
+		std::copy(samples, samples + count, m_Frame.begin() + m_FrameFill);
+		m_FrameFill += count;
+		samples += count;
+		numSamples -= count;
+		if (m_FrameFill == m_Frame.size())
+		{
+			ProcessFrame();
+			m_FrameFill -= m_HopSize;
+		}
+	}
+}
+
+void KeyAnalyzer::Finish()
+{
+	// The last frames are padded with silence, up to the one centered on
+	// the last sample
+	while (m_FrameFill > m_Frame.size() / 2)
+	{
+		std::fill(m_Frame.begin() + m_FrameFill, m_Frame.end(), 0.0f);
+		ProcessFrame();
+		m_FrameFill -= m_HopSize;
+	}
+	EstimateKey();
+}
+
+void KeyAnalyzer::EstimateKey()
+{
+	double sum = 0.0;
+	for (auto it = m_Chroma.begin(); it != m_Chroma.end(); ++it)
+	{
+		sum += *it;
+	}
+	if (sum > 0.0)
+	{
+		for (auto it = m_Chroma.begin(); it != m_Chroma.end(); ++it)
+		{
+			*it /= sum;
+		}
+	}
+
+	m_Strength = -1.0;
+	for (int tonic = 0; tonic != 12; ++tonic)
+	{
+		double major = Correlation(m_Chroma, m_MajorProfile, tonic);
+		double minor = Correlation(m_Chroma, m_MinorProfile, tonic);
+		if (major > m_Strength)
+		{
+			m_Strength = major;
+			m_Key = MusicalKey(tonic, MusicalKey::MODE_MAJOR);
+		}
+		if (minor > m_Strength)
+		{
+			m_Strength = minor;
+			m_Key = MusicalKey(tonic, MusicalKey::MODE_MINOR);
+		}
+	}
+}
+
+bool KeyAnalyzer::Analyze(const std::string & audioFilename)
+{
+	bool rv = false;
+
+	Reset();
+	m_DecodeTime = m_TransformTime = 0.0;
+
+	// Decoding and transforming are interleaved, so the time spent in each
+	// of them is accumulated block by block
+	Clock::time_point start = Clock::now();
+	AudioFile file(1, m_AnalysisSampleRate);
+	file.setFilename(audioFilename);
+	bool opened = file.OpenFile();
+	m_DecodeTime += SecondsSince(start);
+	if (opened)
+	{
+		while (!file.isFileDone())
+		{
+			start = Clock::now();
+			std::shared_ptr<AudioBlock> block = file.getNextAudioBlock();
+			m_DecodeTime += SecondsSince(start);
+
+			start = Clock::now();
+			if (block->getNumSamples() != 0)
+			{
+				SubmitSamples(block->getChannelData(0),
+						block->getNumSamples());
+			}
+			m_TransformTime += SecondsSince(start);
+		}
+		start = Clock::now();
+		Finish();
+		m_TransformTime += SecondsSince(start);
+		rv = m_Duration > 0.0;
+	}
+	return rv;
+}
@@ -0,0 +1,77 @@
+#ifndef SRC_CORE_ANALYSIS_KEY_KEYANALYZER_H_
+#define SRC_CORE_ANALYSIS_KEY_KEYANALYZER_H_
+
+#include "MusicalKey.h"
+#include "../../../util/cqt/ConstantQTransform.h"
+#include "../../../util/cqt/FrequencyList.h"
+#include <string>
+#include <vector>
+
+// Estimates the key of an audio file offline.  The file is decoded to mono
+// at a low sample rate, and a constant-Q transform with three bins per
+// semitone is taken every hop.  Its magnitudes are folded into a chroma
+// vector (the energy of each pitch class, over all octaves), which is summed
+// over the whole track and matched against the Krumhansl-Kessler profiles
+// of all 24 keys.
+class KeyAnalyzer
+{
+	static const int m_AnalysisSampleRate;
+	static const size_t m_BinsPerSemitone;
+	static const size_t m_NumOctaves;
+	static const float m_LowestPitch;
+	static const size_t m_HopSize;
+	static const double m_MajorProfile[12];
+	static const double m_MinorProfile[12];
+
+	FrequencyList m_Frequencies;
+	ConstantQTransform m_Transform;
+
+	// The frame being filled, which is shifted along by a hop at a time
+	std::vector<float> m_Frame;
+	size_t m_FrameFill;
+	std::vector<float> m_Magnitudes;
+
+	std::vector<double> m_Chroma;
+	MusicalKey m_Key;
+	double m_Strength;
+	double m_Duration;
+
+	// Wall-clock time (in seconds) spent in each stage of the last analysis
+	double m_DecodeTime;
+	double m_TransformTime;
+
+	void ProcessFrame();
+	void EstimateKey();
+public:
+	KeyAnalyzer();
+	virtual ~KeyAnalyzer();
+
+	// Forgets the samples so far
+	void Reset();
+
+	// Feeds samples at the analysis sample rate, and estimates the key of
+	// all of them so far once Finish() is called
+	void SubmitSamples(const float * samples, size_t numSamples);
+	void Finish();
+
+	// Analyzes the given audio file.  AudioFile::InitializeAvformat() must
+	// have been called beforehand.
+	bool Analyze(const std::string & audioFilename);
+
+	static int getAnalysisSampleRate() { return m_AnalysisSampleRate; }
+
+	const MusicalKey & getKey() const { return m_Key; }
+
+	// Correlation of the chroma with the profile of the key, from -1 to 1.
+	// Tracks with little tonal content score low.
+	double getStrength() const { return m_Strength; }
+
+	// Energy of each pitch class, with C first, normalized to sum to one
+	const std::vector<double> & getChroma() const { return m_Chroma; }
+
+	double getDuration() const { return m_Duration; }
+	double getDecodeTime() const { return m_DecodeTime; }
+	double getTransformTime() const { return m_TransformTime; }
+};
+
+#endif /* SRC_CORE_ANALYSIS_KEY_KEYANALYZER_H_ */
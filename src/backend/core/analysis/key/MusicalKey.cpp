@@ -0,0 +1,60 @@
+#include "MusicalKey.h"
+#include "../../../util/StrUtil.h"
+#include <cstdlib>
+
+static const char * const pitchClassNames[] = {
+	"C", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B"
+};
+
+// Indexed by the distance between the keys on the wheel.  Along the same
+// ring, one step is a fifth, two steps are a whole tone, and five steps are
+// a semitone, which is still usable to lift the energy.
+const double MusicalKey::m_SameModeScores[7] = {
+	1.0, 0.8, 0.4, 0.1, 0.0, 0.3, 0.0
+};
+
+// Across the rings, no step is the relative key, and one step keeps all but
+// one of the notes
+const double MusicalKey::m_OtherModeScores[7] = {
+	0.9, 0.5, 0.1, 0.0, 0.0, 0.0, 0.0
+};
+
+MusicalKey::MusicalKey(int tonic, Mode mode)
+: m_Tonic(((tonic % 12) + 12) % 12), m_Mode(mode)
+{
+}
+
+MusicalKey::~MusicalKey()
+{
+}
+
+int MusicalKey::GetCamelotNumber() const
+{
+	// Minor keys sit next to their relative major, three semitones up, and
+	// each fifth up is one step clockwise
+	int major = m_Mode == MODE_MINOR ? (m_Tonic + 3) % 12 : m_Tonic;
+	return (7 * major + 7) % 12 + 1;
+}
+
+std::string MusicalKey::GetCamelotCode() const
+{
+	return StrUtil::format("%d%c", GetCamelotNumber(), GetCamelotLetter());
+}
+
+std::string MusicalKey::GetName() const
+{
+	return std::string(pitchClassNames[m_Tonic]) +
+			(m_Mode == MODE_MINOR ? " minor" : " major");
+}
+
+double MusicalKey::GetCompatibility(const MusicalKey & from,
+		const MusicalKey & to)
+{
+	int distance = abs(to.GetCamelotNumber() - from.GetCamelotNumber());
+	if (distance > 6)
+	{
+		distance = 12 - distance;
+	}
+	return from.m_Mode == to.m_Mode ? m_SameModeScores[distance]
+			: m_OtherModeScores[distance];
+}
@@ -0,0 +1,52 @@
+#ifndef SRC_CORE_ANALYSIS_KEY_MUSICALKEY_H_
+#define SRC_CORE_ANALYSIS_KEY_MUSICALKEY_H_
+
+#include <string>
+
+// A major or minor key, and its place on the Camelot wheel that DJs use for
+// harmonic mixing.  The wheel puts the keys a fifth apart next to each
+// other, with the major keys on the outer ring (B) and their relative
+// minors on the inner ring (A), so that keys that mix well are close.
+class MusicalKey
+{
+public:
+	enum Mode
+	{
+		MODE_MAJOR,
+		MODE_MINOR
+	};
+
+private:
+	static const double m_SameModeScores[7];
+	static const double m_OtherModeScores[7];
+
+	// Pitch class, with C as 0
+	int m_Tonic;
+	Mode m_Mode;
+public:
+	MusicalKey(int tonic = 0, Mode mode = MODE_MAJOR);
+	virtual ~MusicalKey();
+
+	int getTonic() const { return m_Tonic; }
+	Mode getMode() const { return m_Mode; }
+
+	// From 1 to 12, with C major and A minor as 8
+	int GetCamelotNumber() const;
+
+	// 'A' for minor keys and 'B' for major ones
+	char GetCamelotLetter() const { return m_Mode == MODE_MINOR ? 'A' : 'B'; }
+
+	// Such as "8A"
+	std::string GetCamelotCode() const;
+
+	// Such as "A minor"
+	std::string GetName() const;
+
+	// How well a transition from one key to the other works, from 1 for the
+	// same key down to 0.  The relative key and the neighbors on the wheel
+	// score highest, as the usual rules of harmonic mixing have it.
+	static double GetCompatibility(const MusicalKey & from,
+			const MusicalKey & to);
+};
+
+#endif /* SRC_CORE_ANALYSIS_KEY_MUSICALKEY_H_ */
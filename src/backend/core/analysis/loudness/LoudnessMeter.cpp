@@ -0,0 +1,289 @@
+#include "LoudnessMeter.h"
+#include "../../../util/MathConstants.h"
+#include <algorithm>
+#include <cmath>
+
+// Length of the sub-blocks, in seconds, and how many of them make up the
+// momentary (400 ms) and the short-term (3 s) blocks
+const double LoudnessMeter::m_SubBlockTime = 0.1;
+const size_t LoudnessMeter::m_MomentarySize = 4;
+const size_t LoudnessMeter::m_ShortTermSize = 30;
+
+// Gates, in LUFS for the absolute one and in LU below the mean of the blocks
+// that pass it for the relative ones
+const double LoudnessMeter::m_AbsoluteGate = -70.0;
+const double LoudnessMeter::m_IntegratedRelativeGate = -10.0;
+const double LoudnessMeter::m_RangeRelativeGate = -20.0;
+
+// The loudness range spans the short-term loudness between these percentiles
+const double LoudnessMeter::m_RangeLowPercentile = 0.10;
+const double LoudnessMeter::m_RangeHighPercentile = 0.95;
+
+// Longest run that is measured in one go, which bounds the scratch buffers
+const size_t LoudnessMeter::m_MaxRunSize = 256;
+
+static double EnergyToLoudness(double energy)
+{
+	return -0.691 + 10.0 * log10(energy);
+}
+
+static double LoudnessToEnergy(double loudness)
+{
+	return pow(10.0, (loudness + 0.691) / 10.0);
+}
+
+// Sums into several partial sums, so that each addition does not have to
+// wait for the one before it
+static double SumOfSquares(const double * samples, size_t count)
+{
+	double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+	size_t k = 0;
+	for (; k + 4 <= count; k += 4)
+	{
+		sums[0] += samples[k] * samples[k];
+		sums[1] += samples[k + 1] * samples[k + 1];
+		sums[2] += samples[k + 2] * samples[k + 2];
+		sums[3] += samples[k + 3] * samples[k + 3];
+	}
+	for (; k != count; ++k)
+	{
+		sums[0] += samples[k] * samples[k];
+	}
+	return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+
+LoudnessMeter::LoudnessMeter(size_t numChannels, double sampleRate)
+: m_NumChannels(numChannels), m_SampleRate(sampleRate)
+{
+	// The K-weighting filters are specified at 48 kHz only.  They are
+	// designed from their analog prototypes here, so that they match at any
+	// sample rate.
+	double f0 = 1681.974450955533;
+	double gain = 3.999843853973347;
+	double q = 0.7071752369554196;
+	double k = tan(MathConstants::Pi * f0 / m_SampleRate);
+	double vh = pow(10.0, gain / 20.0);
+	double vb = pow(vh, 0.4996667741545416);
+	double a0 = 1.0 + k / q + k * k;
+	m_Shelf.m_B0 = (vh + vb * k / q + k * k) / a0;
+	m_Shelf.m_B1 = 2.0 * (k * k - vh) / a0;
+	m_Shelf.m_B2 = (vh - vb * k / q + k * k) / a0;
+	m_Shelf.m_A1 = 2.0 * (k * k - 1.0) / a0;
+	m_Shelf.m_A2 = (1.0 - k / q + k * k) / a0;
+
+	f0 = 38.13547087602444;
+	q = 0.5003270373238773;
+	k = tan(MathConstants::Pi * f0 / m_SampleRate);
+	a0 = 1.0 + k / q + k * k;
+	m_HighPass.m_B0 = 1.0;
+	m_HighPass.m_B1 = -2.0;
+	m_HighPass.m_B2 = 1.0;
+	m_HighPass.m_A1 = 2.0 * (k * k - 1.0) / a0;
+	m_HighPass.m_A2 = (1.0 - k / q + k * k) / a0;
+
+	m_SubBlockSize = (size_t) (m_SubBlockTime * m_SampleRate + 0.5);
+	m_States.resize(m_NumChannels);
+	m_History.resize(m_NumChannels);
+	for (auto it = m_History.begin(); it != m_History.end(); ++it)
+	{
+		it->resize(m_PeakDetector.GetHistorySize() + m_MaxRunSize);
+	}
+	m_Peaks.resize(m_MaxRunSize);
+	m_Weighted.resize(m_MaxRunSize);
+	Reset();
+}
+
+LoudnessMeter::~LoudnessMeter()
+{
+}
+
+void LoudnessMeter::Reset()
+{
+	ChannelState silence = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	std::fill(m_States.begin(), m_States.end(), silence);
+	for (auto it = m_History.begin(); it != m_History.end(); ++it)
+	{
+		std::fill(it->begin(), it->end(), 0.0f);
+	}
+	m_TruePeak = 0.0f;
+	m_SubBlockFill = 0;
+	m_SubBlockEnergy = 0.0;
+	m_SubBlockEnergies.clear();
+	m_NumSamples = 0;
+}
+
+void LoudnessMeter::Weight(ChannelState & state, const float * input,
+		size_t count, double * output)
+{
+	// Both stages run in one pass.  The recursion ties each sample to the
+	// last, so this loop is the one part of the meter that stays serial,
+	// and it does nothing else.
+	const Biquad & s = m_Shelf;
+	const Biquad & h = m_HighPass;
+	double x1 = state.m_X1, x2 = state.m_X2;
+	double y1 = state.m_Y1, y2 = state.m_Y2;
+	double z1 = state.m_Z1, z2 = state.m_Z2;
+	for (size_t k = 0; k != count; ++k)
+	{
+		double x = input[k];
+		double y = s.m_B0 * x + s.m_B1 * x1 + s.m_B2 * x2 -
+				s.m_A1 * y1 - s.m_A2 * y2;
+		double z = h.m_B0 * y + h.m_B1 * y1 + h.m_B2 * y2 -
+				h.m_A1 * z1 - h.m_A2 * z2;
+		x2 = x1;
+		x1 = x;
+		y2 = y1;
+		y1 = y;
+		z2 = z1;
+		z1 = z;
+		output[k] = z;
+	}
+	state.m_X1 = x1;
+	state.m_X2 = x2;
+	state.m_Y1 = y1;
+	state.m_Y2 = y2;
+	state.m_Z1 = z1;
+	state.m_Z2 = z2;
+}
+
+void LoudnessMeter::ProcessRun(const float * const * channels, size_t start,
+		size_t count)
+{
+	// The run never crosses the end of a sub-block.  All channels are
+	// weighted alike, as the streams are mono or stereo.
+	size_t historySize = m_PeakDetector.GetHistorySize();
+	float * peaks = m_Peaks.data();
+	std::fill(peaks, peaks + count, 0.0f);
+	for (size_t ch = 0; ch != m_NumChannels; ++ch)
+	{
+		const float * input = channels[ch] + start;
+		Weight(m_States[ch], input, count, m_Weighted.data());
+		m_SubBlockEnergy += SumOfSquares(m_Weighted.data(), count);
+
+		float * history = m_History[ch].data();
+		std::copy(input, input + count, history + historySize);
+		m_PeakDetector.Detect(history + historySize, count, peaks);
+		std::copy(history + count, history + count + historySize, history);
+	}
+	m_TruePeak = std::max(m_TruePeak,
+			*std::max_element(peaks, peaks + count));
+
+	m_SubBlockFill += count;
+	if (m_SubBlockFill == m_SubBlockSize)
+	{
+		m_SubBlockEnergies.push_back(m_SubBlockEnergy / m_SubBlockSize);
+		m_SubBlockEnergy = 0.0;
+		m_SubBlockFill = 0;
+	}
+}
+
+void LoudnessMeter::Process(const float * const * channels, size_t count)
+{
+	for (size_t start = 0; start < count;)
+	{
+		size_t run = std::min(std::min(count - start, m_MaxRunSize),
+				m_SubBlockSize - m_SubBlockFill);
+		ProcessRun(channels, start, run);
+		start += run;
+	}
+	m_NumSamples += count;
+}
+
+void LoudnessMeter::GetBlockEnergies(size_t blockSize,
+		std::vector<double> & energies) const
+{
+	// The blocks overlap, and a new one ends with each sub-block
+	energies.clear();
+	for (size_t end = blockSize; end <= m_SubBlockEnergies.size(); ++end)
+	{
+		double sum = 0.0;
+		for (size_t k = end - blockSize; k != end; ++k)
+		{
+			sum += m_SubBlockEnergies[k];
+		}
+		energies.push_back(sum / blockSize);
+	}
+}
+
+double LoudnessMeter::GetIntegratedLoudness() const
+{
+	double rv = -HUGE_VAL;
+
+	std::vector<double> energies;
+	GetBlockEnergies(m_MomentarySize, energies);
+	double threshold = LoudnessToEnergy(m_AbsoluteGate);
+	for (int pass = 0; pass != 2; ++pass)
+	{
+		double sum = 0.0;
+		size_t numBlocks = 0;
+		for (auto it = energies.begin(); it != energies.end(); ++it)
+		{
+			if (*it > threshold)
+			{
+				sum += *it;
+				++numBlocks;
+			}
+		}
+		if (numBlocks == 0)
+		{
+			break;
+		}
+
+		// The second pass gates the blocks that passed the first one by
+		// their mean as well
+		double loudness = EnergyToLoudness(sum / numBlocks);
+		if (pass == 0)
+		{
+			threshold = std::max(threshold,
+					LoudnessToEnergy(loudness + m_IntegratedRelativeGate));
+		}
+		else
+		{
+			rv = loudness;
+		}
+	}
+	return rv;
+}
+
+double LoudnessMeter::GetLoudnessRange() const
+{
+	double rv = 0.0;
+
+	std::vector<double> energies;
+	GetBlockEnergies(m_ShortTermSize, energies);
+	double threshold = LoudnessToEnergy(m_AbsoluteGate);
+	double sum = 0.0;
+	size_t numBlocks = 0;
+	for (auto it = energies.begin(); it != energies.end(); ++it)
+	{
+		if (*it > threshold)
+		{
+			sum += *it;
+			++numBlocks;
+		}
+	}
+	if (numBlocks != 0)
+	{
+		threshold = std::max(threshold, LoudnessToEnergy(
+				EnergyToLoudness(sum / numBlocks) + m_RangeRelativeGate));
+		std::vector<double> loudnesses;
+		for (auto it = energies.begin(); it != energies.end(); ++it)
+		{
+			if (*it > threshold)
+			{
+				loudnesses.push_back(EnergyToLoudness(*it));
+			}
+		}
+		std::sort(loudnesses.begin(), loudnesses.end());
+		size_t last = loudnesses.size() - 1;
+		size_t low = (size_t) (last * m_RangeLowPercentile + 0.5);
+		size_t high = (size_t) (last * m_RangeHighPercentile + 0.5);
+		rv = loudnesses[high] - loudnesses[low];
+	}
+	return rv;
+}
+
+double LoudnessMeter::GetTruePeak() const
+{
+	return 20.0 * log10(m_TruePeak);
+}
@@ -0,0 +1,94 @@
+#ifndef SRC_CORE_ANALYSIS_LOUDNESS_LOUDNESSMETER_H_
+#define SRC_CORE_ANALYSIS_LOUDNESS_LOUDNESSMETER_H_
+
+#include "../../../util/firfilter/TruePeakDetector.h"
+#include <vector>
+
+// Measures the loudness of a stream as in EBU R128 (ITU-R BS.1770): the
+// integrated loudness, the loudness range and the true peak.  Each channel
+// is K-weighted by a high shelf and a high pass, and the mean square of the
+// weighted signal is summed over the channels in sub-blocks of 100 ms.  The
+// gated blocks of 400 ms (for the integrated loudness) and 3 s (for the
+// loudness range) are put together from the sub-blocks when the results are
+// asked for, so the stream may be fed in blocks of any size.
+class LoudnessMeter
+{
+	static const double m_SubBlockTime;
+	static const size_t m_MomentarySize;
+	static const size_t m_ShortTermSize;
+	static const double m_AbsoluteGate;
+	static const double m_IntegratedRelativeGate;
+	static const double m_RangeRelativeGate;
+	static const double m_RangeLowPercentile;
+	static const double m_RangeHighPercentile;
+	static const size_t m_MaxRunSize;
+
+	// Coefficients of a biquad, normalized so that a0 is one
+	struct Biquad
+	{
+		double m_B0, m_B1, m_B2;
+		double m_A1, m_A2;
+	};
+
+	// State of both K-weighting stages of a channel, in direct form I
+	struct ChannelState
+	{
+		double m_X1, m_X2;
+		double m_Y1, m_Y2;
+		double m_Z1, m_Z2;
+	};
+
+	size_t m_NumChannels;
+	double m_SampleRate;
+	Biquad m_Shelf;
+	Biquad m_HighPass;
+	std::vector<ChannelState> m_States;
+
+	// Per channel, the last samples that the peak detector reaches back to,
+	// followed by room for a run of up to m_MaxRunSize more
+	TruePeakDetector m_PeakDetector;
+	std::vector<std::vector<float> > m_History;
+	std::vector<float> m_Peaks;
+
+	// The K-weighted run of the channel being measured
+	std::vector<double> m_Weighted;
+	float m_TruePeak;
+
+	// Energy of each full sub-block so far, and the one being filled
+	size_t m_SubBlockSize;
+	size_t m_SubBlockFill;
+	double m_SubBlockEnergy;
+	std::vector<double> m_SubBlockEnergies;
+	size_t m_NumSamples;
+
+	void Weight(ChannelState & state, const float * input, size_t count,
+			double * output);
+	void ProcessRun(const float * const * channels, size_t start,
+			size_t count);
+	void GetBlockEnergies(size_t blockSize, std::vector<double> & energies)
+			const;
+public:
+	LoudnessMeter(size_t numChannels, double sampleRate);
+	virtual ~LoudnessMeter();
+
+	// Forgets the stream so far
+	void Reset();
+
+	// Measures the next count samples of each channel
+	void Process(const float * const * channels, size_t count);
+
+	// In LUFS, or -HUGE_VAL if the stream is too short or too quiet to
+	// have a loudness
+	double GetIntegratedLoudness() const;
+
+	// In LU, or zero if the stream is shorter than a short-term block
+	double GetLoudnessRange() const;
+
+	// In dBTP, or -HUGE_VAL for silence
+	double GetTruePeak() const;
+
+	// Length of the stream so far, in seconds
+	double GetDuration() const { return m_NumSamples / m_SampleRate; }
+};
+
+#endif /* SRC_CORE_ANALYSIS_LOUDNESS_LOUDNESSMETER_H_ */
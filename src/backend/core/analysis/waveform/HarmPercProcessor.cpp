@@ -20,13 +20,13 @@ void HarmPercProcessor::Initialize(size_t fftSize, size_t medFilterSize, bool us
 	// Constraints
 	assert(medFilterSize > 1);
 	assert((medFilterSize & 1) == 1);
-	assert(m_Threshold <= m_NumMagnitudes);
 
 	m_UseHardMask = useHardMask;
 	m_SoftMaskPower = softMaskPower;
 	m_MedianFilterSize = medFilterSize;
 	m_NumMagnitudes = GetNumMagnitudes(fftSize);
 	m_Threshold = (medFilterSize >> 1) + 1;
+	assert(m_Threshold <= m_NumMagnitudes);
 	m_TemporalHistory.resize(m_NumMagnitudes);
 	for (std::vector<std::deque<float> >::iterator
 			it = m_TemporalHistory.begin(); it != m_TemporalHistory.end();
@@ -34,13 +34,34 @@ void HarmPercProcessor::Initialize(size_t fftSize, size_t medFilterSize, bool us
 	{
 		it->resize(medFilterSize);
 	}
+	m_SortedTemporalHistory.assign(m_NumMagnitudes,
+			std::vector<float>(medFilterSize));
+}
+
+void HarmPercProcessor::SlideSortedWindow(std::vector<float> & sorted, float oldValue, float newValue)
+{
+	// The median filters slide by one value at a time, so rather than
+	// sorting the whole window for every median, the sorted copy of the
+	// window is kept up to date by replacing the value that leaves the
+	// window and moving the new value into place
+	size_t pos = std::lower_bound(sorted.begin(), sorted.end(), oldValue)
+			- sorted.begin();
+	while (pos + 1 < sorted.size() && sorted[pos + 1] < newValue)
+	{
+		sorted[pos] = sorted[pos + 1];
+		++pos;
+	}
+	while (pos > 0 && sorted[pos - 1] > newValue)
+	{
+		sorted[pos] = sorted[pos - 1];
+		--pos;
+	}
+	sorted[pos] = newValue;
 }
 
-float HarmPercProcessor::GetMedianFromQueue(const std::deque<float> & queue)
+float HarmPercProcessor::GetMedianFromSortedWindow(const std::vector<float> & sorted)
 {
-	std::vector<float> sortedArray(queue.begin(), queue.end());
-	std::sort(sortedArray.begin(), sortedArray.end());
-	return sortedArray.at(sortedArray.size() >> 1);
+	return sorted[sorted.size() >> 1];
 }
 
 void HarmPercProcessor::GetScales(float Hsq, float Psq, float & MH, float & MP)
@@ -69,8 +90,10 @@ void HarmPercProcessor::Process(const std::vector<float> & inputSpectrum)
 	for (auto it = m_TemporalHistory.begin(); it != m_TemporalHistory.end();
 			++it, ++k)
 	{
+		float magSquared = GetMagnitudeSquared(inputSpectrum, k);
+		SlideSortedWindow(m_SortedTemporalHistory[k], it->front(), magSquared);
 		it->pop_front();
-		it->push_back(GetMagnitudeSquared(inputSpectrum, k));
+		it->push_back(magSquared);
 	}
 	m_Spectrogram.push_back(inputSpectrum);
 	if (m_Spectrogram.size() >= m_Threshold)
@@ -84,17 +107,21 @@ void HarmPercProcessor::Process(const std::vector<float> & inputSpectrum)
 
 		std::deque<float> spectralHistory;
 		spectralHistory.resize(m_MedianFilterSize);
+		std::vector<float> sortedSpectralHistory(m_MedianFilterSize);
 
 		size_t idx = 0;
 		for (k = 0; k != m_NumMagnitudes; ++k)
 		{
+			float magSquared = GetMagnitudeSquared(targetSpectrum, k);
+			SlideSortedWindow(sortedSpectralHistory, spectralHistory.front(),
+					magSquared);
 			spectralHistory.pop_front();
-			spectralHistory.push_back(GetMagnitudeSquared(targetSpectrum, k));
+			spectralHistory.push_back(magSquared);
 			if (k >= m_Threshold)
 			{
 				idx = k - m_Threshold;
-				float Hsq = GetMedianFromQueue(m_TemporalHistory.at(idx));
-				float Psq = GetMedianFromQueue(spectralHistory);
+				float Hsq = GetMedianFromSortedWindow(m_SortedTemporalHistory.at(idx));
+				float Psq = GetMedianFromSortedWindow(sortedSpectralHistory);
 				float MH, MP;
 				GetScales(Hsq, Psq, MH, MP);
 				ScaleMagnitude(GetOutputSpectrum(0), idx, MH);
@@ -103,10 +130,12 @@ void HarmPercProcessor::Process(const std::vector<float> & inputSpectrum)
 		}
 		for (k = 0; k != m_Threshold; ++k, ++idx)
 		{
+			SlideSortedWindow(sortedSpectralHistory, spectralHistory.front(),
+					0.0f);
 			spectralHistory.pop_front();
 			spectralHistory.push_back(0.0f);
-			float Hsq = GetMedianFromQueue(m_TemporalHistory.at(idx));
-			float Psq = GetMedianFromQueue(spectralHistory);
+			float Hsq = GetMedianFromSortedWindow(m_SortedTemporalHistory.at(idx));
+			float Psq = GetMedianFromSortedWindow(sortedSpectralHistory);
 			float MH, MP;
 			GetScales(Hsq, Psq, MH, MP);
 			ScaleMagnitude(GetOutputSpectrum(0), idx, MH);
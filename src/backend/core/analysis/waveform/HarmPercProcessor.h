@@ -13,16 +13,18 @@ class HarmPercProcessor: public SpectrumProcessor
 	size_t m_NumMagnitudes;
 	size_t m_Threshold;
 	std::vector<std::deque<float> > m_TemporalHistory; // magnitudes only
+	std::vector<std::vector<float> > m_SortedTemporalHistory;
 	std::deque<std::vector<float> > m_Spectrogram;     // mags AND phases
 
-	float GetMedianFromQueue(const std::deque<float> & queue);
+	static void SlideSortedWindow(std::vector<float> & sorted, float oldValue, float newValue);
+	static float GetMedianFromSortedWindow(const std::vector<float> & sorted);
 	void GetScales(float Hsq, float Psq, float & MH, float & MP);
 
 public:
-	HarmPercProcessor(size_t fftSize = 1024, size_t medFilterSize = 16, bool useHardMask = true, float softMaskPower = 1.0f);
+	HarmPercProcessor(size_t fftSize = 1024, size_t medFilterSize = 17, bool useHardMask = true, float softMaskPower = 1.0f);
 	virtual ~HarmPercProcessor();
 
-	void Initialize(size_t fftSize = 1024, size_t medFilterSize = 16, bool useHardMask = true, float softMaskPower = 1.0f);
+	void Initialize(size_t fftSize = 1024, size_t medFilterSize = 17, bool useHardMask = true, float softMaskPower = 1.0f);
 
 	void Process(const std::vector<float> & inputSpectrum);
 	size_t GetProcessDelayPerStep() const
@@ -1,5 +1,5 @@
 #include "HarmPercSeparator.h"
-#include "../../../util/MathConstants.h"
+#include "../../../util/firwindows/WindowCache.h"
 #include <cmath>
 #include <algorithm>
 
@@ -43,20 +43,11 @@ std::vector<float> HarmPercSeparator::GetChunk(size_t & overlapAmount)
 	return chunk;
 }
 
-float HarmPercSeparator::GetWindowFactor(size_t k, size_t N)
-{
-	return 0.5f - 0.5f * cosf(2.0f * MathConstants::Pi * k / (N - 1));
-}
-
 void HarmPercSeparator::ApplyWindow(std::vector<float> & data)
 {
 	// Applies a Hann window to the data
-	size_t N = data.size();
-	size_t k = 0;
-	for (std::vector<float>::iterator it = data.begin(); it != data.end(); ++it)
-	{
-		*it *= GetWindowFactor(k++, N);
-	}
+	WindowCache::Instance().Get(WindowCache::WINDOW_HANN, data.size())
+			->MultiplyByWindow(data);
 }
 
 float HarmPercSeparator::_GetMagnitudeSqr(const float * spectrum, size_t nyquistIndex, size_t index)
@@ -295,6 +286,9 @@ void HarmPercSeparator::GetSeparatedSignals(std::vector<float> & harmonicContent
 		}
 
 		// Take backward FFT of each frame.
+		std::shared_ptr<const Window> theWindow = WindowCache::Instance().Get(
+				WindowCache::WINDOW_HANN, m_FrameSize);
+		const float * window = theWindow->GetData();
 		size_t index = 0;
 		for (std::deque<DataOverlapPair>::iterator
 				it = m_AudioFrames.begin(); it != m_AudioFrames.end(); ++it)
@@ -312,7 +306,7 @@ void HarmPercSeparator::GetSeparatedSignals(std::vector<float> & harmonicContent
 			float * samples = plan_samples(&fftPlan);
 			for (size_t k = discardAmount; k < m_FrameSize; ++k)
 			{
-				harmonicContent.push_back(samples[k] * GetWindowFactor(k, m_FrameSize));
+				harmonicContent.push_back(samples[k] * window[k]);
 			}
 
 			setup_plan(&fftPlan, percFilteredData.data(), cache.data(), m_FrameSize);
@@ -321,7 +315,7 @@ void HarmPercSeparator::GetSeparatedSignals(std::vector<float> & harmonicContent
 			samples = plan_samples(&fftPlan);
 			for (size_t k = discardAmount; k < m_FrameSize; ++k)
 			{
-				percussiveContent.push_back(samples[k] * GetWindowFactor(k, m_FrameSize));
+				percussiveContent.push_back(samples[k] * window[k]);
 			}
 
 			++index;
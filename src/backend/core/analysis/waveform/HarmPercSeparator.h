@@ -35,7 +35,6 @@ class HarmPercSeparator
 	bool m_FirstRun;
 
 	std::vector<float> GetChunk(size_t & overlapAmount);
-	float GetWindowFactor(size_t k, size_t N);
 	void ApplyWindow(std::vector<float> & data);
 
 	std::vector<std::vector<float> > GetHarmonicSpectrogram(const std::vector<float*> & spectrogram, size_t analysisSize);
@@ -4,7 +4,8 @@
 
 CubicInterpFilter::CubicInterpFilter()
 : m_HaveLeftSideInformation(false), m_LeftSample(0.0f), m_LeftSlope(0.0f),
-  m_HaveRightSideInformation(false), m_RightSample(0.0f), m_RightSlope(0.0f)
+  m_HaveRightSideInformation(false), m_RightSample(0.0f), m_RightSlope(0.0f),
+  m_BasisSize(0)
 {
 	// TODO Auto-generated constructor stub
 }
@@ -20,53 +21,126 @@ void CubicInterpFilter::Reset()
 	m_LeftSample = m_LeftSlope = m_RightSample = m_RightSlope = 0.0f;
 }
 
-void CubicInterpFilter::GetLeftBlockInformation(const AudioBlock & block, size_t channel)
+void CubicInterpFilter::GetLeftSideInformation(const float * leftEnd,
+		size_t available)
 {
 	size_t sampRate = AudioSink::Instance().getSampleRate();
-	size_t numSamples = block.getNumSamples();
 	size_t minNumSamples = (size_t) (m_TimeInterval * sampRate);
 	size_t minNumSamplesLeft = (minNumSamples >> 1) + 1;
-	if (numSamples >= minNumSamplesLeft)
+	if (available >= minNumSamplesLeft)
 	{
-		size_t leftSideStart = numSamples - minNumSamplesLeft;
+		const float * leftSide = leftEnd - minNumSamplesLeft;
 		m_HaveLeftSideInformation = true;
-		float v1 = block.getSampleAtPosition(channel, leftSideStart);
-		float v2 = block.getSampleAtPosition(channel, leftSideStart + 1);
+		float v1 = leftSide[0];
+		float v2 = leftSide[1];
 		m_LeftSample = v2;
 		m_LeftSlope = (v2 - v1) / AudioSink::Instance().getSampleRate();
 	}
 }
 
-void CubicInterpFilter::GetRightBlockInformation(const AudioBlock & block, size_t channel)
+void CubicInterpFilter::GetRightSideInformation(const float * rightStart,
+		size_t available)
 {
 	size_t sampRate = AudioSink::Instance().getSampleRate();
-	size_t numSamples = block.getNumSamples();
 	size_t minNumSamples = (size_t) (m_TimeInterval * sampRate) + 1;
 	size_t minNumSamplesRight = ((minNumSamples + 1) >> 1) + 1;
-	if (numSamples >= minNumSamplesRight)
+	if (available >= minNumSamplesRight)
 	{
 		m_HaveRightSideInformation = true;
-		float v1 = block.getSampleAtPosition(channel, minNumSamplesRight - 2);
-		float v2 = block.getSampleAtPosition(channel, minNumSamplesRight - 1);
+		float v1 = rightStart[minNumSamplesRight - 2];
+		float v2 = rightStart[minNumSamplesRight - 1];
 		m_RightSample = v1;
 		m_RightSlope = (v2 - v1) / AudioSink::Instance().getSampleRate();
 	}
 }
 
+void CubicInterpFilter::GetLeftBlockInformation(const AudioBlock & block, size_t channel)
+{
+	size_t numSamples = block.getNumSamples();
+	GetLeftSideInformation(block.getChannelData(channel) + numSamples,
+			numSamples);
+}
+
+void CubicInterpFilter::GetRightBlockInformation(const AudioBlock & block, size_t channel)
+{
+	GetRightSideInformation(block.getChannelData(channel),
+			block.getNumSamples());
+}
+
+void CubicInterpFilter::GetBasis(float t, float & leftSample,
+		float & leftSlope, float & rightSample, float & rightSlope)
+{
+	float tsq = t * t;
+	leftSample = 1.0f + tsq * (-3.0f + t * 2.0f);
+	leftSlope = t * (1.0f + t * (-2.0f - t));
+	rightSample = tsq * (3.0f + t * -2.0f);
+	rightSlope = tsq * (-1.0f + t);
+}
+
+void CubicInterpFilter::BuildBasisTables(size_t numSamples)
+{
+	m_BasisSize = numSamples;
+	m_LeftSampleBasis.resize(numSamples);
+	m_LeftSlopeBasis.resize(numSamples);
+	m_RightSampleBasis.resize(numSamples);
+	m_RightSlopeBasis.resize(numSamples);
+	for (size_t k = 0; k != numSamples; ++k)
+	{
+		GetBasis((float) (k / (double) numSamples), m_LeftSampleBasis[k],
+				m_LeftSlopeBasis[k], m_RightSampleBasis[k],
+				m_RightSlopeBasis[k]);
+	}
+}
+
+void CubicInterpFilter::Interpolate(float * data, size_t basisStart,
+		size_t count) const
+{
+	// The curve does not depend on the samples it replaces, so the loop is
+	// a plain combination of the tables, which the compiler can vectorize
+	const float * leftSampleBasis = m_LeftSampleBasis.data() + basisStart;
+	const float * leftSlopeBasis = m_LeftSlopeBasis.data() + basisStart;
+	const float * rightSampleBasis = m_RightSampleBasis.data() + basisStart;
+	const float * rightSlopeBasis = m_RightSlopeBasis.data() + basisStart;
+	for (size_t k = 0; k != count; ++k)
+	{
+		data[k] = leftSampleBasis[k] * m_LeftSample
+				+ leftSlopeBasis[k] * m_LeftSlope
+				+ rightSampleBasis[k] * m_RightSample
+				+ rightSlopeBasis[k] * m_RightSlope;
+	}
+}
+
 float CubicInterpFilter::ProcessSample(float sample, float t) const
 {
 	if (m_HaveLeftSideInformation && m_HaveRightSideInformation)
 	{
 		if (t >= 0.0f && t <= 1.0f)
 		{
-			float tsq = t * t;
-			float h00 = 1.0f + tsq * (-3.0f + t * 2.0f);
-			float h01 = t * (1.0f + t * (-2.0f - t));
-			float h10 = tsq * (3.0f + t * -2.0f);
-			float h11 = tsq * (-1.0f + t);
+			float h00, h01, h10, h11;
+			GetBasis(t, h00, h01, h10, h11);
 			sample = h00 * m_LeftSample + h01 * m_LeftSlope
 				   + h10 * m_RightSample + h11 * m_RightSlope;
 		}
 	}
 	return sample;
 }
+
+void CubicInterpFilter::ProcessChannelSeam(float * leftEnd,
+		size_t leftAvailable, float * rightStart, size_t rightAvailable)
+{
+	size_t numSamples, leftNumSamples, rightNumSamples;
+	GetSeamSize(numSamples, leftNumSamples, rightNumSamples);
+	if (numSamples != m_BasisSize)
+	{
+		BuildBasisTables(numSamples);
+	}
+
+	Reset();
+	GetLeftSideInformation(leftEnd, leftAvailable);
+	GetRightSideInformation(rightStart, rightAvailable);
+	if (m_HaveLeftSideInformation && m_HaveRightSideInformation)
+	{
+		Interpolate(leftEnd - leftNumSamples, 0, leftNumSamples);
+		Interpolate(rightStart, leftNumSamples, rightNumSamples);
+	}
+}
@@ -3,6 +3,7 @@
 
 #include "Filter.h"
 #include <string>
+#include <vector>
 
 class AudioBlock;
 
@@ -15,15 +16,34 @@ class CubicInterpFilter: public Filter {
 	float m_RightSample;
 	float m_RightSlope;
 
+	// The Hermite basis functions at each sample of the seam, which only
+	// depend on the number of samples it spans
+	size_t m_BasisSize;
+	std::vector<float> m_LeftSampleBasis;
+	std::vector<float> m_LeftSlopeBasis;
+	std::vector<float> m_RightSampleBasis;
+	std::vector<float> m_RightSlopeBasis;
+
+	static void GetBasis(float t, float & leftSample, float & leftSlope,
+			float & rightSample, float & rightSlope);
+	void BuildBasisTables(size_t numSamples);
+	void Interpolate(float * data, size_t basisStart, size_t count) const;
 public:
 	CubicInterpFilter();
 	virtual ~CubicInterpFilter();
 
 	void Reset();
+
+	// Takes the sample and slope at either end of the seam, from the samples
+	// that end just before leftEnd or start at rightStart
+	void GetLeftSideInformation(const float * leftEnd, size_t available);
+	void GetRightSideInformation(const float * rightStart, size_t available);
 	void GetLeftBlockInformation(const AudioBlock & block, size_t channel);
 	void GetRightBlockInformation(const AudioBlock & block, size_t channel);
 
 	float ProcessSample(float sample, float t) const;
+	void ProcessChannelSeam(float * leftEnd, size_t leftAvailable,
+			float * rightStart, size_t rightAvailable);
 };
 
 #endif /* SRC_CORE_FILTERS_CUBICINTERPFILTER_H_ */
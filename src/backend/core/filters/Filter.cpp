@@ -1,12 +1,13 @@
 #include "Filter.h"
-#include "HoldBackQueue.h"
 #include "../AudioBlock.h"
 #include "../AudioSink.h"
 
 const float Filter::m_DefaultTimeInterval = 0.001f;
 const size_t Filter::m_MinNumSamples = 6;
-const int Filter::m_LeftBlockReady = 1;
-const int Filter::m_RightBlockReady = 2;
+
+// Filters may look a sample or two past the seam, to estimate the slope of
+// the signal there
+const size_t Filter::m_SeamMargin = 2;
 
 Filter::Filter() : m_TimeInterval(m_DefaultTimeInterval)
 {
@@ -27,55 +28,52 @@ void Filter::SetTimeInterval(float timeInterval)
 	m_TimeInterval = std::max(timeInterval, GetMinTimeInterval());
 }
 
-int Filter::GetLeftBlockReadyFlag()
-{
-	return m_LeftBlockReady;
-}
-
-int Filter::GetRightBlockReadyFlag()
+void Filter::GetSeamSize(size_t & numSamples, size_t & leftNumSamples,
+		size_t & rightNumSamples) const
 {
-	return m_RightBlockReady;
+	numSamples = (size_t) (m_TimeInterval *
+			(double) AudioSink::Instance().getSampleRate());
+	leftNumSamples = numSamples >> 1;
+	rightNumSamples = (numSamples + 1) >> 1;
 }
 
-int Filter::GetBothBlocksReadyFlag()
+void Filter::GetSeamExtent(size_t & leftNumSamples,
+		size_t & rightNumSamples) const
 {
-	return GetLeftBlockReadyFlag() | GetRightBlockReadyFlag();
+	size_t numSamples;
+	GetSeamSize(numSamples, leftNumSamples, rightNumSamples);
+	leftNumSamples += m_SeamMargin;
+	rightNumSamples += m_SeamMargin;
 }
 
-int Filter::GetFilterReadyFlagsAux(size_t queueSize, const AudioBlock * block, ssize_t extraMargin) const
+void Filter::ProcessChannelSeam(float * leftEnd, size_t leftAvailable,
+		float * rightStart, size_t rightAvailable)
 {
-	int flags = 0;
-	size_t sampRate = (size_t) AudioSink::Instance().getSampleRate();
-	size_t numSamples = (size_t) (m_TimeInterval * sampRate);
-	size_t leftNumSamples = (numSamples >> 1) + extraMargin;
-	size_t leftBlockSize = queueSize;
-	if (leftBlockSize >= leftNumSamples)
+	size_t numSamples, leftNumSamples, rightNumSamples;
+	GetSeamSize(numSamples, leftNumSamples, rightNumSamples);
+	if (leftAvailable >= leftNumSamples && rightAvailable >= rightNumSamples)
 	{
-		flags |= m_LeftBlockReady;
-	}
-	if (block != nullptr)
-	{
-		size_t rightNumSamples = ((numSamples + 1) >> 1) + extraMargin;
-		size_t rightBlockSize = block->getNumSamples();
-		if (rightBlockSize >= rightNumSamples)
+		double dt = 1.0 / numSamples;
+		float * leftData = leftEnd - leftNumSamples;
+		for (size_t k = 0; k != leftNumSamples; ++k)
+		{
+			leftData[k] = ProcessSample(leftData[k], k * dt);
+		}
+		for (size_t k = 0; k != rightNumSamples; ++k)
 		{
-			flags |= m_RightBlockReady;
+			rightStart[k] = ProcessSample(rightStart[k],
+					(k + leftNumSamples) * dt);
 		}
 	}
-	return flags;
 }
 
-int Filter::GetFilterReadyFlags(const HoldBackQueue & hbqueue, const AudioBlock & block, ssize_t extraMargin) const
+void Filter::ProcessSeam(AudioBlock & left, AudioBlock & right)
 {
-	return GetFilterReadyFlagsAux(hbqueue.GetTotalSize(), &block, extraMargin);
-}
-
-bool Filter::IsQueueReadyAfterQueueFetch(const HoldBackQueue & hbqueue, ssize_t extraMargin) const
-{
-	return GetFilterReadyFlagsAux(hbqueue.GetTotalSizeWithoutFront(), nullptr, extraMargin) != 0;
-}
-
-bool Filter::IsQueueReadyAfterQueueFetchAndAdd(const HoldBackQueue & hbqueue, const AudioBlock & block, ssize_t extraMargin) const
-{
-	return GetFilterReadyFlagsAux(hbqueue.GetTotalSizeWithoutFront() + block.getNumSamples(), nullptr, extraMargin) != 0;
+	size_t leftNumSamples = left.getNumSamples();
+	size_t rightNumSamples = right.getNumSamples();
+	for (int ch = 0; ch != AudioSink::Instance().getNumChannels(); ++ch)
+	{
+		ProcessChannelSeam(left.getChannelData(ch) + leftNumSamples,
+				leftNumSamples, right.getChannelData(ch), rightNumSamples);
+	}
 }
@@ -4,38 +4,47 @@
 #include <string>
 
 class AudioBlock;
-class HoldBackQueue;
 
 class Filter {
 	static const float m_DefaultTimeInterval;
 	static const size_t m_MinNumSamples;
-
-	static const int m_LeftBlockReady;
-	static const int m_RightBlockReady;
+	static const size_t m_SeamMargin;
 
 	float GetMinTimeInterval() const;
-	int GetFilterReadyFlagsAux(size_t queueSize,
-				const AudioBlock * block, ssize_t extraMargin) const;
 protected:
 	float m_TimeInterval;
 public:
-	static int GetLeftBlockReadyFlag();
-	static int GetRightBlockReadyFlag();
-	static int GetBothBlocksReadyFlag();
-
 	Filter();
 	virtual ~Filter();
 
 	float GetTimeInterval() const { return m_TimeInterval; }
 	void SetTimeInterval(float timeInterval);
 
+	// Number of samples of the seam as a whole, and on either side of it
+	void GetSeamSize(size_t & numSamples, size_t & leftNumSamples,
+			size_t & rightNumSamples) const;
+
+	// Number of samples on either side of the seam that the filter reads or
+	// writes, which is a little more than the seam itself
+	void GetSeamExtent(size_t & leftNumSamples,
+			size_t & rightNumSamples) const;
+
 	virtual float ProcessSample(float sample, float t) const = 0;
-	int GetFilterReadyFlags(const HoldBackQueue & hbqueue,
-			const AudioBlock & block, ssize_t extraMargin = 0) const;
-	bool IsQueueReadyAfterQueueFetch(const HoldBackQueue & hbqueue,
-			ssize_t extraMargin = 0) const;
-	bool IsQueueReadyAfterQueueFetchAndAdd(const HoldBackQueue & hbqueue,
-			const AudioBlock & block, ssize_t extraMargin = 0) const;
+
+	// Filters the seam of one channel in place.  The samples on the left of
+	// the seam end just before leftEnd, and those on the right start at
+	// rightStart, which are the same pointer if the channel is contiguous
+	// across the seam.  The seam spans GetTimeInterval(), half of it on
+	// either side, and is left as it is if either side has fewer samples
+	// available than GetSeamExtent() asks for.  By default, ProcessSample is
+	// called on every sample of the seam, with t running from 0 to 1 across
+	// it.
+	virtual void ProcessChannelSeam(float * leftEnd, size_t leftAvailable,
+			float * rightStart, size_t rightAvailable);
+
+	// Filters the seam between the end of the left block and the start of
+	// the right block, in all channels
+	void ProcessSeam(AudioBlock & left, AudioBlock & right);
 };
 
 #endif /* SRC_CORE_FILTERS_FILTER_H_ */
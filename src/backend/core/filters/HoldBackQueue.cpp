@@ -1,82 +1,171 @@
 #include "HoldBackQueue.h"
+#include "Filter.h"
 #include "../AudioBlock.h"
+#include "../AudioSink.h"
+#include <algorithm>
 
-HoldBackQueue::HoldBackQueue() : totalBufSize(0) {
-	// TODO Auto-generated constructor stub
+// Room for a block of the usual size along with the seams on either side of
+// it, so that the buffer rarely has to grow
+const size_t HoldBackQueue::m_MinCapacity = 8192;
 
+HoldBackQueue::HoldBackQueue()
+: m_Capacity(0), m_BufferStart(0), m_Begin(0), m_End(0), m_LeftExtent(0),
+  m_RightExtent(0)
+{
 }
 
-HoldBackQueue::~HoldBackQueue() {
-	// TODO Auto-generated destructor stub
-}
-
-void HoldBackQueue::Add(const std::shared_ptr<AudioBlock> & item)
+HoldBackQueue::~HoldBackQueue()
 {
-	queue.push_back(item);
-	totalBufSize += item->getNumSamples();
 }
 
-std::shared_ptr<AudioBlock> HoldBackQueue::Remove()
+void HoldBackQueue::MakeRoom(size_t numChannels, size_t numSamples)
 {
-	std::shared_ptr<AudioBlock> item;
-	if (!queue.empty())
+	size_t numHeld = m_End - m_Begin;
+	size_t offset = m_Begin - m_BufferStart;
+	if (numChannels != m_Samples.size() || numHeld + numSamples > m_Capacity)
+	{
+		size_t capacity = std::max(m_Capacity, m_MinCapacity);
+		while (capacity < numHeld + numSamples)
+		{
+			capacity <<= 1;
+		}
+		std::vector<std::vector<float> > samples(numChannels,
+				std::vector<float>(capacity));
+		for (size_t ch = 0; ch != std::min(numChannels, m_Samples.size()); ++ch)
+		{
+			std::copy(m_Samples[ch].begin() + offset,
+					m_Samples[ch].begin() + offset + numHeld,
+					samples[ch].begin());
+		}
+		m_Samples.swap(samples);
+		m_Capacity = capacity;
+		m_BufferStart = m_Begin;
+	}
+	else if (offset + numHeld + numSamples > m_Capacity)
 	{
-		item = queue.front();
-		totalBufSize -= item->getNumSamples();
-		queue.pop_front();
+		for (size_t ch = 0; ch != numChannels; ++ch)
+		{
+			std::copy(m_Samples[ch].begin() + offset,
+					m_Samples[ch].begin() + offset + numHeld,
+					m_Samples[ch].begin());
+		}
+		m_BufferStart = m_Begin;
 	}
-	return item;
 }
 
-std::shared_ptr<AudioBlock> HoldBackQueue::RemoveUntilNextClickRemovalBlock()
+void HoldBackQueue::Add(const std::shared_ptr<AudioBlock> & block,
+		Filter & filter)
 {
-	std::shared_ptr<AudioBlock> item = Remove();
-	while (!queue.empty() && queue.front()->isClickRemovalSet())
+	size_t numChannels = AudioSink::Instance().getNumChannels();
+	size_t numSamples = block->getNumSamples();
+	MakeRoom(numChannels, numSamples);
+	for (size_t ch = 0; ch != numChannels; ++ch)
 	{
-		item->append(queue.front());
-		totalBufSize -= queue.front()->getNumSamples();
-		queue.pop_front();
+		const float * data = block->getChannelData(ch);
+		std::copy(data, data + numSamples,
+				m_Samples[ch].begin() + (m_End - m_BufferStart));
 	}
-	return item;
-}
 
-size_t HoldBackQueue::GetBackBufferSize() const
-{
-	return queue.empty() ? 0 : queue.back()->getNumSamples();
+	if (block->isClickRemovalSet() && m_Begin != m_End)
+	{
+		m_Seams.push_back(m_End);
+	}
+	HeldBlock held = { block, m_End, false };
+	m_Blocks.push_back(held);
+	m_End += numSamples;
+
+	filter.GetSeamExtent(m_LeftExtent, m_RightExtent);
+	FilterSeams(filter);
 }
 
-size_t HoldBackQueue::GetFrontBufferSize() const
+void HoldBackQueue::FilterSeams(Filter & filter)
 {
-	return queue.empty() ? 0 : queue.front()->getNumSamples();
+	while (!m_Seams.empty() && m_End - m_Seams.front() >= m_RightExtent)
+	{
+		size_t seam = m_Seams.front();
+		m_Seams.pop_front();
+		for (size_t ch = 0; ch != m_Samples.size(); ++ch)
+		{
+			float * data = &m_Samples[ch][seam - m_BufferStart];
+			filter.ProcessChannelSeam(data, seam - m_Begin, data,
+					m_End - seam);
+		}
+		MarkFiltered(seam - std::min(m_LeftExtent, seam - m_Begin),
+				seam + m_RightExtent);
+	}
 }
 
-size_t HoldBackQueue::GetTotalSize() const
+void HoldBackQueue::MarkFiltered(size_t start, size_t end)
 {
-	return totalBufSize;
+	// The seam is near the end, so the blocks that it reaches are searched
+	// from there
+	for (auto it = m_Blocks.rbegin(); it != m_Blocks.rend() &&
+			it->m_Start + it->m_Block->getNumSamples() > start; ++it)
+	{
+		if (it->m_Start < end)
+		{
+			it->m_Filtered = true;
+		}
+	}
 }
 
-size_t HoldBackQueue::GetTotalSizeWithoutFront() const
+std::shared_ptr<AudioBlock> HoldBackQueue::RemoveFront()
 {
-	return totalBufSize - GetFrontBufferSize();
+	HeldBlock & held = m_Blocks.front();
+	std::shared_ptr<AudioBlock> block = std::move(held.m_Block);
+	size_t numSamples = block->getNumSamples();
+	if (held.m_Filtered)
+	{
+		for (size_t ch = 0; ch != m_Samples.size(); ++ch)
+		{
+			auto data = m_Samples[ch].begin() + (held.m_Start - m_BufferStart);
+			std::copy(data, data + numSamples, block->getChannelData(ch));
+		}
+	}
+	m_Blocks.pop_front();
+	m_Begin += numSamples;
+	return block;
 }
 
-std::shared_ptr<AudioBlock> HoldBackQueue::CreateBlock() const
+std::shared_ptr<AudioBlock> HoldBackQueue::Remove()
 {
-	std::shared_ptr<AudioBlock> accumulate = std::make_shared<AudioBlock>();
-	accumulate->initializeChannels();
-	for (auto it = queue.rbegin(); it != queue.rend(); ++it)
+	std::shared_ptr<AudioBlock> block;
+	if (!m_Blocks.empty())
 	{
-		accumulate->append(*it);
+		// Both the next seam to come in and those still to be filtered reach
+		// back by the left extent
+		size_t limit = m_End;
+		if (!m_Seams.empty())
+		{
+			limit = m_Seams.front();
+		}
+		const HeldBlock & held = m_Blocks.front();
+		if (held.m_Start + held.m_Block->getNumSamples() + m_LeftExtent <=
+				limit)
+		{
+			block = RemoveFront();
+		}
 	}
-	return accumulate;
+	return block;
 }
 
-bool HoldBackQueue::IsEmpty() const
+std::shared_ptr<AudioBlock> HoldBackQueue::Drain()
 {
-	return queue.empty();
+	std::shared_ptr<AudioBlock> block;
+	if (!m_Blocks.empty())
+	{
+		block = RemoveFront();
+		if (m_Blocks.empty())
+		{
+			m_Seams.clear();
+		}
+	}
+	return block;
 }
 
 void HoldBackQueue::Clear()
 {
-	queue.clear();
+	m_Blocks.clear();
+	m_Seams.clear();
+	m_Begin = m_End = m_BufferStart;
 }
@@ -3,30 +3,74 @@
 
 #include <deque>
 #include <memory>
+#include <vector>
 
 class AudioBlock;
+class Filter;
 
+// Holds back the blocks on their way to the sink for as long as the seams
+// between them may still be filtered.  The samples of the held blocks are
+// kept back to back in one buffer per channel, so that each seam is
+// contiguous however the blocks around it are cut, and it is filtered in
+// place as soon as there are enough samples on its right.  The blocks are
+// released as they came in, with whatever was filtered copied back into
+// them, once no seam can reach them anymore.
 class HoldBackQueue {
-	std::deque<std::shared_ptr<AudioBlock> > queue;
-	size_t totalBufSize;
+	struct HeldBlock
+	{
+		std::shared_ptr<AudioBlock> m_Block;
+		// Stream position of the first sample of the block
+		size_t m_Start;
+		// Whether any seam was filtered over the block
+		bool m_Filtered;
+	};
 
+	static const size_t m_MinCapacity;
+
+	// Per channel, the samples from stream position m_BufferStart on.  When
+	// the end of the buffer is reached, the held samples are moved back to
+	// the front, which is cheap since only a few milliseconds of audio are
+	// held at a time, so the buffer only grows for blocks that do not fit.
+	std::vector<std::vector<float> > m_Samples;
+	size_t m_Capacity;
+	size_t m_BufferStart;
+
+	// Stream positions of the first held sample and of the one after the
+	// last
+	size_t m_Begin;
+	size_t m_End;
+
+	std::deque<HeldBlock> m_Blocks;
+
+	// Stream positions of the seams that are still to be filtered
+	std::deque<size_t> m_Seams;
+
+	// Samples that the filter reaches on either side of a seam
+	size_t m_LeftExtent;
+	size_t m_RightExtent;
+
+	void MakeRoom(size_t numChannels, size_t numSamples);
+	void FilterSeams(Filter & filter);
+	void MarkFiltered(size_t start, size_t end);
+	std::shared_ptr<AudioBlock> RemoveFront();
 public:
 	HoldBackQueue();
 	virtual ~HoldBackQueue();
 
-	void Add(const std::shared_ptr<AudioBlock> & item);
-	std::shared_ptr<AudioBlock> Remove();
-	std::shared_ptr<AudioBlock> RemoveUntilNextClickRemovalBlock();
-
-	size_t GetBackBufferSize() const;
-	size_t GetFrontBufferSize() const;
+	// Takes in the next block, and filters the seams that have enough
+	// samples on their right now.  A block with click removal set starts a
+	// seam, unless nothing is held before it.
+	void Add(const std::shared_ptr<AudioBlock> & block, Filter & filter);
 
-	size_t GetTotalSize() const;
-	size_t GetTotalSizeWithoutFront() const;
+	// Returns the oldest block if no seam can reach it anymore, or null
+	std::shared_ptr<AudioBlock> Remove();
 
-	std::shared_ptr<AudioBlock> CreateBlock() const;
+	// Returns the oldest block, or null if none is held.  Seams that are
+	// still to be filtered are left as they are.
+	std::shared_ptr<AudioBlock> Drain();
 
-	bool IsEmpty() const;
+	size_t GetTotalSize() const { return m_End - m_Begin; }
+	bool IsEmpty() const { return m_Blocks.empty(); }
 	void Clear();
 };
 
@@ -0,0 +1,184 @@
+#include "TruePeakLimiter.h"
+#include "../AudioBlock.h"
+#include <algorithm>
+#include <cmath>
+
+// Longest run that is limited in one go, which bounds the scratch buffers
+const size_t TruePeakLimiter::m_MaxRunSize = 256;
+
+// Attack and release, in seconds.  The attack is the look-ahead, and it is
+// short enough that the delay goes unnoticed.
+const double TruePeakLimiter::m_LookAheadTime = 0.0015;
+const double TruePeakLimiter::m_ReleaseTime = 0.05;
+
+// In dB relative to full scale, which leaves some room for the rounding of
+// converters and codecs further down the line
+const double TruePeakLimiter::m_DefaultCeiling = -1.0;
+
+TruePeakLimiter::TruePeakLimiter(size_t numChannels, double sampleRate,
+		double ceiling)
+: m_NumChannels(numChannels), m_HoldFront(0), m_HoldCount(0), m_Frame(0),
+  m_Envelope(1.0), m_AveragePos(0), m_AverageSum(0.0)
+{
+	SetCeiling(ceiling);
+	m_ReleaseCoeff = 1.0 - exp(-1.0 / (m_ReleaseTime * sampleRate));
+
+	// The peak of a frame is held for one frame more than the gain is
+	// averaged over, so that the frames on either side of a peak between
+	// samples are turned down all the way too
+	size_t averageSize = std::max((size_t) (m_LookAheadTime * sampleRate + 0.5),
+			m_PeakDetector.GetHistorySize() + 1);
+	m_HoldSize = averageSize + 1;
+	m_Latency = m_PeakDetector.GetDelay() + averageSize - 1;
+	m_Average.resize(averageSize);
+	m_HoldGains.resize(m_HoldSize + 1);
+	m_HoldFrames.resize(m_HoldSize + 1);
+
+	m_Delay.resize(m_NumChannels);
+	for (auto it = m_Delay.begin(); it != m_Delay.end(); ++it)
+	{
+		it->resize(m_Latency + m_MaxRunSize);
+	}
+	m_Peaks.resize(m_MaxRunSize);
+	m_Gains.resize(m_MaxRunSize);
+	Reset();
+}
+
+TruePeakLimiter::~TruePeakLimiter()
+{
+}
+
+double TruePeakLimiter::GetCeiling() const
+{
+	return 20.0 * log10(m_Ceiling);
+}
+
+void TruePeakLimiter::SetCeiling(double ceiling)
+{
+	m_Ceiling = (float) pow(10.0, ceiling / 20.0);
+}
+
+void TruePeakLimiter::Reset()
+{
+	for (auto it = m_Delay.begin(); it != m_Delay.end(); ++it)
+	{
+		std::fill(it->begin(), it->end(), 0.0f);
+	}
+	m_HoldFront = m_HoldCount = m_Frame = 0;
+	m_Envelope = 1.0;
+	std::fill(m_Average.begin(), m_Average.end(), 1.0);
+	m_AveragePos = 0;
+	m_AverageSum = (double) m_Average.size();
+}
+
+float TruePeakLimiter::Hold(float gain)
+{
+	// Frames that need no less gain than this one will never be the
+	// minimum again
+	size_t ringSize = m_HoldGains.size();
+	while (m_HoldCount != 0 &&
+			m_HoldGains[(m_HoldFront + m_HoldCount - 1) % ringSize] >= gain)
+	{
+		--m_HoldCount;
+	}
+	size_t back = (m_HoldFront + m_HoldCount) % ringSize;
+	m_HoldGains[back] = gain;
+	m_HoldFrames[back] = m_Frame;
+	++m_HoldCount;
+	if (m_HoldFrames[m_HoldFront] + m_HoldSize <= m_Frame)
+	{
+		m_HoldFront = (m_HoldFront + 1) % ringSize;
+		--m_HoldCount;
+	}
+	++m_Frame;
+	return m_HoldGains[m_HoldFront];
+}
+
+float TruePeakLimiter::Smooth(float gain)
+{
+	// The gain drops at once and recovers over the release time, and the
+	// average turns the drop into a ramp over the look-ahead
+	if (gain < m_Envelope)
+	{
+		m_Envelope = gain;
+	}
+	else
+	{
+		m_Envelope += (gain - m_Envelope) * m_ReleaseCoeff;
+	}
+	m_AverageSum += m_Envelope - m_Average[m_AveragePos];
+	m_Average[m_AveragePos] = m_Envelope;
+	if (++m_AveragePos == m_Average.size())
+	{
+		// The running sum is worked out afresh every so often, so that the
+		// rounding errors do not build up
+		m_AveragePos = 0;
+		m_AverageSum = 0.0;
+		for (auto it = m_Average.begin(); it != m_Average.end(); ++it)
+		{
+			m_AverageSum += *it;
+		}
+	}
+	return (float) (m_AverageSum / m_Average.size());
+}
+
+void TruePeakLimiter::ProcessRun(AudioBlock & block, size_t start,
+		size_t count)
+{
+	// The loops over the run are free of dependencies, so that they can be
+	// vectorized, except for the gain, which follows the frames one by one
+	float * peaks = m_Peaks.data();
+	float * gains = m_Gains.data();
+	std::fill(peaks, peaks + count, 0.0f);
+	for (size_t ch = 0; ch != m_NumChannels; ++ch)
+	{
+		float * delay = m_Delay[ch].data();
+		const float * input = block.getChannelData(ch) + start;
+		std::copy(input, input + count, delay + m_Latency);
+		m_PeakDetector.Detect(delay + m_Latency, count, peaks);
+	}
+
+	// Frames below the ceiling need a gain of exactly one
+	float ceiling = m_Ceiling;
+	for (size_t k = 0; k != count; ++k)
+	{
+		gains[k] = ceiling / std::max(peaks[k], ceiling);
+	}
+	for (size_t k = 0; k != count; ++k)
+	{
+		gains[k] = Smooth(Hold(gains[k]));
+	}
+
+	for (size_t ch = 0; ch != m_NumChannels; ++ch)
+	{
+		float * delay = m_Delay[ch].data();
+		float * output = block.getChannelData(ch) + start;
+		for (size_t k = 0; k != count; ++k)
+		{
+			output[k] = delay[k] * gains[k];
+		}
+		std::copy(delay + count, delay + count + m_Latency, delay);
+	}
+}
+
+void TruePeakLimiter::Process(AudioBlock & block)
+{
+	size_t numSamples = block.getNumSamples();
+	for (size_t start = 0; start < numSamples; start += m_MaxRunSize)
+	{
+		ProcessRun(block, start, std::min(numSamples - start, m_MaxRunSize));
+	}
+}
+
+std::shared_ptr<AudioBlock> TruePeakLimiter::Flush()
+{
+	std::shared_ptr<AudioBlock> block = std::make_shared<AudioBlock>();
+	std::vector<float> silence(m_Latency);
+	for (size_t ch = 0; ch != m_NumChannels; ++ch)
+	{
+		block->pushChannelData(silence.data(), m_Latency);
+	}
+	Process(*block);
+	Reset();
+	return block;
+}
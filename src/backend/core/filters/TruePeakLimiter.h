@@ -0,0 +1,81 @@
+#ifndef SRC_CORE_FILTERS_TRUEPEAKLIMITER_H_
+#define SRC_CORE_FILTERS_TRUEPEAKLIMITER_H_
+
+#include "../../util/firfilter/TruePeakDetector.h"
+#include <memory>
+#include <vector>
+
+class AudioBlock;
+
+// Keeps the true peak of the mix below a ceiling, on its way into the sink.
+// The peaks between the samples are found with a TruePeakDetector.  The gain
+// needed for each frame is held over the look-ahead window and then averaged
+// over the same window, so that the gain has ramped all the way down by the
+// time the peak comes out, and it recovers smoothly afterwards.  All channels
+// share the gain, which keeps the stereo image in place.
+//
+// The stream is delayed by GetLatency() frames, which is bounded by the
+// look-ahead time plus the delay of the peak detector.
+class TruePeakLimiter
+{
+	static const size_t m_MaxRunSize;
+	static const double m_LookAheadTime;
+	static const double m_ReleaseTime;
+	static const double m_DefaultCeiling;
+
+	size_t m_NumChannels;
+	size_t m_HoldSize;
+	size_t m_Latency;
+	float m_Ceiling;
+	double m_ReleaseCoeff;
+
+	TruePeakDetector m_PeakDetector;
+
+	// Per channel, the last m_Latency inputs, followed by room for a run of
+	// up to m_MaxRunSize more
+	std::vector<std::vector<float> > m_Delay;
+
+	// Per frame of the current run
+	std::vector<float> m_Peaks;
+	std::vector<float> m_Gains;
+
+	// Minimum of the needed gains over the hold window, kept as a queue of
+	// the frames whose gains are increasing, in a ring of m_HoldSize + 1
+	std::vector<float> m_HoldGains;
+	std::vector<size_t> m_HoldFrames;
+	size_t m_HoldFront;
+	size_t m_HoldCount;
+	size_t m_Frame;
+
+	// The released gain, and the ring of its last values that are averaged
+	double m_Envelope;
+	std::vector<double> m_Average;
+	size_t m_AveragePos;
+	double m_AverageSum;
+
+	float Hold(float gain);
+	float Smooth(float gain);
+	void ProcessRun(AudioBlock & block, size_t start, size_t count);
+public:
+	// The ceiling is in dB relative to full scale
+	TruePeakLimiter(size_t numChannels, double sampleRate,
+			double ceiling = m_DefaultCeiling);
+	virtual ~TruePeakLimiter();
+
+	size_t GetLatency() const { return m_Latency; }
+	double GetCeiling() const;
+	void SetCeiling(double ceiling);
+
+	// Forgets the input so far, as though the stream were preceded by silence
+	void Reset();
+
+	// Limits the next block of the stream in place.  What comes out is
+	// GetLatency() frames behind what goes in.
+	void Process(AudioBlock & block);
+
+	// Returns the last GetLatency() frames of the stream, as though it were
+	// followed by silence, and resets the limiter
+	std::shared_ptr<AudioBlock> Flush();
+};
+
+#endif /* SRC_CORE_FILTERS_TRUEPEAKLIMITER_H_ */
@@ -1,5 +1,7 @@
 #include "AudioStretchInfo.h"
 #include "../AudioSink.h"
+#include "../xfade/BandSplitter.h"
+#include "../xfade/fademaps/FadeCurves.h"
 #include <cstring>
 
 AudioStretchInfo::AudioStretchInfo()
@@ -12,6 +14,22 @@ AudioStretchInfo::~AudioStretchInfo()
 {
 }
 
+void AudioStretchInfo::Reserve(size_t numFrames)
+{
+	m_Buffer.reserve(numFrames * AudioSink::Instance().getNumChannels());
+}
+
+void AudioStretchInfo::Clear()
+{
+	m_Buffer.clear();
+	m_LastOne = false;
+	m_TimeRatio = 1.0;
+	m_UseRefPos = false;
+	m_ReferencePos = 0;
+	m_UseComplementaryRefPos = false;
+	m_ComplementaryReferencePos = 0;
+}
+
 void AudioStretchInfo::AppendSamples(const AudioBlock & block, float scale,
 	size_t start, size_t end)
 {
@@ -32,6 +50,48 @@ void AudioStretchInfo::AppendSamples(const AudioBlock & block, float scale,
 	}
 }
 
+void AudioStretchInfo::AppendSamples(const AudioBlock & block,
+	const FadeCurveTable & curve, double volume, double volumeStep,
+	size_t start, size_t end)
+{
+	size_t numChannels = AudioSink::Instance().getNumChannels();
+	size_t theEnd = end == std::string::npos ? block.getNumSamples() : end;
+	size_t addCount = theEnd - start;
+	size_t sampleSize = m_Buffer.size() / numChannels;
+
+	size_t majIdx = numChannels * sampleSize;
+	m_Buffer.resize(majIdx + numChannels * addCount);
+	for (size_t k = 0; k < addCount; ++k)
+	{
+		float scale = curve(volume + k * volumeStep);
+		for (size_t ch = 0; ch != numChannels; ++ch)
+		{
+			m_Buffer[ch + majIdx] = scale * block.getSampleAtPosition(ch, start + k);
+		}
+		majIdx += numChannels;
+	}
+}
+
+void AudioStretchInfo::AppendSamples(const AudioBlock & block,
+	BandSplitter & splitter, double volume, double volumeStep, size_t start,
+	size_t end)
+{
+	size_t numChannels = AudioSink::Instance().getNumChannels();
+	size_t theEnd = end == std::string::npos ? block.getNumSamples() : end;
+	size_t majIdx = m_Buffer.size();
+	m_Buffer.resize(majIdx + numChannels * (theEnd - start));
+	splitter.Process(block, volume, volumeStep, start, theEnd,
+			m_Buffer.data() + majIdx);
+}
+
+void AudioStretchInfo::AppendSplitterTail(BandSplitter & splitter)
+{
+	size_t numChannels = AudioSink::Instance().getNumChannels();
+	size_t majIdx = m_Buffer.size();
+	m_Buffer.resize(majIdx + numChannels * splitter.GetLatency());
+	splitter.Flush(m_Buffer.data() + majIdx);
+}
+
 void AudioStretchInfo::AppendSample(const float * sample, float scale)
 {
 	size_t numChannels = AudioSink::Instance().getNumChannels();
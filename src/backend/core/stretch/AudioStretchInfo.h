@@ -6,6 +6,8 @@
 #include <string>
 
 class AudioBlock;
+class BandSplitter;
+class FadeCurveTable;
 
 class AudioStretchInfo
 {
@@ -21,8 +23,27 @@ public:
 	AudioStretchInfo();
 	virtual ~AudioStretchInfo();
 
+	// Makes room for the given number of frames, so that appending up to
+	// that many frames does not allocate
+	void Reserve(size_t numFrames);
+
+	// Resets all information, but keeps the memory of the sample buffer
+	void Clear();
+
 	void AppendSamples(const AudioBlock & block, float scale = 1.0,
 			size_t start = 0, size_t end = std::string::npos);
+	// Ramps the volume linearly from the given value, by the given step per
+	// frame, and scales each frame by the gain that the curve maps it to
+	void AppendSamples(const AudioBlock & block, const FadeCurveTable & curve,
+			double volume, double volumeStep, size_t start = 0,
+			size_t end = std::string::npos);
+	// The same ramp, but each band is scaled by its own curve in the
+	// splitter, so the frames come out GetLatency() frames late
+	void AppendSamples(const AudioBlock & block, BandSplitter & splitter,
+			double volume, double volumeStep, size_t start = 0,
+			size_t end = std::string::npos);
+	// Appends the frames that the splitter still holds back
+	void AppendSplitterTail(BandSplitter & splitter);
 	void AppendSample(const float * sample, float scale = 1.0);
 	std::shared_ptr<AudioBlock> GenerateBlock() const;
 
@@ -0,0 +1,98 @@
+#include "AudioStretchInfoRing.h"
+#include <chrono>
+#include <thread>
+
+const size_t AudioStretchInfoRing::m_DefaultCapacity = 64;
+
+AudioStretchInfoRing::AudioStretchInfoRing(size_t numFramesPerSlot,
+		size_t capacity)
+: m_Mask(0), m_WriteCount(0), m_ReadCount(0), m_Closed(false),
+  m_Discarding(false)
+{
+	size_t actualCapacity = 1;
+	while (actualCapacity < capacity)
+	{
+		actualCapacity <<= 1;
+	}
+	m_Mask = actualCapacity - 1;
+
+	m_Slots.resize(actualCapacity);
+	for (auto it = m_Slots.begin(); it != m_Slots.end(); ++it)
+	{
+		it->Reserve(numFramesPerSlot);
+	}
+	m_DiscardSlot.Reserve(numFramesPerSlot);
+}
+
+AudioStretchInfoRing::~AudioStretchInfoRing()
+{
+}
+
+void AudioStretchInfoRing::Backoff(unsigned int & numTries)
+{
+	// Spin briefly, then yield, then sleep
+	if (numTries < 64)
+	{
+		++numTries;
+		std::this_thread::yield();
+	}
+	else
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+}
+
+AudioStretchInfo & AudioStretchInfoRing::BeginWrite()
+{
+	size_t writeCount = m_WriteCount.load(std::memory_order_relaxed);
+	unsigned int numTries = 0;
+	while (!m_Closed.load(std::memory_order_acquire) &&
+			writeCount - m_ReadCount.load(std::memory_order_acquire) > m_Mask)
+	{
+		Backoff(numTries);
+	}
+	m_Discarding = m_Closed.load(std::memory_order_acquire);
+	AudioStretchInfo & slot = m_Discarding ? m_DiscardSlot :
+			m_Slots[writeCount & m_Mask];
+	slot.Clear();
+	return slot;
+}
+
+void AudioStretchInfoRing::CommitWrite()
+{
+	if (!m_Discarding)
+	{
+		m_WriteCount.store(m_WriteCount.load(std::memory_order_relaxed) + 1,
+				std::memory_order_release);
+	}
+}
+
+AudioStretchInfo & AudioStretchInfoRing::BeginRead()
+{
+	size_t readCount = m_ReadCount.load(std::memory_order_relaxed);
+	unsigned int numTries = 0;
+	while (m_WriteCount.load(std::memory_order_acquire) == readCount)
+	{
+		Backoff(numTries);
+	}
+	return m_Slots[readCount & m_Mask];
+}
+
+void AudioStretchInfoRing::EndRead()
+{
+	m_ReadCount.store(m_ReadCount.load(std::memory_order_relaxed) + 1,
+			std::memory_order_release);
+}
+
+void AudioStretchInfoRing::Close()
+{
+	m_Closed.store(true, std::memory_order_release);
+}
+
+void AudioStretchInfoRing::Reset()
+{
+	m_WriteCount.store(0);
+	m_ReadCount.store(0);
+	m_Closed.store(false);
+	m_Discarding = false;
+}
@@ -0,0 +1,58 @@
+#ifndef SRC_CORE_STRETCH_AUDIOSTRETCHINFORING_H_
+#define SRC_CORE_STRETCH_AUDIOSTRETCHINFORING_H_
+
+#include "AudioStretchInfo.h"
+#include <atomic>
+#include <vector>
+
+// A fixed-capacity single-producer, single-consumer ring of stretch
+// information chunks.  All slots are allocated up front and reused, so the
+// producer and the consumer exchange chunks without any allocation or
+// locking.  The producer waits while the ring is full, and the consumer
+// waits while it is empty.  A consumer that stops reading closes the ring,
+// so that the producer never waits for it: from then on, whatever the
+// producer writes goes to a spare slot and is dropped.
+class AudioStretchInfoRing
+{
+	static const size_t m_DefaultCapacity;
+
+	std::vector<AudioStretchInfo> m_Slots;
+	size_t m_Mask;
+
+	// Monotonically increasing counters; the slot is the counter masked by
+	// m_Mask
+	std::atomic<size_t> m_WriteCount;
+	std::atomic<size_t> m_ReadCount;
+
+	std::atomic<bool> m_Closed;
+	AudioStretchInfo m_DiscardSlot;
+	bool m_Discarding;
+
+	static void Backoff(unsigned int & numTries);
+
+	AudioStretchInfoRing(const AudioStretchInfoRing &) = delete;
+	AudioStretchInfoRing & operator=(const AudioStretchInfoRing &) = delete;
+public:
+	// The capacity is rounded up to a power of two
+	AudioStretchInfoRing(size_t numFramesPerSlot,
+			size_t capacity = m_DefaultCapacity);
+	virtual ~AudioStretchInfoRing();
+
+	// Producer side:  obtain an empty slot, fill it, then commit it
+	AudioStretchInfo & BeginWrite();
+	void CommitWrite();
+
+	// Consumer side:  obtain the oldest committed slot, and release it once
+	// it is no longer needed
+	AudioStretchInfo & BeginRead();
+	void EndRead();
+
+	// Consumer side:  stop reading for good (until the ring is reset)
+	void Close();
+
+	// Empties the ring and opens it again.  Must not be called while either
+	// side is active.
+	void Reset();
+};
+
+#endif /* SRC_CORE_STRETCH_AUDIOSTRETCHINFORING_H_ */
@@ -1,8 +1,13 @@
 #include "AudioStretcher.h"
 #include "AudioStretchInfo.h"
+#include "engines/RubberBandStretchEngine.h"
+#include "engines/VarispeedStretchEngine.h"
+#include "engines/WSOLAStretchEngine.h"
+#include "../xfade/BandSplitter.h"
 #include "../AudioBlock.h"
 #include "../AudioSink.h"
 #include <algorithm>
+#include <cmath>
 #include <string>
 #include <cstring>
 
@@ -10,110 +15,217 @@
 
 const size_t AudioStretcher::m_RubberbandBlockSize = 256;
 
+// Chunk size used by the crossfader; chunk slots are sized for it up front,
+// along with the tail that a band splitter adds to the last chunk of a track
+const size_t AudioStretcher::m_ChunkSize = 512;
+
 AudioStretcher::AudioStretcher()
-: m_Rotate(true), m_BufPos(0), m_BufLen(0), m_NumSIFrames(0),
-  m_RefPos(std::string::npos), m_RelRefPos(std::string::npos),
-  m_RefPosStretch(1.0), m_CompRefPos(std::string::npos),
-  m_RelCompRefPos(std::string::npos), m_EOS(false),
-  m_Latency(0), m_ConsumedLatency(0), m_PastInitialLatency(false),
-  m_FinalLatency(0)
+: m_StretchInfoRing(m_ChunkSize + BandSplitter::GetLatency()),
+  m_Engine(nullptr),
+  m_EngineType(ENGINE_RUBBERBAND), m_SampleRate(0), m_NumChannels(0),
+  m_StretchInfo(nullptr), m_Rotate(true), m_BufPos(0), m_BufLen(0), m_NumSIFrames(0),
+  m_EOS(false), m_HaveRatioCurve(false), m_EngineRatio(1.0),
+  m_RatioSpanEnd(0), m_InputPos(0),
+  m_OutputPos(0), m_OutputEnd(0), m_RefPos(std::string::npos),
+  m_CompRefPos(std::string::npos), m_Latency(0), m_ConsumedLatency(0),
+  m_PastInitialLatency(false)
 {
-	m_RBBuf.resize(AudioBufUtil::MaxAudioBufLen);
-	m_RBProcBuf = AudioBufUtil::NewAudioBuffer(AudioBufUtil::MaxAudioBufLen);
-	InitRubberband();
+	m_OutBuf.resize(AudioBufUtil::MaxAudioBufLen);
+	m_ProcBuf = AudioBufUtil::NewAudioBuffer(AudioBufUtil::MaxAudioBufLen);
+	InitEngines();
 }
 
 AudioStretcher::~AudioStretcher()
 {
-	AudioBufUtil::FreeAudioBuffer(m_RBProcBuf);
+	AudioBufUtil::FreeAudioBuffer(m_ProcBuf);
+}
+
+void AudioStretcher::InitEngines()
+{
+	m_SampleRate = AudioSink::Instance().getSampleRate();
+	m_NumChannels = AudioSink::Instance().getNumChannels();
+	m_RubberBandEngine.reset(new RubberBandStretchEngine(
+			m_SampleRate, m_NumChannels, m_RubberbandBlockSize));
+	m_NativeEngine.reset(new WSOLAStretchEngine(m_SampleRate, m_NumChannels));
+	m_VarispeedEngine.reset(new VarispeedStretchEngine(m_NumChannels));
+	SelectEngine(m_EngineType);
+}
+
+void AudioStretcher::SelectEngine(EngineType engineType)
+{
+	m_EngineType = engineType;
+	switch (engineType)
+	{
+	case ENGINE_NATIVE:
+		m_Engine = m_NativeEngine.get();
+		break;
+	case ENGINE_VARISPEED:
+		m_Engine = m_VarispeedEngine.get();
+		break;
+	default:
+		m_Engine = m_RubberBandEngine.get();
+		break;
+	}
+}
+
+void AudioStretcher::Reset()
+{
+	m_RubberBandEngine->Reset();
+	m_NativeEngine->Reset();
+	m_VarispeedEngine->Reset();
+	SelectEngine(ENGINE_RUBBERBAND);
+
+	m_StretchInfoRing.Reset();
+	m_StretchInfo = nullptr;
+	m_Block.reset();
+
+	m_Rotate = true;
+	m_BufPos = 0;
+	m_BufLen = 0;
+	m_NumSIFrames = 0;
+	m_EOS = false;
+	m_RatioCurve.Clear();
+	m_HaveRatioCurve = false;
+	m_EngineRatio = 1.0;
+	m_RatioSpanEnd = 0;
+	m_InputPos = 0;
+	m_OutputPos = 0;
+	m_OutputEnd = 0;
+	m_RefPos = std::string::npos;
+	m_CompRefPos = std::string::npos;
+	m_Latency = 0;
+	m_ConsumedLatency = 0;
+	m_PastInitialLatency = false;
+}
+
+void AudioStretcher::SetRatioCurve(const RatioCurve & curve)
+{
+	m_RatioCurve = curve;
+	m_HaveRatioCurve = true;
+}
+
+AudioStretchInfo & AudioStretcher::BeginAudioStretchInfo()
+{
+	return m_StretchInfoRing.BeginWrite();
 }
 
-void AudioStretcher::InitRubberband()
+void AudioStretcher::SubmitAudioStretchInfo()
 {
-	m_RBS.reset(new RubberBand::RubberBandStretcher(
-			AudioSink::Instance().getSampleRate(),
-			AudioSink::Instance().getNumChannels(),
-			RubberBand::RubberBandStretcher::OptionProcessRealTime));
-	m_RBS->setMaxProcessSize(m_RubberbandBlockSize);
-	// Minimize memory reallocations during audio playback by setting
-	// the time ratio to a modestly large value and then going back to
-	// unity
-	m_RBS->setTimeRatio(2.0);
-	m_RBS->setTimeRatio(1.0);
+	m_StretchInfoRing.CommitWrite();
 }
 
-void AudioStretcher::SubmitAudioStretchInfo(const std::shared_ptr<AudioStretchInfo> & stretchInfo)
+void AudioStretcher::StopReading()
 {
-	std::lock_guard<std::mutex> lck(m_AudioStretchInfoQueueMutex);
-	m_AudioStretchInfoQueue.push(stretchInfo);
-	m_AudioStretchInfoQueueCond.notify_all();
+	m_StretchInfoRing.Close();
 }
 
-std::shared_ptr<AudioStretchInfo> AudioStretcher::ObtainAudioStretchInfo()
+AudioStretchInfo & AudioStretcher::ObtainAudioStretchInfo()
 {
-	std::unique_lock<std::mutex> lck(m_AudioStretchInfoQueueMutex);
-	m_AudioStretchInfoQueueCond.wait(lck,
-			[this]{ return !m_AudioStretchInfoQueue.empty(); });
-	std::shared_ptr<AudioStretchInfo> item = m_AudioStretchInfoQueue.front();
-	m_AudioStretchInfoQueue.pop();
-	return item;
+	// Give the chunk we are done with back to the producer
+	if (m_StretchInfo != nullptr)
+	{
+		m_StretchInfoRing.EndRead();
+	}
+	return m_StretchInfoRing.BeginRead();
 }
 
-size_t AudioStretcher::GetFromRubberBand(float * buffer, size_t frames)
+size_t AudioStretcher::GetFromEngine(float * buffer, size_t frames)
 {
-	size_t framesAvailable = (size_t) m_RBS->available();
+	size_t framesAvailable = m_Engine->Available();
 	size_t framesToRead = std::min(framesAvailable, frames);
-	size_t framesReceived = m_RBS->retrieve(
-			(float * const *) m_RBProcBuf.data(), framesToRead);
+	size_t framesReceived = m_Engine->Retrieve(
+			(float * const *) m_ProcBuf.data(), framesToRead);
 	size_t numChannels = AudioSink::Instance().getNumChannels();
 	for (size_t ch = 0; ch < numChannels; ++ch)
 	{
 		for (size_t k = 0; k < framesReceived; ++k)
 		{
-			buffer[ch + k * numChannels] = m_RBProcBuf.at(ch)[k];
+			buffer[ch + k * numChannels] = m_ProcBuf.at(ch)[k];
 		}
 	}
 	return framesReceived;
 }
 
-void AudioStretcher::PutIntoRubberBand(const float * buffer, size_t frames, bool flush)
+void AudioStretcher::PutIntoEngine(const float * buffer, size_t frames, bool flush)
 {
 	size_t numChannels = AudioSink::Instance().getNumChannels();
 	for (size_t ch = 0; ch < numChannels; ++ch)
 	{
 		for (size_t k = 0; k < frames; ++k)
 		{
-			m_RBProcBuf.at(ch)[k] = buffer[ch + k * numChannels];
+			m_ProcBuf.at(ch)[k] = buffer[ch + k * numChannels];
 		}
 	}
-	m_RBS->process((const float * const *) m_RBProcBuf.data(), frames, flush);
+
+	if (m_InputPos == 0)
+	{
+		m_Latency = m_Engine->GetLatency();
+	}
+
+	m_Engine->Process((const float * const *) m_ProcBuf.data(), frames, flush);
+	m_InputPos += frames;
+	if (flush)
+	{
+		// Everything that was put in has come out once the output reaches
+		// the end of the input
+		m_OutputEnd = GetOutputPosOfInput(m_InputPos);
+	}
 }
 
-size_t AudioStretcher::ComputeRefPos(size_t stretchedSize, size_t & coarseRefPos, size_t & relRefPos)
+void AudioStretcher::UpdateEngineRatio(size_t chunkFrames)
 {
-	size_t refPos = std::string::npos;
-	if (coarseRefPos != std::string::npos)
+	// The blocks never reach past the end of the span (see
+	// LimitToRatioPoint), and the mean ratio over the span puts its end
+	// exactly where the curve does
+	if (m_InputPos >= m_RatioSpanEnd)
 	{
-		size_t theRefPos = coarseRefPos + m_RefPosStretch * relRefPos;
-		if (theRefPos >= stretchedSize)
+		m_RatioSpanEnd = m_InputPos + LimitToRatioPoint(chunkFrames);
+		double ratio = m_RatioCurve.GetRatioAt(m_InputPos);
+		if (m_RatioSpanEnd != m_InputPos)
 		{
-			refPos = std::string::npos;
-			coarseRefPos = 0;
-			relRefPos = (size_t)
-					((theRefPos - stretchedSize) / m_RefPosStretch);
+			ratio = (m_RatioCurve.GetOutputPosAt(m_RatioSpanEnd) -
+					m_RatioCurve.GetOutputPosAt(m_InputPos)) /
+					(m_RatioSpanEnd - m_InputPos);
 		}
-		else
+		if (ratio != m_EngineRatio)
 		{
-			refPos = theRefPos;
-			coarseRefPos = std::string::npos;
+			m_Engine->SetTimeRatio(ratio);
+			m_EngineRatio = ratio;
 		}
 	}
+}
+
+size_t AudioStretcher::LimitToRatioPoint(size_t frames) const
+{
+	double nextPoint = m_RatioCurve.GetNextPointAfter(m_InputPos);
+	if (nextPoint >= 0.0)
+	{
+		frames = std::min(frames,
+				(size_t) std::ceil(nextPoint) - m_InputPos);
+	}
+	return frames;
+}
+
+size_t AudioStretcher::GetOutputPosOfInput(size_t inputPos) const
+{
+	return (size_t) (m_RatioCurve.GetOutputPosAt(inputPos) + 0.5);
+}
+
+size_t AudioStretcher::ComputeRefPos(size_t stretchedSize, size_t & absRefPos)
+{
+	size_t refPos = std::string::npos;
+	if (absRefPos != std::string::npos &&
+			absRefPos < m_OutputPos + stretchedSize)
+	{
+		refPos = absRefPos > m_OutputPos ? absRefPos - m_OutputPos : 0;
+		absRefPos = std::string::npos;
+	}
 	return refPos;
 }
 
 const std::vector<float> & AudioStretcher::getStretchedAudio(size_t requestedStretchedSize, size_t & actualStretchedSize, size_t & refPos, size_t & compRefPos, bool & eos)
 {
-	float * readBuf = m_RBBuf.data();
+	float * readBuf = m_OutBuf.data();
 	size_t numChannels = AudioSink::Instance().getNumChannels();
 	size_t remainingCount = requestedStretchedSize / numChannels;
 	actualStretchedSize = 0;
@@ -123,20 +235,25 @@ const std::vector<float> & AudioStretcher::getStretchedAudio(size_t requestedStr
 	{
 		if (m_EOS)
 		{
-			remainingCount = std::min(remainingCount, m_FinalLatency);
+			size_t outputPos = m_OutputPos + actualStretchedSize;
+			remainingCount = std::min(remainingCount,
+					m_OutputEnd > outputPos ? m_OutputEnd - outputPos : 0);
 		}
-		size_t framesReturned = GetFromRubberBand(readBuf, remainingCount);
+		size_t framesRetrieved = GetFromEngine(readBuf, remainingCount);
+		size_t framesReturned = framesRetrieved;
 		if (m_Latency != 0 && !m_PastInitialLatency)
 		{
 			m_ConsumedLatency += framesReturned;
 			if (m_ConsumedLatency >= m_Latency)
 			{
+				// Only the frames past the latency are kept
 				m_PastInitialLatency = true;
 				size_t leftover = std::min(framesReturned,
 						m_ConsumedLatency - m_Latency);
-				framesReturned -= leftover;
-				memmove(readBuf, readBuf + leftover * numChannels,
-						framesReturned * numChannels * sizeof(float));
+				memmove(readBuf,
+						readBuf + (framesReturned - leftover) * numChannels,
+						leftover * numChannels * sizeof(float));
+				framesReturned = leftover;
 			}
 			else
 			{
@@ -152,73 +269,62 @@ const std::vector<float> & AudioStretcher::getStretchedAudio(size_t requestedStr
 
 		if (m_EOS)
 		{
-			if (framesReturned == 0 || (m_FinalLatency -= framesReturned) == 0)
+			if (framesRetrieved == 0 ||
+					m_OutputPos + actualStretchedSize >= m_OutputEnd)
 			{
 				eos = true;
-				m_RBS->reset();
+				m_Engine->Reset();
 				remainingCount = 0;
 			}
 		}
 		else
 		{
-			size_t numFramesRequired = m_RBS->getSamplesRequired();
-			if (numFramesRequired == 0)
+			size_t numFramesRequired = m_Engine->GetSamplesRequired();
+			if (numFramesRequired == 0 && m_Engine->Available() == 0)
 			{
-				int available = m_RBS->available();
-				if (available == 0)
-				{
-					numFramesRequired = m_RubberbandBlockSize;
-				}
+				numFramesRequired = m_RubberbandBlockSize;
 			}
 
 			if (remainingCount > 0 && numFramesRequired > 0)
 			{
 				if (m_Rotate)
 				{
-					m_StretchInfo = ObtainAudioStretchInfo();
-					m_RefPosStretch = m_StretchInfo->GetTimeRatio();
+					m_StretchInfo = &ObtainAudioStretchInfo();
 					m_NumSIFrames =
 							m_StretchInfo->GetBuffer().size() / numChannels;
-					m_RBS->setTimeRatio(m_StretchInfo->GetTimeRatio());
-					if (m_Latency == 0 || m_PastInitialLatency)
-					{
-						m_Latency = m_RBS->getLatency();
-						if (m_PastInitialLatency)
-						{
-							m_FinalLatency = m_Latency;
-						}
-					}
-					else
+					if (!m_HaveRatioCurve)
 					{
-						m_Latency = m_ConsumedLatency +
-								((m_ConsumedLatency - m_Latency)
-								* m_RBS->getLatency()) / m_Latency;
+						m_RatioCurve.AddStep(m_InputPos,
+								m_StretchInfo->GetTimeRatio());
 					}
 					m_BufPos = 0;
-					m_BufLen = std::min(m_NumSIFrames, numFramesRequired);
+					m_BufLen = LimitToRatioPoint(
+							std::min(m_NumSIFrames, numFramesRequired));
 					if (m_RefPos == std::string::npos &&
 							m_StretchInfo->IsUsingRefPos())
 					{
-						m_RefPos = actualStretchedSize;
-						m_RelRefPos = m_StretchInfo->GetReferencePos();
+						m_RefPos = GetOutputPosOfInput(m_InputPos +
+								m_StretchInfo->GetReferencePos());
 					}
 					if (m_CompRefPos == std::string::npos &&
 							m_StretchInfo->IsUsingComplementaryRefPos())
 					{
-						m_CompRefPos = actualStretchedSize;
-						m_RelCompRefPos =
-								m_StretchInfo->GetComplementaryReferencePos();
+						m_CompRefPos = GetOutputPosOfInput(m_InputPos +
+								m_StretchInfo->GetComplementaryReferencePos());
 					}
 				}
 				else
 				{
 					m_BufPos += m_BufLen;
 					m_BufLen = m_BufPos > m_NumSIFrames ? 0 :
-						std::min(m_NumSIFrames - m_BufPos, numFramesRequired);
+						LimitToRatioPoint(std::min(m_NumSIFrames - m_BufPos,
+								numFramesRequired));
 				}
 				m_Rotate = m_BufPos + m_BufLen >= m_NumSIFrames;
 				m_EOS = m_Rotate && m_StretchInfo->IsLastOne();
-				PutIntoRubberBand(
+				UpdateEngineRatio(m_NumSIFrames > m_BufPos ?
+						m_NumSIFrames - m_BufPos : 0);
+				PutIntoEngine(
 					m_StretchInfo->GetBuffer().data() + m_BufPos * numChannels,
 					m_BufLen, m_EOS);
 			}
@@ -227,12 +333,12 @@ const std::vector<float> & AudioStretcher::getStretchedAudio(size_t requestedStr
 
 	if (!m_EOS)
 	{
-		refPos = ComputeRefPos(actualStretchedSize, m_RefPos, m_RelRefPos);
-		compRefPos = ComputeRefPos(actualStretchedSize, m_CompRefPos,
-				m_RelCompRefPos);
+		refPos = ComputeRefPos(actualStretchedSize, m_RefPos);
+		compRefPos = ComputeRefPos(actualStretchedSize, m_CompRefPos);
 	}
+	m_OutputPos += actualStretchedSize;
 
-	return m_RBBuf;
+	return m_OutBuf;
 }
 
 std::shared_ptr<AudioBlock> AudioStretcher::getStretchedAudioAsBlock(size_t requestedStretchedSize, size_t & refPos, size_t & compRefPos, bool & eos)
@@ -2,58 +2,116 @@
 #define SRC_CORE_STRETCH_AUDIOSTRETCHER_H_
 
 #include "../../util/AudioBufUtil.h"
-#include <rubberband/RubberBandStretcher.h>
+#include "AudioStretchInfoRing.h"
+#include "RatioCurve.h"
 #include <memory>
-#include <queue>
-#include <mutex>
-#include <condition_variable>
 
 class AudioBlock;
-class AudioStretchInfo;
+class StretchEngine;
 
 class AudioStretcher
 {
+public:
+	enum EngineType
+	{
+		ENGINE_RUBBERBAND,
+		ENGINE_NATIVE,
+		ENGINE_VARISPEED
+	};
+
+private:
 	static const size_t m_RubberbandBlockSize;
+	static const size_t m_ChunkSize;
 
-	std::mutex m_AudioStretchInfoQueueMutex;
-	std::queue<std::shared_ptr<AudioStretchInfo> > m_AudioStretchInfoQueue;
-	std::condition_variable m_AudioStretchInfoQueueCond;
+	AudioStretchInfoRing m_StretchInfoRing;
 
-	std::unique_ptr<RubberBand::RubberBandStretcher> m_RBS;
-	std::shared_ptr<AudioStretchInfo> m_StretchInfo;
+	// Both engines are created up front, so switching between them never
+	// allocates
+	std::unique_ptr<StretchEngine> m_RubberBandEngine;
+	std::unique_ptr<StretchEngine> m_NativeEngine;
+	std::unique_ptr<StretchEngine> m_VarispeedEngine;
+	StretchEngine * m_Engine;
+	EngineType m_EngineType;
+	int m_SampleRate;
+	int m_NumChannels;
+	AudioStretchInfo * m_StretchInfo;
 	std::shared_ptr<AudioBlock> m_Block;
-	std::vector<float> m_RBBuf;
-	AudioBuf m_RBProcBuf;
+	std::vector<float> m_OutBuf;
+	AudioBuf m_ProcBuf;
 	bool m_Rotate;
 	size_t m_BufPos;
 	size_t m_BufLen;
 	size_t m_NumSIFrames;
+	bool m_EOS;
+
+	// The ratio over the whole input, either given up front or built up from
+	// the ratios of the chunks as they come in.  The engine holds one ratio
+	// from the start of each chunk up to the end of the chunk or the next
+	// point of the curve, whichever comes first, which is the mean of the
+	// curve over that span.  It is only given a new ratio when that changes.
+	RatioCurve m_RatioCurve;
+	bool m_HaveRatioCurve;
+	double m_EngineRatio;
+	size_t m_RatioSpanEnd;
+
+	// Frames put into the engine, and frames given out (not counting the
+	// latency), since the stretcher was reset.  The reference positions and
+	// the end of the output are positions in the output, which are found on
+	// the ratio curve.
+	size_t m_InputPos;
+	size_t m_OutputPos;
+	size_t m_OutputEnd;
 	size_t m_RefPos;
-	size_t m_RelRefPos;
-	double m_RefPosStretch;
 	size_t m_CompRefPos;
-	size_t m_RelCompRefPos;
-	bool m_EOS;
+
+	// The latency is fixed by the ratio the engine starts out with
 	size_t m_Latency;
 	size_t m_ConsumedLatency;
 	bool m_PastInitialLatency;
-	size_t m_FinalLatency;
 
-	size_t GetFromRubberBand(float * buffer, size_t frames);
-	void PutIntoRubberBand(const float * buffer, size_t frames, bool flush);
+	size_t GetFromEngine(float * buffer, size_t frames);
+	void UpdateEngineRatio(size_t chunkFrames);
+	void PutIntoEngine(const float * buffer, size_t frames, bool flush);
+	size_t LimitToRatioPoint(size_t frames) const;
+	size_t GetOutputPosOfInput(size_t inputPos) const;
 
-	std::shared_ptr<AudioStretchInfo> ObtainAudioStretchInfo();
-	size_t ComputeRefPos(size_t stretchedSize, size_t & coarseRefPos, size_t & relRefPos);
+	AudioStretchInfo & ObtainAudioStretchInfo();
+	size_t ComputeRefPos(size_t stretchedSize, size_t & absRefPos);
 public:
 	AudioStretcher();
 	virtual ~AudioStretcher();
 
-	void InitRubberband();
+	void InitEngines();
+
+	// Brings the stretcher back to its freshly constructed state without
+	// giving up any of its memory.  This also selects RubberBand again.
+	void Reset();
+
+	// Chooses the engine that stretches the audio.  Must not be called once
+	// the stretcher has been given audio (until it is reset).
+	void SelectEngine(EngineType engineType);
+	EngineType getEngineType() const { return m_EngineType; }
 
-	void SubmitAudioStretchInfo(const std::shared_ptr<AudioStretchInfo> & stretchInfo);
+	// Gives the ratio over the whole input up front, in frames from the first
+	// frame that is submitted.  The ratios of the chunks are then ignored.
+	// Must be called before the first chunk is submitted.
+	void SetRatioCurve(const RatioCurve & curve);
+
+	int getSampleRate() const { return m_SampleRate; }
+	int getNumChannels() const { return m_NumChannels; }
+
+	// Producer side (one thread only):  obtain a chunk to fill in, then
+	// submit it.  Waits while too many chunks are outstanding.
+	AudioStretchInfo & BeginAudioStretchInfo();
+	void SubmitAudioStretchInfo();
 
 	const std::vector<float> & getStretchedAudio(size_t requestedStretchedSize, size_t & actualStretchedSize, size_t & refPos, size_t & compRefPos, bool & eos);
 	std::shared_ptr<AudioBlock> getStretchedAudioAsBlock(size_t requestedStretchedSize, size_t & refPos, size_t & compRefPos, bool & eos);
+
+	// Consumer side:  no more stretched audio is read (until the stretcher is
+	// reset).  The producer is no longer held up, and what it submits from
+	// then on is dropped.
+	void StopReading();
 };
 
 #endif /* SRC_CORE_STRETCH_AUDIOSTRETCHER_H_ */
@@ -0,0 +1,77 @@
+#include "AudioStretcherPool.h"
+#include "AudioStretcher.h"
+#include "../AudioSink.h"
+
+AudioStretcherPool::AudioStretcherPool()
+: m_SampleRate(0), m_NumChannels(0)
+{
+}
+
+AudioStretcherPool::~AudioStretcherPool()
+{
+}
+
+AudioStretcherPool & AudioStretcherPool::Instance()
+{
+	static AudioStretcherPool inst;
+	return inst;
+}
+
+void AudioStretcherPool::DiscardIfSinkChanged()
+{
+	// Must be called with m_PoolMutex held.  Stretchers are configured for
+	// the sample rate and channel count of the sink at the time they were
+	// created, so they cannot be reused once those change.
+	int sampleRate = AudioSink::Instance().getSampleRate();
+	int numChannels = AudioSink::Instance().getNumChannels();
+	if (sampleRate != m_SampleRate || numChannels != m_NumChannels)
+	{
+		m_Stretchers.clear();
+		m_SampleRate = sampleRate;
+		m_NumChannels = numChannels;
+	}
+}
+
+void AudioStretcherPool::Prewarm(size_t numStretchers)
+{
+	std::lock_guard<std::mutex> lck(m_PoolMutex);
+	DiscardIfSinkChanged();
+	while (m_Stretchers.size() < numStretchers)
+	{
+		m_Stretchers.emplace_back(new AudioStretcher);
+	}
+}
+
+std::unique_ptr<AudioStretcher> AudioStretcherPool::Acquire()
+{
+	std::unique_ptr<AudioStretcher> stretcher;
+	{
+		std::lock_guard<std::mutex> lck(m_PoolMutex);
+		DiscardIfSinkChanged();
+		if (!m_Stretchers.empty())
+		{
+			stretcher = std::move(m_Stretchers.back());
+			m_Stretchers.pop_back();
+		}
+	}
+	if (stretcher == nullptr)
+	{
+		stretcher.reset(new AudioStretcher);
+	}
+	return stretcher;
+}
+
+void AudioStretcherPool::Release(std::unique_ptr<AudioStretcher> && stretcher)
+{
+	if (stretcher != nullptr)
+	{
+		stretcher->Reset();
+		std::lock_guard<std::mutex> lck(m_PoolMutex);
+		if (stretcher->getSampleRate() == m_SampleRate &&
+				stretcher->getNumChannels() == m_NumChannels)
+		{
+			m_Stretchers.push_back(std::move(stretcher));
+		}
+		stretcher.reset();
+	}
+}
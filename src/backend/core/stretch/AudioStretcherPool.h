@@ -0,0 +1,38 @@
+#ifndef SRC_CORE_STRETCH_AUDIOSTRETCHERPOOL_H_
+#define SRC_CORE_STRETCH_AUDIOSTRETCHERPOOL_H_
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class AudioStretcher;
+
+// A pool of ready-to-use audio stretchers.  Creating a stretcher is costly
+// (large buffers and the RubberBand FFT setup), so stretchers are created
+// ahead of time and are reset and reused after each crossfade.
+class AudioStretcherPool
+{
+	std::mutex m_PoolMutex;
+	std::vector<std::unique_ptr<AudioStretcher> > m_Stretchers;
+	int m_SampleRate;
+	int m_NumChannels;
+
+	void DiscardIfSinkChanged();
+
+	AudioStretcherPool();
+public:
+	virtual ~AudioStretcherPool();
+
+	static AudioStretcherPool & Instance();
+
+	// Makes sure that at least the given number of stretchers are available
+	void Prewarm(size_t numStretchers);
+
+	// Hands out a stretcher from the pool, or a new one if the pool is empty
+	std::unique_ptr<AudioStretcher> Acquire();
+
+	// Resets the stretcher and returns it to the pool
+	void Release(std::unique_ptr<AudioStretcher> && stretcher);
+};
+
+#endif /* SRC_CORE_STRETCH_AUDIOSTRETCHERPOOL_H_ */
@@ -0,0 +1,135 @@
+#include "RatioCurve.h"
+#include <algorithm>
+
+RatioCurve::RatioCurve()
+{
+}
+
+RatioCurve::~RatioCurve()
+{
+}
+
+void RatioCurve::Clear()
+{
+	m_Points.clear();
+}
+
+size_t RatioCurve::FindPoint(double inputPos) const
+{
+	// Of several points at the same position, the last one is found, so a
+	// step takes effect right at its position
+	std::vector<Point>::const_iterator it = std::upper_bound(
+			m_Points.begin(), m_Points.end(), inputPos,
+			[] (double pos, const Point & point)
+			{
+				return pos < point.m_InputPos;
+			});
+	return (it - m_Points.begin()) - 1;
+}
+
+void RatioCurve::AddPoint(double inputPos, double ratio)
+{
+	Point point;
+	point.m_InputPos = inputPos;
+	point.m_Ratio = ratio;
+	if (m_Points.empty())
+	{
+		// The first ratio is held from the start of the input
+		point.m_OutputPos = inputPos * ratio;
+	}
+	else
+	{
+		const Point & prev = m_Points.back();
+		point.m_OutputPos = prev.m_OutputPos + (inputPos - prev.m_InputPos) *
+				0.5 * (prev.m_Ratio + ratio);
+	}
+	m_Points.push_back(point);
+}
+
+void RatioCurve::AddStep(double inputPos, double ratio)
+{
+	if (m_Points.empty())
+	{
+		AddPoint(inputPos, ratio);
+	}
+	else if (ratio != m_Points.back().m_Ratio)
+	{
+		AddPoint(inputPos, m_Points.back().m_Ratio);
+		AddPoint(inputPos, ratio);
+	}
+}
+
+double RatioCurve::GetRatioAt(double inputPos) const
+{
+	double rv;
+	if (m_Points.empty())
+	{
+		rv = 1.0;
+	}
+	else if (inputPos < m_Points.front().m_InputPos)
+	{
+		rv = m_Points.front().m_Ratio;
+	}
+	else
+	{
+		size_t index = FindPoint(inputPos);
+		const Point & prev = m_Points[index];
+		if (index + 1 == m_Points.size())
+		{
+			rv = prev.m_Ratio;
+		}
+		else
+		{
+			// The next point lies strictly after the input position, so the
+			// span is never zero
+			const Point & next = m_Points[index + 1];
+			rv = prev.m_Ratio + (inputPos - prev.m_InputPos) /
+					(next.m_InputPos - prev.m_InputPos) *
+					(next.m_Ratio - prev.m_Ratio);
+		}
+	}
+	return rv;
+}
+
+double RatioCurve::GetNextPointAfter(double inputPos) const
+{
+	double rv = -1.0;
+	if (!m_Points.empty())
+	{
+		if (inputPos < m_Points.front().m_InputPos)
+		{
+			rv = m_Points.front().m_InputPos;
+		}
+		else
+		{
+			size_t index = FindPoint(inputPos);
+			if (index + 1 != m_Points.size())
+			{
+				rv = m_Points[index + 1].m_InputPos;
+			}
+		}
+	}
+	return rv;
+}
+
+double RatioCurve::GetOutputPosAt(double inputPos) const
+{
+	double rv;
+	if (m_Points.empty())
+	{
+		rv = inputPos;
+	}
+	else if (inputPos < m_Points.front().m_InputPos)
+	{
+		rv = inputPos * m_Points.front().m_Ratio;
+	}
+	else
+	{
+		// The ratio is linear within the segment, so its integral over the
+		// part of the segment up to the input position is exact
+		const Point & prev = m_Points[FindPoint(inputPos)];
+		rv = prev.m_OutputPos + (inputPos - prev.m_InputPos) *
+				0.5 * (prev.m_Ratio + GetRatioAt(inputPos));
+	}
+	return rv;
+}
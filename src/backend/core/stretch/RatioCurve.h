@@ -0,0 +1,54 @@
+#ifndef SRC_CORE_STRETCH_RATIOCURVE_H_
+#define SRC_CORE_STRETCH_RATIOCURVE_H_
+
+#include <cstddef>
+#include <vector>
+
+// The time ratio of a stretcher over the whole of its input, given up front
+// so that the stretcher does not have to be reconfigured chunk by chunk.
+//
+// The curve is made of points (input frame, ratio) and is linear between
+// them; a step is made of two points at the same input frame.  Before the
+// first point and after the last one, the ratio is held.  Along with each
+// point, the integral of the ratio up to it is kept, which is the position
+// in the output (once the latency is discarded) where that input frame comes
+// out.
+class RatioCurve
+{
+	struct Point
+	{
+		double m_InputPos;
+		double m_Ratio;
+		double m_OutputPos;
+	};
+
+	std::vector<Point> m_Points;
+
+	// Index of the last point at or before the given input position; the
+	// caller guarantees that there is one
+	size_t FindPoint(double inputPos) const;
+public:
+	RatioCurve();
+	virtual ~RatioCurve();
+
+	void Clear();
+	bool empty() const { return m_Points.empty(); }
+
+	// Points must be added in order of their input positions
+	void AddPoint(double inputPos, double ratio);
+
+	// Holds the ratio up to the given input position, then switches to the
+	// given ratio
+	void AddStep(double inputPos, double ratio);
+
+	double GetRatioAt(double inputPos) const;
+
+	// Input position of the first point after the given position, or a
+	// negative value if there is none (the ratio is held from there on)
+	double GetNextPointAfter(double inputPos) const;
+
+	// Position in the output where the given input position comes out
+	double GetOutputPosAt(double inputPos) const;
+};
+
+#endif /* SRC_CORE_STRETCH_RATIOCURVE_H_ */
@@ -0,0 +1,57 @@
+#include "RubberBandStretchEngine.h"
+
+RubberBandStretchEngine::RubberBandStretchEngine(int sampleRate,
+		int numChannels, size_t maxProcessSize)
+: m_RBS(new RubberBand::RubberBandStretcher(sampleRate, numChannels,
+		RubberBand::RubberBandStretcher::OptionProcessRealTime))
+{
+	m_RBS->setMaxProcessSize(maxProcessSize);
+	// Minimize memory reallocations during audio playback by setting
+	// the time ratio to a modestly large value and then going back to
+	// unity
+	m_RBS->setTimeRatio(2.0);
+	m_RBS->setTimeRatio(1.0);
+}
+
+RubberBandStretchEngine::~RubberBandStretchEngine()
+{
+}
+
+void RubberBandStretchEngine::Reset()
+{
+	m_RBS->reset();
+	m_RBS->setTimeRatio(1.0);
+}
+
+void RubberBandStretchEngine::SetTimeRatio(double ratio)
+{
+	m_RBS->setTimeRatio(ratio);
+}
+
+size_t RubberBandStretchEngine::GetLatency() const
+{
+	return m_RBS->getLatency();
+}
+
+size_t RubberBandStretchEngine::GetSamplesRequired() const
+{
+	return m_RBS->getSamplesRequired();
+}
+
+size_t RubberBandStretchEngine::Available() const
+{
+	// RubberBand reports -1 once it has been flushed and drained
+	int available = m_RBS->available();
+	return available < 0 ? 0 : (size_t) available;
+}
+
+void RubberBandStretchEngine::Process(const float * const * input,
+		size_t frames, bool final)
+{
+	m_RBS->process(input, frames, final);
+}
+
+size_t RubberBandStretchEngine::Retrieve(float * const * output, size_t frames)
+{
+	return m_RBS->retrieve(output, frames);
+}
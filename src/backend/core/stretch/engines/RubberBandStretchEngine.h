@@ -0,0 +1,29 @@
+#ifndef SRC_CORE_STRETCH_ENGINES_RUBBERBANDSTRETCHENGINE_H_
+#define SRC_CORE_STRETCH_ENGINES_RUBBERBANDSTRETCHENGINE_H_
+
+#include "StretchEngine.h"
+#include <rubberband/RubberBandStretcher.h>
+#include <memory>
+
+// High quality time stretching with RubberBand's real-time mode.  This is
+// the engine to use for large or rapidly changing ratios, but it costs
+// noticeably more CPU than the native engine.
+class RubberBandStretchEngine: public StretchEngine
+{
+	std::unique_ptr<RubberBand::RubberBandStretcher> m_RBS;
+public:
+	RubberBandStretchEngine(int sampleRate, int numChannels,
+			size_t maxProcessSize);
+	virtual ~RubberBandStretchEngine();
+
+	virtual void Reset();
+	virtual void SetTimeRatio(double ratio);
+	virtual size_t GetLatency() const;
+	virtual size_t GetSamplesRequired() const;
+	virtual size_t Available() const;
+	virtual void Process(const float * const * input, size_t frames,
+			bool final);
+	virtual size_t Retrieve(float * const * output, size_t frames);
+};
+
+#endif /* SRC_CORE_STRETCH_ENGINES_RUBBERBANDSTRETCHENGINE_H_ */
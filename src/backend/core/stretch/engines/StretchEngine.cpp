@@ -0,0 +1,9 @@
+#include "StretchEngine.h"
+
+StretchEngine::StretchEngine()
+{
+}
+
+StretchEngine::~StretchEngine()
+{
+}
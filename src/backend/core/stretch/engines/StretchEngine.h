@@ -0,0 +1,40 @@
+#ifndef SRC_CORE_STRETCH_ENGINES_STRETCHENGINE_H_
+#define SRC_CORE_STRETCH_ENGINES_STRETCHENGINE_H_
+
+#include <cstddef>
+
+// A real-time time stretcher working on planar (one buffer per channel)
+// audio.  The interface follows the part of RubberBand's real-time API that
+// AudioStretcher needs, so that AudioStretcher can drive any engine the same
+// way: it sets the time ratio (output duration over input duration), feeds
+// the engine as many frames as it asks for, and takes out whatever is
+// available.  The first GetLatency() frames that come out precede the
+// stretched input and are discarded by the caller.
+class StretchEngine
+{
+public:
+	StretchEngine();
+	virtual ~StretchEngine();
+
+	// Brings the engine back to its freshly constructed state without giving
+	// up any of its memory
+	virtual void Reset() = 0;
+
+	virtual void SetTimeRatio(double ratio) = 0;
+	virtual size_t GetLatency() const = 0;
+
+	// Number of input frames needed before more output can be produced
+	virtual size_t GetSamplesRequired() const = 0;
+
+	// Number of output frames that can be retrieved right away
+	virtual size_t Available() const = 0;
+
+	// Once the final block has been processed, everything that is still held
+	// by the engine is made available, and no more input may be processed
+	// until the engine is reset
+	virtual void Process(const float * const * input, size_t frames,
+			bool final) = 0;
+	virtual size_t Retrieve(float * const * output, size_t frames) = 0;
+};
+
+#endif /* SRC_CORE_STRETCH_ENGINES_STRETCHENGINE_H_ */
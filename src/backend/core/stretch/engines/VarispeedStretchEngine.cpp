@@ -0,0 +1,264 @@
+#include "VarispeedStretchEngine.h"
+#include "../../../util/MathConstants.h"
+#include <algorithm>
+#include <cmath>
+
+// Zero crossings of the sinc on either side of the center at full bandwidth
+const size_t VarispeedStretchEngine::m_NumZeroCrossings = 8;
+
+// Table entries per zero crossing
+const size_t VarispeedStretchEngine::m_TableResolution = 128;
+
+// Input frames on either side of the output frame that go into it.  Twice
+// the number of zero crossings leaves room for the impulse response to
+// widen as the cutoff is lowered (down to half the bandwidth).
+const size_t VarispeedStretchEngine::m_HalfWidth = 16;
+
+// Fraction of the bandwidth that is kept, leaving room for the transition
+// band of the filter
+const float VarispeedStretchEngine::m_Rolloff = 0.95f;
+
+// Input is asked for in blocks of this many frames, rather than just as much
+// as the next output frame needs, so that it is not fed a frame at a time
+const size_t VarispeedStretchEngine::m_BlockSize = 256;
+
+VarispeedStretchEngine::VarispeedStretchEngine(int numChannels)
+: m_NumChannels(numChannels), m_InputStart(0), m_InputEnd(0),
+  m_FlushEnd(0), m_Final(false), m_Time(0.0), m_Ratio(1.0)
+{
+	// Blackman-windowed sinc, tabulated from the center out to the last zero
+	// crossing (where the window reaches zero)
+	size_t tableSize = m_NumZeroCrossings * m_TableResolution;
+	m_ImpulseTable.resize(tableSize + 1);
+	for (size_t k = 0; k <= tableSize; ++k)
+	{
+		double x = k / (double) m_TableResolution;
+		double u = k / (double) tableSize;
+		double sinc = k == 0 ? 1.0 : sin(MathConstants::Pi * x) /
+				(MathConstants::Pi * x);
+		double window = 0.42 + 0.5 * cos(MathConstants::Pi * u) +
+				0.08 * cos(2.0 * MathConstants::Pi * u);
+		m_ImpulseTable[k] = (float) (sinc * window);
+	}
+	m_ImpulseTable[tableSize] = 0.0f;
+	m_ImpulseDeltas.resize(tableSize + 1);
+	for (size_t k = 0; k != tableSize; ++k)
+	{
+		m_ImpulseDeltas[k] = m_ImpulseTable[k + 1] - m_ImpulseTable[k];
+	}
+	m_ImpulseDeltas[tableSize] = 0.0f;
+	m_Taps.resize(2 * m_HalfWidth);
+
+	// Reserve enough room up front that playback does not have to allocate
+	m_Input.resize(m_NumChannels);
+	m_Output.resize(m_NumChannels);
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		m_Input[ch].reserve(4096);
+		m_Output[ch].reserve(4096);
+	}
+	m_RatioChanges.reserve(16);
+
+	Reset();
+}
+
+VarispeedStretchEngine::~VarispeedStretchEngine()
+{
+}
+
+void VarispeedStretchEngine::Reset()
+{
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		m_Input[ch].assign(m_HalfWidth, 0.0f);
+		m_Output[ch].clear();
+	}
+	m_InputStart = 0;
+	m_InputEnd = m_HalfWidth;
+	m_FlushEnd = 0;
+	m_Final = false;
+	m_Time = m_HalfWidth;
+	m_Ratio = 1.0;
+	m_RatioChanges.clear();
+}
+
+void VarispeedStretchEngine::SetTimeRatio(double ratio)
+{
+	if (ratio > 0.0 && !m_Final)
+	{
+		if (!m_RatioChanges.empty() &&
+				m_RatioChanges.back().first == m_InputEnd)
+		{
+			m_RatioChanges.back().second = ratio;
+		}
+		else
+		{
+			m_RatioChanges.push_back(std::make_pair(m_InputEnd, ratio));
+		}
+	}
+}
+
+size_t VarispeedStretchEngine::GetLatency() const
+{
+	return 0;
+}
+
+bool VarispeedStretchEngine::CanProduceFrame() const
+{
+	bool flushed = m_Final && m_Time >= m_FlushEnd;
+	return !flushed && (size_t) m_Time + m_HalfWidth < m_InputEnd;
+}
+
+size_t VarispeedStretchEngine::GetSamplesRequired() const
+{
+	size_t rv = 0;
+	if (!m_Final)
+	{
+		size_t requiredEnd = (size_t) m_Time + m_HalfWidth + 1;
+		if (requiredEnd > m_InputEnd)
+		{
+			rv = requiredEnd - m_InputEnd + m_BlockSize - 1;
+		}
+	}
+	return rv;
+}
+
+size_t VarispeedStretchEngine::Available() const
+{
+	return m_Output.empty() ? 0 : m_Output[0].size();
+}
+
+size_t VarispeedStretchEngine::ComputeTaps(double frac, float cutoff)
+{
+	// The impulse response is stretched by the inverse of the cutoff, and
+	// scaled by the cutoff so that the gain stays at unity.  Only the taps
+	// that fall within the impulse response are computed; they are centered
+	// in m_Taps, and their count is returned.
+	const float tableScale = cutoff * m_TableResolution;
+	const size_t tableSize = m_NumZeroCrossings * m_TableResolution;
+	size_t halfCount = std::min(m_HalfWidth,
+			(size_t) ceil(m_NumZeroCrossings / cutoff));
+	size_t first = m_HalfWidth - halfCount;
+
+	// Frames at and before the output position, and then after it
+	float x = (float) (halfCount - 1 + frac) * tableScale;
+	for (size_t k = first; k != m_HalfWidth; ++k, x -= tableScale)
+	{
+		size_t index = (size_t) x;
+		m_Taps[k] = index < tableSize ? cutoff * (m_ImpulseTable[index] +
+				(x - index) * m_ImpulseDeltas[index]) : 0.0f;
+	}
+	x = (float) (1.0 - frac) * tableScale;
+	for (size_t k = m_HalfWidth; k != m_HalfWidth + halfCount;
+			++k, x += tableScale)
+	{
+		size_t index = (size_t) x;
+		m_Taps[k] = index < tableSize ? cutoff * (m_ImpulseTable[index] +
+				(x - index) * m_ImpulseDeltas[index]) : 0.0f;
+	}
+	return 2 * halfCount;
+}
+
+void VarispeedStretchEngine::ProduceFrame()
+{
+	while (!m_RatioChanges.empty() && m_RatioChanges.front().first <= m_Time)
+	{
+		m_Ratio = m_RatioChanges.front().second;
+		m_RatioChanges.erase(m_RatioChanges.begin());
+	}
+
+	size_t pos = (size_t) m_Time;
+	double frac = m_Time - pos;
+	size_t offset = pos - m_InputStart;
+	if (frac == 0.0 && m_Ratio == 1.0)
+	{
+		// Until the ratio first changes, the input passes through untouched
+		for (int ch = 0; ch != m_NumChannels; ++ch)
+		{
+			m_Output[ch].push_back(m_Input[ch][offset]);
+		}
+	}
+	else
+	{
+		float cutoff = m_Rolloff * (float) std::min(m_Ratio, 1.0);
+		cutoff = std::max(cutoff,
+				m_NumZeroCrossings / (float) m_HalfWidth);
+		size_t numTaps = ComputeTaps(frac, cutoff);
+		size_t firstTap = m_HalfWidth - numTaps / 2;
+
+		const float * taps = m_Taps.data() + firstTap;
+		for (int ch = 0; ch != m_NumChannels; ++ch)
+		{
+			const float * input = m_Input[ch].data() + offset + 1 -
+					m_HalfWidth + firstTap;
+			float sum = 0.0f;
+			for (size_t k = 0; k != numTaps; ++k)
+			{
+				sum += taps[k] * input[k];
+			}
+			m_Output[ch].push_back(sum);
+		}
+	}
+	m_Time += 1.0 / m_Ratio;
+}
+
+void VarispeedStretchEngine::DiscardInput()
+{
+	// Input is only discarded in large pieces to keep the copying down
+	size_t keepFrom = (size_t) m_Time + 1 - m_HalfWidth;
+	if (keepFrom >= m_InputStart + 1024)
+	{
+		size_t count = keepFrom - m_InputStart;
+		for (int ch = 0; ch != m_NumChannels; ++ch)
+		{
+			m_Input[ch].erase(m_Input[ch].begin(),
+					m_Input[ch].begin() + count);
+		}
+		m_InputStart = keepFrom;
+	}
+}
+
+void VarispeedStretchEngine::Process(const float * const * input,
+		size_t frames, bool final)
+{
+	if (!m_Final)
+	{
+		for (int ch = 0; ch != m_NumChannels; ++ch)
+		{
+			m_Input[ch].insert(m_Input[ch].end(), input[ch],
+					input[ch] + frames);
+		}
+		m_InputEnd += frames;
+
+		if (final)
+		{
+			// Pad with enough silence for the lookahead of the last frames
+			for (int ch = 0; ch != m_NumChannels; ++ch)
+			{
+				m_Input[ch].insert(m_Input[ch].end(), m_HalfWidth, 0.0f);
+			}
+			m_FlushEnd = m_InputEnd;
+			m_InputEnd += m_HalfWidth;
+			m_Final = true;
+		}
+
+		while (CanProduceFrame())
+		{
+			ProduceFrame();
+		}
+		DiscardInput();
+	}
+}
+
+size_t VarispeedStretchEngine::Retrieve(float * const * output, size_t frames)
+{
+	size_t count = std::min(frames, Available());
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		std::copy(m_Output[ch].begin(), m_Output[ch].begin() + count,
+				output[ch]);
+		m_Output[ch].erase(m_Output[ch].begin(),
+				m_Output[ch].begin() + count);
+	}
+	return count;
+}
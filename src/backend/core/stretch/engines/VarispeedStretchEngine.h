@@ -0,0 +1,74 @@
+#ifndef SRC_CORE_STRETCH_ENGINES_VARISPEEDSTRETCHENGINE_H_
+#define SRC_CORE_STRETCH_ENGINES_VARISPEEDSTRETCHENGINE_H_
+
+#include "StretchEngine.h"
+#include <utility>
+#include <vector>
+
+// "Stretches" audio by resampling it, like changing the speed of a record:
+// the tempo changes by the time ratio, and so does the pitch.  For many
+// transitions the pitch change is acceptable, and resampling costs far less
+// than time stretching.
+//
+// The resampler is a bandlimited (windowed sinc) interpolator.  The
+// impulse response is tabulated finely enough that the taps for any
+// fractional position are interpolated linearly from the table, and the
+// taps are computed once per output frame and shared by all channels, so
+// that the per-channel work is a plain dot product.  When speeding up, the
+// cutoff is lowered along with the ratio so that nothing aliases.
+//
+// A ratio change takes effect exactly at the first frame of input that is
+// processed after the change, so the position in the output of every input
+// frame is known exactly: it is the integral of the ratio over the input up to
+// that frame.  There is no latency; the interpolator only needs a few frames
+// of lookahead.
+class VarispeedStretchEngine: public StretchEngine
+{
+	static const size_t m_NumZeroCrossings;
+	static const size_t m_TableResolution;
+	static const size_t m_HalfWidth;
+	static const float m_Rolloff;
+	static const size_t m_BlockSize;
+
+	int m_NumChannels;
+	std::vector<float> m_ImpulseTable;
+	std::vector<float> m_ImpulseDeltas;
+	std::vector<float> m_Taps;
+
+	// Input frames that may still be needed, starting at absolute input
+	// position m_InputStart.  The input is preceded by half a filter width
+	// of silence, so the first output frame lines up with the first input
+	// frame.
+	std::vector<std::vector<float> > m_Input;
+	size_t m_InputStart;
+	size_t m_InputEnd;
+	size_t m_FlushEnd;
+	bool m_Final;
+
+	std::vector<std::vector<float> > m_Output;
+
+	// Input position of the next output frame, and ratio changes that take
+	// effect at later input positions
+	double m_Time;
+	double m_Ratio;
+	std::vector<std::pair<size_t, double> > m_RatioChanges;
+
+	bool CanProduceFrame() const;
+	size_t ComputeTaps(double frac, float cutoff);
+	void ProduceFrame();
+	void DiscardInput();
+public:
+	VarispeedStretchEngine(int numChannels);
+	virtual ~VarispeedStretchEngine();
+
+	virtual void Reset();
+	virtual void SetTimeRatio(double ratio);
+	virtual size_t GetLatency() const;
+	virtual size_t GetSamplesRequired() const;
+	virtual size_t Available() const;
+	virtual void Process(const float * const * input, size_t frames,
+			bool final);
+	virtual size_t Retrieve(float * const * output, size_t frames);
+};
+
+#endif /* SRC_CORE_STRETCH_ENGINES_VARISPEEDSTRETCHENGINE_H_ */
@@ -0,0 +1,421 @@
+#include "WSOLAStretchEngine.h"
+#include "../../../util/firwindows/WindowCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// About 20 ms at common sample rates (1024 frames at 44.1 and 48 kHz), which
+// is long enough to cover a period of the lowest bass notes
+const double WSOLAStretchEngine::m_FrameDuration = 0.02;
+
+// A frame whose second half has this much more energy than its first half
+// starts a transient
+const double WSOLAStretchEngine::m_TransientRatio = 4.0;
+
+// How far a frame that a transient overlaps may be shifted.  The beats in
+// it move just as far, which keeps them well within a millisecond of where
+// the ratio says, and the search still covers a period of what the
+// transient is mostly made of.
+const double WSOLAStretchEngine::m_TransientShiftDuration = 0.0005;
+
+WSOLAStretchEngine::WSOLAStretchEngine(int sampleRate, int numChannels)
+: m_NumChannels(numChannels), m_FrameSize(256), m_Ratio(1.0),
+  m_InputStart(0), m_InputEnd(0), m_FlushEnd(0), m_Final(false),
+  m_FirstFrame(true), m_PrevPos(0), m_NominalPos(0.0), m_TransientFrames(0)
+{
+	while (m_FrameSize < m_FrameDuration * sampleRate)
+	{
+		m_FrameSize <<= 1;
+	}
+	m_SynthesisHop = m_FrameSize >> 1;
+	m_Tolerance = m_FrameSize >> 2;
+	m_TransientTolerance = std::min(m_Tolerance,
+			(size_t) (m_TransientShiftDuration * sampleRate));
+
+	// The correlation is linear (rather than circular) as long as the FFT
+	// holds the whole search region
+	m_FFTSize = m_FrameSize;
+	while (m_FFTSize < m_SynthesisHop + 2 * m_Tolerance)
+	{
+		m_FFTSize <<= 1;
+	}
+
+	WindowCache::Instance().Get(WindowCache::WINDOW_HANN, m_FrameSize)
+			->AssignWindow(m_Window);
+
+	m_TemplateData.resize(m_FFTSize);
+	m_TemplateCache.resize(plan_cache_size(m_FFTSize));
+	setup_plan(&m_TemplatePlan, m_TemplateData.data(), m_TemplateCache.data(),
+			m_FFTSize);
+	m_SearchData.resize(m_FFTSize);
+	m_SearchCache.resize(plan_cache_size(m_FFTSize));
+	setup_plan(&m_SearchPlan, m_SearchData.data(), m_SearchCache.data(),
+			m_FFTSize);
+	m_SearchMix.resize(m_FFTSize);
+
+	// Reserve enough room up front that playback does not have to allocate
+	m_Input.resize(m_NumChannels);
+	m_OutAccum.resize(m_NumChannels);
+	m_Output.resize(m_NumChannels);
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		m_Input[ch].reserve(8 * m_FrameSize);
+		m_OutAccum[ch].resize(m_FrameSize);
+		m_Output[ch].reserve(4 * m_FrameSize);
+	}
+	m_WindowAccum.resize(m_FrameSize);
+	m_RatioChanges.reserve(64);
+
+	Reset();
+}
+
+WSOLAStretchEngine::~WSOLAStretchEngine()
+{
+}
+
+void WSOLAStretchEngine::Reset()
+{
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		m_Input[ch].assign(m_SynthesisHop, 0.0f);
+		std::fill(m_OutAccum[ch].begin(), m_OutAccum[ch].end(), 0.0f);
+		m_Output[ch].clear();
+	}
+	std::fill(m_WindowAccum.begin(), m_WindowAccum.end(), 0.0f);
+	m_InputStart = 0;
+	m_InputEnd = m_SynthesisHop;
+	m_FlushEnd = 0;
+	m_Final = false;
+	m_FirstFrame = true;
+	m_PrevPos = 0;
+	m_NominalPos = 0.0;
+	m_TransientFrames = 0;
+	m_Ratio = 1.0;
+	m_RatioChanges.clear();
+}
+
+void WSOLAStretchEngine::SetTimeRatio(double ratio)
+{
+	if (ratio > 0.0)
+	{
+		// The ratio applies from the next input on, which is a synthesis hop
+		// of silence further into m_Input than into the actual input
+		double pos = (double) (m_InputEnd - m_SynthesisHop);
+		if (m_RatioChanges.empty() && pos <= m_NominalPos)
+		{
+			m_Ratio = ratio;
+		}
+		else if (!m_RatioChanges.empty() && m_RatioChanges.back().first == pos)
+		{
+			m_RatioChanges.back().second = ratio;
+		}
+		else
+		{
+			m_RatioChanges.push_back(std::make_pair(pos, ratio));
+		}
+	}
+}
+
+size_t WSOLAStretchEngine::GetLatency() const
+{
+	return m_SynthesisHop;
+}
+
+size_t WSOLAStretchEngine::GetNominalPos() const
+{
+	return (size_t) (m_NominalPos + 0.5);
+}
+
+size_t WSOLAStretchEngine::GetSearchStart(size_t nominalPos) const
+{
+	return nominalPos > m_Tolerance ? nominalPos - m_Tolerance : 0;
+}
+
+size_t WSOLAStretchEngine::GetRequiredInputEnd() const
+{
+	return m_FirstFrame ? m_FrameSize
+	                    : GetNominalPos() + m_Tolerance + m_FrameSize;
+}
+
+bool WSOLAStretchEngine::CanProduceFrame() const
+{
+	// Once flushed, frames are only produced until the end of the actual
+	// input has made it into the output
+	bool flushed = m_Final && !m_FirstFrame &&
+			m_NominalPos >= m_FlushEnd + m_SynthesisHop;
+	return !flushed && m_InputEnd >= GetRequiredInputEnd();
+}
+
+size_t WSOLAStretchEngine::GetSamplesRequired() const
+{
+	size_t rv = 0;
+	if (!m_Final)
+	{
+		size_t requiredEnd = GetRequiredInputEnd();
+		if (requiredEnd > m_InputEnd)
+		{
+			rv = requiredEnd - m_InputEnd;
+		}
+	}
+	return rv;
+}
+
+size_t WSOLAStretchEngine::Available() const
+{
+	return m_Output.empty() ? 0 : m_Output[0].size();
+}
+
+void WSOLAStretchEngine::MixIntoPlan(fft_plan_t & plan, size_t pos,
+		size_t frames)
+{
+	float * samples = plan_samples(&plan);
+	size_t offset = pos - m_InputStart;
+	std::fill(samples, samples + m_FFTSize, 0.0f);
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		const float * input = m_Input[ch].data() + offset;
+		for (size_t k = 0; k != frames; ++k)
+		{
+			samples[k] += input[k];
+		}
+	}
+}
+
+bool WSOLAStretchEngine::IsTransient(size_t pos) const
+{
+	size_t offset = pos - m_InputStart;
+	float firstEnergy = 0.0f, secondEnergy = 0.0f;
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		const float * input = m_Input[ch].data() + offset;
+		for (size_t k = 0; k != m_SynthesisHop; ++k)
+		{
+			firstEnergy += input[k] * input[k];
+		}
+		for (size_t k = m_SynthesisHop; k != m_FrameSize; ++k)
+		{
+			secondEnergy += input[k] * input[k];
+		}
+	}
+	const float energyFloor = 1e-6f * m_FrameSize;
+	return secondEnergy > m_TransientRatio * firstEnergy + energyFloor;
+}
+
+size_t WSOLAStretchEngine::FindBestPos(size_t nominalPos, size_t tolerance)
+{
+	size_t natural = m_PrevPos + m_SynthesisHop;
+	size_t searchStart = nominalPos > tolerance ? nominalPos - tolerance : 0;
+	size_t searchEnd = nominalPos + tolerance;
+	bool naturalInRange = natural >= searchStart && natural <= searchEnd;
+	size_t rv = natural;
+	if (m_Ratio != 1.0 || !naturalInRange)
+	{
+		// Cross-correlate the natural continuation of the previous frame
+		// (over the part where the next frame overlaps it) with every
+		// candidate in the search region
+		size_t numLags = searchEnd - searchStart + 1;
+		size_t searchLen = numLags - 1 + m_SynthesisHop;
+		MixIntoPlan(m_TemplatePlan, natural, m_SynthesisHop);
+		MixIntoPlan(m_SearchPlan, searchStart, searchLen);
+		const float * mix = plan_samples(&m_SearchPlan);
+		m_SearchMix.assign(mix, mix + searchLen);
+
+		r2hc(&m_TemplatePlan);
+		r2hc(&m_SearchPlan);
+		const float * t = plan_samples(&m_TemplatePlan);
+		float * s = plan_samples(&m_SearchPlan);
+		size_t halfSize = m_FFTSize >> 1;
+		s[0] *= t[0];
+		s[halfSize] *= t[halfSize];
+		for (size_t k = 1; k != halfSize; ++k)
+		{
+			float tRe = t[k];
+			float tIm = t[m_FFTSize - k];
+			float sRe = s[k];
+			float sIm = s[m_FFTSize - k];
+			s[k] = tRe * sRe + tIm * sIm;
+			s[m_FFTSize - k] = tRe * sIm - tIm * sRe;
+		}
+		hc2r(&m_SearchPlan);
+		const float * corr = plan_samples(&m_SearchPlan);
+
+		// Normalize by the energy of each candidate, so that louder parts of
+		// the search region are not favored just for being loud
+		const float energyFloor = 1e-9f * m_SynthesisHop;
+		float energy = 0.0f;
+		for (size_t k = 0; k != m_SynthesisHop; ++k)
+		{
+			energy += m_SearchMix[k] * m_SearchMix[k];
+		}
+		size_t bestLag = naturalInRange ? natural - searchStart : 0;
+		float bestScore = -HUGE_VALF;
+		for (size_t lag = 0; lag != numLags; ++lag)
+		{
+			float score = corr[lag] / sqrtf(std::max(energy, 0.0f) +
+					energyFloor);
+			if (score > bestScore ||
+					(score == bestScore && lag + searchStart == natural))
+			{
+				bestScore = score;
+				bestLag = lag;
+			}
+			if (lag + 1 != numLags)
+			{
+				float in = m_SearchMix[lag + m_SynthesisHop];
+				float out = m_SearchMix[lag];
+				energy += in * in - out * out;
+			}
+		}
+		rv = searchStart + bestLag;
+	}
+	return rv;
+}
+
+void WSOLAStretchEngine::ProduceFrame()
+{
+	// Shifting a frame shifts the beats in it, so every frame that a
+	// transient overlaps is kept close to its nominal position
+	size_t pos = 0;
+	if (!m_FirstFrame)
+	{
+		size_t nominalPos = GetNominalPos();
+		if (IsTransient(nominalPos))
+		{
+			m_TransientFrames = m_FrameSize / m_SynthesisHop + 1;
+		}
+		size_t tolerance = m_Tolerance;
+		if (m_TransientFrames != 0)
+		{
+			tolerance = m_TransientTolerance;
+			--m_TransientFrames;
+		}
+		pos = FindBestPos(nominalPos, tolerance);
+	}
+	size_t offset = pos - m_InputStart;
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		const float * input = m_Input[ch].data() + offset;
+		float * accum = m_OutAccum[ch].data();
+		for (size_t k = 0; k != m_FrameSize; ++k)
+		{
+			accum[k] += input[k] * m_Window[k];
+		}
+	}
+	for (size_t k = 0; k != m_FrameSize; ++k)
+	{
+		m_WindowAccum[k] += m_Window[k];
+	}
+
+	// The first synthesis hop of the accumulators is now complete
+	size_t remaining = m_FrameSize - m_SynthesisHop;
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		float * accum = m_OutAccum[ch].data();
+		for (size_t k = 0; k != m_SynthesisHop; ++k)
+		{
+			float windowSum = m_WindowAccum[k];
+			m_Output[ch].push_back(windowSum > 1e-3f ? accum[k] / windowSum
+			                                         : accum[k]);
+		}
+		memmove(accum, accum + m_SynthesisHop, remaining * sizeof(float));
+		std::fill(accum + remaining, accum + m_FrameSize, 0.0f);
+	}
+	memmove(m_WindowAccum.data(), m_WindowAccum.data() + m_SynthesisHop,
+			remaining * sizeof(float));
+	std::fill(m_WindowAccum.begin() + remaining, m_WindowAccum.end(), 0.0f);
+
+	m_PrevPos = pos;
+	AdvanceNominalPos();
+	m_FirstFrame = false;
+	DiscardInput();
+}
+
+void WSOLAStretchEngine::AdvanceNominalPos()
+{
+	// Frame m comes out centered at m synthesis hops (once the latency is
+	// discarded), so its nominal center in the input is the integral of the
+	// inverse ratio up to there, taking each ratio over the input it was set
+	// for.  The first frame is centered on the first frame of actual input,
+	// and so is every other nominal position.
+	double remaining = (double) m_SynthesisHop;
+	size_t numApplied = 0;
+	while (numApplied != m_RatioChanges.size())
+	{
+		const std::pair<double, double> & change = m_RatioChanges[numApplied];
+		double span = (change.first - m_NominalPos) * m_Ratio;
+		if (span > remaining)
+		{
+			break;
+		}
+		remaining -= std::max(span, 0.0);
+		m_NominalPos = std::max(m_NominalPos, change.first);
+		m_Ratio = change.second;
+		++numApplied;
+	}
+	m_NominalPos += remaining / m_Ratio;
+	m_RatioChanges.erase(m_RatioChanges.begin(),
+			m_RatioChanges.begin() + numApplied);
+}
+
+void WSOLAStretchEngine::DiscardInput()
+{
+	// Input is only discarded a frame at a time to keep the copying down
+	size_t keepFrom = std::min(m_PrevPos + m_SynthesisHop,
+			GetSearchStart(GetNominalPos()));
+	if (keepFrom >= m_InputStart + m_FrameSize)
+	{
+		size_t count = keepFrom - m_InputStart;
+		for (int ch = 0; ch != m_NumChannels; ++ch)
+		{
+			m_Input[ch].erase(m_Input[ch].begin(),
+					m_Input[ch].begin() + count);
+		}
+		m_InputStart = keepFrom;
+	}
+}
+
+void WSOLAStretchEngine::Process(const float * const * input, size_t frames,
+		bool final)
+{
+	if (!m_Final)
+	{
+		for (int ch = 0; ch != m_NumChannels; ++ch)
+		{
+			m_Input[ch].insert(m_Input[ch].end(), input[ch],
+					input[ch] + frames);
+		}
+		m_InputEnd += frames;
+
+		if (final)
+		{
+			// Pad with enough silence to get every frame of actual input
+			// through the overlap-add
+			size_t padding = m_SynthesisHop + m_Tolerance + m_FrameSize;
+			for (int ch = 0; ch != m_NumChannels; ++ch)
+			{
+				m_Input[ch].insert(m_Input[ch].end(), padding, 0.0f);
+			}
+			m_FlushEnd = m_InputEnd;
+			m_InputEnd += padding;
+			m_Final = true;
+		}
+
+		while (CanProduceFrame())
+		{
+			ProduceFrame();
+		}
+	}
+}
+
+size_t WSOLAStretchEngine::Retrieve(float * const * output, size_t frames)
+{
+	size_t count = std::min(frames, Available());
+	for (int ch = 0; ch != m_NumChannels; ++ch)
+	{
+		std::copy(m_Output[ch].begin(), m_Output[ch].begin() + count,
+				output[ch]);
+		m_Output[ch].erase(m_Output[ch].begin(),
+				m_Output[ch].begin() + count);
+	}
+	return count;
+}
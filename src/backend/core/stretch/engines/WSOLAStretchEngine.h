@@ -0,0 +1,104 @@
+#ifndef SRC_CORE_STRETCH_ENGINES_WSOLASTRETCHENGINE_H_
+#define SRC_CORE_STRETCH_ENGINES_WSOLASTRETCHENGINE_H_
+
+#include "StretchEngine.h"
+#include "../../../util/minfft.h"
+#include <utility>
+#include <vector>
+
+// Time stretching by waveform similarity overlap-add (WSOLA).  Windowed
+// frames of the input are overlap-added at a fixed synthesis hop, while the
+// analysis hop between the frames is the synthesis hop divided by the time
+// ratio.  Rather than taking each frame exactly at its nominal position,
+// the frame is shifted by up to a small tolerance to wherever it lines up
+// best with the natural continuation of the previous frame, which is found
+// by cross-correlating a mono mix of the two in the frequency domain.
+//
+// Frames that a transient overlaps are only shifted by a fraction of a
+// millisecond, so that the beats stay where the ratio puts them.  There is
+// no phase vocoding, so this only sounds clean for ratios close to unity,
+// but it costs a fraction of the CPU of RubberBand.  At a ratio of exactly
+// one, frames are taken at their natural continuation and the input passes
+// through unchanged.
+class WSOLAStretchEngine: public StretchEngine
+{
+	static const double m_FrameDuration;
+	static const double m_TransientRatio;
+	static const double m_TransientShiftDuration;
+
+	int m_NumChannels;
+	size_t m_FrameSize;
+	size_t m_SynthesisHop;
+	size_t m_Tolerance;
+	size_t m_TransientTolerance;
+	size_t m_FFTSize;
+	double m_Ratio;
+	std::vector<float> m_Window;
+
+	// Input frames that may still be needed, starting at absolute input
+	// position m_InputStart.  The input is preceded by a synthesis hop of
+	// silence, so that the first frame that reaches full overlap starts
+	// with the first frame of actual input.
+	std::vector<std::vector<float> > m_Input;
+	size_t m_InputStart;
+	size_t m_InputEnd;
+	size_t m_FlushEnd;
+	bool m_Final;
+
+	// Overlap-add accumulators, one frame long, starting at the next
+	// output frame that has not been completed yet
+	std::vector<std::vector<float> > m_OutAccum;
+	std::vector<float> m_WindowAccum;
+
+	std::vector<std::vector<float> > m_Output;
+
+	bool m_FirstFrame;
+	size_t m_PrevPos;
+	double m_NominalPos;
+
+	// Frames left that are searched with the transient tolerance, because a
+	// transient overlaps them
+	size_t m_TransientFrames;
+
+	// The input is taken in well ahead of the frames that are produced from
+	// it, so a new time ratio is kept along with the input position where it
+	// starts, until the nominal position gets there.  m_Ratio is the ratio at
+	// the nominal position.
+	std::vector<std::pair<double, double> > m_RatioChanges;
+
+	fft_plan_t m_TemplatePlan;
+	std::vector<float> m_TemplateData;
+	std::vector<float> m_TemplateCache;
+	fft_plan_t m_SearchPlan;
+	std::vector<float> m_SearchData;
+	std::vector<float> m_SearchCache;
+	std::vector<float> m_SearchMix;
+
+	size_t GetNominalPos() const;
+	size_t GetSearchStart(size_t nominalPos) const;
+	size_t GetRequiredInputEnd() const;
+	bool CanProduceFrame() const;
+	void MixIntoPlan(fft_plan_t & plan, size_t pos, size_t frames);
+	bool IsTransient(size_t pos) const;
+	size_t FindBestPos(size_t nominalPos, size_t tolerance);
+	void AdvanceNominalPos();
+	void ProduceFrame();
+	void DiscardInput();
+
+	WSOLAStretchEngine(const WSOLAStretchEngine &) = delete;
+	WSOLAStretchEngine & operator=(const WSOLAStretchEngine &) = delete;
+public:
+	WSOLAStretchEngine(int sampleRate, int numChannels);
+	virtual ~WSOLAStretchEngine();
+
+	virtual void Reset();
+	virtual void SetTimeRatio(double ratio);
+	virtual size_t GetLatency() const;
+	virtual size_t GetSamplesRequired() const;
+	virtual size_t Available() const;
+	virtual void Process(const float * const * input, size_t frames,
+			bool final);
+	virtual size_t Retrieve(float * const * output, size_t frames);
+};
+
+#endif /* SRC_CORE_STRETCH_ENGINES_WSOLASTRETCHENGINE_H_ */
@@ -0,0 +1,157 @@
+#include "BandSplitter.h"
+#include "fademaps/FadeCurves.h"
+#include "../AudioBlock.h"
+#include "../../util/firfilter/HighPassFIRFilter.h"
+#include "../../util/firfilter/LowPassFIRFilter.h"
+#include <algorithm>
+
+// Long enough for a transition band of well under 100 Hz at 44.1 kHz, which
+// the low crossover needs
+const size_t BandSplitter::m_FilterSize = 1024;
+
+// Crossover frequencies, in Hz
+const double BandSplitter::m_LowCrossover = 200.0;
+const double BandSplitter::m_HighCrossover = 2500.0;
+
+static const FadeCurveTable LinearCurveTable;
+
+BandSplitter::BandSplitter(size_t numChannels, double sampleRate)
+: m_NumChannels(numChannels), m_Fill(0), m_LastVolume(0.0)
+{
+	LowPassFIRFilter lowPass(m_FilterSize, m_LowCrossover / sampleRate);
+	HighPassFIRFilter highPass(m_FilterSize, m_HighCrossover / sampleRate);
+	std::vector<float> lowKernel;
+	std::vector<float> highKernel;
+	lowPass.AssignFilter(lowKernel);
+	highPass.AssignFilter(highKernel);
+	m_Delay = lowPass.GetFilterDelay();
+
+	for (size_t ch = 0; ch != m_NumChannels; ++ch)
+	{
+		m_LowPass.emplace_back(new FFTConvolver(lowKernel));
+		m_HighPass.emplace_back(new FFTConvolver(highKernel));
+	}
+	m_BlockSize = m_LowPass.front()->GetBlockSize();
+
+	m_Input.resize(m_NumChannels);
+	for (auto it = m_Input.begin(); it != m_Input.end(); ++it)
+	{
+		it->resize(m_Delay + m_BlockSize);
+	}
+	m_Volumes.resize(m_Delay + m_BlockSize);
+	m_Output.resize(m_NumChannels * m_BlockSize);
+	m_LowBand.resize(m_BlockSize);
+	m_HighBand.resize(m_BlockSize);
+	for (size_t b = 0; b != NUM_BANDS; ++b)
+	{
+		m_Curves[b] = &LinearCurveTable;
+		m_Gains[b].resize(m_BlockSize);
+	}
+}
+
+BandSplitter::~BandSplitter()
+{
+}
+
+size_t BandSplitter::GetLatency()
+{
+	// A block of the convolvers plus the delay of the (symmetric) filters
+	return FFTConvolver::GetDefaultBlockSize(m_FilterSize) +
+			(m_FilterSize >> 1);
+}
+
+void BandSplitter::SetCurve(Band band, const FadeCurveTable & curve)
+{
+	m_Curves[band] = &curve;
+}
+
+void BandSplitter::Reset()
+{
+	for (size_t ch = 0; ch != m_NumChannels; ++ch)
+	{
+		m_LowPass[ch]->Reset();
+		m_HighPass[ch]->Reset();
+		std::fill(m_Input[ch].begin(), m_Input[ch].end(), 0.0f);
+	}
+	std::fill(m_Volumes.begin(), m_Volumes.end(), 0.0);
+	std::fill(m_Output.begin(), m_Output.end(), 0.0f);
+	m_Fill = 0;
+	m_LastVolume = 0.0;
+}
+
+void BandSplitter::Process(const AudioBlock & block, double volume,
+		double volumeStep, size_t start, size_t end, float * output)
+{
+	for (size_t k = start; k != end; ++k)
+	{
+		for (size_t ch = 0; ch != m_NumChannels; ++ch)
+		{
+			m_Input[ch][m_Delay + m_Fill] =
+					block.getSampleAtPosition(ch, k);
+		}
+		Advance(volume + (k - start) * volumeStep, output);
+		output += m_NumChannels;
+	}
+}
+
+void BandSplitter::Flush(float * output)
+{
+	for (size_t k = GetLatency(); k != 0; --k)
+	{
+		for (size_t ch = 0; ch != m_NumChannels; ++ch)
+		{
+			m_Input[ch][m_Delay + m_Fill] = 0.0f;
+		}
+		Advance(m_LastVolume, output);
+		output += m_NumChannels;
+	}
+}
+
+void BandSplitter::Advance(double volume, float * output)
+{
+	// The input of the frame is in place already
+	m_Volumes[m_Delay + m_Fill] = volume;
+	m_LastVolume = volume;
+	const float * out = &m_Output[m_Fill * m_NumChannels];
+	std::copy(out, out + m_NumChannels, output);
+	if (++m_Fill == m_BlockSize)
+	{
+		ProcessBlock();
+		m_Fill = 0;
+	}
+}
+
+void BandSplitter::ProcessBlock()
+{
+	// The filters are centered m_Delay frames back, which is where the
+	// held-back input and volumes start
+	for (size_t k = 0; k != m_BlockSize; ++k)
+	{
+		for (size_t b = 0; b != NUM_BANDS; ++b)
+		{
+			m_Gains[b][k] = (*m_Curves[b])(m_Volumes[k]);
+		}
+	}
+
+	for (size_t ch = 0; ch != m_NumChannels; ++ch)
+	{
+		std::vector<float> & input = m_Input[ch];
+		m_LowPass[ch]->ProcessBlock(&input[m_Delay], m_LowBand.data());
+		m_HighPass[ch]->ProcessBlock(&input[m_Delay], m_HighBand.data());
+
+		const float * lowGain = m_Gains[BAND_LOW].data();
+		const float * midGain = m_Gains[BAND_MID].data();
+		const float * highGain = m_Gains[BAND_HIGH].data();
+		float * out = &m_Output[ch];
+		for (size_t k = 0; k != m_BlockSize; ++k)
+		{
+			out[k * m_NumChannels] = midGain[k] * input[k] +
+					(lowGain[k] - midGain[k]) * m_LowBand[k] +
+					(highGain[k] - midGain[k]) * m_HighBand[k];
+		}
+
+		std::copy(input.begin() + m_BlockSize, input.end(), input.begin());
+	}
+	std::copy(m_Volumes.begin() + m_BlockSize, m_Volumes.end(),
+			m_Volumes.begin());
+}
@@ -0,0 +1,94 @@
+#ifndef SRC_CORE_XFADE_BANDSPLITTER_H_
+#define SRC_CORE_XFADE_BANDSPLITTER_H_
+
+#include "../../util/firfilter/FFTConvolver.h"
+#include <memory>
+#include <vector>
+
+class AudioBlock;
+class FadeCurveTable;
+
+// Fades the low, mid and high bands of a track with separate curves, so that
+// a crossfade can swap the bass lines of the two tracks instead of playing
+// both at once.
+//
+// The low and high bands are taken from linear-phase FIR filters, and the
+// output is formed as
+//
+//     g_mid * x + (g_low - g_mid) * low + (g_high - g_mid) * high
+//
+// so the mid band is never filtered explicitly.  Wherever the three gains
+// agree (at the very start and end of a fade, for instance), the output is
+// exactly the scaled input, with no filter ripple.
+//
+// The filters run block by block, so the output lags the input by
+// GetLatency() frames, the first of which are silent.
+class BandSplitter
+{
+public:
+	enum Band
+	{
+		BAND_LOW,
+		BAND_MID,
+		BAND_HIGH,
+		NUM_BANDS
+	};
+private:
+	static const size_t m_FilterSize;
+	static const double m_LowCrossover;
+	static const double m_HighCrossover;
+
+	size_t m_NumChannels;
+	size_t m_BlockSize;
+	size_t m_Delay;
+	const FadeCurveTable * m_Curves[NUM_BANDS];
+
+	std::vector<std::unique_ptr<FFTConvolver>> m_LowPass;
+	std::vector<std::unique_ptr<FFTConvolver>> m_HighPass;
+
+	// The input of each channel (and the volume of each frame) for the
+	// current block, preceded by the last m_Delay frames of the previous
+	// one, which the filters have yet to catch up with
+	std::vector<std::vector<float>> m_Input;
+	std::vector<double> m_Volumes;
+	size_t m_Fill;
+	double m_LastVolume;
+
+	// The output of the previous block (interleaved), which is handed out
+	// while the current block fills up
+	std::vector<float> m_Output;
+
+	std::vector<float> m_LowBand;
+	std::vector<float> m_HighBand;
+	std::vector<float> m_Gains[NUM_BANDS];
+
+	void Advance(double volume, float * output);
+	void ProcessBlock();
+public:
+	BandSplitter(size_t numChannels, double sampleRate);
+	virtual ~BandSplitter();
+
+	// The curve is not copied, so it must outlive the splitter.  All bands
+	// start out linear.
+	void SetCurve(Band band, const FadeCurveTable & curve);
+
+	// The same for every splitter, since it only depends on the filters, so
+	// that the buffers the tail is flushed into can be sized up front
+	static size_t GetLatency();
+
+	// Forgets the input so far, as though the track were preceded by
+	// silence
+	void Reset();
+
+	// Splits the frames in [start, end) of the block, ramping the volume
+	// linearly from the given value by the given step per frame, and writes
+	// as many (interleaved) frames of output
+	void Process(const AudioBlock & block, double volume, double volumeStep,
+			size_t start, size_t end, float * output);
+
+	// Writes the GetLatency() frames that are still held back, which ends
+	// the output on the last frame of input
+	void Flush(float * output);
+};
+
+#endif /* SRC_CORE_XFADE_BANDSPLITTER_H_ */
@@ -9,7 +9,8 @@ const double CrossfadeCalculator::m_Epsilon = 64.0 * std::numeric_limits<double>
 
 CrossfadeCalculator::CrossfadeCalculator(const AudioFile & audioFile1, const AudioFile & audioFile2)
 : m_AudioFile1(&audioFile1), m_AudioFile2(&audioFile2),
-  m_CrossfadeTime(RequestQueue::GetDefaultXfadeDuration())
+  m_CrossfadeTime(RequestQueue::GetDefaultXfadeDuration()),
+  m_FadeOutStartTime(-1.0)
 {
 }
 
@@ -24,7 +25,8 @@ double CrossfadeCalculator::GetEpsilon()
 
 double CrossfadeCalculator::GetTimeAtStartOfFadeOut() const
 {
-	return m_AudioFile1->getDuration() - m_CrossfadeTime;
+	return m_FadeOutStartTime >= 0.0 ? m_FadeOutStartTime
+			: m_AudioFile1->getDuration() - m_CrossfadeTime;
 }
 
 double CrossfadeCalculator::GetTimeAtStartOfFadeIn() const
@@ -34,19 +36,17 @@ double CrossfadeCalculator::GetTimeAtStartOfFadeIn() const
 
 double CrossfadeCalculator::ComputePercentageChangeForFadeOutTrack(double percent, double time, double timeChange, double & newTime, bool & done)
 {
-	(void) percent; // Ignore for simple crossfade
 	newTime = time + timeChange;
 	double value = timeChange / m_CrossfadeTime;
-	done = value >= 1.0 - m_Epsilon;
+	done = percent + value >= 1.0 - m_Epsilon;
 	return value;
 }
 
 double CrossfadeCalculator::ComputePercentageChangeForFadeInTrack(double percent, double time, double timeChange, double & newTime, bool & done)
 {
-	(void) percent; // Ignore for simple crossfade
 	newTime = time + timeChange;
 	double value = timeChange / m_CrossfadeTime;
-	done = value >= 1.0 - m_Epsilon;
+	done = percent + value >= 1.0 - m_Epsilon;
 	return value;
 }
 
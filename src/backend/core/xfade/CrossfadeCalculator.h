@@ -11,6 +11,7 @@ protected:
 	const AudioFile * m_AudioFile2;
 
 	double m_CrossfadeTime; // crossfade time in seconds
+	double m_FadeOutStartTime; // negative if fading out at the end of track
 	static const double m_Epsilon;
 public:
 	CrossfadeCalculator(const AudioFile & audioFile1, const AudioFile & audioFile2);
@@ -65,6 +66,13 @@ public:
 		m_CrossfadeTime = crossfadeTime;
 	}
 
+	// Starts the fade out at the given time instead of at the end of the
+	// track (used for skipping)
+	void setTimeAtStartOfFadeOut(double fadeOutStartTime)
+	{
+		m_FadeOutStartTime = fadeOutStartTime;
+	}
+
 	DJCrossfadeCalculatorOld * AsDJCalculator();
 };
 
@@ -0,0 +1,320 @@
+#include "CrossfadeSchedule.h"
+#include "CrossfadeCalculator.h"
+#include "fademaps/FadeMap.h"
+#include "../stretch/RatioCurve.h"
+#include <algorithm>
+#include <utility>
+#include <cmath>
+
+const size_t CrossfadeSchedule::m_RowsPerChunk = 4;
+const size_t CrossfadeSchedule::m_NumBisections = 40;
+
+// Farthest that the ratio curve strays from the ratio of any row.  Over the
+// longest fades, that moves the output by well under a millisecond.
+const double CrossfadeSchedule::m_RatioCurveTolerance = 1e-5;
+
+// Finds the row after which the given value falls, where the rows are sorted
+// by the given field, and inverts the linear interpolation of that field
+// within the row
+static double InvertAtValue(const std::vector<CrossfadeSchedule::Row> & rows,
+		double value, double CrossfadeSchedule::Row::*field)
+{
+	double rv;
+	if (rows.empty())
+	{
+		rv = 0.0;
+	}
+	else if (value <= rows.front().*field)
+	{
+		rv = rows.front().m_SourceTime;
+	}
+	else if (value >= rows.back().*field)
+	{
+		rv = rows.back().m_SourceTime;
+	}
+	else
+	{
+		std::vector<CrossfadeSchedule::Row>::const_iterator it =
+			std::upper_bound(rows.begin(), rows.end(), value,
+				[field] (double v, const CrossfadeSchedule::Row & row)
+				{
+					return v < row.*field;
+				});
+		const CrossfadeSchedule::Row & next = *it;
+		const CrossfadeSchedule::Row & prev = *(it - 1);
+		double span = next.*field - prev.*field;
+		rv = prev.m_SourceTime + (span > 0.0
+				? (value - prev.*field) / span *
+						(next.m_SourceTime - prev.m_SourceTime)
+				: 0.0);
+	}
+	return rv;
+}
+
+CrossfadeSchedule::CrossfadeSchedule()
+: m_RowTime(0.0), m_OffsetPercent(0.0)
+{
+}
+
+CrossfadeSchedule::~CrossfadeSchedule()
+{
+}
+
+void CrossfadeSchedule::Build(CrossfadeCalculator & calc,
+		const FadeMap & fadeMap, bool fadeOut, double chunkTime)
+{
+	m_Rows.clear();
+	m_CurveTable = fadeMap.GetCurveTable();
+	m_RowTime = chunkTime / m_RowsPerChunk;
+	m_OffsetPercent = fadeOut ? calc.GetFadeOutPercentage()
+	                          : calc.GetFadeInPercentage();
+
+	// Step through the fade just like the stretcher feed used to, one row
+	// at a time, until the calculator reports that the fade is complete
+	double time = 0.0;
+	double percent = 0.0;
+	double stretchedTime = 0.0;
+	bool done = false;
+	for (;;)
+	{
+		Row row;
+		row.m_SourceTime = time;
+		row.m_StretchedTime = stretchedTime;
+		row.m_Percent = percent;
+		row.m_Ratio = calc.ComputeStretchFactorForTrack(fadeOut, percent);
+		row.m_Volume = calc.ComputeVolumeForTrack(fadeOut, percent);
+		row.m_Gain = fadeMap.MapCrossfadeVolume(row.m_Volume);
+		m_Rows.push_back(row);
+
+		if (done)
+		{
+			break;
+		}
+
+		double newTime;
+		double dp = calc.ComputePercentageChangeForTrack(fadeOut, percent,
+				time, m_RowTime, newTime, done);
+		if (done)
+		{
+			// The fade ends somewhere within this row.  Find out exactly
+			// where, so that the end of the fade does not depend on how
+			// finely the fade is tabulated.
+			double lo = 0.0;
+			double hi = m_RowTime;
+			for (size_t k = 0; k != m_NumBisections; ++k)
+			{
+				double mid = 0.5 * (lo + hi);
+				bool midDone;
+				double midTime;
+				calc.ComputePercentageChangeForTrack(fadeOut, percent, time,
+						mid, midTime, midDone);
+				if (midDone)
+				{
+					hi = mid;
+				}
+				else
+				{
+					lo = mid;
+				}
+			}
+			dp = calc.ComputePercentageChangeForTrack(fadeOut, percent, time,
+					hi, newTime, done);
+		}
+		else if (!(dp > 0.0))
+		{
+			// A fade that makes no progress would never end, so cut it off
+			// here rather than tabulate it forever
+			done = true;
+		}
+
+		stretchedTime += row.m_Ratio * (newTime - time);
+		time = newTime;
+		percent += dp;
+	}
+}
+
+void CrossfadeSchedule::Clear()
+{
+	m_Rows.clear();
+	m_RowTime = 0.0;
+	m_OffsetPercent = 0.0;
+}
+
+size_t CrossfadeSchedule::RowIndexAtTime(double sourceTime) const
+{
+	// Only the last row is placed irregularly, so the row is found by
+	// division.  The caller guarantees that there are at least two rows and
+	// that the time lies strictly within the table.
+	size_t index = (size_t) (sourceTime / m_RowTime);
+	return std::min(index, m_Rows.size() - 2);
+}
+
+double CrossfadeSchedule::InterpolateAtTime(double sourceTime,
+		double Row::*field) const
+{
+	double rv;
+	if (m_Rows.empty())
+	{
+		rv = 0.0;
+	}
+	else if (sourceTime <= 0.0)
+	{
+		rv = m_Rows.front().*field;
+	}
+	else if (sourceTime >= m_Rows.back().m_SourceTime)
+	{
+		rv = m_Rows.back().*field;
+	}
+	else
+	{
+		size_t index = RowIndexAtTime(sourceTime);
+		const Row & prev = m_Rows[index];
+		const Row & next = m_Rows[index + 1];
+		double span = next.m_SourceTime - prev.m_SourceTime;
+		double alpha = span > 0.0 ? (sourceTime - prev.m_SourceTime) / span
+		                          : 0.0;
+		rv = prev.*field + alpha * (next.*field - prev.*field);
+	}
+	return rv;
+}
+
+double CrossfadeSchedule::GetEndTime() const
+{
+	return m_Rows.empty() ? 0.0 : m_Rows.back().m_SourceTime;
+}
+
+bool CrossfadeSchedule::IsDoneAtTime(double sourceTime) const
+{
+	return sourceTime >= GetEndTime();
+}
+
+double CrossfadeSchedule::GetMaxRatioDeviation() const
+{
+	double rv = 0.0;
+	for (auto it = m_Rows.begin(); it != m_Rows.end(); ++it)
+	{
+		rv = std::max(rv, std::fabs(it->m_Ratio - 1.0));
+	}
+	return rv;
+}
+
+void CrossfadeSchedule::GetRatioCurve(double startTime, double frameRate,
+		RatioCurve & curve) const
+{
+	// The ratio is held within each row, but it mostly ramps from row to
+	// row.  A line through the middle of each row has the same integral over
+	// the rows as the steps, even across a jump, so the output comes out
+	// where the rows put it.  The last row is held from its middle on, as
+	// though it were as long as the one before it.
+	std::vector<std::pair<double, double> > nodes;
+	nodes.push_back(std::make_pair(0.0, GetRatioAtTime(startTime)));
+	for (size_t k = 0; k != m_Rows.size(); ++k)
+	{
+		double rowStart = std::max(m_Rows[k].m_SourceTime - startTime, 0.0);
+		double rowEnd;
+		if (k + 1 != m_Rows.size())
+		{
+			rowEnd = m_Rows[k + 1].m_SourceTime - startTime;
+		}
+		else if (k != 0)
+		{
+			rowEnd = rowStart + m_Rows[k].m_SourceTime -
+					m_Rows[k - 1].m_SourceTime;
+		}
+		else
+		{
+			rowEnd = rowStart;
+		}
+		double middle = 0.5 * (rowStart + rowEnd) * frameRate;
+		if (middle > nodes.back().first)
+		{
+			nodes.push_back(std::make_pair(middle, m_Rows[k].m_Ratio));
+		}
+	}
+
+	// Each segment is stretched as far as the nodes it passes over stay
+	// within the tolerance of it, which they do as long as its slope stays
+	// between the bounds that they set
+	curve.Clear();
+	curve.AddPoint(nodes.front().first, nodes.front().second);
+	size_t start = 0;
+	while (start + 1 != nodes.size())
+	{
+		double startPos = nodes[start].first;
+		double startRatio = nodes[start].second;
+		double minSlope = -HUGE_VAL;
+		double maxSlope = HUGE_VAL;
+		size_t end = start + 1;
+		for (size_t k = start + 1; k != nodes.size(); ++k)
+		{
+			double span = nodes[k].first - startPos;
+			double slope = (nodes[k].second - startRatio) / span;
+			if (slope < minSlope || slope > maxSlope)
+			{
+				break;
+			}
+			end = k;
+			minSlope = std::max(minSlope,
+				(nodes[k].second - m_RatioCurveTolerance - startRatio) / span);
+			maxSlope = std::min(maxSlope,
+				(nodes[k].second + m_RatioCurveTolerance - startRatio) / span);
+		}
+		curve.AddPoint(nodes[end].first, nodes[end].second);
+		start = end;
+	}
+}
+
+double CrossfadeSchedule::GetPercentAtTime(double sourceTime) const
+{
+	return InterpolateAtTime(sourceTime, &Row::m_Percent);
+}
+
+double CrossfadeSchedule::GetTimeAtPercent(double percent) const
+{
+	return InvertAtValue(m_Rows, percent, &Row::m_Percent);
+}
+
+double CrossfadeSchedule::GetRatioAtTime(double sourceTime) const
+{
+	// The ratio changes abruptly wherever the tempo of the beatgrid does, so
+	// it is held from the start of the row rather than interpolated (just as
+	// it is held for the duration of a chunk by the stretcher)
+	double rv;
+	if (m_Rows.empty())
+	{
+		rv = 1.0;
+	}
+	else if (sourceTime <= 0.0)
+	{
+		rv = m_Rows.front().m_Ratio;
+	}
+	else if (sourceTime >= m_Rows.back().m_SourceTime)
+	{
+		rv = m_Rows.back().m_Ratio;
+	}
+	else
+	{
+		rv = m_Rows[RowIndexAtTime(sourceTime)].m_Ratio;
+	}
+	return rv;
+}
+
+double CrossfadeSchedule::GetVolumeAtTime(double sourceTime) const
+{
+	return InterpolateAtTime(sourceTime, &Row::m_Volume);
+}
+
+double CrossfadeSchedule::GetGainAtTime(double sourceTime) const
+{
+	return InterpolateAtTime(sourceTime, &Row::m_Gain);
+}
+
+double CrossfadeSchedule::GetStretchedTimeAtTime(double sourceTime) const
+{
+	return InterpolateAtTime(sourceTime, &Row::m_StretchedTime);
+}
+
+double CrossfadeSchedule::GetTimeAtStretchedTime(double stretchedTime) const
+{
+	return InvertAtValue(m_Rows, stretchedTime, &Row::m_StretchedTime);
+}
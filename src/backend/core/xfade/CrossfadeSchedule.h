@@ -0,0 +1,103 @@
+#ifndef SRC_CORE_XFADE_CROSSFADESCHEDULE_H_
+#define SRC_CORE_XFADE_CROSSFADESCHEDULE_H_
+
+#include <cstddef>
+#include <vector>
+#include "fademaps/FadeCurves.h"
+
+class CrossfadeCalculator;
+class FadeMap;
+class RatioCurve;
+
+// The course of a crossfade for one of its two tracks, tabulated once when
+// the crossfade is set up.  Each row of the table holds, at a point in time
+// of the source track (measured from the start of the fade):
+//
+// - the time that has elapsed in the stretched (played back) audio,
+// - the percentage into the crossfade,
+// - the time ratio that is given to the stretcher,
+// - the volume of the track, before the fade map is applied, and
+// - the gain of the track, with the fade map already applied.
+//
+// A copy of the fade map's curve table is kept along with the rows, so that
+// the gain can be ramped sample by sample along the volume.
+//
+// Rows are spaced evenly in source time (except for the last row, which is
+// placed exactly where the fade is complete), so a row is found by division.
+// Values between rows are interpolated linearly (except for the ratio, which
+// is held), and the mappings from
+// percentage or stretched time back to source time are inverted in closed
+// form within a row.  This way, the threads that feed the stretchers never
+// have to call into the crossfade calculator (and through it, the fade map)
+// while a crossfade is running.
+class CrossfadeSchedule
+{
+public:
+	struct Row
+	{
+		double m_SourceTime;
+		double m_StretchedTime;
+		double m_Percent;
+		double m_Ratio;
+		double m_Volume;
+		double m_Gain;
+	};
+
+private:
+	static const size_t m_RowsPerChunk;
+	static const size_t m_NumBisections;
+	static const double m_RatioCurveTolerance;
+
+	std::vector<Row> m_Rows;
+	FadeCurveTable m_CurveTable;
+	double m_RowTime;
+	double m_OffsetPercent;
+
+	size_t RowIndexAtTime(double sourceTime) const;
+	double InterpolateAtTime(double sourceTime, double Row::*field) const;
+public:
+	CrossfadeSchedule();
+	virtual ~CrossfadeSchedule();
+
+	// Tabulates the fade-out or the fade-in of the given calculator.  The
+	// chunk time is the duration of the chunks that are sent to the
+	// stretcher; several rows are placed in each chunk.
+	void Build(CrossfadeCalculator & calc, const FadeMap & fadeMap,
+			bool fadeOut, double chunkTime);
+	void Clear();
+
+	bool empty() const { return m_Rows.empty(); }
+	size_t size() const { return m_Rows.size(); }
+	const Row & at(size_t index) const { return m_Rows.at(index); }
+
+	// Percentage into the crossfade at which the beatgrid of the track starts
+	double GetOffsetPercent() const { return m_OffsetPercent; }
+
+	// Source time at which the fade is complete
+	double GetEndTime() const;
+	bool IsDoneAtTime(double sourceTime) const;
+
+	// Largest distance of the time ratio from unity over the whole fade
+	double GetMaxRatioDeviation() const;
+
+	// The ratio from the given source time on, as a curve over the frames of
+	// the stretcher's input (which starts at that time).  The curve is made
+	// of as few linear segments as follow the rows closely, so that the
+	// stretcher need not follow every row.
+	void GetRatioCurve(double startTime, double frameRate,
+			RatioCurve & curve) const;
+
+	double GetPercentAtTime(double sourceTime) const;
+	double GetTimeAtPercent(double percent) const;
+	double GetRatioAtTime(double sourceTime) const;
+	double GetVolumeAtTime(double sourceTime) const;
+	double GetGainAtTime(double sourceTime) const;
+
+	// Maps a volume to a gain, just like the fade map that the schedule was
+	// built with
+	const FadeCurveTable & GetCurveTable() const { return m_CurveTable; }
+	double GetStretchedTimeAtTime(double sourceTime) const;
+	double GetTimeAtStretchedTime(double stretchedTime) const;
+};
+
+#endif /* SRC_CORE_XFADE_CROSSFADESCHEDULE_H_ */
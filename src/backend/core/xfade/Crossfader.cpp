@@ -6,18 +6,52 @@
 #include "../RequestQueue.h"
 #include "../stretch/AudioStretchInfo.h"
 #include "../stretch/AudioStretcher.h"
+#include "../stretch/AudioStretcherPool.h"
+#include "../stretch/RatioCurve.h"
+#include "BandSplitter.h"
 #include "CrossfadeCalculator.h"
 #include "DJCrossfadeCalculatorOld.h"
 #include <cassert>
+#include <chrono>
 #include <string>
 #include <iostream>
 
 const size_t Crossfader::m_DefaultXfadeBufferSize = 512;
+const size_t Crossfader::m_NumSchedulerWorkers = 3;
 
-void Crossfader::SubmitStretchInfoAndReset(bool fadeOut, std::shared_ptr<AudioStretchInfo> & stretchInfo)
+TaskScheduler & Crossfader::GetScheduler()
 {
-	(fadeOut ? m_Stretcher1 : m_Stretcher2)->SubmitAudioStretchInfo(stretchInfo);
-	stretchInfo = std::make_shared<AudioStretchInfo>();
+	static TaskScheduler inst(m_NumSchedulerWorkers);
+	return inst;
+}
+
+AudioStretchInfo * Crossfader::BeginStretchInfo(bool fadeOut)
+{
+	return &(fadeOut ? m_Stretcher1 : m_Stretcher2)->BeginAudioStretchInfo();
+}
+
+BandSplitter * Crossfader::BeginBandSplit(bool fadeOut)
+{
+	BandSplitter * rv = (fadeOut ? m_Splitter1 : m_Splitter2).get();
+	if (rv != nullptr)
+	{
+		rv->Reset();
+		for (size_t b = 0; b != BandSplitter::NUM_BANDS; ++b)
+		{
+			const FadeMap * fadeMap = m_BandFadeMaps[b] != nullptr
+					? m_BandFadeMaps[b] : m_FadeMap;
+			rv->SetCurve((BandSplitter::Band) b, fadeMap->GetCurveTable());
+		}
+	}
+	return rv;
+}
+
+void Crossfader::SubmitStretchInfoAndReset(bool fadeOut, AudioStretchInfo * & stretchInfo)
+{
+	// The next chunk is only obtained once there is something to put in it,
+	// since obtaining one may wait on the consumer
+	(fadeOut ? m_Stretcher1 : m_Stretcher2)->SubmitAudioStretchInfo();
+	stretchInfo = nullptr;
 }
 
 void Crossfader::setCrossfadeTime(double crossfadeTime)
@@ -26,6 +60,7 @@ void Crossfader::setCrossfadeTime(double crossfadeTime)
 	if (m_Initialized)
 	{
 		xfadeCalc->setCrossfadeTime(crossfadeTime);
+		BuildSchedules();
 	}
 }
 
@@ -36,9 +71,18 @@ void Crossfader::setUsingOptimisticTempoAdaptation(bool enable)
 	{
 		xfadeCalc->AsDJCalculator()->setUsingOptimisticTempoAdaptation(
 				enable);
+		BuildSchedules();
 	}
 }
 
+void Crossfader::BuildSchedules()
+{
+	double chunkTime = m_XfadeBufferSize /
+			(double) AudioSink::Instance().getSampleRate();
+	m_FadeOutSchedule.Build(*xfadeCalc, *m_FadeMap, true, chunkTime);
+	m_FadeInSchedule.Build(*xfadeCalc, *m_FadeMap, false, chunkTime);
+}
+
 std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<AudioStretcher> & stretcher, AudioBlock * block)
 {
 	// VERY CHALLENGING CRAFTSMANSHIP HERE!!!
@@ -46,8 +90,9 @@ std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<
 	bool done = false;
 	bool fadeOut = stretcher == m_Stretcher1;
 	AudioFile * & file = fadeOut ? m_File1 : m_File2;
-	std::shared_ptr<AudioStretchInfo> stretchInfo =
-			std::make_shared<AudioStretchInfo>();
+	const CrossfadeSchedule & schedule = GetSchedule(fadeOut);
+	AudioStretchInfo * stretchInfo = nullptr;
+	BandSplitter * splitter = BeginBandSplit(fadeOut);
 	AudioBlock * theBlock = block;
 	std::shared_ptr<AudioBlock> nextBlock;
 	bool haveRefPos = false;
@@ -64,11 +109,15 @@ std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<
 	double relTime = 0.0;
 	double fadePercent = 0.0;
 
+	// The band splitter delays the track, and the silence it starts with is
+	// skipped by pushing the reference positions back by as much
+	size_t latency = splitter != nullptr ? splitter->GetLatency() : 0;
+
 	// Step 1:  synchronize the two tracks
 	if (fadeOut)
 	{
-		double fadeOutPercent = xfadeCalc->GetFadeOutPercentage();
-		double fadeInPercent = xfadeCalc->GetFadeInPercentage();
+		double fadeOutPercent = m_FadeOutSchedule.GetOffsetPercent();
+		double fadeInPercent = m_FadeInSchedule.GetOffsetPercent();
 		double origRefPercent = 0.0;
 		if (fadeInPercent < 1.0 - CrossfadeCalculator::GetEpsilon())
 		{
@@ -83,30 +132,19 @@ std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<
 		refPercent += fadeOutPercent;
 		compRefPercent = fadeInPercent + origRefPercent;
 
-		bool percentDone = false;
-		double timePadding = relTime;
-		bool calculationDone = false;
-		while (!percentDone && !calculationDone)
-		{
-			double dp = xfadeCalc->ComputePercentageChangeForTrack(fadeOut,
-					fadePercent, relTime, dt, relTime, percentDone);
-			double theDt = dt;
-			double theDp = dp;
-			if (fadePercent + dp >= refPercent)
-			{
-				calculationDone = true;
-				theDp = refPercent - fadePercent;
-				theDt = xfadeCalc->ComputeOriginalTimeChangeForTrack(
-						fadeOut, fadePercent, theDp);
-			}
-			timePadding -= theDt;
-			fadePercent += theDp;
-		}
-		done = done || percentDone;
+		// Start the fade where the schedule reaches the reference percentage
+		relTime = schedule.GetTimeAtPercent(refPercent);
+		fadePercent = schedule.GetPercentAtTime(relTime);
+		done = done || schedule.IsDoneAtTime(relTime);
+
+		// The given block starts right at the start of the fade out, but
+		// that is where the schedule is picked up
+		m_FadeOutOrigin = xfadeCalc->GetTimeAtStartOfFadeOut() - relTime;
 	}
 	else
 	{
 		double desiredSeek = xfadeCalc->GetTimeAtStartOfFadeIn();
+		m_FadeInOrigin = desiredSeek;
 		assert(file->seek(desiredSeek));
 		nextBlock = file->getNextAudioBlock();
 		done = file->isFileDone();
@@ -116,19 +154,12 @@ std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<
 
 		// At least in libav, it seems to be almost always the
 		// case that filePos >= desiredSeek.
-		bool percentDone = false;
-		double timePadding = filePos > desiredSeek
-				? filePos - desiredSeek : 0.0;
-		while (!percentDone && timePadding > 0.0)
+		if (filePos > desiredSeek)
 		{
-			double theDt = std::min(timePadding, dt);
-			double dp = xfadeCalc->ComputePercentageChangeForTrack(
-					fadeOut, fadePercent, relTime, theDt,
-					relTime, percentDone);
-			timePadding -= dt;
-			fadePercent += dp;
+			relTime = std::min(filePos - desiredSeek, schedule.GetEndTime());
+			fadePercent = schedule.GetPercentAtTime(relTime);
+			done = done || schedule.IsDoneAtTime(relTime);
 		}
-		done = done || percentDone;
 
 		{
 			std::lock_guard<std::mutex> lck(m_ExtraEndInfoMutex);
@@ -137,8 +168,8 @@ std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<
 			m_ExtraEndInfoCond.notify_all();
 		}
 
-		refPercent = xfadeCalc->GetFadeInPercentage() + fadePercent;
-		compRefPercent = xfadeCalc->GetFadeOutPercentage();
+		refPercent = m_FadeInSchedule.GetOffsetPercent() + fadePercent;
+		compRefPercent = m_FadeOutSchedule.GetOffsetPercent();
 	}
 
 	bool setCompRes = compRefPercent > refPercent;
@@ -150,10 +181,19 @@ std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<
 		m_File2HasCompRefPosCond.notify_all();
 	}
 
+	// The stretcher follows the ratio of the schedule on its own from here
+	// on, rather than being given a new ratio with every chunk
+	RatioCurve ratioCurve;
+	schedule.GetRatioCurve(relTime - latency / sr, sr, ratioCurve);
+	stretcher->SetRatioCurve(ratioCurve);
+
 	// Step 2:  Shove audio data into the stretcher
 	size_t offset = 0;
 	size_t blocksPlacedInBuffer = 0;
-	double volPercent = 0.0;
+	// The volume is ramped over each chunk, from its value at the start of
+	// the chunk to its value at the end
+	double volume = 0.0;
+	double volumeStep = 0.0;
 	bool haveLastBlock = false;
 	bool transferredAtLeastOneBlock = false;
 	while (!done)
@@ -171,60 +211,76 @@ std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<
 			if (blocksPlacedInBuffer == 0)
 			{
 				// Set up new stretch information
+				if (stretchInfo == nullptr)
+				{
+					stretchInfo = BeginStretchInfo(fadeOut);
+				}
 
-				double dp = xfadeCalc->ComputePercentageChangeForTrack(fadeOut,
-						fadePercent, relTime, dt, relTime, haveLastBlock);
+				double newTime = relTime + dt;
+				double dp = schedule.GetPercentAtTime(newTime) - fadePercent;
+				haveLastBlock = schedule.IsDoneAtTime(newTime);
 				if (!haveRefPos && fadePercent + dp >= refPercent)
 				{
-					double refDp = refPercent - fadePercent;
 					haveRefPos = true;
 					stretchInfo->SetUsingRefPos(true);
-					double refDt =
-							xfadeCalc->ComputeOriginalTimeChangeForTrack(
-							fadeOut, fadePercent, refDp);
+					double refDt = std::max(0.0,
+							schedule.GetTimeAtPercent(refPercent) - relTime);
 					size_t refPos = (size_t)
 							(refDt * AudioSink::Instance().getSampleRate());
-					stretchInfo->SetReferencePos(refPos);
+					stretchInfo->SetReferencePos(refPos + latency);
 				}
 				if (!haveCompRefPos && setCompRes && fadePercent + dp >= compRefPercent)
 				{
-					double refDp = compRefPercent - fadePercent;
 					haveCompRefPos = true;
 					stretchInfo->SetUsingComplementaryRefPos(true);
-					double refDt =
-							xfadeCalc->ComputeOriginalTimeChangeForTrack(
-							fadeOut, fadePercent, refDp);
+					double refDt = std::max(0.0,
+							schedule.GetTimeAtPercent(compRefPercent) - relTime);
 					size_t refPos = (size_t)
 							(refDt * AudioSink::Instance().getSampleRate());
-					stretchInfo->SetComplementaryReferencePos(refPos);
+					stretchInfo->SetComplementaryReferencePos(
+							refPos + latency);
 				}
 
-				double timeRatio = xfadeCalc->ComputeStretchFactorForTrack(
-						fadeOut, fadePercent);
-				stretchInfo->SetTimeRatio(timeRatio);
-				volPercent = xfadeCalc->ComputeVolumeForTrack(fadeOut,
-						fadePercent);
-				volPercent = m_FadeMap->MapCrossfadeVolume(volPercent);
+				stretchInfo->SetTimeRatio(schedule.GetRatioAtTime(relTime));
+				volume = schedule.GetVolumeAtTime(relTime);
+				volumeStep = (schedule.GetVolumeAtTime(newTime) - volume) /
+						m_XfadeBufferSize;
 				fadePercent += dp;
+				relTime = newTime;
 			}
 
 			size_t count = theBlock->getNumSamples() - offset;
 			size_t bufCount = m_XfadeBufferSize - blocksPlacedInBuffer;
-			if (count >= bufCount)
+			double startVolume = volume + blocksPlacedInBuffer * volumeStep;
+			bool fillsBuffer = count >= bufCount;
+			if (fillsBuffer)
 			{
 				count = bufCount;
+			}
+			if (splitter != nullptr)
+			{
+				stretchInfo->AppendSamples(*theBlock, *splitter, startVolume,
+						volumeStep, offset, offset + count);
+			}
+			else
+			{
+				stretchInfo->AppendSamples(*theBlock, schedule.GetCurveTable(),
+						startVolume, volumeStep, offset, offset + count);
+			}
+			if (fillsBuffer)
+			{
 				blocksPlacedInBuffer = 0;
-				stretchInfo->AppendSamples(*theBlock, volPercent, offset,
-						offset + count);
 				done = haveLastBlock;
+				if (done && splitter != nullptr)
+				{
+					stretchInfo->AppendSplitterTail(*splitter);
+				}
 				stretchInfo->SetLastOne(done);
 				SubmitStretchInfoAndReset(fadeOut, stretchInfo);
 				transferredAtLeastOneBlock = true;
 			}
 			else
 			{
-				stretchInfo->AppendSamples(*theBlock, volPercent, offset,
-						offset + count);
 				blocksPlacedInBuffer += count;
 			}
 
@@ -243,6 +299,14 @@ std::shared_ptr<AudioBlock> Crossfader::ChunkAndSendToStretcher(std::unique_ptr<
 		// If we reach this branch, we hit EOF before the end of the crossfade
 		// interval.
 
+		if (stretchInfo == nullptr)
+		{
+			stretchInfo = BeginStretchInfo(fadeOut);
+		}
+		if (splitter != nullptr)
+		{
+			stretchInfo->AppendSplitterTail(*splitter);
+		}
 		stretchInfo->SetLastOne(true);
 		SubmitStretchInfoAndReset(fadeOut, stretchInfo);
 	}
@@ -446,30 +510,22 @@ void Crossfader::PlaybackCrossfadeMix()
 			{
 				blk2 = m_Stretcher2->getStretchedAudioAsBlock(
 						m_XfadeBufferSize, refPos, compRefPos, eos2);
-				if (blk1->getNumSamples() != 0)
+				if (blk2->getNumSamples() != 0)
 				{
-					blk1->setRemoveClick(clickRemove);
+					blk2->setRemoveClick(clickRemove);
 					clickRemove = false;
 					AudioSink::Instance().SubmitAudioBlock(blk2);
 				}
 			}
 		}
 	}
-}
 
-void Crossfader::PlaybackThread(Crossfader * xfader)
-{
-	xfader->PlaybackCrossfadeMix();
-}
-
-void Crossfader::LaunchCrossfade1Thread(Crossfader * xfader, std::shared_ptr<AudioBlock> startingFadeOutBlock)
-{
-	xfader->ChunkAndSendToStretcher(xfader->m_Stretcher1, startingFadeOutBlock.get());
-}
-
-void Crossfader::LaunchCrossfade2Thread(Crossfader * xfader)
-{
-	xfader->m_XfadeLeftover = xfader->ChunkAndSendToStretcher(xfader->m_Stretcher2);
+	// A stretcher that was not read to its end (the first one when the next
+	// track runs out first, or the second one when the first track runs out
+	// before the beats are lined up) is abandoned, so that its producer
+	// finishes instead of waiting for room forever
+	m_Stretcher1->StopReading();
+	m_Stretcher2->StopReading();
 }
 
 FadeMap & Crossfader::GetFadeMap()
@@ -485,14 +541,22 @@ const FadeMap & Crossfader::GetFadeMap() const
 void Crossfader::SetFadeMap(FadeMap & fadeMap)
 {
 	m_FadeMap = &fadeMap;
+	if (m_Initialized)
+	{
+		BuildSchedules();
+	}
 }
 
 Crossfader::Crossfader(AudioFile & file1, AudioFile & file2, FadeMap & fadeMap)
-: m_StretchBufReadPos(0), m_File1(&file1), m_File2(&file2),
-  m_FadeMap(&fadeMap), m_Initialized(false), m_Ineligible(false),
+: m_FadeOutOrigin(0.0), m_FadeInOrigin(0.0),
+  m_StretchBufReadPos(0), m_File1(&file1), m_File2(&file2),
+  m_FadeMap(&fadeMap), m_BandFadeMaps(), m_Initialized(false), m_Ineligible(false),
   m_AllowDJCrossfade(false), m_AllowCrossfade(false),
   m_CrossfadeTime(RequestQueue::GetDefaultXfadeDuration()),
-  m_UseOptimisticTempoAdaptation(false), m_SampleCounter(0),
+  m_UseOptimisticTempoAdaptation(false),
+  m_NativeStretchBand(RequestQueue::GetDefaultNativeStretchBand()),
+  m_UseVarispeed(false), m_UseBandSplit(false),
+  m_SetupTime(0.0), m_SampleCounter(0),
   m_XfadeBufferSize(m_DefaultXfadeBufferSize), m_File2HasCompRefPos(false),
   m_File2HasCompRefPosAvailable(false), m_PercentPadding(0.0),
   m_ExtraEndInfoAvailable(false)
@@ -501,10 +565,91 @@ Crossfader::Crossfader(AudioFile & file1, AudioFile & file2, FadeMap & fadeMap)
 
 Crossfader::~Crossfader()
 {
+	// Never leave tasks running on a destroyed crossfader
+	m_XfadeTasks.Wait();
+	AudioStretcherPool::Instance().Release(std::move(m_Stretcher1));
+	AudioStretcherPool::Instance().Release(std::move(m_Stretcher2));
+}
+
+void Crossfader::AcquireStretchers()
+{
+	if (m_Stretcher1 == nullptr)
+	{
+		m_Stretcher1 = AudioStretcherPool::Instance().Acquire();
+	}
+	if (m_Stretcher2 == nullptr)
+	{
+		m_Stretcher2 = AudioStretcherPool::Instance().Acquire();
+	}
+}
+
+void Crossfader::CreateBandSplitters()
+{
+	// Designing the filters takes a while, so it is done up front rather
+	// than in the crossfade tasks
+	if (m_UseBandSplit)
+	{
+		if (m_Splitter1 == nullptr)
+		{
+			size_t numChannels = AudioSink::Instance().getNumChannels();
+			double sr = (double) AudioSink::Instance().getSampleRate();
+			m_Splitter1.reset(new BandSplitter(numChannels, sr));
+			m_Splitter2.reset(new BandSplitter(numChannels, sr));
+		}
+	}
+	else
+	{
+		m_Splitter1.reset();
+		m_Splitter2.reset();
+	}
+}
+
+static AudioStretcher::EngineType ChooseStretchEngine(
+		const CrossfadeSchedule & schedule, bool useVarispeed,
+		double nativeStretchBand)
+{
+	// A negative band forces RubberBand, even on a track that is not
+	// stretched at all.  Otherwise, such a track passes through the native
+	// engine untouched, so it never needs anything else.
+	AudioStretcher::EngineType rv;
+	double deviation = schedule.GetMaxRatioDeviation();
+	if (!useVarispeed && nativeStretchBand < 0.0)
+	{
+		rv = AudioStretcher::ENGINE_RUBBERBAND;
+	}
+	else if (deviation == 0.0)
+	{
+		rv = AudioStretcher::ENGINE_NATIVE;
+	}
+	else if (useVarispeed)
+	{
+		rv = AudioStretcher::ENGINE_VARISPEED;
+	}
+	else if (deviation <= nativeStretchBand)
+	{
+		rv = AudioStretcher::ENGINE_NATIVE;
+	}
+	else
+	{
+		rv = AudioStretcher::ENGINE_RUBBERBAND;
+	}
+	return rv;
+}
+
+void Crossfader::SelectStretchEngines()
+{
+	// Each stretcher is reset when it is acquired, so it has not been given
+	// any audio yet
+	m_Stretcher1->SelectEngine(ChooseStretchEngine(m_FadeOutSchedule,
+			m_UseVarispeed, m_NativeStretchBand));
+	m_Stretcher2->SelectEngine(ChooseStretchEngine(m_FadeInSchedule,
+			m_UseVarispeed, m_NativeStretchBand));
 }
 
 void Crossfader::InitializeCrossfade()
 {
+	std::chrono::steady_clock::time_point startTime =
+			std::chrono::steady_clock::now();
 	if (!m_Initialized && !m_Ineligible)
 	{
 		xfadeCalc.reset(new DJCrossfadeCalculatorOld(*m_File1, *m_File2));
@@ -530,10 +675,45 @@ void Crossfader::InitializeCrossfade()
 		}
 		if (m_Initialized)
 		{
-			m_Stretcher1.reset(new AudioStretcher);
-			m_Stretcher2.reset(new AudioStretcher);
+			BuildSchedules();
+			AcquireStretchers();
+			CreateBandSplitters();
 		}
 	}
+	m_SetupTime = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startTime).count();
+}
+
+bool Crossfader::InitializeQuickCrossfade(double crossfadeTime)
+{
+	// Replace whatever crossfade was planned with a short, plain crossfade
+	// that starts at the current position of the first track.  Stretchers
+	// that were already set up for the planned crossfade are reused.
+	std::chrono::steady_clock::time_point startTime =
+			std::chrono::steady_clock::now();
+	xfadeCalc.reset(new CrossfadeCalculator(*m_File1, *m_File2));
+	xfadeCalc->setCrossfadeTime(crossfadeTime);
+	xfadeCalc->setTimeAtStartOfFadeOut(m_File1->getPosition());
+
+	// Both tracks must last as long as the fade, counting from here for the
+	// first one, just as for a planned crossfade
+	m_Initialized = xfadeCalc->CheckCrossfadeCondition() &&
+			m_File1->getDuration() - m_File1->getPosition() >= crossfadeTime;
+	m_Ineligible = !m_Initialized;
+	if (m_Initialized)
+	{
+		BuildSchedules();
+		AcquireStretchers();
+		CreateBandSplitters();
+		m_CrossfadeTime = crossfadeTime;
+	}
+	else
+	{
+		xfadeCalc.reset();
+	}
+	m_SetupTime = std::chrono::duration<double>(
+			std::chrono::steady_clock::now() - startTime).count();
+	return m_Initialized;
 }
 
 bool Crossfader::ReadyToCrossfade(double & backDelta) const
@@ -551,30 +731,29 @@ void Crossfader::StartCrossfade(std::shared_ptr<AudioBlock> & startingFadeOutBlo
 {
 	if (m_Initialized)
 	{
+		TaskScheduler & scheduler = GetScheduler();
+		scheduler.Start(); // no-op if already started
+
 		m_File2HasCompRefPosAvailable = false;
-		m_XfadeThread1.reset(new std::thread(LaunchCrossfade1Thread, this, startingFadeOutBlock));
-		m_XfadeThread2.reset(new std::thread(LaunchCrossfade2Thread, this));
-		m_PlaybackThread.reset(new std::thread(PlaybackThread, this));
+		SelectStretchEngines();
+		std::shared_ptr<AudioBlock> fadeOutBlock = startingFadeOutBlock;
+		scheduler.Submit([this, fadeOutBlock] {
+			ChunkAndSendToStretcher(m_Stretcher1, fadeOutBlock.get());
+		}, TaskScheduler::PRIORITY_NORMAL, &m_XfadeTasks);
+		scheduler.Submit([this] {
+			m_XfadeLeftover = ChunkAndSendToStretcher(m_Stretcher2);
+		}, TaskScheduler::PRIORITY_NORMAL, &m_XfadeTasks);
+
+		// The mix feeds the sink directly, so it goes first
+		scheduler.Submit([this] {
+			PlaybackCrossfadeMix();
+		}, TaskScheduler::PRIORITY_HIGH, &m_XfadeTasks);
 	}
 }
 
 void Crossfader::WaitOnThreadsAndGiveXfadeLeftover(std::shared_ptr<AudioBlock> & leftover)
 {
-	if (m_XfadeThread1 != nullptr)
-	{
-		m_XfadeThread1->join();
-		m_XfadeThread1.reset();
-	}
-	if (m_XfadeThread2 != nullptr)
-	{
-		m_XfadeThread2->join();
-		m_XfadeThread2.reset();
-	}
-	if (m_PlaybackThread != nullptr)
-	{
-		m_PlaybackThread->join();
-		m_PlaybackThread.reset();
-	}
+	m_XfadeTasks.Wait();
 	leftover = m_XfadeLeftover;
 	m_XfadeLeftover.reset();
 }
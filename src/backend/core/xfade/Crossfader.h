@@ -4,8 +4,10 @@
 #include <memory>
 #include <mutex>
 #include <condition_variable>
-#include <thread>
 #include <rubberband/RubberBandStretcher.h>
+#include "../../util/TaskScheduler.h"
+#include "BandSplitter.h"
+#include "CrossfadeSchedule.h"
 
 class AudioFile;
 class AudioStretchInfo;
@@ -17,16 +19,33 @@ class FadeMap;
 class Crossfader {
 	static const size_t m_DefaultXfadeBufferSize;
 
+	// The fade-out, fade-in and mix tasks wait on each other, so the
+	// scheduler needs at least this many workers
+	static const size_t m_NumSchedulerWorkers;
+
 	std::unique_ptr<AudioStretcher> m_Stretcher1;
 	std::unique_ptr<AudioStretcher> m_Stretcher2;
 
+	// Only present in band-split mode
+	std::unique_ptr<BandSplitter> m_Splitter1;
+	std::unique_ptr<BandSplitter> m_Splitter2;
+
 	std::unique_ptr<CrossfadeCalculator> xfadeCalc;
+
+	// Tabulated from xfadeCalc whenever the crossfade is (re)configured, so
+	// the crossfade tasks never call into xfadeCalc themselves
+	CrossfadeSchedule m_FadeOutSchedule;
+	CrossfadeSchedule m_FadeInSchedule;
+	double m_FadeOutOrigin;
+	double m_FadeInOrigin;
+
 	std::vector<char> m_StretchBuf;
 	size_t m_StretchBufReadPos;
 
 	AudioFile * m_File1;
 	AudioFile * m_File2;
 	FadeMap * m_FadeMap;
+	const FadeMap * m_BandFadeMaps[BandSplitter::NUM_BANDS];
 
 	bool m_Initialized;
 	bool m_Ineligible;
@@ -35,6 +54,10 @@ class Crossfader {
 
 	double m_CrossfadeTime;
 	bool m_UseOptimisticTempoAdaptation;
+	double m_NativeStretchBand;
+	bool m_UseVarispeed;
+	bool m_UseBandSplit;
+	double m_SetupTime;
 
 	size_t m_SampleCounter;
 	size_t m_XfadeBufferSize;
@@ -54,23 +77,33 @@ class Crossfader {
 	std::shared_ptr<AudioBlock> m_ExtraEndBlock;
 
 	std::shared_ptr<AudioBlock> m_XfadeLeftover;
-	std::unique_ptr<std::thread> m_XfadeThread1;
-	std::unique_ptr<std::thread> m_XfadeThread2;
-	std::unique_ptr<std::thread> m_PlaybackThread;
+	TaskScheduler::TaskGroup m_XfadeTasks;
 
-	void SubmitStretchInfoAndReset(bool fadeOut, std::shared_ptr<AudioStretchInfo> & stretchInfo);
+	AudioStretchInfo * BeginStretchInfo(bool fadeOut);
+	BandSplitter * BeginBandSplit(bool fadeOut);
+	void SubmitStretchInfoAndReset(bool fadeOut, AudioStretchInfo * & stretchInfo);
 	std::shared_ptr<AudioBlock> ChunkAndSendToStretcher(std::unique_ptr<AudioStretcher> & stretcher, AudioBlock * block = nullptr);
 
-	static void PlaybackThread(Crossfader * xfader);
-	static void LaunchCrossfade1Thread(Crossfader * xfader, std::shared_ptr<AudioBlock> startingFadeOutBlock);
-	static void LaunchCrossfade2Thread(Crossfader * xfader);
-
 	void PlaybackCrossfadeMix();
+	void AcquireStretchers();
+	void CreateBandSplitters();
+	void BuildSchedules();
+	void SelectStretchEngines();
 public:
 	Crossfader(AudioFile & file1, AudioFile & file2, FadeMap & fadeMap);
 	virtual ~Crossfader();
 
+	// The scheduler that runs the crossfade tasks of all crossfaders.  It is
+	// started on first use if it has not been started already.
+	static TaskScheduler & GetScheduler();
+
 	void InitializeCrossfade();
+
+	// Replaces the planned crossfade with a plain one of the given length,
+	// starting right away.  False if either track is too short for it, in
+	// which case there is no crossfade at all.
+	bool InitializeQuickCrossfade(double crossfadeTime);
+
 	bool ReadyToCrossfade(double & backDelta) const;
 
 	bool isAllowingDJCrossfade() const
@@ -98,11 +131,20 @@ public:
 		return !m_Ineligible;
 	}
 
+	// Wall-clock time (in seconds) spent in the last call to
+	// InitializeCrossfade or InitializeQuickCrossfade
+	double getSetupTime() const
+	{
+		return m_SetupTime;
+	}
+
 	double getCrossfadeTime() const
 	{
 		return m_CrossfadeTime;
 	}
 
+	// These mutators (and SetFadeMap) rebuild the crossfade schedules, so
+	// they must not be called while a crossfade is running
 	void setCrossfadeTime(double crossfadeTime);
 
 	bool isUsingOptimisticTempoAdaptation() const
@@ -112,10 +154,72 @@ public:
 
 	void setUsingOptimisticTempoAdaptation(bool enable);
 
+	double getNativeStretchBand() const
+	{
+		return m_NativeStretchBand;
+	}
+
+	// Tracks whose time ratios stay within this distance of unity for the
+	// whole crossfade are stretched with the native engine, which is much
+	// cheaper than RubberBand.  Must not be called while a crossfade is
+	// running.
+	void setNativeStretchBand(double nativeStretchBand)
+	{
+		m_NativeStretchBand = nativeStretchBand;
+	}
+
+	bool isUsingVarispeed() const
+	{
+		return m_UseVarispeed;
+	}
+
+	// In varispeed mode, tracks are brought to the common tempo by
+	// resampling them (which shifts their pitch along with their tempo)
+	// rather than by time stretching them.  Must not be called while a
+	// crossfade is running.
+	void setUsingVarispeed(bool enable)
+	{
+		m_UseVarispeed = enable;
+	}
+
+	bool isUsingBandSplit() const
+	{
+		return m_UseBandSplit;
+	}
+
+	// In band-split mode, the low, mid and high bands of the tracks are
+	// faded with their own fade maps (see SetBandFadeMap).  Must not be
+	// called while a crossfade is running.
+	void setUsingBandSplit(bool enable)
+	{
+		m_UseBandSplit = enable;
+	}
+
+	// Valid once the crossfade is initialized
+	const CrossfadeSchedule & GetSchedule(bool fadeOut) const
+	{
+		return fadeOut ? m_FadeOutSchedule : m_FadeInSchedule;
+	}
+
+	// Position in the fade-out or fade-in track (in seconds) from which the
+	// source times of its schedule are measured.  Valid once the crossfade
+	// tasks are done.
+	double GetScheduleOrigin(bool fadeOut) const
+	{
+		return fadeOut ? m_FadeOutOrigin : m_FadeInOrigin;
+	}
+
 	FadeMap & GetFadeMap();
 	const FadeMap & GetFadeMap() const;
 	void SetFadeMap(FadeMap & fadeMap);
 
+	// The fade map of a band in band-split mode, which must outlive the
+	// crossfade.  Null makes the band follow the main fade map.
+	void SetBandFadeMap(BandSplitter::Band band, const FadeMap * fadeMap)
+	{
+		m_BandFadeMaps[band] = fadeMap;
+	}
+
 	void StartCrossfade(std::shared_ptr<AudioBlock> & startingFadeOutBlock);
 	void WaitOnThreadsAndGiveXfadeLeftover(std::shared_ptr<AudioBlock> & leftover);
 };
@@ -1,14 +1,12 @@
 #include "DJCrossfadeCalculator.h"
 #include "../AudioFile.h"
+#include "bgfile/BeatgridCache.h"
 #include <string>
-#include <sstream>
 #include <utility>
 #include <limits>
 #include <algorithm>
 #include <cmath>
 
-const std::string DJCrossfadeCalculator::m_bpmInfoFileExt = ".bpm";
-
 DJCrossfadeCalculator::DJCrossfadeCalculator(const AudioFile & audioFile1, const AudioFile & audioFile2)
 : CrossfadeCalculator(audioFile1, audioFile2), m_FadeOutTime(0.0),
   m_InstantaneousFadeOutTempo(0.0), m_FadeInTime(0.0),
@@ -21,100 +19,6 @@ DJCrossfadeCalculator::~DJCrossfadeCalculator() {
 	// TODO Auto-generated destructor stub
 }
 
-bool DJCrossfadeCalculator::ReadBeatgrid(std::ifstream & ifs, double & instantaneousFadeTempo, std::vector<double> & fadeInfo)
-{
-	bool rv = false;
-
-	int numBeats;
-	double bpm;
-	std::vector<std::pair<int, double> > beatgrid;
-	char ch;
-	while ((ifs >> numBeats >> ch >> bpm) && ch == '@')
-	{
-		beatgrid.push_back(std::make_pair(numBeats, bpm));
-	}
-	ifs.clear();
-
-	fadeInfo.clear();
-	if (!beatgrid.empty())
-	{
-		std::vector<std::pair<int, double> >::const_iterator
-			it = beatgrid.begin();
-
-		bool haveInstTempo = false;
-		const double eps = 2.0 * std::numeric_limits<double>::epsilon();
-		for (; it != beatgrid.end(); ++it)
-		{
-			if (it->second >= eps) // BPM must be strictly positive
-			{
-				if (it->first == 0)
-				{
-					haveInstTempo = true;
-					instantaneousFadeTempo = it->second;
-				}
-				else
-				{
-					for (int k = 0; k < it->first; ++k)
-					{
-						fadeInfo.push_back(it->second);
-					}
-				}
-			}
-		}
-
-		if (!haveInstTempo && !beatgrid.empty())
-		{
-			instantaneousFadeTempo = beatgrid.back().second;
-		}
-
-		rv = true;
-	}
-
-	return rv;
-}
-
-bool DJCrossfadeCalculator::ReadFadeInfo(std::ifstream & ifs, bool fadeOut, double & fadeTime, double & instantaneousFadeTempo, std::vector<double> & fadeInfo)
-{
-	bool rv = false;
-
-	bool done = false;
-	bool secondRun = false;
-	double time;
-	std::string parsedLine;
-
-	while (!done && std::getline(ifs, parsedLine))
-	{
-		char ch1, ch2;
-		if ((std::istringstream(parsedLine) >> ch1 >> time >> ch2) &&
-				ch1 == '[' && ch2 == ']')
-		{
-			fadeTime = time;
-			if (fadeOut)
-			{
-				if (secondRun)
-				{
-					done = true;
-				}
-				else
-				{
-					secondRun = true;
-				}
-			}
-			else
-			{
-				done = true;
-			}
-		}
-	}
-
-	if (done)
-	{
-		rv = ReadBeatgrid(ifs, instantaneousFadeTempo, fadeInfo);
-	}
-
-	return rv;
-}
-
 bool DJCrossfadeCalculator::VerifyRubberBandConstraintsForSingleGrid(const std::vector<double> & fadeInfo, double instantaneousFadeTempo, size_t (*bgOffsetFunc)(const DJCrossfadeCalculator &)) const
 {
 	// We need to check whether it is possible to do the crossfade with
@@ -154,11 +58,11 @@ bool DJCrossfadeCalculator::VerifyRubberBandConstraintsForSingleGrid(const std::
 
 bool DJCrossfadeCalculator::VerifyRubberBandConstraints() const
 {
-	return VerifyRubberBandConstraintsForSingleGrid(m_FadeOutInfo,
+	return VerifyRubberBandConstraintsForSingleGrid(m_FadeOutInfo.GetBPMBeatgrid(),
 			m_InstantaneousFadeOutTempo,
 			[](const DJCrossfadeCalculator & calc)
 				{ return calc.GetFadeOutBeatgridOffset(); })
-			&& VerifyRubberBandConstraintsForSingleGrid(m_FadeInInfo,
+			&& VerifyRubberBandConstraintsForSingleGrid(m_FadeInInfo.GetBPMBeatgrid(),
 			m_InstantaneousFadeInTempo,
 			[](const DJCrossfadeCalculator & calc)
 				{ return calc.GetFadeInBeatgridOffset(); });
@@ -167,13 +71,13 @@ bool DJCrossfadeCalculator::VerifyRubberBandConstraints() const
 double DJCrossfadeCalculator::GetBPMAtStartOfCrossfade() const
 {
 	return m_FadeOutInfo.empty() ? m_InstantaneousFadeOutTempo
-	                             : *m_FadeOutInfo.begin();
+	                             : m_FadeOutInfo.at(0);
 }
 
 double DJCrossfadeCalculator::GetBPMAtEndOfCrossfade() const
 {
 	return m_FadeInInfo.empty() ? m_InstantaneousFadeInTempo
-	                            : *m_FadeInInfo.rbegin();
+	                            : m_FadeInInfo.at(m_FadeInInfo.size() - 1);
 }
 
 size_t DJCrossfadeCalculator::GetFadeOutBeatgridOffset() const
@@ -204,14 +108,7 @@ size_t DJCrossfadeCalculator::GetMaxBeatgridSize() const
 
 double DJCrossfadeCalculator::GetTimeAtFadeOutBeat(size_t beatPos) const
 {
-	double delta = 0.0;
-	size_t count = 0;
-	for (std::vector<double>::const_iterator it = m_FadeOutInfo.begin();
-			count != beatPos && it != m_FadeOutInfo.end(); ++it, ++count)
-	{
-		delta += 1.0 / *it;
-	}
-	return m_FadeOutTime + delta;
+	return m_FadeOutTime + m_FadeOutInfo.GetTimeOffsetAtBeat(beatPos);
 }
 
 double DJCrossfadeCalculator::GetTimeAtEndOfFadeOut() const
@@ -221,19 +118,12 @@ double DJCrossfadeCalculator::GetTimeAtEndOfFadeOut() const
 
 double DJCrossfadeCalculator::GetTimeAtFadeInBeat(size_t beatPos) const
 {
-	double delta = 0.0;
-	size_t count = 0;
-	for (std::vector<double>::const_iterator it = m_FadeInInfo.begin();
-			count != beatPos && it != m_FadeInInfo.end(); ++it, ++count)
-	{
-		delta += 1.0 / *it;
-	}
-	return m_FadeInTime + delta;
+	return m_FadeInTime + m_FadeInInfo.GetTimeOffsetAtBeat(beatPos);
 }
 
 double DJCrossfadeCalculator::GetTimeAtEndOfFadeIn() const
 {
-	return GetTimeAtFadeOutBeat(m_FadeInInfo.size());
+	return GetTimeAtFadeInBeat(m_FadeInInfo.size());
 }
 
 double DJCrossfadeCalculator::InterpolateBPMAtCrossfade(double percent) const
@@ -326,42 +216,52 @@ double DJCrossfadeCalculator::InterpolateBPMAtCrossfade(double percent) const
 	return interpolatedBPM;
 }
 
-double DJCrossfadeCalculator::ComputePercentageChangeForFadeOutTrack(double percent, double time, double timeChange, double & newTime, bool & done)
+double DJCrossfadeCalculator::ComputePercentageChangeForGrid(const Beatgrid & grid, double percent, double time, double newTime) const
 {
-	newTime = time + timeChange;
-
-	double timeBase = 0.0;
-	double percentChange = 0.0;
+	// Walking beat by beat from the current position, every beat that is
+	// passed over completely contributes 1 / maxBGS to the percentage change,
+	// and the first and last beats contribute the fraction of them that is
+	// covered.  The last beat is found by a binary search of the table of
+	// beat times.
+	double percentChange;
 	size_t maxBGS = GetMaxBeatgridSize();
 	double dIndex = percent * maxBGS;
 	size_t index = (size_t) dIndex;
-	size_t limit = std::min(m_FadeOutInfo.size(), index);
-	bool finished = false;
-	for (size_t k = 0; k < limit; ++k)
+	const std::vector<double> & times = grid.GetTimeBeatgrid();
+	std::vector<double>::const_iterator endIt = index < grid.size()
+			? std::lower_bound(times.begin() + (index + 1), times.end(), newTime)
+			: times.end();
+	if (endIt == times.end())
 	{
-		timeBase += 60.0 / m_FadeOutInfo.at(k);
+		// We run past the end of the beatgrid
+		percentChange = 1.0 - percent;
 	}
-	double prevTime = time;
-	while (!finished && index < m_FadeOutInfo.size())
+	else
 	{
-		double dt = 60.0 / m_FadeOutInfo.at(index);
-		double updatedTime = timeBase + dt;
-		if (updatedTime >= newTime)
+		size_t endIndex = (endIt - times.begin()) - 1;
+		if (endIndex == index)
 		{
-			percentChange += (newTime - prevTime) / (dt * maxBGS);
-			finished = true;
+			percentChange = (newTime - time) /
+					((60.0 / grid.at(index)) * maxBGS);
 		}
 		else
 		{
-			percentChange += (updatedTime - prevTime) / (dt * maxBGS);
-			prevTime = timeBase = updatedTime;
-			++index;
+			percentChange = (times[index + 1] - time) /
+					((60.0 / grid.at(index)) * maxBGS);
+			percentChange += (endIndex - index - 1) / ((double) maxBGS);
+			percentChange += (newTime - times[endIndex]) /
+					((60.0 / grid.at(endIndex)) * maxBGS);
 		}
 	}
-	if (!finished)
-	{
-		percentChange = 1.0 - percent;
-	}
+	return percentChange;
+}
+
+double DJCrossfadeCalculator::ComputePercentageChangeForFadeOutTrack(double percent, double time, double timeChange, double & newTime, bool & done)
+{
+	newTime = time + timeChange;
+
+	double percentChange = ComputePercentageChangeForGrid(m_FadeOutInfo,
+			percent, time, newTime);
 	done = percent + percentChange >= 1.0 - m_Epsilon;
 	return percentChange;
 }
@@ -370,38 +270,8 @@ double DJCrossfadeCalculator::ComputePercentageChangeForFadeInTrack(double perce
 {
 	newTime = time + timeChange;
 
-	double timeBase = 0.0;
-	double percentChange = 0.0;
-	size_t maxBGS = GetMaxBeatgridSize();
-	double dIndex = percent * maxBGS;
-	size_t index = (size_t) dIndex;
-	size_t limit = std::min(m_FadeInInfo.size(), index);
-	bool finished = false;
-	for (size_t k = 0; k < limit; ++k)
-	{
-		timeBase += 60.0 / m_FadeInInfo.at(k);
-	}
-	double prevTime = time;
-	while (!finished && index < m_FadeInInfo.size())
-	{
-		double dt = 60.0 / m_FadeInInfo.at(index);
-		double updatedTime = timeBase + dt;
-		if (updatedTime >= newTime)
-		{
-			percentChange += (newTime - prevTime) / (dt * maxBGS);
-			finished = true;
-		}
-		else
-		{
-			percentChange += (updatedTime - prevTime) / (dt * maxBGS);
-			prevTime = timeBase = updatedTime;
-			++index;
-		}
-	}
-	if (!finished)
-	{
-		percentChange = 1.0 - percent;
-	}
+	double percentChange = ComputePercentageChangeForGrid(m_FadeInInfo,
+			percent, time, newTime);
 	done = percent + percentChange >= 1.0 - m_Epsilon;
 	return percentChange;
 }
@@ -430,13 +300,8 @@ double DJCrossfadeCalculator::ComputeOriginalTimeChangeForFadeOutTrack(double pe
 		size_t clipEndIndex = std::max((size_t) 0,
 				std::min(relEndIndex, m_FadeOutInfo.size() - 1));
 
-		std::vector<double>::const_iterator startIt = m_FadeOutInfo.begin() + relStartIndex;
-		std::vector<double>::const_iterator endIt = m_FadeOutInfo.begin() + relEndIndex;
-		for (std::vector<double>::const_iterator it = startIt;
-				it != endIt; ++it)
-		{
-			timeChange += 60.0 / *it;
-		}
+		timeChange += m_FadeOutInfo.GetTimeOffsetAtBeat(relEndIndex) -
+				m_FadeOutInfo.GetTimeOffsetAtBeat(relStartIndex);
 
 		double endBPM = m_FadeOutInfo.at(clipEndIndex);
 		timeChange += 60.0 * (dEndIndex - endIndex) / endBPM;
@@ -468,13 +333,8 @@ double DJCrossfadeCalculator::ComputeOriginalTimeChangeForFadeInTrack(double per
 		size_t clipEndIndex = std::max((size_t) 0,
 				std::min(relEndIndex, m_FadeInInfo.size() - 1));
 
-		std::vector<double>::const_iterator startIt = m_FadeInInfo.begin() + relStartIndex;
-		std::vector<double>::const_iterator endIt = m_FadeInInfo.begin() + relEndIndex;
-		for (std::vector<double>::const_iterator it = startIt;
-				it != endIt; ++it)
-		{
-			timeChange += 60.0 / *it;
-		}
+		timeChange += m_FadeInInfo.GetTimeOffsetAtBeat(relEndIndex) -
+				m_FadeInInfo.GetTimeOffsetAtBeat(relStartIndex);
 
 		double endBPM = m_FadeInInfo.at(clipEndIndex);
 		timeChange += 60.0 * (dEndIndex - endIndex) / endBPM;
@@ -551,26 +411,33 @@ double DJCrossfadeCalculator::GetFadeInPercentage() const
 	return maxBGSize == 0 ? 0.0 : GetFadeInBeatgridOffset() / ((double) maxBGSize);
 }
 
+void DJCrossfadeCalculator::TakeFadeSection(const FadeSection & section, double & fadeTime, double & instantaneousFadeTempo, Beatgrid & fadeInfo)
+{
+	fadeTime = section.GetTime();
+	instantaneousFadeTempo = section.GetInstantaneousTempo();
+	fadeInfo = section.GetBeatgrid();
+}
+
 bool DJCrossfadeCalculator::ReadBPMFiles()
 {
 	bool rv = false;
 
-	std::ifstream ifs(m_AudioFile1->getFilename() + m_bpmInfoFileExt);
-	if (ifs.good())
+	BeatgridCache & cache = BeatgridCache::Instance();
+	std::shared_ptr<const BeatgridFileReader> reader =
+			cache.Get(m_AudioFile1->getFilename());
+	if (reader != nullptr &&
+			reader->HasSection(BeatgridFileReader::FADE_OUT_SECTION))
 	{
-		rv = ReadFadeInfo(ifs, true, m_FadeOutTime,
-				m_InstantaneousFadeOutTempo, m_FadeOutInfo);
-		ifs.close();
-	}
+		TakeFadeSection(reader->GetSection(BeatgridFileReader::FADE_OUT_SECTION),
+				m_FadeOutTime, m_InstantaneousFadeOutTempo, m_FadeOutInfo);
 
-	if (rv)
-	{
-		ifs.open(m_AudioFile2->getFilename() + m_bpmInfoFileExt);
-		if ((rv = ifs.good()))
+		reader = cache.Get(m_AudioFile2->getFilename());
+		if (reader != nullptr &&
+				reader->HasSection(BeatgridFileReader::FADE_IN_SECTION))
 		{
-			rv = ReadFadeInfo(ifs, false, m_FadeInTime,
-					m_InstantaneousFadeInTempo, m_FadeInInfo);
-			ifs.close();
+			TakeFadeSection(reader->GetSection(BeatgridFileReader::FADE_IN_SECTION),
+					m_FadeInTime, m_InstantaneousFadeInTempo, m_FadeInInfo);
+			rv = true;
 		}
 	}
 
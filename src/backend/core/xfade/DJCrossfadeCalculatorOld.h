@@ -2,7 +2,8 @@
 #define SRC_CORE_XFADE_DJCROSSFADECALCULATOROLD_H_
 
 #include "CrossfadeCalculator.h"
-#include <fstream>
+#include "bgfile/Beatgrid.h"
+#include "bgfile/FadeSection.h"
 #include <vector>
 
 class AudioFile;
@@ -12,21 +13,16 @@ class AudioFile;
 // implementation.
 
 class DJCrossfadeCalculatorOld: public CrossfadeCalculator {
-	static const std::string m_bpmInfoFileExt;
-
 	double m_FadeOutTime;
 	double m_InstantaneousFadeOutTempo;
-	std::vector<double> m_FadeOutInfo;
+	Beatgrid m_FadeOutInfo;
 
 	double m_FadeInTime;
 	double m_InstantaneousFadeInTempo;
-	std::vector<double> m_FadeInInfo;
+	Beatgrid m_FadeInInfo;
 
 	bool m_UseOptimisticTempoAdaptation;
 
-	static bool ReadBeatgrid(std::ifstream & ifs, double & instantaneousFadeTempo, std::vector<double> & fadeInfo);
-	static bool ReadFadeInfo(std::ifstream & ifs, bool fadeOut, double & fadeTime, double & instantaneousFadeTempo, std::vector<double> & fadeInfo);
-
 	bool VerifyRubberBandConstraintsForSingleGrid(const std::vector<double> & fadeInfo, size_t (*bgOffsetFunc)(const DJCrossfadeCalculatorOld &)) const;
 	bool VerifyRubberBandConstraints() const;
 
@@ -43,6 +39,12 @@ class DJCrossfadeCalculatorOld: public CrossfadeCalculator {
 	double GetTimeAtFadeInBeat(size_t beatPos) const;
 	double GetTimeAtEndOfFadeIn() const;
 
+	// Converts a time offset into the given beatgrid to a percentage change
+	// using the beat time table, so the cost is logarithmic in the number of
+	// beats instead of linear
+	double ComputePercentageChangeForGrid(const Beatgrid & grid, double percent, double time, double newTime) const;
+
+	static void TakeFadeSection(const FadeSection & section, double & fadeTime, double & instantaneousFadeTempo, Beatgrid & fadeInfo);
 	bool ReadBPMFiles();
 	double InterpolateBPMAtCrossfade(double percent) const;
 
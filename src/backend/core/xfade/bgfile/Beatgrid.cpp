@@ -1,4 +1,5 @@
 #include "Beatgrid.h"
+#include <algorithm>
 
 Beatgrid::Beatgrid()
 : m_HasGrid(false), m_RefTime(0.0), m_RefTimeOffset(0.0), m_BaseTempo(0.0)
@@ -63,8 +64,7 @@ Beatgrid Beatgrid::GetBeatgridSection(size_t start) const
 	{
 		bg.m_BPMBeatgrid.assign(m_BPMBeatgrid.begin() + start,
 				m_BPMBeatgrid.end());
-		bg.m_TimeBeatgrid.assign(m_TimeBeatgrid.begin() + start,
-				m_TimeBeatgrid.end());
+		bg.UpdateTimeBeatgrid();
 	}
 	return bg;
 }
@@ -80,11 +80,98 @@ Beatgrid Beatgrid::GetBeatgridSection(size_t start,
 		bg.m_BaseTempo = m_BaseTempo;
 		bg.m_BPMBeatgrid.assign(m_BPMBeatgrid.begin() + start,
 				m_BPMBeatgrid.begin() + (start + count));
+		bg.UpdateTimeBeatgrid();
 		return bg;
 	}
 	return GetBeatgridSection(start);
 }
 
+void Beatgrid::UpdateTimeBeatgrid()
+{
+	// The running sum is accumulated in the same order as a linear walk over
+	// the beats would, so lookups give exactly the same times as before
+	m_TimeBeatgrid.clear();
+	if (!m_BPMBeatgrid.empty())
+	{
+		m_TimeBeatgrid.reserve(m_BPMBeatgrid.size() + 1);
+		double time = 0.0;
+		m_TimeBeatgrid.push_back(time);
+		for (std::vector<double>::const_iterator it = m_BPMBeatgrid.begin();
+				it != m_BPMBeatgrid.end(); ++it)
+		{
+			time += 60.0 / *it;
+			m_TimeBeatgrid.push_back(time);
+		}
+	}
+}
+
+void Beatgrid::SetBPMBeatgrid(const std::vector<double> & bpmBeatgrid)
+{
+	m_BPMBeatgrid = bpmBeatgrid;
+	UpdateTimeBeatgrid();
+}
+
+void Beatgrid::SetBPMBeatgrid(std::vector<double> && bpmBeatgrid)
+{
+	m_BPMBeatgrid = std::move(bpmBeatgrid);
+	UpdateTimeBeatgrid();
+}
+
+void Beatgrid::SetBeatgrid(std::vector<double> && bpmBeatgrid,
+		std::vector<double> && timeBeatgrid)
+{
+	m_BPMBeatgrid = std::move(bpmBeatgrid);
+	size_t expectedSize = m_BPMBeatgrid.empty() ? 0 : m_BPMBeatgrid.size() + 1;
+	if (timeBeatgrid.size() == expectedSize)
+	{
+		m_TimeBeatgrid = std::move(timeBeatgrid);
+	}
+	else
+	{
+		UpdateTimeBeatgrid();
+	}
+}
+
+std::vector<std::pair<size_t, double> > Beatgrid::GetSegments() const
+{
+	std::vector<std::pair<size_t, double> > segments;
+	for (std::vector<double>::const_iterator it = m_BPMBeatgrid.begin();
+			it != m_BPMBeatgrid.end(); ++it)
+	{
+		if (segments.empty() || segments.back().second != *it)
+		{
+			segments.push_back(std::make_pair((size_t) 0, *it));
+		}
+		++segments.back().first;
+	}
+	return segments;
+}
+
+double Beatgrid::GetTimeOffsetAtBeat(size_t beatPos) const
+{
+	double rv = 0.0;
+	if (!m_TimeBeatgrid.empty())
+	{
+		rv = m_TimeBeatgrid[std::min(beatPos, m_BPMBeatgrid.size())];
+	}
+	return rv;
+}
+
+size_t Beatgrid::FindBeatAtTimeOffset(double timeOffset) const
+{
+	size_t rv = 0;
+	if (!m_TimeBeatgrid.empty())
+	{
+		// First beat boundary strictly after the offset, minus one
+		std::vector<double>::const_iterator it = std::upper_bound(
+				m_TimeBeatgrid.begin(), m_TimeBeatgrid.end(), timeOffset);
+		rv = it == m_TimeBeatgrid.begin() ? 0
+				: std::min((size_t) (it - m_TimeBeatgrid.begin()) - 1,
+				           m_BPMBeatgrid.size());
+	}
+	return rv;
+}
+
 void Beatgrid::Sanitize()
 {
 
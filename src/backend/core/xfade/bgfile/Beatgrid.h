@@ -2,8 +2,13 @@
 #define SRC_CORE_XFADE_BGFILE_BEATGRID_H_
 
 #include <vector>
+#include <utility>
 #include <cstring>
 
+// A sequence of beats, each with its own tempo.  Alongside the tempo of each
+// beat, the time offset of every beat boundary (relative to the first beat)
+// is kept, so that conversions between beats and time do not have to sum up
+// the beat lengths over and over again.
 class Beatgrid
 {
 	bool m_HasGrid;
@@ -12,6 +17,8 @@ class Beatgrid
 	double m_BaseTempo;
 	std::vector<double> m_BPMBeatgrid;
 	std::vector<double> m_TimeBeatgrid;
+
+	void UpdateTimeBeatgrid();
 public:
 	Beatgrid();
 	Beatgrid(const Beatgrid & bg);
@@ -26,6 +33,11 @@ public:
 		return m_HasGrid;
 	}
 
+	void SetHasGrid(bool hasGrid)
+	{
+		m_HasGrid = hasGrid;
+	}
+
 	double GetRefTime() const
 	{
 		return m_RefTime;
@@ -51,11 +63,48 @@ public:
 		return m_BPMBeatgrid;
 	}
 
+	void SetBPMBeatgrid(const std::vector<double> & bpmBeatgrid);
+	void SetBPMBeatgrid(std::vector<double> && bpmBeatgrid);
+
+	// Takes a beatgrid along with its precomputed table of beat times.  If
+	// the table does not match the beatgrid, it is computed again.
+	void SetBeatgrid(std::vector<double> && bpmBeatgrid,
+			std::vector<double> && timeBeatgrid);
+
+	// Run-length form of the beatgrid:  (number of beats, BPM) pairs
+	std::vector<std::pair<size_t, double> > GetSegments() const;
+
+	// Beat k starts at GetTimeBeatgrid()[k] and ends at
+	// GetTimeBeatgrid()[k + 1]; the table has one more entry than there are
+	// beats (unless there are no beats at all)
 	const std::vector<double> & GetTimeBeatgrid() const
 	{
 		return m_TimeBeatgrid;
 	}
 
+	size_t size() const
+	{
+		return m_BPMBeatgrid.size();
+	}
+
+	bool empty() const
+	{
+		return m_BPMBeatgrid.empty();
+	}
+
+	double at(size_t beatPos) const
+	{
+		return m_BPMBeatgrid.at(beatPos);
+	}
+
+	// Time offset of the start of the given beat relative to the start of
+	// the first beat (positions past the end are clamped to the end)
+	double GetTimeOffsetAtBeat(size_t beatPos) const;
+
+	// Finds the beat containing the given time offset in logarithmic time.
+	// The number of beats is returned if the offset lies past the end.
+	size_t FindBeatAtTimeOffset(double timeOffset) const;
+
 	Beatgrid GetBeatgridSection(size_t start = 0) const;
 	Beatgrid GetBeatgridSection(size_t start, size_t count) const;
 
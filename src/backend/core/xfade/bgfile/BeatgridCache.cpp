@@ -0,0 +1,112 @@
+#include "BeatgridCache.h"
+#include "../../../os/Path.h"
+
+const size_t BeatgridCache::m_DefaultMaxEntries = 64;
+
+BeatgridCache::Entry::Entry()
+: m_TextModTime(-1), m_BinaryModTime(-1), m_LastUse(0)
+{
+}
+
+BeatgridCache::BeatgridCache()
+: m_Entries(std::make_shared<EntryMap>()), m_UseCounter(0),
+  m_MaxEntries(m_DefaultMaxEntries)
+{
+}
+
+BeatgridCache::~BeatgridCache()
+{
+}
+
+BeatgridCache & BeatgridCache::Instance()
+{
+	static BeatgridCache inst;
+	return inst;
+}
+
+void BeatgridCache::GetModificationTimes(const std::string & audioFilename,
+		long long & textModTime, long long & binaryModTime)
+{
+	if (!Path::GetModificationTimeNs(
+			BeatgridFileReader::GetTextFilename(audioFilename), textModTime))
+	{
+		textModTime = -1;
+	}
+	if (!Path::GetModificationTimeNs(
+			BeatgridFileReader::GetBinaryFilename(audioFilename), binaryModTime))
+	{
+		binaryModTime = -1;
+	}
+}
+
+void BeatgridCache::Insert(const std::string & audioFilename,
+		const std::shared_ptr<const Entry> & entry)
+{
+	std::lock_guard<std::mutex> lck(m_WriteMutex);
+	std::shared_ptr<EntryMap> entries = std::make_shared<EntryMap>(
+			*std::atomic_load(&m_Entries));
+	(*entries)[audioFilename] = entry;
+
+	while (entries->size() > m_MaxEntries && !entries->empty())
+	{
+		EntryMap::iterator oldest = entries->begin();
+		for (EntryMap::iterator it = entries->begin(); it != entries->end();
+				++it)
+		{
+			if (it->second->m_LastUse < oldest->second->m_LastUse)
+			{
+				oldest = it;
+			}
+		}
+		entries->erase(oldest);
+	}
+
+	std::atomic_store(&m_Entries,
+			std::shared_ptr<const EntryMap>(std::move(entries)));
+}
+
+std::shared_ptr<const BeatgridFileReader> BeatgridCache::Get(
+		const std::string & audioFilename)
+{
+	std::shared_ptr<const BeatgridFileReader> rv;
+
+	long long textModTime, binaryModTime;
+	GetModificationTimes(audioFilename, textModTime, binaryModTime);
+
+	bool found = false;
+	std::shared_ptr<const EntryMap> entries = std::atomic_load(&m_Entries);
+	EntryMap::const_iterator it = entries->find(audioFilename);
+	if (it != entries->end() && it->second->m_TextModTime == textModTime &&
+			it->second->m_BinaryModTime == binaryModTime)
+	{
+		it->second->m_LastUse = ++m_UseCounter;
+		rv = it->second->m_Reader;
+		found = true;
+	}
+
+	if (!found)
+	{
+		std::shared_ptr<BeatgridFileReader> reader =
+				std::make_shared<BeatgridFileReader>();
+		if (reader->Read(audioFilename))
+		{
+			rv = reader;
+		}
+
+		std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+		entry->m_Reader = rv;
+		entry->m_TextModTime = textModTime;
+		entry->m_BinaryModTime = binaryModTime;
+		entry->m_LastUse = ++m_UseCounter;
+		Insert(audioFilename, entry);
+	}
+
+	return rv;
+}
+
+void BeatgridCache::Clear()
+{
+	std::lock_guard<std::mutex> lck(m_WriteMutex);
+	std::atomic_store(&m_Entries,
+			std::shared_ptr<const EntryMap>(std::make_shared<EntryMap>()));
+}
@@ -0,0 +1,71 @@
+#ifndef SRC_CORE_XFADE_BGFILE_BEATGRIDCACHE_H_
+#define SRC_CORE_XFADE_BGFILE_BEATGRIDCACHE_H_
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "BeatgridFileReader.h"
+
+// A process-wide cache of parsed beatgrid files, keyed by audio file name.
+// An entry is only used while the modification times of the beatgrid files
+// it was read from are unchanged, so edited files are picked up again.
+//
+// Lookups never take a lock:  the table of entries is never modified in
+// place, but is copied, modified and then swapped in by writers.  The number
+// of entries is bounded; when the cache is full, the least recently used
+// entry is evicted.
+class BeatgridCache
+{
+	struct Entry
+	{
+		std::shared_ptr<const BeatgridFileReader> m_Reader;
+		long long m_TextModTime;
+		long long m_BinaryModTime;
+		mutable std::atomic<unsigned long long> m_LastUse;
+
+		Entry();
+	};
+
+	typedef std::map<std::string, std::shared_ptr<const Entry> > EntryMap;
+
+	static const size_t m_DefaultMaxEntries;
+
+	std::shared_ptr<const EntryMap> m_Entries;
+	std::mutex m_WriteMutex;
+	std::atomic<unsigned long long> m_UseCounter;
+	size_t m_MaxEntries;
+
+	static void GetModificationTimes(const std::string & audioFilename,
+			long long & textModTime, long long & binaryModTime);
+	void Insert(const std::string & audioFilename,
+			const std::shared_ptr<const Entry> & entry);
+
+	BeatgridCache();
+public:
+	virtual ~BeatgridCache();
+
+	static BeatgridCache & Instance();
+
+	// Returns the parsed beatgrid file of the given audio file, reading it
+	// if it is not cached or out of date.  A null pointer is returned if the
+	// beatgrid file cannot be read.
+	std::shared_ptr<const BeatgridFileReader> Get(const std::string & audioFilename);
+
+	void Clear();
+
+	// Accessor may be called at any time
+	size_t getMaxEntries() const
+	{
+		return m_MaxEntries;
+	}
+
+	// Mutator must not be called while the cache is in use
+	void setMaxEntries(size_t maxEntries)
+	{
+		m_MaxEntries = maxEntries;
+	}
+};
+
+#endif /* SRC_CORE_XFADE_BGFILE_BEATGRIDCACHE_H_ */
@@ -1,11 +1,415 @@
 #include "BeatgridFileReader.h"
+#include "../../../os/MappedFile.h"
+#include "../../../os/Path.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
 
-BeatgridFileReader::BeatgridFileReader() {
-	// TODO Auto-generated constructor stub
+const std::string BeatgridFileReader::m_TextFileExt = ".bpm";
+const std::string BeatgridFileReader::m_BinaryFileExt = ".bpmb";
+const char BeatgridFileReader::m_Magic[4] = { 'M', 'M', 'B', 'G' };
+const uint32_t BeatgridFileReader::m_ByteOrderMark = 0x01020304;
+const uint32_t BeatgridFileReader::m_Version = 2;
 
+// Binary layout (all fields in native byte order):
+//
+// header:   char magic[4], uint32 byteOrderMark, uint32 version,
+//           uint32 numSections, int64 sourceModificationTime (in ns, or -1
+//           if the sections did not come from a text file)
+// section:  double time, double instantaneousTempo, uint32 hasGrid,
+//           uint32 numSegments, uint32 numBeats, uint32 reserved,
+//           numSegments x { uint32 numBeats, uint32 reserved, double bpm },
+//           (numBeats + 1) x double beatTime (omitted if numBeats is zero)
+
+template <typename T>
+static bool ReadValue(const char *& pos, const char * end, T & value)
+{
+	bool rv = (size_t) (end - pos) >= sizeof(T);
+	if (rv)
+	{
+		memcpy(&value, pos, sizeof(T));
+		pos += sizeof(T);
+	}
+	return rv;
+}
+
+template <typename T>
+static void WriteValue(std::string & out, const T & value)
+{
+	out.append((const char *) &value, sizeof(T));
+}
+
+BeatgridFileReader::BeatgridFileReader()
+: m_SourceModificationTime(-1)
+{
 }
 
 BeatgridFileReader::~BeatgridFileReader() {
 	// TODO Auto-generated destructor stub
 }
 
+std::string BeatgridFileReader::GetTextFilename(const std::string & audioFilename)
+{
+	return audioFilename + m_TextFileExt;
+}
+
+std::string BeatgridFileReader::GetBinaryFilename(const std::string & audioFilename)
+{
+	return audioFilename + m_BinaryFileExt;
+}
+
+void BeatgridFileReader::BuildSection(
+		const std::vector<std::pair<int, double> > & entries,
+		FadeSection & section)
+{
+	std::vector<double> bpmBeatgrid;
+	if (!entries.empty())
+	{
+		bool haveInstTempo = false;
+		const double eps = 2.0 * std::numeric_limits<double>::epsilon();
+		for (std::vector<std::pair<int, double> >::const_iterator
+				it = entries.begin(); it != entries.end(); ++it)
+		{
+			if (it->second >= eps) // BPM must be strictly positive
+			{
+				if (it->first == 0)
+				{
+					haveInstTempo = true;
+					section.SetInstantaneousTempo(it->second);
+				}
+				else
+				{
+					for (int k = 0; k < it->first; ++k)
+					{
+						bpmBeatgrid.push_back(it->second);
+					}
+				}
+			}
+		}
+
+		if (!haveInstTempo)
+		{
+			section.SetInstantaneousTempo(entries.back().second);
+		}
+	}
+	section.GetBeatgrid().SetBPMBeatgrid(std::move(bpmBeatgrid));
+	section.GetBeatgrid().SetHasGrid(!entries.empty());
+}
+
+bool BeatgridFileReader::ReadText(const std::string & path)
+{
+	bool rv = false;
+
+	m_Sections.clear();
+	// The time is taken first, so that an edit made while the file is read
+	// leaves the sections out of date rather than the other way round
+	if (!Path::GetModificationTimeNs(path, m_SourceModificationTime))
+	{
+		m_SourceModificationTime = -1;
+	}
+	std::ifstream ifs(path);
+	if (ifs.good())
+	{
+		bool inSection = false;
+		bool collecting = false;
+		double time;
+		std::vector<std::pair<int, double> > entries;
+		std::string parsedLine;
+		while (std::getline(ifs, parsedLine))
+		{
+			char ch1, ch2;
+			std::istringstream iss(parsedLine);
+			if ((iss >> ch1 >> time >> ch2) && ch1 == '[' && ch2 == ']')
+			{
+				if (inSection)
+				{
+					BuildSection(entries, m_Sections.back());
+				}
+				m_Sections.push_back(FadeSection());
+				m_Sections.back().SetTime(time);
+				entries.clear();
+				inSection = collecting = true;
+			}
+			else if (collecting)
+			{
+				// Entries follow the section header until the first token
+				// that is not an entry
+				int numBeats;
+				double bpm;
+				char ch;
+				iss.clear();
+				iss.seekg(0);
+				while ((iss >> numBeats >> ch >> bpm) && ch == '@')
+				{
+					entries.push_back(std::make_pair(numBeats, bpm));
+				}
+
+				// Keep going on the next line only if nothing but entries
+				// were found on this one
+				collecting = false;
+				if (iss.fail())
+				{
+					iss.clear();
+					collecting = (iss >> std::ws).eof();
+				}
+			}
+		}
+		if (inSection)
+		{
+			BuildSection(entries, m_Sections.back());
+		}
+		rv = true;
+	}
+
+	return rv;
+}
+
+bool BeatgridFileReader::ReadBinarySection(const char *& pos,
+		const char * end, FadeSection & section)
+{
+	bool rv = false;
+
+	// The counts are checked against what is left of the file before
+	// anything is allocated for them, since a damaged file may hold any
+	// count at all
+	const size_t segmentSize = 2 * sizeof(uint32_t) + sizeof(double);
+	double time, instTempo;
+	uint32_t hasGrid, numSegments, numBeats, reserved;
+	if (ReadValue(pos, end, time) && ReadValue(pos, end, instTempo) &&
+			ReadValue(pos, end, hasGrid) && ReadValue(pos, end, numSegments) &&
+			ReadValue(pos, end, numBeats) && ReadValue(pos, end, reserved) &&
+			numSegments <= numBeats &&
+			(size_t) (end - pos) / segmentSize >= numSegments &&
+			((size_t) (end - pos) - numSegments * segmentSize) /
+				sizeof(double) >= (numBeats == 0 ? 0 : (size_t) numBeats + 1))
+	{
+		std::vector<double> bpmBeatgrid;
+		bpmBeatgrid.reserve(numBeats);
+
+		const double eps = 2.0 * std::numeric_limits<double>::epsilon();
+		bool valid = true;
+		for (uint32_t k = 0; valid && k < numSegments; ++k)
+		{
+			uint32_t count;
+			double bpm;
+			valid = ReadValue(pos, end, count) &&
+					ReadValue(pos, end, reserved) &&
+					ReadValue(pos, end, bpm) &&
+					bpm >= eps && count <= numBeats - bpmBeatgrid.size();
+			if (valid)
+			{
+				bpmBeatgrid.insert(bpmBeatgrid.end(), count, bpm);
+			}
+		}
+
+		size_t numTimes = numBeats == 0 ? 0 : (size_t) numBeats + 1;
+		if (valid && bpmBeatgrid.size() == numBeats &&
+				(size_t) (end - pos) / sizeof(double) >= numTimes)
+		{
+			std::vector<double> timeBeatgrid(numTimes);
+			if (numTimes != 0)
+			{
+				memcpy(timeBeatgrid.data(), pos, numTimes * sizeof(double));
+				pos += numTimes * sizeof(double);
+			}
+
+			// The lookups search the beat times, so they must go up
+			for (size_t k = 1; valid && k < numTimes; ++k)
+			{
+				valid = timeBeatgrid[k] > timeBeatgrid[k - 1];
+			}
+
+			if (valid)
+			{
+				section.SetTime(time);
+				section.SetInstantaneousTempo(instTempo);
+				section.GetBeatgrid().SetBeatgrid(std::move(bpmBeatgrid),
+						std::move(timeBeatgrid));
+				section.GetBeatgrid().SetHasGrid(hasGrid != 0);
+				rv = true;
+			}
+		}
+	}
+
+	return rv;
+}
+
+bool BeatgridFileReader::ReadBinary(const std::string & path)
+{
+	bool rv = false;
+
+	m_Sections.clear();
+	MappedFile file;
+	if (file.Open(path))
+	{
+		const char * pos = file.getData();
+		const char * end = pos + file.getSize();
+
+		char magic[sizeof(m_Magic)];
+		uint32_t byteOrderMark, version, numSections;
+		int64_t sourceTime;
+		if (ReadValue(pos, end, magic) &&
+				memcmp(magic, m_Magic, sizeof(m_Magic)) == 0 &&
+				ReadValue(pos, end, byteOrderMark) &&
+				byteOrderMark == m_ByteOrderMark &&
+				ReadValue(pos, end, version) && version == m_Version &&
+				ReadValue(pos, end, numSections) &&
+				ReadValue(pos, end, sourceTime))
+		{
+			m_SourceModificationTime = sourceTime;
+			rv = true;
+			for (uint32_t k = 0; rv && k < numSections; ++k)
+			{
+				m_Sections.push_back(FadeSection());
+				rv = ReadBinarySection(pos, end, m_Sections.back());
+			}
+		}
+	}
+
+	if (!rv)
+	{
+		m_Sections.clear();
+		m_SourceModificationTime = -1;
+	}
+	return rv;
+}
+
+bool BeatgridFileReader::WriteText(const std::string & path) const
+{
+	bool rv = false;
+
+	std::ofstream ofs(path, std::ios::out | std::ios::trunc);
+	if (ofs.good())
+	{
+		ofs << std::fixed << std::setprecision(6);
+		for (std::vector<FadeSection>::const_iterator it = m_Sections.begin();
+				it != m_Sections.end(); ++it)
+		{
+			ofs << '[' << it->GetTime() << ']' << std::endl;
+
+			std::vector<std::pair<size_t, double> > segments =
+					it->GetBeatgrid().GetSegments();
+			for (std::vector<std::pair<size_t, double> >::const_iterator
+					segIt = segments.begin(); segIt != segments.end(); ++segIt)
+			{
+				ofs << segIt->first << '@' << segIt->second << std::endl;
+			}
+			ofs << 0 << '@' << it->GetInstantaneousTempo() << std::endl;
+		}
+		ofs.close();
+		rv = ofs.good();
+	}
+
+	return rv;
+}
+
+void BeatgridFileReader::WriteBinarySection(std::string & out,
+		const FadeSection & section)
+{
+	const Beatgrid & beatgrid = section.GetBeatgrid();
+	std::vector<std::pair<size_t, double> > segments = beatgrid.GetSegments();
+	const uint32_t reserved = 0;
+
+	WriteValue(out, section.GetTime());
+	WriteValue(out, section.GetInstantaneousTempo());
+	WriteValue(out, (uint32_t) (beatgrid.HasGrid() ? 1 : 0));
+	WriteValue(out, (uint32_t) segments.size());
+	WriteValue(out, (uint32_t) beatgrid.size());
+	WriteValue(out, reserved);
+	for (std::vector<std::pair<size_t, double> >::const_iterator
+			it = segments.begin(); it != segments.end(); ++it)
+	{
+		WriteValue(out, (uint32_t) it->first);
+		WriteValue(out, reserved);
+		WriteValue(out, it->second);
+	}
+
+	const std::vector<double> & times = beatgrid.GetTimeBeatgrid();
+	out.append((const char *) times.data(), times.size() * sizeof(double));
+}
+
+bool BeatgridFileReader::WriteBinary(const std::string & path) const
+{
+	bool rv = false;
+
+	std::string out;
+	out.append(m_Magic, sizeof(m_Magic));
+	WriteValue(out, m_ByteOrderMark);
+	WriteValue(out, m_Version);
+	WriteValue(out, (uint32_t) m_Sections.size());
+	WriteValue(out, (int64_t) m_SourceModificationTime);
+	for (std::vector<FadeSection>::const_iterator it = m_Sections.begin();
+			it != m_Sections.end(); ++it)
+	{
+		WriteBinarySection(out, *it);
+	}
+
+	// Write to a temporary file first, so that readers never see a partially
+	// written file
+	const std::string tmpPath = path + ".tmp";
+	std::ofstream ofs(tmpPath, std::ios::out | std::ios::binary |
+			std::ios::trunc);
+	if (ofs.good())
+	{
+		ofs.write(out.data(), out.size());
+		ofs.close();
+		if (ofs.good())
+		{
+#ifdef WIN32
+			std::remove(path.c_str());
+#endif
+			rv = std::rename(tmpPath.c_str(), path.c_str()) == 0;
+		}
+		if (!rv)
+		{
+			std::remove(tmpPath.c_str());
+		}
+	}
+
+	return rv;
+}
+
+bool BeatgridFileReader::ReadCurrentBinary(const std::string & audioFilename)
+{
+	// The binary file records the time of the text file that it was
+	// converted from, rather than being compared with it by its own time,
+	// which need not have moved on since (the clock of the file system only
+	// moves every second on Windows)
+	long long textTime = 0;
+	bool haveText = Path::GetModificationTimeNs(
+			GetTextFilename(audioFilename), textTime);
+	bool rv = ReadBinary(GetBinaryFilename(audioFilename)) &&
+			(!haveText || m_SourceModificationTime == textTime);
+	if (!rv)
+	{
+		m_Sections.clear();
+	}
+	return rv;
+}
+
+bool BeatgridFileReader::IsBinaryFileCurrent(const std::string & audioFilename)
+{
+	BeatgridFileReader reader;
+	return reader.ReadCurrentBinary(audioFilename);
+}
+
+bool BeatgridFileReader::Read(const std::string & audioFilename)
+{
+	bool rv = ReadCurrentBinary(audioFilename);
+	if (!rv)
+	{
+		rv = ReadText(GetTextFilename(audioFilename));
+	}
+	return rv;
+}
+
+bool BeatgridFileReader::ConvertTextFile(const std::string & audioFilename)
+{
+	BeatgridFileReader reader;
+	return reader.ReadText(GetTextFilename(audioFilename)) &&
+			reader.m_SourceModificationTime != -1 &&
+			reader.WriteBinary(GetBinaryFilename(audioFilename));
+}
@@ -1,10 +1,102 @@
 #ifndef SRC_CORE_XFADE_BGFILE_BEATGRIDFILEREADER_H_
 #define SRC_CORE_XFADE_BGFILE_BEATGRIDFILEREADER_H_
 
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "FadeSection.h"
+
+// Reads and writes the beatgrid files that accompany audio files.  There are
+// two formats:
+//
+// - The text format (<audio file>.bpm), which is written by hand.  Each fade
+//   section starts with a line of the form "[time]" and is followed by
+//   entries of the form "N@bpm" (N beats at the given BPM, or the tempo just
+//   after the section ends if N is zero).
+//
+// - The binary format (<audio file>.bpmb), which holds the same sections in
+//   run-length form together with the precomputed beat times, so that it can
+//   be memory-mapped and loaded without any parsing.  It is written in the
+//   byte order of the machine that produced it and is rejected on a machine
+//   with a different byte order.
+//
+// The first section of a file describes the fade into the track, and the
+// second section describes the fade out of the track.
 class BeatgridFileReader {
+	static const std::string m_TextFileExt;
+	static const std::string m_BinaryFileExt;
+	static const char m_Magic[4];
+	static const uint32_t m_ByteOrderMark;
+	static const uint32_t m_Version;
+
+	std::vector<FadeSection> m_Sections;
+
+	// Modification time (in ns) of the text file that the sections were read
+	// from, or -1
+	long long m_SourceModificationTime;
+
+	static void BuildSection(const std::vector<std::pair<int, double> > & entries,
+			FadeSection & section);
+	static bool ReadBinarySection(const char *& pos, const char * end,
+			FadeSection & section);
+	static void WriteBinarySection(std::string & out, const FadeSection & section);
+
+	bool ReadCurrentBinary(const std::string & audioFilename);
 public:
+	enum SectionIndex
+	{
+		FADE_IN_SECTION = 0,
+		FADE_OUT_SECTION = 1
+	};
+
 	BeatgridFileReader();
 	virtual ~BeatgridFileReader();
+
+	static std::string GetTextFilename(const std::string & audioFilename);
+	static std::string GetBinaryFilename(const std::string & audioFilename);
+
+	// True if the binary beatgrid file of an audio file can be read and was
+	// converted from the text file as it is now (or there is no text file).
+	// The binary file records the modification time of the text file for
+	// this.
+	static bool IsBinaryFileCurrent(const std::string & audioFilename);
+
+	// Reads the beatgrid file of an audio file:  the binary file if it is
+	// current, and the text file otherwise.  Nothing is written; binary
+	// files are made by the analyzer or by ConvertTextFile().
+	bool Read(const std::string & audioFilename);
+
+	bool ReadText(const std::string & path);
+	bool ReadBinary(const std::string & path);
+	bool WriteText(const std::string & path) const;
+	bool WriteBinary(const std::string & path) const;
+
+	// Converts the text beatgrid file of an audio file to the binary format
+	static bool ConvertTextFile(const std::string & audioFilename);
+
+	const std::vector<FadeSection> & GetSections() const
+	{
+		return m_Sections;
+	}
+
+	void SetSections(std::vector<FadeSection> && sections)
+	{
+		m_Sections = std::move(sections);
+		m_SourceModificationTime = -1;
+	}
+
+	// A section is only usable if it has at least one beatgrid entry
+	bool HasSection(size_t index) const
+	{
+		return index < m_Sections.size() &&
+				m_Sections[index].GetBeatgrid().HasGrid();
+	}
+
+	const FadeSection & GetSection(size_t index) const
+	{
+		return m_Sections.at(index);
+	}
 };
 
 #endif /* SRC_CORE_XFADE_BGFILE_BEATGRIDFILEREADER_H_ */
@@ -1,12 +1,10 @@
 #include "FadeSection.h"
 
 FadeSection::FadeSection()
-: m_Time(0), m_FadeOutTime(0.0), m_InstantaneousFadeOutTempo(0.0)
+: m_Time(0.0), m_InstantaneousTempo(0.0)
 {
-	// TODO Auto-generated constructor stub
 }
 
 FadeSection::~FadeSection() {
 	// TODO Auto-generated destructor stub
 }
-
@@ -1,24 +1,50 @@
 #ifndef SRC_CORE_XFADE_BGFILE_FADESECTION_H_
 #define SRC_CORE_XFADE_BGFILE_FADESECTION_H_
 
-#include <vector>
-#include <cstring>
+#include "Beatgrid.h"
 
+// A section of a track over which a fade takes place:  the time at which the
+// section starts, the beatgrid of the section, and the tempo just after the
+// section ends
 class FadeSection
 {
-	size_t m_Time;
-
-	double m_FadeOutTime;
-	double m_InstantaneousFadeOutTempo;
-	std::vector<double> m_FadeOutInfo;
+	double m_Time;
+	double m_InstantaneousTempo;
+	Beatgrid m_Beatgrid;
 
 public:
 	FadeSection();
 	virtual ~FadeSection();
 
-	virtual const char * SectionName() const = 0;
-
-
+	double GetTime() const
+	{
+		return m_Time;
+	}
+
+	void SetTime(double time)
+	{
+		m_Time = time;
+	}
+
+	double GetInstantaneousTempo() const
+	{
+		return m_InstantaneousTempo;
+	}
+
+	void SetInstantaneousTempo(double tempo)
+	{
+		m_InstantaneousTempo = tempo;
+	}
+
+	const Beatgrid & GetBeatgrid() const
+	{
+		return m_Beatgrid;
+	}
+
+	Beatgrid & GetBeatgrid()
+	{
+		return m_Beatgrid;
+	}
 };
 
 #endif /* SRC_CORE_XFADE_BGFILE_FADESECTION_H_ */
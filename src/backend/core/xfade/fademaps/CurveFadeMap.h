@@ -0,0 +1,36 @@
+#ifndef SRC_CORE_XFADE_FADEMAPS_CURVEFADEMAP_H_
+#define SRC_CORE_XFADE_FADEMAPS_CURVEFADEMAP_H_
+
+#include "FadeMap.h"
+
+// A fade map for any of the curves in FadeCurves.h
+template <class Curve>
+class CurveFadeMap: public FadeMap {
+	Curve m_Curve;
+public:
+	explicit CurveFadeMap(const Curve & curve = Curve())
+	: m_Curve(curve)
+	{
+		m_CurveTable.Fill(m_Curve);
+	}
+
+	virtual ~CurveFadeMap() {}
+
+	const Curve & GetCurve() const
+	{
+		return m_Curve;
+	}
+
+	double MapCrossfadeVolume(double volume) const
+	{
+		return m_Curve(volume);
+	}
+};
+
+typedef CurveFadeMap<EqualPowerFadeCurve> EqualPowerFadeMap;
+typedef CurveFadeMap<LogarithmicFadeCurve> LogarithmicFadeMap;
+typedef CurveFadeMap<SCurveFadeCurve> SCurveFadeMap;
+typedef CurveFadeMap<SwapFadeCurve> SwapFadeMap;
+typedef CurveFadeMap<BezierFadeCurve> BezierFadeMap;
+
+#endif /* SRC_CORE_XFADE_FADEMAPS_CURVEFADEMAP_H_ */
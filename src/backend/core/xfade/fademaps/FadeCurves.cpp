@@ -0,0 +1,91 @@
+#include "FadeCurves.h"
+#include "../../../util/MathConstants.h"
+#include <cmath>
+
+// Range of the logarithmic curve, in dB
+const double LogarithmicFadeCurve::m_DefaultRange = 60.0;
+
+// Fraction of the fade over which the swap curve cuts in
+const double SwapFadeCurve::m_DefaultWidth = 0.0625;
+
+// Enough to find the parameter of the Bezier curve to double precision
+const size_t BezierFadeCurve::m_NumBisections = 52;
+
+double KneeFadeCurve::operator()(double volume) const
+{
+	double mappedVolume = 0.0;
+	if (volume < m_KneeLocation)
+	{
+		mappedVolume = (volume / m_KneeLocation) * m_LevelAtKnee;
+	}
+	else
+	{
+		double num = 1.0 - m_LevelAtKnee;
+		double offVol = volume - m_KneeLocation;
+		double denom = 1.0 - m_KneeLocation;
+		mappedVolume = m_LevelAtKnee + (offVol / denom) * num;
+	}
+	return mappedVolume;
+}
+
+double EqualPowerFadeCurve::operator()(double volume) const
+{
+	return sin(0.5 * MathConstants::Pi * volume);
+}
+
+LogarithmicFadeCurve::LogarithmicFadeCurve()
+: m_Range(m_DefaultRange)
+{
+}
+
+double LogarithmicFadeCurve::operator()(double volume) const
+{
+	return volume > 0.0 ? pow(10.0, (volume - 1.0) * m_Range / 20.0) : 0.0;
+}
+
+SwapFadeCurve::SwapFadeCurve()
+: m_Width(m_DefaultWidth)
+{
+}
+
+BezierFadeCurve::BezierFadeCurve()
+: m_X1(0.42), m_Y1(0.0), m_X2(0.58), m_Y2(1.0)
+{
+}
+
+BezierFadeCurve::BezierFadeCurve(double x1, double y1, double x2, double y2)
+: m_X1(x1), m_Y1(y1), m_X2(x2), m_Y2(y2)
+{
+}
+
+double BezierFadeCurve::Evaluate(double p1, double p2, double t)
+{
+	double s = 1.0 - t;
+	return 3.0 * s * s * t * p1 + 3.0 * s * t * t * p2 + t * t * t;
+}
+
+double BezierFadeCurve::operator()(double volume) const
+{
+	// x rises monotonically with the parameter, so the parameter at which
+	// it reaches the volume is found by bisection
+	double lo = 0.0;
+	double hi = 1.0;
+	for (size_t k = 0; k != m_NumBisections; ++k)
+	{
+		double mid = 0.5 * (lo + hi);
+		if (Evaluate(m_X1, m_X2, mid) < volume)
+		{
+			lo = mid;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return Evaluate(m_Y1, m_Y2, 0.5 * (lo + hi));
+}
+
+FadeCurveTable::FadeCurveTable()
+{
+	Fill(LinearFadeCurve());
+}
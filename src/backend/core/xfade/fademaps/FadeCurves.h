@@ -0,0 +1,149 @@
+#ifndef SRC_CORE_XFADE_FADEMAPS_FADECURVES_H_
+#define SRC_CORE_XFADE_FADEMAPS_FADECURVES_H_
+
+#include <algorithm>
+#include <cstddef>
+
+// Fade curves, each of which maps a crossfade volume (which runs linearly
+// from 0 to 1 over the fade) to the gain that is applied to the track.  The
+// curves are plain functors, so they can be handed to templates and inlined;
+// the fade maps wrap them for the code that selects a curve at run time.
+
+class LinearFadeCurve
+{
+public:
+	double operator()(double volume) const
+	{
+		return volume;
+	}
+};
+
+// Rises linearly to the given level at the knee, then linearly to full
+// volume
+class KneeFadeCurve
+{
+	double m_KneeLocation;
+	double m_LevelAtKnee;
+public:
+	KneeFadeCurve(double kneeLocation, double levelAtKnee)
+	: m_KneeLocation(kneeLocation), m_LevelAtKnee(levelAtKnee)
+	{
+	}
+
+	double operator()(double volume) const;
+};
+
+// Keeps the summed power of two crossfaded (uncorrelated) tracks constant
+class EqualPowerFadeCurve
+{
+public:
+	double operator()(double volume) const;
+};
+
+// Linear in decibels over the given range, below which the track is cut off
+class LogarithmicFadeCurve
+{
+	static const double m_DefaultRange;
+
+	double m_Range;
+public:
+	LogarithmicFadeCurve();
+	explicit LogarithmicFadeCurve(double range) : m_Range(range) {}
+
+	double operator()(double volume) const;
+};
+
+// Eases in and out of the fade (smoothstep)
+class SCurveFadeCurve
+{
+public:
+	double operator()(double volume) const
+	{
+		return volume * volume * (3.0 - 2.0 * volume);
+	}
+};
+
+// Cuts in over a short stretch around the middle of the fade.  The curves of
+// the two tracks always add up to one, so one track takes over from the other
+// (a bass swap, say) without the two ever playing together at full volume.
+class SwapFadeCurve
+{
+	static const double m_DefaultWidth;
+
+	double m_Width;
+public:
+	SwapFadeCurve();
+	explicit SwapFadeCurve(double width) : m_Width(width) {}
+
+	double operator()(double volume) const
+	{
+		return std::min(std::max((volume - 0.5) / m_Width + 0.5, 0.0), 1.0);
+	}
+};
+
+// Cubic Bezier curve from (0, 0) to (1, 1) with two user-defined control
+// points, as in CSS easing functions.  The x coordinates of the control
+// points must lie within [0, 1], so that the curve is a function of x.
+class BezierFadeCurve
+{
+	static const size_t m_NumBisections;
+
+	double m_X1;
+	double m_Y1;
+	double m_X2;
+	double m_Y2;
+
+	static double Evaluate(double p1, double p2, double t);
+public:
+	BezierFadeCurve();
+	BezierFadeCurve(double x1, double y1, double x2, double y2);
+
+	double GetX1() const { return m_X1; }
+	double GetY1() const { return m_Y1; }
+	double GetX2() const { return m_X2; }
+	double GetY2() const { return m_Y2; }
+
+	double operator()(double volume) const;
+};
+
+// A fade curve sampled at regular steps of the volume and interpolated
+// linearly in between.  Looking up a gain costs the same for every curve and
+// involves no virtual call, so it can be done for every sample of a gain
+// ramp.  Piecewise linear curves with their corners on the grid (such as the
+// default knee) are reproduced exactly.
+class FadeCurveTable
+{
+	static const size_t m_NumSteps = 1024;
+
+	float m_Gains[m_NumSteps + 1];
+public:
+	// Starts out linear
+	FadeCurveTable();
+
+	template <class Curve>
+	explicit FadeCurveTable(const Curve & curve)
+	{
+		Fill(curve);
+	}
+
+	template <class Curve>
+	void Fill(const Curve & curve)
+	{
+		for (size_t k = 0; k <= m_NumSteps; ++k)
+		{
+			m_Gains[k] = curve((double) k / m_NumSteps);
+		}
+	}
+
+	double operator()(double volume) const
+	{
+		// Clamped without branches, so that the loop around the lookup
+		// stays tight
+		double pos = std::min(std::max(volume, 0.0), 1.0) * m_NumSteps;
+		size_t index = std::min((size_t) pos, m_NumSteps - 1);
+		double frac = pos - index;
+		return m_Gains[index] + frac * (m_Gains[index + 1] - m_Gains[index]);
+	}
+};
+
+#endif /* SRC_CORE_XFADE_FADEMAPS_FADECURVES_H_ */
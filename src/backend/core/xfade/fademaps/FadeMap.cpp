@@ -1,4 +1,8 @@
 #include "FadeMap.h"
+#include "CurveFadeMap.h"
+#include "KneeFadeMap.h"
+#include "LinearFadeMap.h"
+#include <cstdio>
 
 FadeMap::FadeMap() {
 	// TODO Auto-generated constructor stub
@@ -9,3 +13,51 @@ FadeMap::~FadeMap() {
 	// TODO Auto-generated destructor stub
 }
 
+std::unique_ptr<FadeMap> FadeMap::CreateFromSetting(const std::string & setting)
+{
+	std::unique_ptr<FadeMap> rv;
+	double range, width, x1, y1, x2, y2;
+	char extra;
+	if (setting == "linear")
+	{
+		rv.reset(new LinearFadeMap);
+	}
+	else if (setting == "knee")
+	{
+		rv.reset(new KneeFadeMap);
+	}
+	else if (setting == "equal-power")
+	{
+		rv.reset(new EqualPowerFadeMap);
+	}
+	else if (setting == "s-curve")
+	{
+		rv.reset(new SCurveFadeMap);
+	}
+	else if (setting == "log")
+	{
+		rv.reset(new LogarithmicFadeMap);
+	}
+	else if (sscanf(setting.c_str(), "log:%lf%c", &range, &extra) == 1 &&
+			range > 0.0)
+	{
+		rv.reset(new LogarithmicFadeMap(LogarithmicFadeCurve(range)));
+	}
+	else if (setting == "swap")
+	{
+		rv.reset(new SwapFadeMap);
+	}
+	else if (sscanf(setting.c_str(), "swap:%lf%c", &width, &extra) == 1 &&
+			width > 0.0)
+	{
+		rv.reset(new SwapFadeMap(SwapFadeCurve(width)));
+	}
+	else if (sscanf(setting.c_str(), "bezier:%lf,%lf,%lf,%lf%c",
+			&x1, &y1, &x2, &y2, &extra) == 4 &&
+			x1 >= 0.0 && x1 <= 1.0 && y1 >= 0.0 && y1 <= 1.0 &&
+			x2 >= 0.0 && x2 <= 1.0 && y2 >= 0.0 && y2 <= 1.0)
+	{
+		rv.reset(new BezierFadeMap(BezierFadeCurve(x1, y1, x2, y2)));
+	}
+	return rv;
+}
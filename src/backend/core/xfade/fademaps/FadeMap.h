@@ -1,12 +1,34 @@
 #ifndef SRC_CORE_XFADE_FADEMAPS_FADEMAP_H_
 #define SRC_CORE_XFADE_FADEMAPS_FADEMAP_H_
 
+#include "FadeCurves.h"
+#include <memory>
+#include <string>
+
 class FadeMap {
+protected:
+	// Subclasses fill this with their curve when they are constructed
+	FadeCurveTable m_CurveTable;
 public:
 	FadeMap();
 	virtual ~FadeMap();
 
+	// Creates the fade map that a setting describes, which is one of
+	// "linear", "knee", "equal-power", "s-curve", "log", "log:<range in dB>",
+	// "swap", "swap:<width>" (as a fraction of the fade) or
+	// "bezier:<x1>,<y1>,<x2>,<y2>" (the control points of the curve, each
+	// within the unit square, so that the gain never leaves [0, 1]).
+	// Returns null if the setting is not understood.
+	static std::unique_ptr<FadeMap> CreateFromSetting(
+			const std::string & setting);
+
 	virtual double MapCrossfadeVolume(double volume) const = 0;
+
+	// The same mapping as a table, for evaluating it sample by sample
+	const FadeCurveTable & GetCurveTable() const
+	{
+		return m_CurveTable;
+	}
 };
 
 #endif /* SRC_CORE_XFADE_FADEMAPS_FADEMAP_H_ */
@@ -6,6 +6,7 @@ const double KneeFadeMap::m_DefaultLevelAtKnee = 0.75;
 KneeFadeMap::KneeFadeMap()
 : m_KneeLocation(m_DefaultKneeLocation), m_LevelAtKnee(m_DefaultLevelAtKnee)
 {
+	m_CurveTable.Fill(KneeFadeCurve(m_KneeLocation, m_LevelAtKnee));
 }
 
 KneeFadeMap::~KneeFadeMap() {
@@ -14,17 +15,5 @@ KneeFadeMap::~KneeFadeMap() {
 
 double KneeFadeMap::MapCrossfadeVolume(double volume) const
 {
-	double mappedVolume = 0.0;
-	if (volume < m_KneeLocation)
-	{
-		mappedVolume = (volume / m_KneeLocation) * m_LevelAtKnee;
-	}
-	else
-	{
-		double num = 1.0 - m_LevelAtKnee;
-		double offVol = volume - m_KneeLocation;
-		double denom = 1.0 - m_KneeLocation;
-		mappedVolume = m_LevelAtKnee + (offVol / denom) * num;
-	}
-	return mappedVolume;
+	return KneeFadeCurve(m_KneeLocation, m_LevelAtKnee)(volume);
 }
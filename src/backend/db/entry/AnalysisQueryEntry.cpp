@@ -0,0 +1,11 @@
+#include "AnalysisQueryEntry.h"
+
+AnalysisQueryEntry::AnalysisQueryEntry()
+: FileQueryEntry(), m_ModificationTime(0), m_Status(STATUS_FAILED),
+  m_Tempo(0.0), m_Duration(0.0), m_AnalysisTime(0.0)
+{
+}
+
+AnalysisQueryEntry::~AnalysisQueryEntry()
+{
+}
@@ -0,0 +1,44 @@
+#ifndef SRC_DB_ENTRY_ANALYSISQUERYENTRY_H_
+#define SRC_DB_ENTRY_ANALYSISQUERYENTRY_H_
+
+#include "FileQueryEntry.h"
+
+// The outcome of the beat analysis of one audio file.  The modification time
+// of the file at the time of the analysis is kept, so that a file is analyzed
+// again once it changes.
+class AnalysisQueryEntry : public FileQueryEntry {
+public:
+	enum Status
+	{
+		STATUS_FAILED,
+		STATUS_DONE
+	};
+
+private:
+	long long m_ModificationTime;
+	Status m_Status;
+	double m_Tempo;
+	double m_Duration;
+	double m_AnalysisTime;
+public:
+	AnalysisQueryEntry();
+	virtual ~AnalysisQueryEntry();
+
+	long long getModificationTime() const { return m_ModificationTime; }
+	void setModificationTime(long long mtime) { m_ModificationTime = mtime; }
+
+	Status getStatus() const { return m_Status; }
+	void setStatus(Status status) { m_Status = status; }
+
+	double getTempo() const { return m_Tempo; }
+	void setTempo(double tempo) { m_Tempo = tempo; }
+
+	double getDuration() const { return m_Duration; }
+	void setDuration(double duration) { m_Duration = duration; }
+
+	// Wall-clock time (in seconds) it took to analyze the file
+	double getAnalysisTime() const { return m_AnalysisTime; }
+	void setAnalysisTime(double time) { m_AnalysisTime = time; }
+};
+
+#endif /* SRC_DB_ENTRY_ANALYSISQUERYENTRY_H_ */
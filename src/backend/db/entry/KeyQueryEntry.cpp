@@ -0,0 +1,10 @@
+#include "KeyQueryEntry.h"
+
+KeyQueryEntry::KeyQueryEntry()
+: FileQueryEntry(), m_ModificationTime(0), m_Strength(0.0)
+{
+}
+
+KeyQueryEntry::~KeyQueryEntry()
+{
+}
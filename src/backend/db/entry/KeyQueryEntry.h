@@ -0,0 +1,29 @@
+#ifndef SRC_DB_ENTRY_KEYQUERYENTRY_H_
+#define SRC_DB_ENTRY_KEYQUERYENTRY_H_
+
+#include "FileQueryEntry.h"
+#include "../../core/analysis/key/MusicalKey.h"
+
+// The musical key of one audio file, as estimated by a KeyAnalyzer.  The
+// modification time of the file at the time of the analysis is kept, so that
+// a file is analyzed again once it changes.
+class KeyQueryEntry : public FileQueryEntry {
+	long long m_ModificationTime;
+	MusicalKey m_Key;
+	double m_Strength;
+public:
+	KeyQueryEntry();
+	virtual ~KeyQueryEntry();
+
+	long long getModificationTime() const { return m_ModificationTime; }
+	void setModificationTime(long long mtime) { m_ModificationTime = mtime; }
+
+	const MusicalKey & getKey() const { return m_Key; }
+	void setKey(const MusicalKey & key) { m_Key = key; }
+
+	// From -1 to 1, as KeyAnalyzer::getStrength()
+	double getStrength() const { return m_Strength; }
+	void setStrength(double strength) { m_Strength = strength; }
+};
+
+#endif /* SRC_DB_ENTRY_KEYQUERYENTRY_H_ */
@@ -0,0 +1,11 @@
+#include "LoudnessQueryEntry.h"
+
+LoudnessQueryEntry::LoudnessQueryEntry()
+: FileQueryEntry(), m_ModificationTime(0), m_IntegratedLoudness(0.0),
+  m_LoudnessRange(0.0), m_TruePeak(0.0), m_Duration(0.0)
+{
+}
+
+LoudnessQueryEntry::~LoudnessQueryEntry()
+{
+}
@@ -0,0 +1,41 @@
+#ifndef SRC_DB_ENTRY_LOUDNESSQUERYENTRY_H_
+#define SRC_DB_ENTRY_LOUDNESSQUERYENTRY_H_
+
+#include "FileQueryEntry.h"
+
+// The loudness of one audio file, as measured by a LoudnessMeter.  The
+// modification time of the file at the time of the measurement is kept, so
+// that a file is measured again once it changes.
+class LoudnessQueryEntry : public FileQueryEntry {
+	long long m_ModificationTime;
+	double m_IntegratedLoudness;
+	double m_LoudnessRange;
+	double m_TruePeak;
+	double m_Duration;
+public:
+	LoudnessQueryEntry();
+	virtual ~LoudnessQueryEntry();
+
+	long long getModificationTime() const { return m_ModificationTime; }
+	void setModificationTime(long long mtime) { m_ModificationTime = mtime; }
+
+	// In LUFS
+	double getIntegratedLoudness() const { return m_IntegratedLoudness; }
+	void setIntegratedLoudness(double loudness)
+	{
+		m_IntegratedLoudness = loudness;
+	}
+
+	// In LU
+	double getLoudnessRange() const { return m_LoudnessRange; }
+	void setLoudnessRange(double range) { m_LoudnessRange = range; }
+
+	// In dBTP
+	double getTruePeak() const { return m_TruePeak; }
+	void setTruePeak(double truePeak) { m_TruePeak = truePeak; }
+
+	double getDuration() const { return m_Duration; }
+	void setDuration(double duration) { m_Duration = duration; }
+};
+
+#endif /* SRC_DB_ENTRY_LOUDNESSQUERYENTRY_H_ */
@@ -0,0 +1,81 @@
+#include "AnalysisQueryInterface.h"
+#include "../../util/StrUtil.h"
+#include <cstdlib>
+
+const std::string AnalysisQueryInterface::m_TableName = "analysis";
+const std::string AnalysisQueryInterface::m_FilenameColumn = "filename";
+const std::string AnalysisQueryInterface::m_ModificationTimeColumn = "mtime";
+const std::string AnalysisQueryInterface::m_StatusColumn = "status";
+const std::string AnalysisQueryInterface::m_TempoColumn = "tempo";
+const std::string AnalysisQueryInterface::m_DurationColumn = "duration";
+const std::string AnalysisQueryInterface::m_AnalysisTimeColumn =
+		"analysis_time";
+const std::string AnalysisQueryInterface::m_ColumnSpec =
+		AnalysisQueryInterface::m_FilenameColumn +
+			" varchar(255) PRIMARY KEY NOT NULL, " +
+		AnalysisQueryInterface::m_ModificationTimeColumn +
+			" integer NOT NULL, " +
+		AnalysisQueryInterface::m_StatusColumn + " integer NOT NULL, " +
+		AnalysisQueryInterface::m_TempoColumn + " real NOT NULL, " +
+		AnalysisQueryInterface::m_DurationColumn + " real NOT NULL, " +
+		AnalysisQueryInterface::m_AnalysisTimeColumn + " real NOT NULL";
+
+AnalysisQueryInterface::AnalysisQueryInterface(SettingsDB & db)
+: QueryInterface(db)
+{
+}
+
+AnalysisQueryInterface::~AnalysisQueryInterface()
+{
+}
+
+bool AnalysisQueryInterface::TableExists()
+{
+	return QueryInterface::TableExists(m_TableName);
+}
+
+bool AnalysisQueryInterface::CreateTable()
+{
+	return QueryInterface::CreateTable(m_TableName, m_ColumnSpec);
+}
+
+bool AnalysisQueryInterface::EnsureTableExists()
+{
+	return QueryInterface::EnsureTableExists(m_TableName, m_ColumnSpec);
+}
+
+bool AnalysisQueryInterface::GetEntry(const std::string & filename,
+		AnalysisQueryEntry & entry)
+{
+	bool found = false;
+	bool rv = m_Db->Query("SELECT * FROM " + m_TableName + " WHERE " +
+			m_FilenameColumn + "='" + SettingsDB::FmtStr(filename) + '\'',
+		[&] (const SettingsDB::RowType & row)
+		{
+			entry.setFilename(row.at(m_FilenameColumn));
+			entry.setModificationTime(
+				strtoll(row.at(m_ModificationTimeColumn).c_str(), nullptr, 10));
+			entry.setStatus(
+				(AnalysisQueryEntry::Status) atoi(row.at(m_StatusColumn).c_str()));
+			entry.setTempo(strtod(row.at(m_TempoColumn).c_str(), nullptr));
+			entry.setDuration(strtod(row.at(m_DurationColumn).c_str(), nullptr));
+			entry.setAnalysisTime(
+				strtod(row.at(m_AnalysisTimeColumn).c_str(), nullptr));
+			found = true;
+			return true;
+		});
+	return rv && found;
+}
+
+bool AnalysisQueryInterface::UpdateDbWithEntry(const AnalysisQueryEntry & entry)
+{
+	return m_Db->Query("INSERT OR REPLACE INTO " + m_TableName + " (" +
+			m_FilenameColumn + ", " + m_ModificationTimeColumn + ", " +
+			m_StatusColumn + ", " + m_TempoColumn + ", " + m_DurationColumn +
+			", " + m_AnalysisTimeColumn + ") VALUES ('" +
+			SettingsDB::FmtStr(entry.getFilename()) + "', " +
+			StrUtil::format("%lld, %d, %.17g, %.17g, %.17g",
+				entry.getModificationTime(), (int) entry.getStatus(),
+				entry.getTempo(), entry.getDuration(),
+				entry.getAnalysisTime()) + ')');
+}
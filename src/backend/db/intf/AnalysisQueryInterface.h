@@ -0,0 +1,35 @@
+#ifndef SRC_DB_INTF_ANALYSISQUERYINTERFACE_H_
+#define SRC_DB_INTF_ANALYSISQUERYINTERFACE_H_
+
+#include "QueryInterface.h"
+#include "../entry/AnalysisQueryEntry.h"
+
+// Records the progress of batch beat analysis, so that an interrupted run can
+// be resumed without analyzing the same files again
+class AnalysisQueryInterface : public QueryInterface {
+	static const std::string m_TableName;
+	static const std::string m_FilenameColumn;
+	static const std::string m_ModificationTimeColumn;
+	static const std::string m_StatusColumn;
+	static const std::string m_TempoColumn;
+	static const std::string m_DurationColumn;
+	static const std::string m_AnalysisTimeColumn;
+	static const std::string m_ColumnSpec;
+
+	bool TableExists();
+	bool CreateTable();
+public:
+	AnalysisQueryInterface(SettingsDB & db);
+	virtual ~AnalysisQueryInterface();
+
+	bool EnsureTableExists();
+
+	// Looks up the entry of the given file.  False is returned if the file
+	// has never been analyzed.
+	bool GetEntry(const std::string & filename, AnalysisQueryEntry & entry);
+
+	// Adds the entry, replacing any earlier entry of the same file
+	bool UpdateDbWithEntry(const AnalysisQueryEntry & entry);
+};
+
+#endif /* SRC_DB_INTF_ANALYSISQUERYINTERFACE_H_ */
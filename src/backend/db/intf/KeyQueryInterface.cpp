@@ -0,0 +1,78 @@
+#include "KeyQueryInterface.h"
+#include "../../util/StrUtil.h"
+#include <cstdlib>
+
+// "key" is a keyword in SQL
+const std::string KeyQueryInterface::m_TableName = "musical_key";
+const std::string KeyQueryInterface::m_FilenameColumn = "filename";
+const std::string KeyQueryInterface::m_ModificationTimeColumn = "mtime";
+const std::string KeyQueryInterface::m_TonicColumn = "tonic";
+const std::string KeyQueryInterface::m_ModeColumn = "mode";
+const std::string KeyQueryInterface::m_StrengthColumn = "strength";
+const std::string KeyQueryInterface::m_ColumnSpec =
+		KeyQueryInterface::m_FilenameColumn +
+			" varchar(255) PRIMARY KEY NOT NULL, " +
+		KeyQueryInterface::m_ModificationTimeColumn + " integer NOT NULL, " +
+		KeyQueryInterface::m_TonicColumn + " integer NOT NULL, " +
+		KeyQueryInterface::m_ModeColumn + " integer NOT NULL, " +
+		KeyQueryInterface::m_StrengthColumn + " real NOT NULL";
+
+KeyQueryInterface::KeyQueryInterface(SettingsDB & db)
+: QueryInterface(db)
+{
+}
+
+KeyQueryInterface::~KeyQueryInterface()
+{
+}
+
+bool KeyQueryInterface::TableExists()
+{
+	return QueryInterface::TableExists(m_TableName);
+}
+
+bool KeyQueryInterface::CreateTable()
+{
+	return QueryInterface::CreateTable(m_TableName, m_ColumnSpec);
+}
+
+bool KeyQueryInterface::EnsureTableExists()
+{
+	return QueryInterface::EnsureTableExists(m_TableName, m_ColumnSpec);
+}
+
+bool KeyQueryInterface::GetEntry(const std::string & filename,
+		KeyQueryEntry & entry)
+{
+	bool found = false;
+	bool rv = m_Db->Query("SELECT * FROM " + m_TableName + " WHERE " +
+			m_FilenameColumn + "='" + SettingsDB::FmtStr(filename) + '\'',
+		[&] (const SettingsDB::RowType & row)
+		{
+			entry.setFilename(row.at(m_FilenameColumn));
+			entry.setModificationTime(
+				strtoll(row.at(m_ModificationTimeColumn).c_str(), nullptr, 10));
+			int tonic = atoi(row.at(m_TonicColumn).c_str());
+			int mode = atoi(row.at(m_ModeColumn).c_str());
+			entry.setKey(MusicalKey(tonic, mode == MusicalKey::MODE_MINOR ?
+					MusicalKey::MODE_MINOR : MusicalKey::MODE_MAJOR));
+			entry.setStrength(strtod(row.at(m_StrengthColumn).c_str(), nullptr));
+			found = true;
+			return true;
+		});
+	return rv && found;
+}
+
+bool KeyQueryInterface::UpdateDbWithEntry(const KeyQueryEntry & entry)
+{
+	return m_Db->Query("INSERT OR REPLACE INTO " + m_TableName + " (" +
+			m_FilenameColumn + ", " + m_ModificationTimeColumn + ", " +
+			m_TonicColumn + ", " + m_ModeColumn + ", " +
+			m_StrengthColumn + ") VALUES ('" +
+			SettingsDB::FmtStr(entry.getFilename()) + "', " +
+			StrUtil::format("%lld, %d, %d, %.17g",
+				entry.getModificationTime(),
+				entry.getKey().getTonic(),
+				(int) entry.getKey().getMode(),
+				entry.getStrength()) + ')');
+}
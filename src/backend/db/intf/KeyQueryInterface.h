@@ -0,0 +1,34 @@
+#ifndef SRC_DB_INTF_KEYQUERYINTERFACE_H_
+#define SRC_DB_INTF_KEYQUERYINTERFACE_H_
+
+#include "QueryInterface.h"
+#include "../entry/KeyQueryEntry.h"
+
+// Caches the musical key of each audio file, so that transitions can be
+// scored by MusicalKey::GetCompatibility() without analyzing tracks again
+class KeyQueryInterface : public QueryInterface {
+	static const std::string m_TableName;
+	static const std::string m_FilenameColumn;
+	static const std::string m_ModificationTimeColumn;
+	static const std::string m_TonicColumn;
+	static const std::string m_ModeColumn;
+	static const std::string m_StrengthColumn;
+	static const std::string m_ColumnSpec;
+
+	bool TableExists();
+	bool CreateTable();
+public:
+	KeyQueryInterface(SettingsDB & db);
+	virtual ~KeyQueryInterface();
+
+	bool EnsureTableExists();
+
+	// Looks up the entry of the given file.  False is returned if the file
+	// has never been analyzed.
+	bool GetEntry(const std::string & filename, KeyQueryEntry & entry);
+
+	// Adds the entry, replacing any earlier entry of the same file
+	bool UpdateDbWithEntry(const KeyQueryEntry & entry);
+};
+
+#endif /* SRC_DB_INTF_KEYQUERYINTERFACE_H_ */
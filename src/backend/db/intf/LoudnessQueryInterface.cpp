@@ -0,0 +1,88 @@
+#include "LoudnessQueryInterface.h"
+#include "../../util/StrUtil.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstdlib>
+
+const std::string LoudnessQueryInterface::m_TableName = "loudness";
+const std::string LoudnessQueryInterface::m_FilenameColumn = "filename";
+const std::string LoudnessQueryInterface::m_ModificationTimeColumn = "mtime";
+const std::string LoudnessQueryInterface::m_IntegratedLoudnessColumn =
+		"integrated";
+const std::string LoudnessQueryInterface::m_LoudnessRangeColumn = "range";
+const std::string LoudnessQueryInterface::m_TruePeakColumn = "true_peak";
+const std::string LoudnessQueryInterface::m_DurationColumn = "duration";
+const std::string LoudnessQueryInterface::m_ColumnSpec =
+		LoudnessQueryInterface::m_FilenameColumn +
+			" varchar(255) PRIMARY KEY NOT NULL, " +
+		LoudnessQueryInterface::m_ModificationTimeColumn +
+			" integer NOT NULL, " +
+		LoudnessQueryInterface::m_IntegratedLoudnessColumn +
+			" real NOT NULL, " +
+		LoudnessQueryInterface::m_LoudnessRangeColumn + " real NOT NULL, " +
+		LoudnessQueryInterface::m_TruePeakColumn + " real NOT NULL, " +
+		LoudnessQueryInterface::m_DurationColumn + " real NOT NULL";
+
+LoudnessQueryInterface::LoudnessQueryInterface(SettingsDB & db)
+: QueryInterface(db)
+{
+}
+
+LoudnessQueryInterface::~LoudnessQueryInterface()
+{
+}
+
+bool LoudnessQueryInterface::TableExists()
+{
+	return QueryInterface::TableExists(m_TableName);
+}
+
+bool LoudnessQueryInterface::CreateTable()
+{
+	return QueryInterface::CreateTable(m_TableName, m_ColumnSpec);
+}
+
+bool LoudnessQueryInterface::EnsureTableExists()
+{
+	return QueryInterface::EnsureTableExists(m_TableName, m_ColumnSpec);
+}
+
+bool LoudnessQueryInterface::GetEntry(const std::string & filename,
+		LoudnessQueryEntry & entry)
+{
+	bool found = false;
+	bool rv = m_Db->Query("SELECT * FROM " + m_TableName + " WHERE " +
+			m_FilenameColumn + "='" + SettingsDB::FmtStr(filename) + '\'',
+		[&] (const SettingsDB::RowType & row)
+		{
+			entry.setFilename(row.at(m_FilenameColumn));
+			entry.setModificationTime(
+				strtoll(row.at(m_ModificationTimeColumn).c_str(), nullptr, 10));
+			entry.setIntegratedLoudness(
+				strtod(row.at(m_IntegratedLoudnessColumn).c_str(), nullptr));
+			entry.setLoudnessRange(
+				strtod(row.at(m_LoudnessRangeColumn).c_str(), nullptr));
+			entry.setTruePeak(strtod(row.at(m_TruePeakColumn).c_str(), nullptr));
+			entry.setDuration(strtod(row.at(m_DurationColumn).c_str(), nullptr));
+			found = true;
+			return true;
+		});
+	return rv && found;
+}
+
+bool LoudnessQueryInterface::UpdateDbWithEntry(const LoudnessQueryEntry & entry)
+{
+	// Silent files have no loudness and no peak, and SQL has no literal for
+	// minus infinity, so they are stored as the lowest finite value instead
+	return m_Db->Query("INSERT OR REPLACE INTO " + m_TableName + " (" +
+			m_FilenameColumn + ", " + m_ModificationTimeColumn + ", " +
+			m_IntegratedLoudnessColumn + ", " + m_LoudnessRangeColumn + ", " +
+			m_TruePeakColumn + ", " + m_DurationColumn + ") VALUES ('" +
+			SettingsDB::FmtStr(entry.getFilename()) + "', " +
+			StrUtil::format("%lld, %.17g, %.17g, %.17g, %.17g",
+				entry.getModificationTime(),
+				std::max(entry.getIntegratedLoudness(), -DBL_MAX),
+				entry.getLoudnessRange(),
+				std::max(entry.getTruePeak(), -DBL_MAX),
+				entry.getDuration()) + ')');
+}
@@ -0,0 +1,35 @@
+#ifndef SRC_DB_INTF_LOUDNESSQUERYINTERFACE_H_
+#define SRC_DB_INTF_LOUDNESSQUERYINTERFACE_H_
+
+#include "QueryInterface.h"
+#include "../entry/LoudnessQueryEntry.h"
+
+// Caches the loudness of each audio file, so that tracks can be normalized
+// at playback without being measured again
+class LoudnessQueryInterface : public QueryInterface {
+	static const std::string m_TableName;
+	static const std::string m_FilenameColumn;
+	static const std::string m_ModificationTimeColumn;
+	static const std::string m_IntegratedLoudnessColumn;
+	static const std::string m_LoudnessRangeColumn;
+	static const std::string m_TruePeakColumn;
+	static const std::string m_DurationColumn;
+	static const std::string m_ColumnSpec;
+
+	bool TableExists();
+	bool CreateTable();
+public:
+	LoudnessQueryInterface(SettingsDB & db);
+	virtual ~LoudnessQueryInterface();
+
+	bool EnsureTableExists();
+
+	// Looks up the entry of the given file.  False is returned if the file
+	// has never been measured.
+	bool GetEntry(const std::string & filename, LoudnessQueryEntry & entry);
+
+	// Adds the entry, replacing any earlier entry of the same file
+	bool UpdateDbWithEntry(const LoudnessQueryEntry & entry);
+};
+
+#endif /* SRC_DB_INTF_LOUDNESSQUERYINTERFACE_H_ */
@@ -0,0 +1,57 @@
+#include "PreferenceQueryInterface.h"
+
+const std::string PreferenceQueryInterface::m_TableName = "preference";
+const std::string PreferenceQueryInterface::m_NameColumn = "name";
+const std::string PreferenceQueryInterface::m_ValueColumn = "value";
+const std::string PreferenceQueryInterface::m_ColumnSpec =
+		PreferenceQueryInterface::m_NameColumn +
+			" varchar(255) PRIMARY KEY NOT NULL, " +
+		PreferenceQueryInterface::m_ValueColumn + " text NOT NULL";
+
+PreferenceQueryInterface::PreferenceQueryInterface(SettingsDB & db)
+: QueryInterface(db)
+{
+}
+
+PreferenceQueryInterface::~PreferenceQueryInterface()
+{
+}
+
+bool PreferenceQueryInterface::TableExists()
+{
+	return QueryInterface::TableExists(m_TableName);
+}
+
+bool PreferenceQueryInterface::CreateTable()
+{
+	return QueryInterface::CreateTable(m_TableName, m_ColumnSpec);
+}
+
+bool PreferenceQueryInterface::EnsureTableExists()
+{
+	return QueryInterface::EnsureTableExists(m_TableName, m_ColumnSpec);
+}
+
+bool PreferenceQueryInterface::GetValue(const std::string & name,
+		std::string & value)
+{
+	bool found = false;
+	bool rv = m_Db->Query("SELECT * FROM " + m_TableName + " WHERE " +
+			m_NameColumn + "='" + SettingsDB::FmtStr(name) + '\'',
+		[&] (const SettingsDB::RowType & row)
+		{
+			value = row.at(m_ValueColumn);
+			found = true;
+			return true;
+		});
+	return rv && found;
+}
+
+bool PreferenceQueryInterface::SetValue(const std::string & name,
+		const std::string & value)
+{
+	return m_Db->Query("INSERT OR REPLACE INTO " + m_TableName + " (" +
+			m_NameColumn + ", " + m_ValueColumn + ") VALUES ('" +
+			SettingsDB::FmtStr(name) + "', '" +
+			SettingsDB::FmtStr(value) + "')");
+}
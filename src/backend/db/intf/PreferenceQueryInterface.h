@@ -0,0 +1,30 @@
+#ifndef SRC_DB_INTF_PREFERENCEQUERYINTERFACE_H_
+#define SRC_DB_INTF_PREFERENCEQUERYINTERFACE_H_
+
+#include "QueryInterface.h"
+
+// Keeps the preferences of the user as pairs of names and text values, such
+// as the fade curve, in the form that FadeMap::CreateFromSetting() takes
+class PreferenceQueryInterface : public QueryInterface {
+	static const std::string m_TableName;
+	static const std::string m_NameColumn;
+	static const std::string m_ValueColumn;
+	static const std::string m_ColumnSpec;
+
+	bool TableExists();
+	bool CreateTable();
+public:
+	PreferenceQueryInterface(SettingsDB & db);
+	virtual ~PreferenceQueryInterface();
+
+	bool EnsureTableExists();
+
+	// Looks up the value of the given preference.  False is returned if the
+	// preference has never been set.
+	bool GetValue(const std::string & name, std::string & value);
+
+	// Sets the value, replacing any earlier value of the same preference
+	bool SetValue(const std::string & name, const std::string & value);
+};
+
+#endif /* SRC_DB_INTF_PREFERENCEQUERYINTERFACE_H_ */
@@ -0,0 +1,105 @@
+#include "MappedFile.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+: m_Data(nullptr), m_Size(0)
+#ifdef WIN32
+  , m_FileHandle(INVALID_HANDLE_VALUE), m_MappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string & path)
+{
+	bool rv = false;
+
+	Close();
+#ifdef WIN32
+	m_FileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+			nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_FileHandle != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		if (GetFileSizeEx(m_FileHandle, &size) && size.QuadPart > 0)
+		{
+			m_MappingHandle = CreateFileMappingA(m_FileHandle, nullptr,
+					PAGE_READONLY, 0, 0, nullptr);
+			if (m_MappingHandle != nullptr)
+			{
+				m_Data = (const char *) MapViewOfFile(m_MappingHandle,
+						FILE_MAP_READ, 0, 0, 0);
+				if (m_Data != nullptr)
+				{
+					m_Size = (size_t) size.QuadPart;
+					rv = true;
+				}
+			}
+		}
+	}
+#else
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void * data = mmap(nullptr, (size_t) st.st_size, PROT_READ,
+					MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED)
+			{
+				m_Data = (const char *) data;
+				m_Size = (size_t) st.st_size;
+				rv = true;
+			}
+		}
+		// The mapping stays valid after the descriptor is closed
+		close(fd);
+	}
+#endif
+
+	if (!rv)
+	{
+		Close();
+	}
+	return rv;
+}
+
+void MappedFile::Close()
+{
+#ifdef WIN32
+	if (m_Data != nullptr)
+	{
+		UnmapViewOfFile(m_Data);
+	}
+	if (m_MappingHandle != nullptr)
+	{
+		CloseHandle(m_MappingHandle);
+		m_MappingHandle = nullptr;
+	}
+	if (m_FileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_FileHandle);
+		m_FileHandle = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_Data != nullptr)
+	{
+		munmap((void *) m_Data, m_Size);
+	}
+#endif
+	m_Data = nullptr;
+	m_Size = 0;
+}
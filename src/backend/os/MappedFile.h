@@ -0,0 +1,42 @@
+#ifndef SRC_OS_MAPPEDFILE_H_
+#define SRC_OS_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+// A read-only view of an entire file, mapped into memory
+class MappedFile
+{
+	const char * m_Data;
+	size_t m_Size;
+#ifdef WIN32
+	void * m_FileHandle;
+	void * m_MappingHandle;
+#endif
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+public:
+	MappedFile();
+	virtual ~MappedFile();
+
+	bool Open(const std::string & path);
+	void Close();
+
+	bool IsOpen() const
+	{
+		return m_Data != nullptr;
+	}
+
+	const char * getData() const
+	{
+		return m_Data;
+	}
+
+	size_t getSize() const
+	{
+		return m_Size;
+	}
+};
+
+#endif /* SRC_OS_MAPPEDFILE_H_ */
@@ -15,6 +15,7 @@
 #define S_ISDIR(m) ((m) & _S_IFDIR != 0)
 #define SEPS "/\\"
 #else
+#include <dirent.h>
 #include <unistd.h>
 static const std::string m_XdgConfigName = "CONFIG";
 static const std::string m_XdgConfigDir = ".config";
@@ -281,3 +282,140 @@ std::string Path::GetBaseName(const std::string & path)
 	}
 	return length > 0 ? path.substr(slashPos + 1, length - (slashPos + 1)) : "";
 }
+
+bool Path::GetModificationTime(const std::string & path, long long & mtime)
+{
+	struct stat st;
+	bool rv = stat(path.c_str(), &st) == 0;
+	if (rv)
+	{
+		mtime = (long long) st.st_mtime;
+	}
+	return rv;
+}
+
+bool Path::GetModificationTimeNs(const std::string & path, long long & mtimeNs)
+{
+	struct stat st;
+	bool rv = stat(path.c_str(), &st) == 0;
+	if (rv)
+	{
+#if defined(WIN32)
+		mtimeNs = 1000000000LL * st.st_mtime;
+#elif defined(__APPLE__)
+		mtimeNs = 1000000000LL * st.st_mtimespec.tv_sec +
+				st.st_mtimespec.tv_nsec;
+#else
+		mtimeNs = 1000000000LL * st.st_mtim.tv_sec + st.st_mtim.tv_nsec;
+#endif
+	}
+	return rv;
+}
+
+bool Path::ListDirectory(const std::string & path,
+		std::vector<std::string> & files, bool recursive)
+{
+	// Directories are visited with an explicit stack rather than by
+	// recursion, since music libraries can be nested arbitrarily deep.  Only
+	// the top-level directory must be readable; subdirectories that cannot be
+	// read are skipped.
+	bool rv = false;
+	std::stack<std::string> dirStack;
+	dirStack.push(path);
+	files.clear();
+
+	bool topLevel = true;
+	while (!dirStack.empty())
+	{
+		std::string dir = dirStack.top();
+		dirStack.pop();
+
+		std::string prefix = dir;
+		if (prefix.empty() ||
+				std::string(SEPS).find(prefix.back()) == std::string::npos)
+		{
+			prefix += GetSeparator();
+		}
+
+#ifdef WIN32
+		WIN32_FIND_DATAA data;
+		HANDLE hFind = FindFirstFileA((prefix + '*').c_str(), &data);
+		bool opened = hFind != INVALID_HANDLE_VALUE;
+		if (opened)
+		{
+			do
+			{
+				std::string name = data.cFileName;
+				if (name == "." || name == "..")
+				{
+					continue;
+				}
+				if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0)
+				{
+					if (recursive)
+					{
+						dirStack.push(prefix + name);
+					}
+				}
+				else
+				{
+					files.push_back(prefix + name);
+				}
+			}
+			while (FindNextFileA(hFind, &data));
+			FindClose(hFind);
+		}
+#else
+		DIR * dirp = opendir(dir.c_str());
+		bool opened = dirp != nullptr;
+		if (opened)
+		{
+			struct dirent * entry;
+			while ((entry = readdir(dirp)) != nullptr)
+			{
+				std::string name = entry->d_name;
+				if (name == "." || name == "..")
+				{
+					continue;
+				}
+
+				// d_type is not available on every file system, so the entry
+				// is looked up instead.  Symbolic links to files are followed,
+				// but symbolic links to directories are not, so that a link
+				// cycle cannot make the walk run forever.
+				struct stat st;
+				std::string entryPath = prefix + name;
+				bool found = lstat(entryPath.c_str(), &st) == 0;
+				if (found && S_ISLNK(st.st_mode))
+				{
+					found = stat(entryPath.c_str(), &st) == 0 &&
+							S_ISREG(st.st_mode);
+				}
+				if (found)
+				{
+					if (S_ISDIR(st.st_mode))
+					{
+						if (recursive)
+						{
+							dirStack.push(entryPath);
+						}
+					}
+					else if (S_ISREG(st.st_mode))
+					{
+						files.push_back(entryPath);
+					}
+				}
+			}
+			closedir(dirp);
+		}
+#endif
+
+		if (topLevel)
+		{
+			rv = opened;
+			topLevel = false;
+		}
+	}
+
+	return rv;
+}
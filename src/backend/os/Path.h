@@ -2,6 +2,7 @@
 #define SRC_OS_PATH_H_
 
 #include <string>
+#include <vector>
 
 namespace Path
 {
@@ -12,6 +13,12 @@ namespace Path
 	bool MakeDirectory(const std::string & path, bool simplifyPath = false);
 	bool MakeApplicationPath();
 	std::string GetBaseName(const std::string & path);
+	bool GetModificationTime(const std::string & path, long long & mtime);
+	// In nanoseconds, as precisely as the file system keeps it (only whole
+	// seconds on Windows)
+	bool GetModificationTimeNs(const std::string & path, long long & mtimeNs);
+	bool ListDirectory(const std::string & path,
+			std::vector<std::string> & files, bool recursive = true);
 }
 
 #endif /* SRC_OS_PATH_H_ */
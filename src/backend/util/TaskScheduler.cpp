@@ -0,0 +1,212 @@
+#include "TaskScheduler.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+TaskScheduler::TaskGroup::TaskGroup()
+: m_NumPending(0)
+{
+}
+
+TaskScheduler::TaskGroup::~TaskGroup()
+{
+}
+
+void TaskScheduler::TaskGroup::Add()
+{
+	lock_guard<mutex> lck(m_Mutex);
+	++m_NumPending;
+}
+
+void TaskScheduler::TaskGroup::Done()
+{
+	lock_guard<mutex> lck(m_Mutex);
+	if (--m_NumPending == 0)
+	{
+		m_DoneCond.notify_all();
+	}
+}
+
+bool TaskScheduler::TaskGroup::IsDone()
+{
+	lock_guard<mutex> lck(m_Mutex);
+	return m_NumPending == 0;
+}
+
+void TaskScheduler::TaskGroup::Wait()
+{
+	unique_lock<mutex> lck(m_Mutex);
+	m_DoneCond.wait(lck, [this] { return m_NumPending == 0; });
+}
+
+TaskScheduler::TaskScheduler(size_t numWorkers)
+: m_NumWorkers(numWorkers), m_UseRealtimePriority(false), m_Running(false),
+  m_Terminate(false)
+{
+}
+
+TaskScheduler::~TaskScheduler()
+{
+	Stop();
+}
+
+void TaskScheduler::WorkerThread(TaskScheduler * scheduler, size_t index)
+{
+	scheduler->DoWork(index);
+}
+
+void TaskScheduler::ConfigureWorkerThread(size_t index)
+{
+	// Both of these are best effort; failures are ignored
+#ifdef WIN32
+	if (m_UseRealtimePriority)
+	{
+		SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL);
+	}
+	if (!m_CPUAffinity.empty())
+	{
+		int cpu = m_CPUAffinity.at(index % m_CPUAffinity.size());
+		SetThreadAffinityMask(GetCurrentThread(), ((DWORD_PTR) 1) << cpu);
+	}
+#else
+	if (m_UseRealtimePriority)
+	{
+		sched_param param;
+		param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+		pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+	}
+#ifdef __linux__
+	if (!m_CPUAffinity.empty())
+	{
+		cpu_set_t cpuSet;
+		CPU_ZERO(&cpuSet);
+		CPU_SET(m_CPUAffinity.at(index % m_CPUAffinity.size()), &cpuSet);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+	}
+#endif
+#endif
+	(void) index;
+}
+
+bool TaskScheduler::PopTask(Task & task)
+{
+	// Must be called with m_Mutex held
+	bool rv = false;
+	for (int prio = NUM_PRIORITIES - 1; !rv && prio >= 0; --prio)
+	{
+		if (!m_Tasks[prio].empty())
+		{
+			task = move(m_Tasks[prio].front());
+			m_Tasks[prio].pop_front();
+			rv = true;
+		}
+	}
+	return rv;
+}
+
+void TaskScheduler::RunTask(Task & task)
+{
+	task.m_Function();
+	if (task.m_Group != nullptr)
+	{
+		task.m_Group->Done();
+	}
+}
+
+void TaskScheduler::DoWork(size_t index)
+{
+	ConfigureWorkerThread(index);
+
+	// The queue is drained before the worker quits, so that every task
+	// group completes
+	unique_lock<mutex> lck(m_Mutex);
+	bool done = false;
+	while (!done)
+	{
+		Task task;
+		if (PopTask(task))
+		{
+			lck.unlock();
+			RunTask(task);
+			lck.lock();
+		}
+		else if (m_Terminate)
+		{
+			done = true;
+		}
+		else
+		{
+			m_HasTaskCond.wait(lck);
+		}
+	}
+}
+
+bool TaskScheduler::IsRunning()
+{
+	lock_guard<mutex> lck(m_Mutex);
+	return m_Running;
+}
+
+void TaskScheduler::Start()
+{
+	lock_guard<mutex> lck(m_Mutex);
+	if (!m_Running)
+	{
+		m_Running = true;
+		m_Terminate = false;
+		for (size_t k = 0; k != m_NumWorkers; ++k)
+		{
+			m_Workers.emplace_back(new thread(WorkerThread, this, k));
+		}
+	}
+}
+
+void TaskScheduler::Stop()
+{
+	// Tasks that are already running or queued are allowed to finish
+	{
+		lock_guard<mutex> lck(m_Mutex);
+		m_Terminate = true;
+		m_HasTaskCond.notify_all();
+	}
+	for (auto it = m_Workers.begin(); it != m_Workers.end(); ++it)
+	{
+		(*it)->join();
+	}
+	m_Workers.clear();
+
+	// Tasks that were submitted as the workers quit (or while there were no
+	// workers) are run here
+	unique_lock<mutex> lck(m_Mutex);
+	Task task;
+	while (PopTask(task))
+	{
+		lck.unlock();
+		RunTask(task);
+		lck.lock();
+	}
+	m_Running = false;
+}
+
+void TaskScheduler::Submit(function<void()> && function, Priority priority,
+		TaskGroup * group)
+{
+	if (group != nullptr)
+	{
+		group->Add();
+	}
+
+	Task task;
+	task.m_Function = move(function);
+	task.m_Group = group;
+
+	lock_guard<mutex> lck(m_Mutex);
+	m_Tasks[priority].push_back(move(task));
+	m_HasTaskCond.notify_one();
+}
@@ -0,0 +1,112 @@
+#ifndef SRC_UTIL_TASKSCHEDULER_H_
+#define SRC_UTIL_TASKSCHEDULER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A pool of long-lived worker threads that run submitted tasks.  The workers
+// are created once (when the scheduler is started) and then wait for work,
+// so no threads are created or destroyed while tasks are being submitted.
+//
+// Tasks of higher priority are always picked up before tasks of lower
+// priority.  Optionally, the workers can be given an elevated OS scheduling
+// priority and pinned to a set of CPUs.
+class TaskScheduler
+{
+public:
+	enum Priority
+	{
+		PRIORITY_LOW,
+		PRIORITY_NORMAL,
+		PRIORITY_HIGH,
+		NUM_PRIORITIES
+	};
+
+	// Tracks the completion of a group of tasks
+	class TaskGroup
+	{
+		friend class TaskScheduler;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_DoneCond;
+		size_t m_NumPending;
+
+		void Add();
+		void Done();
+
+		TaskGroup(const TaskGroup &) = delete;
+		TaskGroup & operator=(const TaskGroup &) = delete;
+	public:
+		TaskGroup();
+		virtual ~TaskGroup();
+
+		bool IsDone();
+		void Wait();
+	};
+
+private:
+	struct Task
+	{
+		std::function<void()> m_Function;
+		TaskGroup * m_Group;
+	};
+
+	std::mutex m_Mutex;
+	std::condition_variable m_HasTaskCond;
+	std::deque<Task> m_Tasks[NUM_PRIORITIES];
+	std::vector<std::unique_ptr<std::thread> > m_Workers;
+
+	size_t m_NumWorkers;
+	bool m_UseRealtimePriority;
+	std::vector<int> m_CPUAffinity;
+	bool m_Running;
+	bool m_Terminate;
+
+	static void WorkerThread(TaskScheduler * scheduler, size_t index);
+	void DoWork(size_t index);
+	void ConfigureWorkerThread(size_t index);
+	bool PopTask(Task & task);
+	static void RunTask(Task & task);
+
+	TaskScheduler(const TaskScheduler &) = delete;
+	TaskScheduler & operator=(const TaskScheduler &) = delete;
+public:
+	TaskScheduler(size_t numWorkers);
+	virtual ~TaskScheduler();
+
+	// Accessor may be called at any time
+	size_t getNumWorkers() const { return m_NumWorkers; }
+	// Mutator must not be called while scheduler is running
+	void setNumWorkers(size_t numWorkers) { m_NumWorkers = numWorkers; }
+
+	// Accessor may be called at any time
+	bool isUsingRealtimePriority() const { return m_UseRealtimePriority; }
+	// Mutator must not be called while scheduler is running.  Raising the
+	// priority is best effort; it may be refused by the OS.
+	void setUsingRealtimePriority(bool enable)
+		{ m_UseRealtimePriority = enable; }
+
+	// Accessor may be called at any time
+	const std::vector<int> & getCPUAffinity() const { return m_CPUAffinity; }
+	// Mutator must not be called while scheduler is running.  Worker k is
+	// pinned to CPU cpus[k % cpus.size()]; an empty list disables pinning.
+	void setCPUAffinity(const std::vector<int> & cpus) { m_CPUAffinity = cpus; }
+
+	bool IsRunning();
+	void Start();
+
+	// Runs every task that is still queued, then stops the workers.  Task
+	// groups are therefore always completed.
+	void Stop();
+
+	// Submits a task.  If a task group is given, it must outlive the task.
+	void Submit(std::function<void()> && function,
+			Priority priority = PRIORITY_NORMAL, TaskGroup * group = nullptr);
+};
+
+#endif /* SRC_UTIL_TASKSCHEDULER_H_ */
@@ -0,0 +1,171 @@
+#include "WorkStealingPool.h"
+
+using namespace std;
+
+WorkStealingPool::WorkStealingPool(size_t numWorkers)
+: m_NumQueued(0), m_NumPending(0), m_NextQueue(0), m_Running(false),
+  m_Terminate(false)
+{
+	if (numWorkers == 0)
+	{
+		numWorkers = thread::hardware_concurrency();
+		if (numWorkers == 0)
+		{
+			numWorkers = 1;
+		}
+	}
+	for (size_t k = 0; k != numWorkers; ++k)
+	{
+		m_Queues.emplace_back(new WorkQueue);
+	}
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	Stop();
+}
+
+void WorkStealingPool::WorkerThread(WorkStealingPool * pool, size_t index)
+{
+	pool->DoWork(index);
+}
+
+bool WorkStealingPool::PopTask(size_t index, function<void()> & task)
+{
+	bool rv = false;
+	size_t numQueues = m_Queues.size();
+
+	// Take the most recently queued task of our own queue first...
+	{
+		WorkQueue & queue = *m_Queues[index];
+		lock_guard<mutex> lck(queue.m_Mutex);
+		if (!queue.m_Tasks.empty())
+		{
+			task = move(queue.m_Tasks.back());
+			queue.m_Tasks.pop_back();
+			rv = true;
+		}
+	}
+
+	// ...then steal the oldest task of another queue
+	for (size_t k = 1; !rv && k != numQueues; ++k)
+	{
+		WorkQueue & queue = *m_Queues[(index + k) % numQueues];
+		lock_guard<mutex> lck(queue.m_Mutex);
+		if (!queue.m_Tasks.empty())
+		{
+			task = move(queue.m_Tasks.front());
+			queue.m_Tasks.pop_front();
+			rv = true;
+		}
+	}
+
+	if (rv)
+	{
+		--m_NumQueued;
+	}
+	return rv;
+}
+
+void WorkStealingPool::DoWork(size_t index)
+{
+	bool done = false;
+	while (!done)
+	{
+		function<void()> task;
+		if (PopTask(index, task))
+		{
+			task();
+
+			lock_guard<mutex> lck(m_Mutex);
+			if (--m_NumPending == 0)
+			{
+				m_DoneCond.notify_all();
+			}
+		}
+		else
+		{
+			// The count of queued tasks is raised before a task is queued,
+			// so a task cannot slip by between the failed pop and the wait
+			unique_lock<mutex> lck(m_Mutex);
+			m_HasTaskCond.wait(lck,
+					[this] { return m_Terminate || m_NumQueued != 0; });
+		}
+
+		lock_guard<mutex> lck(m_Mutex);
+		done = m_Terminate;
+	}
+}
+
+bool WorkStealingPool::IsRunning()
+{
+	lock_guard<mutex> lck(m_Mutex);
+	return m_Running;
+}
+
+void WorkStealingPool::Start()
+{
+	lock_guard<mutex> lck(m_Mutex);
+	if (!m_Running)
+	{
+		m_Running = true;
+		m_Terminate = false;
+		for (size_t k = 0; k != m_Queues.size(); ++k)
+		{
+			m_Workers.emplace_back(new thread(WorkerThread, this, k));
+		}
+	}
+}
+
+void WorkStealingPool::Stop()
+{
+	{
+		lock_guard<mutex> lck(m_Mutex);
+		m_Terminate = true;
+		m_HasTaskCond.notify_all();
+	}
+	for (auto it = m_Workers.begin(); it != m_Workers.end(); ++it)
+	{
+		(*it)->join();
+	}
+	m_Workers.clear();
+
+	for (auto it = m_Queues.begin(); it != m_Queues.end(); ++it)
+	{
+		lock_guard<mutex> lck((*it)->m_Mutex);
+		(*it)->m_Tasks.clear();
+	}
+
+	lock_guard<mutex> lck(m_Mutex);
+	m_NumQueued = 0;
+	m_NumPending = 0;
+	m_Running = false;
+	m_DoneCond.notify_all();
+}
+
+void WorkStealingPool::Submit(function<void()> && function)
+{
+	size_t index;
+	{
+		lock_guard<mutex> lck(m_Mutex);
+		++m_NumPending;
+		++m_NumQueued;
+		index = m_NextQueue;
+		m_NextQueue = (m_NextQueue + 1) % m_Queues.size();
+	}
+
+	{
+		WorkQueue & queue = *m_Queues[index];
+		lock_guard<mutex> lck(queue.m_Mutex);
+		queue.m_Tasks.push_back(move(function));
+	}
+
+	lock_guard<mutex> lck(m_Mutex);
+	m_HasTaskCond.notify_one();
+}
+
+void WorkStealingPool::Wait()
+{
+	unique_lock<mutex> lck(m_Mutex);
+	m_DoneCond.wait(lck, [this] { return m_NumPending == 0; });
+}
@@ -0,0 +1,68 @@
+#ifndef SRC_UTIL_WORKSTEALINGPOOL_H_
+#define SRC_UTIL_WORKSTEALINGPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A pool of worker threads for batches of long, independent jobs whose
+// running times vary widely (such as analyzing a library of audio files).
+//
+// Each worker has its own task queue.  A worker runs the tasks of its own
+// queue from the back, and once its queue runs dry, it steals tasks from the
+// front of the other workers' queues.  This keeps all the workers busy until
+// the whole batch is done, without every worker contending for a single
+// shared queue.  Unlike TaskScheduler, there are no priorities; tasks are
+// meant to be submitted in bulk and then waited on with Wait().
+class WorkStealingPool
+{
+	struct WorkQueue
+	{
+		std::mutex m_Mutex;
+		std::deque<std::function<void()> > m_Tasks;
+	};
+
+	std::vector<std::unique_ptr<WorkQueue> > m_Queues;
+	std::vector<std::unique_ptr<std::thread> > m_Workers;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_HasTaskCond;
+	std::condition_variable m_DoneCond;
+	std::atomic<size_t> m_NumQueued;
+	size_t m_NumPending;
+	size_t m_NextQueue;
+	bool m_Running;
+	bool m_Terminate;
+
+	static void WorkerThread(WorkStealingPool * pool, size_t index);
+	void DoWork(size_t index);
+	bool PopTask(size_t index, std::function<void()> & task);
+
+	WorkStealingPool(const WorkStealingPool &) = delete;
+	WorkStealingPool & operator=(const WorkStealingPool &) = delete;
+public:
+	// A worker count of zero uses one worker per hardware thread
+	WorkStealingPool(size_t numWorkers = 0);
+	virtual ~WorkStealingPool();
+
+	size_t getNumWorkers() const { return m_Queues.size(); }
+
+	bool IsRunning();
+	void Start();
+	// Tasks that are already running are allowed to finish, but tasks that
+	// are still queued are discarded
+	void Stop();
+
+	// Submits a task.  Tasks are dealt out to the workers' queues in turn.
+	void Submit(std::function<void()> && function);
+
+	// Blocks until every submitted task has finished
+	void Wait();
+};
+
+#endif /* SRC_UTIL_WORKSTEALINGPOOL_H_ */
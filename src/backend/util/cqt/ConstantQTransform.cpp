@@ -0,0 +1,156 @@
+#include "ConstantQTransform.h"
+#include "FrequencyList.h"
+#include "../firwindows/WindowCache.h"
+#include "../MathConstants.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+// Entries of a kernel's spectrum below this fraction of its peak are
+// dropped, as in Brown and Puckette, which costs well under 1% of the energy
+// of each bin
+const float ConstantQTransform::m_SparsityThreshold = 0.0054f;
+
+ConstantQTransform::ConstantQTransform(const FrequencyList & frequencies)
+: m_Kernel(GetKernel(frequencies)), m_FFTSize(m_Kernel->m_FFTSize),
+  m_NumBins(frequencies.GetSize())
+{
+	m_FFTData.resize(m_FFTSize);
+	m_FFTCache.resize(plan_cache_size(m_FFTSize));
+	setup_plan(&m_Plan, m_FFTData.data(), m_FFTCache.data(), m_FFTSize);
+}
+
+ConstantQTransform::~ConstantQTransform()
+{
+}
+
+std::shared_ptr<const ConstantQTransform::Kernel>
+ConstantQTransform::GetKernel(const FrequencyList & frequencies)
+{
+	// Log-spaced frequencies are fixed by their number and their ends
+	typedef std::tuple<size_t, float, float> KernelKey;
+	static std::map<KernelKey, std::shared_ptr<const Kernel> > kernels;
+	static std::mutex kernelsMutex;
+
+	size_t numBins = frequencies.GetSize();
+	KernelKey key(numBins, frequencies.At(0), frequencies.At(numBins - 1));
+	std::lock_guard<std::mutex> lck(kernelsMutex);
+	std::shared_ptr<const Kernel> & kernel = kernels[key];
+	if (kernel == nullptr)
+	{
+		kernel = BuildKernel(frequencies);
+	}
+	return kernel;
+}
+
+std::shared_ptr<const ConstantQTransform::Kernel>
+ConstantQTransform::BuildKernel(const FrequencyList & frequencies)
+{
+	std::shared_ptr<Kernel> rv = std::make_shared<Kernel>();
+
+	// The ratio between neighboring bins fixes the quality factor, which is
+	// the number of periods that each kernel spans
+	double q = 1.0 / (frequencies.At(1) / frequencies.At(0) - 1.0);
+	size_t longest = (size_t) ceil(q / frequencies.At(0));
+	size_t fftSize = 1;
+	while (fftSize < longest)
+	{
+		fftSize <<= 1;
+	}
+	rv->m_FFTSize = fftSize;
+
+	fft_plan_t plan;
+	std::vector<float> fftData(fftSize);
+	std::vector<float> fftCache(plan_cache_size(fftSize));
+	setup_plan(&plan, fftData.data(), fftCache.data(), fftSize);
+
+	// The spectra are folded over from both halves, and the inner product
+	// in the frequency domain is not normalized
+	std::vector<float> spectra[2];
+	float scale = 2.0f / fftSize;
+	size_t half = fftSize >> 1;
+	std::vector<float> magnitudes(half);
+	rv->m_BinStarts.push_back(0);
+	for (size_t b = 0; b != frequencies.GetSize(); ++b)
+	{
+		double freq = frequencies.At(b);
+		size_t length = std::min((size_t) ceil(q / freq), fftSize);
+		std::shared_ptr<const Window> window =
+				WindowCache::Instance().Get(WindowCache::WINDOW_HAMMING, length);
+		size_t offset = (fftSize - length) / 2;
+
+		// The transforms leave their result wherever the plan points to, so
+		// the samples are always accessed through the plan
+		for (int part = 0; part != 2; ++part)
+		{
+			float * data = plan_samples(&plan);
+			std::fill(data, data + fftSize, 0.0f);
+			for (size_t n = 0; n != length; ++n)
+			{
+				double phase = 2.0 * MathConstants::Pi * freq * n;
+				data[offset + n] = (float) (window->At(n) / length *
+						(part == 0 ? cos(phase) : sin(phase)));
+			}
+			r2hc(&plan);
+			data = plan_samples(&plan);
+			spectra[part].assign(data, data + fftSize);
+		}
+		const float * cosSpectrum = spectra[0].data();
+		const float * sinSpectrum = spectra[1].data();
+
+		// Real parts of bin k lie at k and the imaginary parts at N - k
+		for (size_t k = 1; k != half; ++k)
+		{
+			magnitudes[k] = std::sqrt(
+					cosSpectrum[k] * cosSpectrum[k] +
+					cosSpectrum[fftSize - k] * cosSpectrum[fftSize - k] +
+					sinSpectrum[k] * sinSpectrum[k] +
+					sinSpectrum[fftSize - k] * sinSpectrum[fftSize - k]);
+		}
+		float threshold = m_SparsityThreshold *
+				*std::max_element(magnitudes.begin(), magnitudes.end());
+		for (size_t k = 1; k != half; ++k)
+		{
+			if (magnitudes[k] >= threshold)
+			{
+				KernelEntry entry = { k,
+						scale * cosSpectrum[k],
+						scale * cosSpectrum[fftSize - k],
+						scale * sinSpectrum[k],
+						scale * sinSpectrum[fftSize - k] };
+				rv->m_Entries.push_back(entry);
+			}
+		}
+		rv->m_BinStarts.push_back(rv->m_Entries.size());
+	}
+	return rv;
+}
+
+void ConstantQTransform::Transform(const float * frame, float * magnitudes)
+{
+	float * x = plan_samples(&m_Plan);
+	std::copy(frame, frame + m_FFTSize, x);
+	r2hc(&m_Plan);
+	x = plan_samples(&m_Plan);
+
+	// For a real frame, the inner product with each part of a kernel is the
+	// real part of the product of the spectra, so the phases cancel out
+	const KernelEntry * entries = m_Kernel->m_Entries.data();
+	const size_t * binStarts = m_Kernel->m_BinStarts.data();
+	for (size_t b = 0; b != m_NumBins; ++b)
+	{
+		float cosSum = 0.0f;
+		float sinSum = 0.0f;
+		for (size_t e = binStarts[b]; e != binStarts[b + 1]; ++e)
+		{
+			const KernelEntry & entry = entries[e];
+			float re = x[entry.m_Index];
+			float im = x[m_FFTSize - entry.m_Index];
+			cosSum += re * entry.m_CosRe + im * entry.m_CosIm;
+			sinSum += re * entry.m_SinRe + im * entry.m_SinIm;
+		}
+		magnitudes[b] = std::sqrt(cosSum * cosSum + sinSum * sinSum);
+	}
+}
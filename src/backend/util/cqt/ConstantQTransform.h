@@ -0,0 +1,81 @@
+#ifndef SRC_UTIL_CQT_CONSTANTQTRANSFORM_H_
+#define SRC_UTIL_CQT_CONSTANTQTRANSFORM_H_
+
+#include "../minfft.h"
+#include <memory>
+#include <vector>
+#include <cstring>
+
+class FrequencyList;
+
+// The constant-Q transform of a frame, computed as in Brown and Puckette:
+// one FFT of the frame, followed by the inner product of the spectrum with
+// the spectrum of each bin's temporal kernel.  Those spectra are almost all
+// zero, so only their significant entries are kept, and each bin costs a
+// few dozen multiplies instead of a convolution over its whole window.
+//
+// The temporal kernels are Hamming-windowed complex exponentials, whose
+// length shrinks with frequency so that every bin spans the same number of
+// periods.  They are all centered on the frame.
+class ConstantQTransform
+{
+	static const float m_SparsityThreshold;
+
+	// The spectra of the real (cosine) and the imaginary (sine) parts of a
+	// kernel at one FFT bin, in the positive half of the spectrum only.  The
+	// frame is real, so the negative half adds the same again.
+	struct KernelEntry
+	{
+		size_t m_Index;
+		float m_CosRe, m_CosIm;
+		float m_SinRe, m_SinIm;
+	};
+
+	// The entries of all bins, one bin after another, with the first entry
+	// of each bin (and the end of the last one) in m_BinStarts
+	struct Kernel
+	{
+		size_t m_FFTSize;
+		std::vector<KernelEntry> m_Entries;
+		std::vector<size_t> m_BinStarts;
+	};
+
+	// Building a kernel takes an FFT per bin and part, which is far longer
+	// than transforming a whole track, so each kernel is only built once
+	// and then shared.  Kernels are never modified.
+	std::shared_ptr<const Kernel> m_Kernel;
+	size_t m_FFTSize;
+	size_t m_NumBins;
+
+	fft_plan_t m_Plan;
+	std::vector<float> m_FFTData;
+	std::vector<float> m_FFTCache;
+
+	static std::shared_ptr<const Kernel> GetKernel(
+			const FrequencyList & frequencies);
+	static std::shared_ptr<const Kernel> BuildKernel(
+			const FrequencyList & frequencies);
+public:
+	// The frequencies must be log-spaced, as FrequencyList makes them, and
+	// there must be at least two of them
+	explicit ConstantQTransform(const FrequencyList & frequencies);
+	virtual ~ConstantQTransform();
+
+	// The plan points into the buffers of the transform
+	ConstantQTransform(const ConstantQTransform &) = delete;
+	ConstantQTransform & operator=(const ConstantQTransform &) = delete;
+
+	// Number of samples in each frame, which is enough for the kernel of
+	// the lowest bin
+	size_t GetFrameSize() const { return m_FFTSize; }
+	size_t GetNumBins() const { return m_NumBins; }
+
+	// Total number of kernel entries, which is what each frame costs beyond
+	// its FFT
+	size_t GetKernelSize() const { return m_Kernel->m_Entries.size(); }
+
+	// Writes the magnitude of each of the GetNumBins() bins of the frame
+	void Transform(const float * frame, float * magnitudes);
+};
+
+#endif /* SRC_UTIL_CQT_CONSTANTQTRANSFORM_H_ */
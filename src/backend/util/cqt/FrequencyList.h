@@ -10,7 +10,9 @@ public:
 	FrequencyList(float minFreq, float maxFreq, size_t numBinsPerOctave, size_t sampRate);
 	virtual ~FrequencyList();
 
+	// Frequencies are relative to the sample rate
 	float At(size_t index) const { return m_Frequencies.at(index); }
+	size_t GetSize() const { return m_Frequencies.size(); }
 };
 
 #endif /* SRC_UTIL_CQT_FREQUENCYLIST_H_ */
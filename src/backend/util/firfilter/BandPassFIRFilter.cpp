@@ -18,8 +18,8 @@ BandPassFIRFilter::BandPassFIRFilter(size_t filterSize, float lowerCutoffFreq, f
 		{
 			float trigFactor = 2.0f * MathConstants::Pi * koff;
 			m_Filter.at(k) =
-					(sinf(trigFactor * upperCutoffFreq)
-					- sinf(trigFactor * lowerCutoffFreq)
+					((sinf(trigFactor * upperCutoffFreq)
+					- sinf(trigFactor * lowerCutoffFreq))
 					/ MathConstants::Pi) / koff;
 		}
 	}
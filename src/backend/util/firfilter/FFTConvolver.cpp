@@ -0,0 +1,116 @@
+#include "FFTConvolver.h"
+#include <algorithm>
+
+FFTConvolver::FFTConvolver(const std::vector<float> & kernel,
+		size_t blockSize)
+: m_BlockSize(blockSize), m_Newest(0)
+{
+	if (m_BlockSize == 0)
+	{
+		m_BlockSize = GetDefaultBlockSize(kernel.size());
+	}
+	m_FFTSize = m_BlockSize << 1;
+	m_NumPartitions = std::max((kernel.size() + m_BlockSize - 1) / m_BlockSize,
+			(size_t) 1);
+
+	m_Input.resize(m_FFTSize);
+	m_Sum.resize(m_FFTSize);
+	m_InputSpectra.resize(m_NumPartitions * m_FFTSize);
+	m_FFTData.resize(m_FFTSize);
+	m_FFTCache.resize(plan_cache_size(m_FFTSize));
+	setup_plan(&m_Plan, m_FFTData.data(), m_FFTCache.data(), m_FFTSize);
+
+	// The inverse transform is not normalized
+	float scale = 1.0f / m_FFTSize;
+	m_KernelSpectra.resize(m_NumPartitions * m_FFTSize);
+	for (size_t p = 0; p != m_NumPartitions; ++p)
+	{
+		// The transforms leave their result wherever the plan points to, so
+		// the samples are always accessed through the plan
+		float * data = plan_samples(&m_Plan);
+		std::fill(data, data + m_FFTSize, 0.0f);
+		size_t start = p * m_BlockSize;
+		size_t end = std::min(start + m_BlockSize, kernel.size());
+		if (start < end)
+		{
+			std::copy(kernel.begin() + start, kernel.begin() + end, data);
+		}
+		r2hc(&m_Plan);
+		data = plan_samples(&m_Plan);
+
+		float * spectrum = &m_KernelSpectra[p * m_FFTSize];
+		for (size_t k = 0; k != m_FFTSize; ++k)
+		{
+			spectrum[k] = scale * data[k];
+		}
+	}
+}
+
+FFTConvolver::~FFTConvolver()
+{
+}
+
+size_t FFTConvolver::GetDefaultBlockSize(size_t kernelSize)
+{
+	size_t rv = 1;
+	while (rv < kernelSize)
+	{
+		rv <<= 1;
+	}
+	return rv;
+}
+
+void FFTConvolver::Reset()
+{
+	std::fill(m_Input.begin(), m_Input.end(), 0.0f);
+	std::fill(m_InputSpectra.begin(), m_InputSpectra.end(), 0.0f);
+	m_Newest = 0;
+}
+
+void FFTConvolver::ProcessBlock(const float * input, float * output)
+{
+	std::copy(m_Input.begin() + m_BlockSize, m_Input.end(), m_Input.begin());
+	std::copy(input, input + m_BlockSize, m_Input.begin() + m_BlockSize);
+
+	float * data = plan_samples(&m_Plan);
+	std::copy(m_Input.begin(), m_Input.end(), data);
+	r2hc(&m_Plan);
+	data = plan_samples(&m_Plan);
+
+	m_Newest = m_Newest == 0 ? m_NumPartitions - 1 : m_Newest - 1;
+	std::copy(data, data + m_FFTSize, &m_InputSpectra[m_Newest * m_FFTSize]);
+
+	// Each partition of the kernel meets the block that came in as many
+	// blocks ago.  The real parts of bin k lie at k and the imaginary parts
+	// at N - k; DC and Nyquist are purely real.
+	std::fill(m_Sum.begin(), m_Sum.end(), 0.0f);
+	float * sum = m_Sum.data();
+	size_t half = m_FFTSize >> 1;
+	size_t slot = m_Newest;
+	for (size_t p = 0; p != m_NumPartitions; ++p)
+	{
+		const float * x = &m_InputSpectra[slot * m_FFTSize];
+		const float * h = &m_KernelSpectra[p * m_FFTSize];
+		sum[0] += x[0] * h[0];
+		sum[half] += x[half] * h[half];
+		for (size_t k = 1; k != half; ++k)
+		{
+			float xr = x[k];
+			float xi = x[m_FFTSize - k];
+			float hr = h[k];
+			float hi = h[m_FFTSize - k];
+			sum[k] += xr * hr - xi * hi;
+			sum[m_FFTSize - k] += xr * hi + xi * hr;
+		}
+		slot = slot + 1 == m_NumPartitions ? 0 : slot + 1;
+	}
+
+	data = plan_samples(&m_Plan);
+	std::copy(m_Sum.begin(), m_Sum.end(), data);
+	hc2r(&m_Plan);
+	data = plan_samples(&m_Plan);
+
+	// The first half wraps around the circular convolution, so only the
+	// second half is valid
+	std::copy(data + m_BlockSize, data + m_FFTSize, output);
+}
@@ -0,0 +1,65 @@
+#ifndef SRC_UTIL_FIRFILTER_FFTCONVOLVER_H_
+#define SRC_UTIL_FIRFILTER_FFTCONVOLVER_H_
+
+#include "../minfft.h"
+#include <vector>
+#include <cstring>
+
+// Convolves a stream with a fixed FIR kernel by uniformly partitioned
+// overlap-save, one block at a time.  The kernel is cut into partitions of
+// the block size, and each block costs one forward and one inverse FFT of
+// twice that size plus a spectral multiply per partition, which is far
+// cheaper than filtering sample by sample for long kernels.  Smaller blocks
+// trade some of that saving for a shorter wait for each block.
+//
+// The output is exactly that of the direct convolution (up to rounding), so
+// a symmetric kernel of N taps delays the stream by N / 2 samples, as with
+// FIRFilter.
+class FFTConvolver
+{
+	size_t m_BlockSize;
+	size_t m_FFTSize;
+	size_t m_NumPartitions;
+
+	// Spectra of the zero-padded partitions of the kernel (in half-complex
+	// order, one after another), already scaled for the inverse transform
+	std::vector<float> m_KernelSpectra;
+
+	// Spectra of the last m_NumPartitions input blocks, used as a ring
+	// starting at m_Newest (and going back in time from there)
+	std::vector<float> m_InputSpectra;
+	size_t m_Newest;
+
+	// The previous block followed by the current one
+	std::vector<float> m_Input;
+	std::vector<float> m_Sum;
+
+	fft_plan_t m_Plan;
+	std::vector<float> m_FFTData;
+	std::vector<float> m_FFTCache;
+public:
+	// A block size of zero takes the kernel length (rounded up to a power of
+	// two), so that the kernel fits in one partition.  Otherwise, the block
+	// size must be a power of two.
+	explicit FFTConvolver(const std::vector<float> & kernel,
+			size_t blockSize = 0);
+	virtual ~FFTConvolver();
+
+	// The plan points into the buffers of the convolver
+	FFTConvolver(const FFTConvolver &) = delete;
+	FFTConvolver & operator=(const FFTConvolver &) = delete;
+
+	size_t GetBlockSize() const { return m_BlockSize; }
+
+	// The block size that a block size of zero stands for
+	static size_t GetDefaultBlockSize(size_t kernelSize);
+
+	// Forgets the input so far, as though the stream were preceded by silence
+	void Reset();
+
+	// Filters the next GetBlockSize() samples of the stream.  The output may
+	// be the same buffer as the input.
+	void ProcessBlock(const float * input, float * output);
+};
+
+#endif /* SRC_UTIL_FIRFILTER_FFTCONVOLVER_H_ */
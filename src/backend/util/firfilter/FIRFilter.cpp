@@ -1,10 +1,18 @@
 #include "FIRFilter.h"
-#include "../firwindows/HannWindow.h"
+#include "../firwindows/WindowCache.h"
+#include <algorithm>
+
+// Beyond this many taps, the FFT engine is cheaper than the direct form
+const size_t FIRFilter::m_MaxDirectFormSize = 128;
+
+// Length of the direct-form head of long kernels and of the partitions of
+// their tail, and the longest run that is filtered in one go
+const size_t FIRFilter::m_PartitionSize = 128;
 
 FIRFilter::FIRFilter(size_t filterSize)
+: m_HeadSize(0), m_TailFill(0)
 {
 	m_Filter.resize(filterSize);
-	m_InputHistory.resize(filterSize);
 }
 
 FIRFilter::~FIRFilter()
@@ -13,20 +21,108 @@ FIRFilter::~FIRFilter()
 
 void FIRFilter::ApplyWindow()
 {
-	HannWindow(m_Filter.size()).MultiplyByWindow(m_Filter);
+	WindowCache::Instance().Get(WindowCache::WINDOW_HANN, m_Filter.size())
+			->MultiplyByWindow(m_Filter);
 }
 
-float FIRFilter::ProcessSample(float input)
+void FIRFilter::PrepareEngine()
 {
-	float output = 0.0f;
+	// The subclasses design the kernel after this class is constructed, so
+	// the engine is set up on first use
+	m_HeadSize = std::min(m_Filter.size(), m_PartitionSize);
+	if (IsUsingFFT())
+	{
+		std::vector<float> tail(m_Filter.begin() + m_HeadSize, m_Filter.end());
+		m_TailConvolver.reset(new FFTConvolver(tail, m_PartitionSize));
+		m_TailInput.resize(m_PartitionSize);
+		m_TailOutput.resize(m_PartitionSize);
+	}
+	else
+	{
+		m_HeadSize = m_Filter.size();
+	}
+	m_ReversedHead.assign(m_Filter.rend() - m_HeadSize, m_Filter.rend());
+	m_History.resize(m_HeadSize - 1 + m_PartitionSize);
+	Reset();
+}
+
+void FIRFilter::Reset()
+{
+	std::fill(m_History.begin(), m_History.end(), 0.0f);
+	std::fill(m_TailOutput.begin(), m_TailOutput.end(), 0.0f);
+	m_TailFill = 0;
+	if (m_TailConvolver != nullptr)
+	{
+		m_TailConvolver->Reset();
+	}
+}
+
+void FIRFilter::ProcessRun(const float * input, float * output, size_t count)
+{
+	// The run never crosses the end of a partition of the tail
+	float * window = m_History.data();
+	std::copy(input, input + count, window + m_HeadSize - 1);
+
+	if (m_TailConvolver != nullptr)
+	{
+		std::copy(m_TailOutput.begin() + m_TailFill,
+				m_TailOutput.begin() + m_TailFill + count, output);
+	}
+	else
+	{
+		std::fill(output, output + count, 0.0f);
+	}
 
-	m_InputHistory.pop_front();
-	m_InputHistory.push_back(input);
+	// One tap at a time over the whole run, which keeps the inner loop free
+	// of dependencies, so that it can be vectorized
+	for (size_t j = 0; j != m_HeadSize; ++j)
+	{
+		float coeff = m_ReversedHead[j];
+		const float * src = window + j;
+		for (size_t k = 0; k != count; ++k)
+		{
+			output[k] += coeff * src[k];
+		}
+	}
 
-	size_t k = 0;
-	for (auto it = m_InputHistory.begin(); it != m_InputHistory.end(); ++it, ++k)
+	if (m_TailConvolver != nullptr)
 	{
-		output += *it * m_Filter.at(k);
+		std::copy(window + m_HeadSize - 1, window + m_HeadSize - 1 + count,
+				m_TailInput.begin() + m_TailFill);
+		m_TailFill += count;
+		if (m_TailFill == m_PartitionSize)
+		{
+			// The tail starts a whole partition into the kernel, so its
+			// output for this partition is due with the next one
+			m_TailConvolver->ProcessBlock(m_TailInput.data(),
+					m_TailOutput.data());
+			m_TailFill = 0;
+		}
 	}
+
+	std::copy(window + count, window + count + m_HeadSize - 1, window);
+}
+
+void FIRFilter::ProcessBlock(const float * input, float * output,
+		size_t count)
+{
+	if (m_HeadSize == 0)
+	{
+		PrepareEngine();
+	}
+	while (count != 0)
+	{
+		size_t run = std::min(count, m_PartitionSize - m_TailFill);
+		ProcessRun(input, output, run);
+		input += run;
+		output += run;
+		count -= run;
+	}
+}
+
+float FIRFilter::ProcessSample(float input)
+{
+	float output;
+	ProcessBlock(&input, &output, 1);
 	return output;
 }
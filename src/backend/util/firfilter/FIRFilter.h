@@ -1,15 +1,42 @@
 #ifndef SRC_UTIL_FIRFILTER_FIRFILTER_H_
 #define SRC_UTIL_FIRFILTER_FIRFILTER_H_
 
+#include "FFTConvolver.h"
+#include <memory>
 #include <vector>
-#include <deque>
 #include <cstring>
 
+// Base of the FIR filters, whose subclasses design the kernel.  The filter
+// runs on whole blocks of samples.  Short kernels are applied in direct form.
+// Long kernels are split: their head is applied in direct form, and the rest
+// by partitioned FFT convolution, which has a whole partition of slack
+// before its output is due.  Either way, there is no latency beyond that of
+// the kernel itself, and the engine is chosen by the length of the kernel.
 class FIRFilter
 {
+	static const size_t m_MaxDirectFormSize;
+	static const size_t m_PartitionSize;
+
+	// Number of taps applied in direct form, reversed, so that each output
+	// sample is a dot product with consecutive inputs
+	size_t m_HeadSize;
+	std::vector<float> m_ReversedHead;
+
+	// The last m_HeadSize - 1 inputs, followed by room for a run of up to
+	// m_PartitionSize more
+	std::vector<float> m_History;
+
+	// Convolves the taps after the head.  It is fed whole partitions of
+	// input, and its output for one partition is added to the next.
+	std::unique_ptr<FFTConvolver> m_TailConvolver;
+	std::vector<float> m_TailInput;
+	std::vector<float> m_TailOutput;
+	size_t m_TailFill;
+
+	void PrepareEngine();
+	void ProcessRun(const float * input, float * output, size_t count);
 protected:
 	std::vector<float> m_Filter;
-	std::deque<float> m_InputHistory;
 
 	void ApplyWindow();
 public:
@@ -20,6 +47,18 @@ public:
 	void AssignFilter(std::vector<float> & vec) const { vec = m_Filter; }
 	size_t GetFilterDelay() const { return m_Filter.size() >> 1; }
 
+	// Whether the kernel is long enough for the FFT engine
+	bool IsUsingFFT() const { return m_Filter.size() > m_MaxDirectFormSize; }
+
+	// Forgets the input so far, as though the stream were preceded by silence
+	void Reset();
+
+	// Filters the next samples of the stream.  The output may be the same
+	// buffer as the input.
+	void ProcessBlock(const float * input, float * output, size_t count);
+
+	// Filters a single sample, which is far slower per sample than filtering
+	// blocks
 	float ProcessSample(float input);
 };
 
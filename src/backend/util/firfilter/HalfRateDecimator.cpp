@@ -0,0 +1,56 @@
+#include "HalfRateDecimator.h"
+#include <algorithm>
+
+// The cutoff (relative to the input sample rate) leaves room for the
+// transition band of the filter below the new Nyquist frequency of 0.25
+const size_t HalfRateDecimator::m_FilterSize = 64;
+const float HalfRateDecimator::m_CutoffFreq = 0.2f;
+
+HalfRateDecimator::HalfRateDecimator()
+: m_Filter(m_FilterSize, m_CutoffFreq), m_DelayLeft(0), m_KeepNext(true)
+{
+	Reset();
+}
+
+HalfRateDecimator::~HalfRateDecimator()
+{
+}
+
+void HalfRateDecimator::Reset()
+{
+	m_Filter.Reset();
+	m_DelayLeft = m_Filter.GetFilterDelay();
+	m_KeepNext = true;
+}
+
+void HalfRateDecimator::Decimate(size_t count, std::vector<float> & output)
+{
+	size_t skipped = std::min(count, m_DelayLeft);
+	m_DelayLeft -= skipped;
+	for (size_t k = skipped; k != count; ++k)
+	{
+		if (m_KeepNext)
+		{
+			output.push_back(m_Filtered[k]);
+		}
+		m_KeepNext = !m_KeepNext;
+	}
+}
+
+void HalfRateDecimator::ProcessBlock(const float * input, size_t count,
+		std::vector<float> & output)
+{
+	m_Filtered.resize(count);
+	m_Filter.ProcessBlock(input, m_Filtered.data(), count);
+	Decimate(count, output);
+}
+
+void HalfRateDecimator::Finish(std::vector<float> & output)
+{
+	// Silence pushes the last samples of the stream through the filter
+	size_t count = m_Filter.GetFilterDelay();
+	std::vector<float> silence(count, 0.0f);
+	m_Filtered.resize(count);
+	m_Filter.ProcessBlock(silence.data(), m_Filtered.data(), count);
+	Decimate(count, output);
+}
@@ -0,0 +1,41 @@
+#ifndef SRC_UTIL_FIRFILTER_HALFRATEDECIMATOR_H_
+#define SRC_UTIL_FIRFILTER_HALFRATEDECIMATOR_H_
+
+#include "LowPassFIRFilter.h"
+#include <vector>
+#include <cstring>
+
+// Halves the sample rate of a stream: it is low-passed below the new Nyquist
+// frequency, and every other sample is kept.  The delay of the filter is
+// made up for, so output sample n lines up with input sample 2n, and a
+// stream of N samples comes out as (N + 1) / 2 samples.
+class HalfRateDecimator
+{
+	static const size_t m_FilterSize;
+	static const float m_CutoffFreq;
+
+	LowPassFIRFilter m_Filter;
+	std::vector<float> m_Filtered;
+
+	// Outputs of the filter that still fall within its delay, and the parity
+	// of the next one after that
+	size_t m_DelayLeft;
+	bool m_KeepNext;
+
+	void Decimate(size_t count, std::vector<float> & output);
+public:
+	HalfRateDecimator();
+	virtual ~HalfRateDecimator();
+
+	// Forgets the input so far
+	void Reset();
+
+	// Appends the output for the next samples of the stream
+	void ProcessBlock(const float * input, size_t count,
+			std::vector<float> & output);
+
+	// Appends the output still held back by the delay of the filter
+	void Finish(std::vector<float> & output);
+};
+
+#endif /* SRC_UTIL_FIRFILTER_HALFRATEDECIMATOR_H_ */
@@ -0,0 +1,80 @@
+#include "TruePeakDetector.h"
+#include "LowPassFIRFilter.h"
+#include <algorithm>
+#include <cmath>
+
+const size_t TruePeakDetector::m_OversamplingFactor = 4;
+
+// Taps of each phase of the filter, and how far its output lags behind the
+// input, in samples
+const size_t TruePeakDetector::m_PhaseSize = 12;
+const size_t TruePeakDetector::m_Delay = 6;
+
+// Longest run that is oversampled in one go, which bounds the scratch buffer
+const size_t TruePeakDetector::m_MaxRunSize = 256;
+
+TruePeakDetector::TruePeakDetector()
+{
+	// Each phase of the filter is normalized on its own, so that all of them
+	// pass DC unchanged
+	size_t filterSize = m_OversamplingFactor * m_PhaseSize;
+	LowPassFIRFilter prototype(filterSize, 0.5f / m_OversamplingFactor);
+	m_Phases.resize(m_OversamplingFactor);
+	for (size_t p = 0; p != m_OversamplingFactor; ++p)
+	{
+		std::vector<float> & phase = m_Phases[p];
+		phase.resize(m_PhaseSize);
+		float sum = 0.0f;
+		for (size_t j = 0; j != m_PhaseSize; ++j)
+		{
+			phase[m_PhaseSize - 1 - j] =
+					prototype.At(j * m_OversamplingFactor + p);
+			sum += phase[m_PhaseSize - 1 - j];
+		}
+		for (size_t j = 0; j != m_PhaseSize; ++j)
+		{
+			phase[j] /= sum;
+		}
+	}
+	m_Interpolated.resize(m_MaxRunSize);
+}
+
+TruePeakDetector::~TruePeakDetector()
+{
+}
+
+void TruePeakDetector::DetectRun(const float * input, size_t count,
+		float * peaks)
+{
+	// The inner loops run over the whole run, one tap at a time, which keeps
+	// them free of dependencies, so that they can be vectorized
+	float * interpolated = m_Interpolated.data();
+	const float * window = input - (m_PhaseSize - 1);
+	for (auto it = m_Phases.begin(); it != m_Phases.end(); ++it)
+	{
+		std::fill(interpolated, interpolated + count, 0.0f);
+		for (size_t j = 0; j != m_PhaseSize; ++j)
+		{
+			float coeff = (*it)[j];
+			const float * src = window + j;
+			for (size_t k = 0; k != count; ++k)
+			{
+				interpolated[k] += coeff * src[k];
+			}
+		}
+		for (size_t k = 0; k != count; ++k)
+		{
+			peaks[k] = std::max(peaks[k], std::fabs(interpolated[k]));
+		}
+	}
+}
+
+void TruePeakDetector::Detect(const float * input, size_t count,
+		float * peaks)
+{
+	for (size_t start = 0; start < count; start += m_MaxRunSize)
+	{
+		DetectRun(input + start, std::min(count - start, m_MaxRunSize),
+				peaks + start);
+	}
+}
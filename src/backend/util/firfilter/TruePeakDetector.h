@@ -0,0 +1,42 @@
+#ifndef SRC_UTIL_FIRFILTER_TRUEPEAKDETECTOR_H_
+#define SRC_UTIL_FIRFILTER_TRUEPEAKDETECTOR_H_
+
+#include <vector>
+#include <cstring>
+
+// Finds the peaks of a signal between its samples, by oversampling it four
+// times with a polyphase filter, as the meters of ITU-R BS.1770 do.  That
+// reads the peaks to within half a dB even at the top of the band.
+class TruePeakDetector
+{
+	static const size_t m_OversamplingFactor;
+	static const size_t m_PhaseSize;
+	static const size_t m_Delay;
+	static const size_t m_MaxRunSize;
+
+	// The taps of each phase of the filter, reversed, so that each phase is
+	// a dot product with consecutive inputs
+	std::vector<std::vector<float> > m_Phases;
+	std::vector<float> m_Interpolated;
+
+	void DetectRun(const float * input, size_t count, float * peaks);
+public:
+	TruePeakDetector();
+	virtual ~TruePeakDetector();
+
+	// Number of samples before each run of input that the filter reaches
+	// back to
+	size_t GetHistorySize() const { return m_PhaseSize - 1; }
+
+	// Number of samples by which the peaks lag behind the input.  The peak
+	// found at each sample lies between the samples that far back and the
+	// one after them.
+	size_t GetDelay() const { return m_Delay; }
+
+	// Raises each of the count peaks to the magnitude of the oversampled
+	// signal at the matching sample, if that is higher.  The GetHistorySize()
+	// samples before the input are read as well.
+	void Detect(const float * input, size_t count, float * peaks);
+};
+
+#endif /* SRC_UTIL_FIRFILTER_TRUEPEAKDETECTOR_H_ */
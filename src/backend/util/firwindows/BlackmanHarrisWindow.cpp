@@ -0,0 +1,18 @@
+#include "BlackmanHarrisWindow.h"
+#include "../MathConstants.h"
+#include <cmath>
+
+// The four-term window, whose sidelobes lie 92 dB down
+BlackmanHarrisWindow::BlackmanHarrisWindow(size_t fftSize) : Window(fftSize)
+{
+	Fill([] (double x)
+	{
+		double phase = 2.0 * MathConstants::Pi * x;
+		return 0.35875 - 0.48829 * cos(phase) + 0.14128 * cos(2.0 * phase)
+				- 0.01168 * cos(3.0 * phase);
+	});
+}
+
+BlackmanHarrisWindow::~BlackmanHarrisWindow()
+{
+}
@@ -0,0 +1,13 @@
+#ifndef SRC_UTIL_FIRWINDOWS_BLACKMANHARRISWINDOW_H_
+#define SRC_UTIL_FIRWINDOWS_BLACKMANHARRISWINDOW_H_
+
+#include "Window.h"
+
+class BlackmanHarrisWindow: public Window
+{
+public:
+	BlackmanHarrisWindow(size_t fftSize);
+	virtual ~BlackmanHarrisWindow();
+};
+
+#endif /* SRC_UTIL_FIRWINDOWS_BLACKMANHARRISWINDOW_H_ */
@@ -0,0 +1,15 @@
+#include "HammingWindow.h"
+#include "../MathConstants.h"
+#include <cmath>
+
+HammingWindow::HammingWindow(size_t fftSize) : Window(fftSize)
+{
+	Fill([] (double x)
+	{
+		return 0.54 - 0.46 * cos(2.0 * MathConstants::Pi * x);
+	});
+}
+
+HammingWindow::~HammingWindow()
+{
+}
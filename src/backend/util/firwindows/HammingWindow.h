@@ -0,0 +1,13 @@
+#ifndef SRC_UTIL_FIRWINDOWS_HAMMINGWINDOW_H_
+#define SRC_UTIL_FIRWINDOWS_HAMMINGWINDOW_H_
+
+#include "Window.h"
+
+class HammingWindow: public Window
+{
+public:
+	HammingWindow(size_t fftSize);
+	virtual ~HammingWindow();
+};
+
+#endif /* SRC_UTIL_FIRWINDOWS_HAMMINGWINDOW_H_ */
@@ -0,0 +1,39 @@
+#include "KaiserWindow.h"
+#include <algorithm>
+#include <cmath>
+
+// Puts the sidelobes about 90 dB down, on par with Blackman-Harris
+const double KaiserWindow::m_DefaultBeta = 12.0;
+
+KaiserWindow::KaiserWindow(size_t fftSize) : KaiserWindow(fftSize, m_DefaultBeta)
+{
+}
+
+KaiserWindow::KaiserWindow(size_t fftSize, double beta) : Window(fftSize)
+{
+	double norm = 1.0 / BesselI0(beta);
+	Fill([beta, norm] (double x)
+	{
+		double t = 2.0 * x - 1.0;
+		return norm * BesselI0(beta * sqrt(std::max(0.0, 1.0 - t * t)));
+	});
+}
+
+KaiserWindow::~KaiserWindow()
+{
+}
+
+double KaiserWindow::BesselI0(double x)
+{
+	// The power series converges quickly for the arguments used here
+	double rv = 1.0;
+	double term = 1.0;
+	double halfX = 0.5 * x;
+	for (size_t k = 1; term > 1e-12 * rv; ++k)
+	{
+		double factor = halfX / k;
+		term *= factor * factor;
+		rv += term;
+	}
+	return rv;
+}
@@ -0,0 +1,19 @@
+#ifndef SRC_UTIL_FIRWINDOWS_KAISERWINDOW_H_
+#define SRC_UTIL_FIRWINDOWS_KAISERWINDOW_H_
+
+#include "Window.h"
+
+// The shape parameter trades the width of the main lobe for the height of
+// the sidelobes
+class KaiserWindow: public Window
+{
+	static const double m_DefaultBeta;
+
+	static double BesselI0(double x);
+public:
+	KaiserWindow(size_t fftSize);
+	KaiserWindow(size_t fftSize, double beta);
+	virtual ~KaiserWindow();
+};
+
+#endif /* SRC_UTIL_FIRWINDOWS_KAISERWINDOW_H_ */
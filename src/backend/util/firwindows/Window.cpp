@@ -11,8 +11,15 @@ Window::~Window()
 
 void Window::MultiplyByWindow(std::vector<float> & vec) const
 {
+	MultiplyByWindow(vec.data(), vec.data());
+}
+
+void Window::MultiplyByWindow(const float * input, float * output) const
+{
+	// A plain loop over raw pointers, which the compiler can vectorize
+	const float * window = m_Window.data();
 	for (size_t k = 0; k != m_Window.size(); ++k)
 	{
-		vec.at(k) *= m_Window.at(k);
+		output[k] = input[k] * window[k];
 	}
 }
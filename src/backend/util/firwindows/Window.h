@@ -4,16 +4,37 @@
 #include <vector>
 #include <cstring>
 
+// Windows are costly to compute, so they should be obtained from WindowCache
+// rather than constructed wherever they are needed
 class Window {
 protected:
 	std::vector<float> m_Window;
+
+	// Fills the window from a shape defined on [0, 1].  Windows are
+	// symmetric, so only the first half of the shape is evaluated.
+	template <class Shape>
+	void Fill(const Shape & shape)
+	{
+		size_t size = m_Window.size();
+		for (size_t k = 0; k < (size + 1) / 2; ++k)
+		{
+			double x = size > 1 ? (double) k / (size - 1) : 0.5;
+			m_Window[k] = m_Window[size - 1 - k] = (float) shape(x);
+		}
+	}
 public:
 	Window(size_t fftSize);
 	virtual ~Window();
 
+	size_t GetSize() const { return m_Window.size(); }
+	const float * GetData() const { return m_Window.data(); }
 	float At(size_t k) const { return m_Window.at(k); }
 	void AssignWindow(std::vector<float> & vec) const { vec = m_Window; }
+	// The vector must hold at least GetSize() samples
 	void MultiplyByWindow(std::vector<float> & vec) const;
+
+	// Both buffers hold GetSize() samples, and may be the same
+	void MultiplyByWindow(const float * input, float * output) const;
 };
 
 #endif /* SRC_UTIL_FIRWINDOWS_WINDOW_H_ */
@@ -0,0 +1,60 @@
+#include "WindowCache.h"
+#include "BlackmanHarrisWindow.h"
+#include "HammingWindow.h"
+#include "HannWindow.h"
+#include "KaiserWindow.h"
+
+WindowCache::WindowCache()
+{
+}
+
+WindowCache::~WindowCache()
+{
+}
+
+WindowCache & WindowCache::Instance()
+{
+	static WindowCache inst;
+	return inst;
+}
+
+std::shared_ptr<const Window> WindowCache::Create(Type type, size_t length)
+{
+	std::shared_ptr<const Window> rv;
+	switch (type)
+	{
+	case WINDOW_HAMMING:
+		rv = std::make_shared<HammingWindow>(length);
+		break;
+	case WINDOW_BLACKMAN_HARRIS:
+		rv = std::make_shared<BlackmanHarrisWindow>(length);
+		break;
+	case WINDOW_KAISER:
+		rv = std::make_shared<KaiserWindow>(length);
+		break;
+	case WINDOW_HANN:
+	default:
+		rv = std::make_shared<HannWindow>(length);
+		break;
+	}
+	return rv;
+}
+
+std::shared_ptr<const Window> WindowCache::Get(Type type, size_t length)
+{
+	// Windows are only computed a handful of times per process, so holding
+	// the lock while one is computed costs nothing worth avoiding
+	std::lock_guard<std::mutex> lck(m_Mutex);
+	std::shared_ptr<const Window> & rv = m_Windows[std::make_pair(type, length)];
+	if (rv == nullptr)
+	{
+		rv = Create(type, length);
+	}
+	return rv;
+}
+
+void WindowCache::Clear()
+{
+	std::lock_guard<std::mutex> lck(m_Mutex);
+	m_Windows.clear();
+}
@@ -0,0 +1,45 @@
+#ifndef SRC_UTIL_FIRWINDOWS_WINDOWCACHE_H_
+#define SRC_UTIL_FIRWINDOWS_WINDOWCACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include "Window.h"
+
+// A process-wide cache of windows, keyed by type and length, so that each
+// window is only ever computed once.  The windows are shared and never
+// modified, so they may be used from any thread.
+class WindowCache
+{
+public:
+	enum Type
+	{
+		WINDOW_HANN,
+		WINDOW_HAMMING,
+		WINDOW_BLACKMAN_HARRIS,
+		WINDOW_KAISER
+	};
+private:
+	typedef std::map<std::pair<Type, size_t>, std::shared_ptr<const Window> >
+			WindowMap;
+
+	WindowMap m_Windows;
+	std::mutex m_Mutex;
+
+	static std::shared_ptr<const Window> Create(Type type, size_t length);
+
+	WindowCache();
+public:
+	virtual ~WindowCache();
+
+	static WindowCache & Instance();
+
+	// Computes the window on first use.  Kaiser windows take the default
+	// shape parameter.
+	std::shared_ptr<const Window> Get(Type type, size_t length);
+
+	void Clear();
+};
+
+#endif /* SRC_UTIL_FIRWINDOWS_WINDOWCACHE_H_ */
@@ -1,11 +1,226 @@
 #include "FilterBankProcessor.h"
+#include "../firfilter/LowPassFIRFilter.h"
+#include <algorithm>
 
-FilterBankProcessor::FilterBankProcessor() {
-	// TODO Auto-generated constructor stub
+// Taps of the half-band filter at the even phase, which is half of its
+// length, and a multiple of four.  That leaves the bands about 40 dB apart
+// an octave from their edges, which is plenty for energy envelopes.
+const size_t FilterBankProcessor::m_HalfBandSize = 16;
 
+// Longest run of output pairs that a level splits in one go, which bounds
+// its buffers
+const size_t FilterBankProcessor::m_MaxRunSize = 256;
+
+FilterBankProcessor::FilterBankProcessor(size_t numBands, size_t hopSize)
+: m_NumBands(std::max(numBands, (size_t) 1))
+{
+	size_t decimation = (size_t) 1 << (m_NumBands - 1);
+	m_HopSize = std::max((hopSize + decimation - 1) / decimation,
+			(size_t) 1) * decimation;
+
+	// The taps of a half-band filter an even distance away from its center
+	// are zero, and those an odd distance away are taken from the prototype
+	// and normalized, so that the two halves add up to the input exactly
+	LowPassFIRFilter prototype(2 * m_HalfBandSize, 0.25f);
+	m_Taps.resize(m_HalfBandSize);
+	float sum = 0.0f;
+	for (size_t k = 0; k != m_HalfBandSize; ++k)
+	{
+		m_Taps[m_HalfBandSize - 1 - k] = prototype.At(2 * k + 1);
+		sum += m_Taps[m_HalfBandSize - 1 - k];
+	}
+	for (size_t k = 0; k != m_HalfBandSize; ++k)
+	{
+		m_Taps[k] *= 0.5f / sum;
+	}
+
+	m_Levels.resize(m_NumBands - 1);
+	for (auto it = m_Levels.begin(); it != m_Levels.end(); ++it)
+	{
+		it->m_Even.resize(m_HalfBandSize - 1 + m_MaxRunSize);
+		it->m_Odd.resize(m_HalfBandSize / 2 + m_MaxRunSize);
+		it->m_Low.resize(m_MaxRunSize);
+		it->m_High.resize(m_MaxRunSize);
+	}
+	m_Bands.resize(m_NumBands);
+	for (size_t b = 0; b != m_NumBands; ++b)
+	{
+		// The last band comes out of the same level as the one above it
+		m_Bands[b].m_HopSize =
+				m_HopSize >> std::min(b + 1, m_Levels.size());
+	}
+	Reset();
+}
+
+FilterBankProcessor::~FilterBankProcessor()
+{
 }
 
-FilterBankProcessor::~FilterBankProcessor() {
-	// TODO Auto-generated destructor stub
+size_t FilterBankProcessor::GetBandDelay(size_t band) const
+{
+	// Each level delays its outputs by the center of the filter, at its own
+	// rate, which is m_HalfBandSize - 1 of its input samples
+	size_t numLevels = std::min(band + 1, m_Levels.size());
+	return (m_HalfBandSize - 1) * (((size_t) 1 << numLevels) - 1);
 }
 
+void FilterBankProcessor::Reset()
+{
+	for (auto it = m_Levels.begin(); it != m_Levels.end(); ++it)
+	{
+		std::fill(it->m_Even.begin(), it->m_Even.end(), 0.0f);
+		std::fill(it->m_Odd.begin(), it->m_Odd.end(), 0.0f);
+		it->m_Leftover = 0.0f;
+		it->m_HasLeftover = false;
+	}
+	for (auto it = m_Bands.begin(); it != m_Bands.end(); ++it)
+	{
+		it->m_Fill = 0;
+		it->m_Sum = 0.0f;
+		it->m_Energies.clear();
+	}
+}
+
+void FilterBankProcessor::SplitPairs(Level & level, size_t numPairs)
+{
+	// The even phase of the low half is a dot product with the taps, and
+	// the odd phase is the center tap, so that the high half is their
+	// difference.  There are few taps, so each dot product is kept in
+	// registers, as four partial sums that do not wait on each other, which
+	// is several times faster than running over the whole run one tap at a
+	// time, as the longer filters do.
+	float * low = level.m_Low.data();
+	float * high = level.m_High.data();
+	const float * taps = m_Taps.data();
+	const float * odd = level.m_Odd.data();
+	for (size_t k = 0; k != numPairs; ++k)
+	{
+		const float * even = &level.m_Even[k];
+		float sum0 = 0.0f, sum1 = 0.0f, sum2 = 0.0f, sum3 = 0.0f;
+		for (size_t j = 0; j != m_HalfBandSize; j += 4)
+		{
+			sum0 += taps[j] * even[j];
+			sum1 += taps[j + 1] * even[j + 1];
+			sum2 += taps[j + 2] * even[j + 2];
+			sum3 += taps[j + 3] * even[j + 3];
+		}
+		float sum = (sum0 + sum1) + (sum2 + sum3);
+		float center = 0.5f * odd[k];
+		low[k] = center + sum;
+		high[k] = center - sum;
+	}
+
+	size_t evenHistory = m_HalfBandSize - 1;
+	size_t oddHistory = m_HalfBandSize / 2;
+	std::copy(level.m_Even.begin() + numPairs,
+			level.m_Even.begin() + numPairs + evenHistory,
+			level.m_Even.begin());
+	std::copy(level.m_Odd.begin() + numPairs,
+			level.m_Odd.begin() + numPairs + oddHistory,
+			level.m_Odd.begin());
+}
+
+void FilterBankProcessor::SplitRun(size_t levelIndex, const float * input,
+		size_t count)
+{
+	if (levelIndex == m_Levels.size())
+	{
+		AccumulateBand(m_NumBands - 1, input, count);
+	}
+	else
+	{
+		// The run makes at most m_MaxRunSize pairs, counting the sample
+		// left over from the last one
+		Level & level = m_Levels[levelIndex];
+		float * even = &level.m_Even[m_HalfBandSize - 1];
+		float * odd = &level.m_Odd[m_HalfBandSize / 2];
+		size_t numPairs = 0;
+		size_t k = 0;
+		if (level.m_HasLeftover && count != 0)
+		{
+			even[0] = level.m_Leftover;
+			odd[0] = input[0];
+			numPairs = 1;
+			k = 1;
+			level.m_HasLeftover = false;
+		}
+		for (; k + 1 < count; k += 2, ++numPairs)
+		{
+			even[numPairs] = input[k];
+			odd[numPairs] = input[k + 1];
+		}
+		if (k != count)
+		{
+			level.m_Leftover = input[k];
+			level.m_HasLeftover = true;
+		}
+
+		if (numPairs != 0)
+		{
+			SplitPairs(level, numPairs);
+			AccumulateBand(levelIndex, level.m_High.data(), numPairs);
+			SplitRun(levelIndex + 1, level.m_Low.data(), numPairs);
+		}
+	}
+}
+
+void FilterBankProcessor::AccumulateBand(size_t band, const float * samples,
+		size_t count)
+{
+	BandState & state = m_Bands[band];
+	while (count != 0)
+	{
+		size_t run = std::min(count, state.m_HopSize - state.m_Fill);
+		float sum = 0.0f;
+		for (size_t k = 0; k != run; ++k)
+		{
+			sum += samples[k] * samples[k];
+		}
+		state.m_Sum += sum;
+		state.m_Fill += run;
+		samples += run;
+		count -= run;
+		if (state.m_Fill == state.m_HopSize)
+		{
+			state.m_Energies.push_back(state.m_Sum / state.m_HopSize);
+			state.m_Sum = 0.0f;
+			state.m_Fill = 0;
+		}
+	}
+}
+
+size_t FilterBankProcessor::Process(const float * input, size_t count,
+		std::vector<float> & energies)
+{
+	// Even with a sample left over from the last run, this makes at most
+	// m_MaxRunSize pairs, and every level below gets no more than that
+	size_t maxRun = 2 * m_MaxRunSize - 1;
+	while (count != 0)
+	{
+		size_t run = std::min(count, maxRun);
+		SplitRun(0, input, run);
+		input += run;
+		count -= run;
+	}
+
+	// The bands lag behind each other by a sample or so of their own rate,
+	// so a hop is only put out once all of them are done with it
+	size_t rv = m_Bands.front().m_Energies.size();
+	for (auto it = m_Bands.begin(); it != m_Bands.end(); ++it)
+	{
+		rv = std::min(rv, it->m_Energies.size());
+	}
+	for (size_t h = 0; h != rv; ++h)
+	{
+		for (auto it = m_Bands.begin(); it != m_Bands.end(); ++it)
+		{
+			energies.push_back(it->m_Energies[h]);
+		}
+	}
+	for (auto it = m_Bands.begin(); it != m_Bands.end(); ++it)
+	{
+		it->m_Energies.erase(it->m_Energies.begin(),
+				it->m_Energies.begin() + rv);
+	}
+	return rv;
+}
@@ -1,10 +1,86 @@
 #ifndef SRC_UTIL_MULTIRESOLUTION_FILTERBANKPROCESSOR_H_
 #define SRC_UTIL_MULTIRESOLUTION_FILTERBANKPROCESSOR_H_
 
-class FilterBankProcessor {
+#include <vector>
+#include <cstring>
+
+// Splits a stream into octave bands and measures the energy of each band
+// over hops of the input, which is far cheaper than a spectrum per hop.  Each
+// level of the bank splits its input in two with a half-band filter, keeps
+// the upper half as a band, and passes the lower half on to the next level
+// at half its rate.  Both halves come out of the same polyphase filter at
+// the lower rate, so a level costs a quarter as much as the one above it,
+// and the whole bank costs less than twice its first level.
+//
+// Band 0 is the highest, from a quarter of the sample rate up to half of it.
+// Each band below is an octave lower, down to the last one, which reaches
+// down to DC.
+class FilterBankProcessor
+{
+	static const size_t m_HalfBandSize;
+	static const size_t m_MaxRunSize;
+
+	// One half-band split, with its input in two phases:  the even samples,
+	// after the m_Taps.size() - 1 before them, and the odd ones, after half
+	// as many before them.  An odd sample left over from the last run is
+	// held back until its even partner comes in.
+	struct Level
+	{
+		std::vector<float> m_Even;
+		std::vector<float> m_Odd;
+		float m_Leftover;
+		bool m_HasLeftover;
+		std::vector<float> m_Low;
+		std::vector<float> m_High;
+	};
+
+	// Energy of each band so far in the current hop, and the energies of the
+	// hops that are complete in that band but not yet in all of them
+	struct BandState
+	{
+		size_t m_HopSize;
+		size_t m_Fill;
+		float m_Sum;
+		std::vector<float> m_Energies;
+	};
+
+	size_t m_NumBands;
+	size_t m_HopSize;
+
+	// The taps of the half-band filter at the even phase, reversed, so that
+	// each output is a dot product with consecutive even samples.  The only
+	// tap at the odd phase is the center one, which is one half.
+	std::vector<float> m_Taps;
+	std::vector<Level> m_Levels;
+	std::vector<BandState> m_Bands;
+
+	void SplitRun(size_t level, const float * input, size_t count);
+	void SplitPairs(Level & level, size_t numPairs);
+	void AccumulateBand(size_t band, const float * samples, size_t count);
 public:
-	FilterBankProcessor();
+	// The hop size is rounded up to a multiple of the decimation of the
+	// lowest band, so that every band has a whole number of samples per hop
+	FilterBankProcessor(size_t numBands, size_t hopSize);
 	virtual ~FilterBankProcessor();
+
+	size_t GetNumBands() const { return m_NumBands; }
+	size_t GetHopSize() const { return m_HopSize; }
+
+	// Upper edge of the band, relative to the sample rate
+	float GetUpperEdge(size_t band) const { return 0.5f / (1 << band); }
+
+	// Number of samples by which the band lags behind the input
+	size_t GetBandDelay(size_t band) const;
+
+	// Forgets the input so far, as though the stream were preceded by silence
+	void Reset();
+
+	// Filters the next samples of the stream, and appends the energies of
+	// each hop that is complete in all bands to the given vector, as
+	// GetNumBands() mean squares, band 0 first.  Returns the number of hops
+	// appended.
+	size_t Process(const float * input, size_t count,
+			std::vector<float> & energies);
 };
 
 #endif /* SRC_UTIL_MULTIRESOLUTION_FILTERBANKPROCESSOR_H_ */
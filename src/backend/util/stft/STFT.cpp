@@ -1,6 +1,6 @@
 #include "STFT.h"
 #include "../MathConstants.h"
-#include "../firwindows/HannWindow.h"
+#include "../firwindows/WindowCache.h"
 #include <cmath>
 #include <cstring>
 
@@ -49,7 +49,8 @@ void STFT::Initialize(SpectrumProcessor * processor, size_t osampFactor)
 	}
 
 	// Set up window
-	HannWindow(m_FrameSize).AssignWindow(m_Window);
+	m_Window = WindowCache::Instance().Get(WindowCache::WINDOW_HANN,
+			m_FrameSize);
 
 	m_StepSize = m_FrameSize / osampFactor;
 	m_FIFOPos = m_FFTLatency = m_FrameSize - m_StepSize;
@@ -73,10 +74,8 @@ void STFT::SubmitSample(float sample)
 	if (++m_FIFOPos >= m_FrameSize)
 	{
 		m_FIFOPos = m_FFTLatency;
-		for (size_t k = 0; k != m_FrameSize; ++k)
-		{
-			m_InFFTData.at(k) = m_InFIFO.at(k) * m_Window.at(k);
-		}
+		m_Window->MultiplyByWindow(m_InFIFO.data(),
+				plan_samples(&m_InFFTPlan));
 		r2hc(&m_InFFTPlan);
 
 		float * inputPtr = plan_samples(&m_InFFTPlan);
@@ -89,10 +88,11 @@ void STFT::SubmitSample(float sample)
 			memcpy(outInfo.m_OutFFTData.data(), data.data(), m_FrameSize * sizeof(float));
 			hc2r(&outInfo.m_OutFFTPlan);
 			float * outSamples = plan_samples(&outInfo.m_OutFFTPlan);
+			const float * window = m_Window->GetData();
+			float scale = 1.27519f / ((m_FrameSize >> 1) * m_OsampFactor);
 			for (size_t m = 0; m != m_FrameSize; ++m)
 			{
-				outInfo.m_OutAccum.at(m) += outSamples[m] * m_Window.at(m)
-						* 1.27519f / ((m_FrameSize >> 1) * m_OsampFactor);
+				outInfo.m_OutAccum[m] += outSamples[m] * window[m] * scale;
 			}
 			memcpy(outInfo.m_OutFIFO.data(), outInfo.m_OutAccum.data(), m_StepSize * sizeof(float));
 			memmove(outInfo.m_OutAccum.data(), outInfo.m_OutAccum.data() + m_StepSize, m_FrameSize * sizeof(float));
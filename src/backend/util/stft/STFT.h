@@ -3,6 +3,7 @@
 
 #include "../minfft.h"
 #include "SpectrumProcessor.h"
+#include "../firwindows/Window.h"
 #include <memory>
 #include <deque>
 #include <vector>
@@ -33,7 +34,7 @@ class STFT
 	std::vector<OutputInfo> m_OutInfo; // Number of outputs
 	size_t m_OutSize;
 
-	std::vector<float> m_Window; // FFT length
+	std::shared_ptr<const Window> m_Window; // FFT length
 	size_t m_FIFOPos;
 
 	size_t m_StepSize;
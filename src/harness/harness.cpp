@@ -0,0 +1,1783 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <ctime>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../backend/core/AudioBlock.h"
+#include "../backend/core/AudioFile.h"
+#include "../backend/core/AudioSink.h"
+#include "../backend/core/analysis/key/KeyAnalyzer.h"
+#include "../backend/core/RequestQueue.h"
+#include "../backend/core/receivers/AudioReceiver.h"
+#include "../backend/core/stretch/AudioStretcher.h"
+#include "../backend/core/stretch/AudioStretchInfo.h"
+#include "../backend/core/stretch/RatioCurve.h"
+#include "../backend/core/xfade/Crossfader.h"
+#include "../backend/core/xfade/CrossfadeSchedule.h"
+#include "../backend/core/xfade/fademaps/FadeMap.h"
+#include "../backend/core/xfade/fademaps/KneeFadeMap.h"
+#include "../backend/core/xfade/bgfile/Beatgrid.h"
+#include "../backend/core/xfade/bgfile/BeatgridFileReader.h"
+#include "../backend/core/xfade/bgfile/FadeSection.h"
+#include "../backend/core/filters/CubicInterpFilter.h"
+#include "../backend/core/filters/TruePeakLimiter.h"
+#include "../backend/util/firfilter/LowPassFIRFilter.h"
+#include "../backend/util/firwindows/WindowCache.h"
+#include "../backend/util/multiresolution/FilterBankProcessor.h"
+#include "../backend/util/minfft.h"
+#include "../backend/util/MathConstants.h"
+#include "../backend/util/StrUtil.h"
+
+// Renders crossfades between synthetic click tracks offline and measures how
+// well they come out: how closely the beats of the two tracks line up (to
+// within a bound for each scenario), how closely the level of each track
+// follows its crossfade schedule, how large the steps are at the seams that
+// the click removal filter smooths over, and how much time the whole thing
+// takes.  After the scenarios, it benchmarks and checks the parts of the mix
+// one at a time, each in a section of the report that is described where it
+// is produced.  The tracks and signals are generated from scratch on every
+// run, so the results only depend on the code.
+//
+// Each track is a quiet, steady tone with a short tone burst on every beat.
+// The bursts of the fade-out track and the fade-in track have different
+// frequencies, so they can be told apart in the mix.  The frequencies (and
+// the length of the detector's moving average) are chosen so that each
+// detector is blind to the bursts of the other track and to the tone.
+
+typedef std::chrono::steady_clock Clock;
+
+static const int sampleRate = 44100;
+static const int numChannels = 2;
+static const double trackDuration = 30.0;
+static const double firstBeatTime = 0.5;
+static const double trackTail = 0.5;
+static const size_t fadeBeats = 16;
+static const double toneFrequency = 500.0;
+static const double toneAmplitude = 0.05;
+static const double fadeOutClickFrequency = 1000.0;
+static const double fadeInClickFrequency = 2000.0;
+static const double clickAmplitude = 0.4;
+static const double clickDuration = 0.02;
+
+// The detector averages over 2 ms, which nulls out every frequency that lies
+// a multiple of 500 Hz away from the one it listens for
+static const double detectorAverageTime = 0.002;
+// Relative to the envelope of a click at full level
+static const double detectorFloor = 0.02;
+static const double detectorRefractoryTime = 0.15;
+
+// Beats are only compared, and levels only checked, where the expected gain
+// of the track is at least this large
+static const double alignmentMinGain = 0.1;
+static const double levelMinGain = 0.05;
+
+// Half of the neighbourhood of a seam that the step across it is compared to
+static const double seamNeighbourhoodTime = 0.005;
+
+static const char * const fadeCurveSettings[] = {
+	"linear", "knee", "equal-power", "s-curve", "log", "bezier:0.42,0,0.58,1"
+};
+static const size_t fadeCurveFrames = 1 << 22;
+static const size_t fadeCurveErrorPoints = 100000;
+
+// Both sides of the switch between the direct form and the FFT engine
+static const size_t firFilterSizes[] = { 16, 64, 128, 256, 1024, 4096 };
+static const size_t firFilterFrames = 1 << 20;
+static const size_t firBlockSize = 512;
+static const double firCutoff = 0.05;
+
+// Seams as long as the sink is ever configured for, and the number of them
+// that each is timed over
+static const double seamTimeIntervals[] = { 0.0005, 0.001, 0.005 };
+static const size_t seamBlockSize = 4096;
+static const size_t seamRepetitions = 20000;
+
+// Channel counts that the limiter is timed with, from mono to 5.1, and the
+// level of each of the two tones that it is fed, which add up to well above
+// full scale, like two loud tracks at the knee of a fade
+static const size_t limiterChannelCounts[] = { 1, 2, 6 };
+static const size_t limiterFrames = 1 << 20;
+static const size_t limiterBlockSize = 4096;
+static const double limiterToneAmplitude = 0.75;
+
+// Band counts that the filterbank is timed with, and the STFT that it stands
+// in for, whose frames are four hops long
+static const size_t filterBankBandCounts[] = { 4, 6, 8 };
+static const size_t filterBankFrames = 1 << 20;
+static const size_t filterBankBlockSize = 4096;
+static const size_t filterBankHopSize = 512;
+static const size_t stftFrameSize = 2048;
+
+// Fade sections far longer than any that a DJ would set, stepped through a
+// chunk of the stretcher at a time, with a tempo that wanders back and forth
+// like that of a live drummer
+static const size_t beatgridSectionBeats[] = { 512, 2048 };
+static const size_t beatgridChunkFrames = 512;
+static const double beatgridTempo = 124.0;
+static const double beatgridTempoSwing = 2.0;
+static const size_t beatgridSwingBeats = 64;
+
+// Times that each beatgrid file is read, in each format
+static const size_t beatgridFileReads = 200;
+
+// Pure tones (as MIDI note numbers) across the range of the key analyzer,
+// each in tune and a quarter of a semitone off either way, which is as far
+// off as a recording can be before it belongs to the next semitone
+static const int chromaTonePitches[] = { 36, 45, 57, 61, 69, 78, 88 };
+static const double chromaToneCents[] = { -25.0, 0.0, 25.0 };
+static const double chromaToneDuration = 5.0;
+
+// Engines that the stretcher is compared with, and the ratios that each is
+// ramped to from unity, which are about as far off as the scenarios go.  The
+// click track is stretched in chunks of the crossfader's size, and the tone
+// between the clicks is fitted over windows of its own.  Every engine has to
+// put every click within the same bound as the scenarios (in ms) of where
+// the ratio curve says.
+static const AudioStretcher::EngineType stretchEngines[] = {
+	AudioStretcher::ENGINE_RUBBERBAND, AudioStretcher::ENGINE_NATIVE,
+	AudioStretcher::ENGINE_VARISPEED
+};
+static const double stretchRatios[] = { 0.95, 1.05 };
+static const double stretchDuration = 20.0;
+static const double stretchRampDuration = 5.0;
+static const double stretchBeatInterval = 0.5;
+static const size_t stretchChunkFrames = 512;
+static const size_t stretchToneWindow = 2048;
+static const double stretchMaxAlignmentMs = 1.0;
+
+enum StretchMode
+{
+	MODE_NORMAL,
+	MODE_RUBBERBAND,
+	MODE_NATIVE,
+	MODE_VARISPEED
+};
+
+struct Scenario
+{
+	const char * m_Name;
+	double m_FromBPM;
+	double m_ToBPM;
+	StretchMode m_Mode;
+	bool m_BandSplit;
+
+	// Largest misalignment (in ms) between the beats of the two tracks that
+	// the scenario passes with, or zero if the beats are not checked
+	double m_MaxAlignmentMs;
+
+	// Seconds of the fade-in track that are actually in its file, whose
+	// header claims the whole track, or zero if all of it is there
+	double m_FadeInLength;
+};
+
+static const Scenario scenarios[] = {
+	{ "dj-rubberband-up", 120.0, 126.0, MODE_RUBBERBAND, false, 1.0, 0.0 },
+	{ "dj-rubberband-down", 128.0, 122.0, MODE_RUBBERBAND, false, 1.0, 0.0 },
+	{ "dj-native", 120.0, 123.0, MODE_NATIVE, false, 1.0, 0.0 },
+	{ "dj-varispeed", 120.0, 126.0, MODE_VARISPEED, false, 1.0, 0.0 },
+	{ "dj-bass-swap", 120.0, 124.0, MODE_RUBBERBAND, true, 1.0, 0.0 },
+	{ "normal", 120.0, 140.0, MODE_NORMAL, false, 0.0, 0.0 },
+	// The fade-in track runs out halfway through its fade, which leaves the
+	// rest of the fade-out track unread.  The scenario passes as long as
+	// the crossfade finishes.
+	{ "dj-short-next", 120.0, 124.0, MODE_RUBBERBAND, false, 0.0, 4.0 }
+};
+
+static const char * GetModeName(StretchMode mode)
+{
+	const char * rv;
+	switch (mode)
+	{
+	case MODE_RUBBERBAND:
+		rv = "rubberband";
+		break;
+	case MODE_NATIVE:
+		rv = "native";
+		break;
+	case MODE_VARISPEED:
+		rv = "varispeed";
+		break;
+	default:
+		rv = "normal";
+		break;
+	}
+	return rv;
+}
+
+// Phase (in radians) of a sinusoid of the given frequency at the given
+// sample, reduced to a single period so that it stays exact over long tracks
+static double GetPhase(double frequency, size_t pos)
+{
+	return 2.0 * MathConstants::Pi * fmod(frequency * pos / sampleRate, 1.0);
+}
+
+// Runs the loop once and returns the seconds it took
+template <typename Loop>
+static double TimeLoop(Loop loop)
+{
+	Clock::time_point start = Clock::now();
+	loop();
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Also adds up what the loop wrote into the checksum.  The benchmarks report
+// the checksum along with their timings, which keeps the compiler from
+// optimizing away a loop whose output is not otherwise used.
+template <typename Loop>
+static double TimeLoop(Loop loop, const float * output, size_t numOutput,
+		double & checksum)
+{
+	double rv = TimeLoop(loop);
+	checksum += std::accumulate(output, output + numOutput, 0.0);
+	return rv;
+}
+
+// The signal that the benchmarks of the filters and fade curves feed through
+// the code that they time
+static std::vector<float> BuildBenchmarkSignal(size_t numFrames)
+{
+	std::vector<float> rv(numFrames);
+	for (size_t k = 0; k != numFrames; ++k)
+	{
+		rv[k] = clickAmplitude * sin(GetPhase(fadeOutClickFrequency, k));
+	}
+	return rv;
+}
+
+static size_t GetNumBeats(double bpm)
+{
+	return (size_t) ((trackDuration - trackTail - firstBeatTime) * bpm / 60.0)
+			+ 1;
+}
+
+static double GetBeatTime(double bpm, size_t beat)
+{
+	return firstBeatTime + beat * 60.0 / bpm;
+}
+
+static std::string GetTrackFilename(const std::string & directory, double bpm,
+		bool fadeOut, double length)
+{
+	return length > 0.0 ?
+			StrUtil::format("%s/harness-%s-%.2f-cut-%.2f.wav",
+					directory.c_str(), fadeOut ? "out" : "in", bpm, length) :
+			StrUtil::format("%s/harness-%s-%.2f.wav", directory.c_str(),
+					fadeOut ? "out" : "in", bpm);
+}
+
+static void WriteLE(std::ostream & out, uint32_t value, size_t numBytes)
+{
+	for (size_t k = 0; k != numBytes; ++k)
+	{
+		out.put((char) ((value >> (8 * k)) & 0xff));
+	}
+}
+
+// Writes a 16-bit PCM WAV file with the given mono samples on every channel.
+// The header declares all of the samples, but only the first numWritten of
+// them are written, as in a file that was cut short.
+static bool WriteWavFile(const std::string & filename,
+		const std::vector<float> & samples, size_t numWritten)
+{
+	std::ofstream out(filename.c_str(), std::ios::binary);
+	uint32_t dataSize = samples.size() * numChannels * 2;
+	out.write("RIFF", 4);
+	WriteLE(out, 36 + dataSize, 4);
+	out.write("WAVEfmt ", 8);
+	WriteLE(out, 16, 4);
+	WriteLE(out, 1, 2);
+	WriteLE(out, numChannels, 2);
+	WriteLE(out, sampleRate, 4);
+	WriteLE(out, sampleRate * numChannels * 2, 4);
+	WriteLE(out, numChannels * 2, 2);
+	WriteLE(out, 16, 2);
+	out.write("data", 4);
+	WriteLE(out, dataSize, 4);
+	for (auto it = samples.begin(); it != samples.begin() + numWritten; ++it)
+	{
+		int16_t value = (int16_t) lrint(
+				std::max(-1.0f, std::min(1.0f, *it)) * INT16_MAX);
+		for (int ch = 0; ch != numChannels; ++ch)
+		{
+			WriteLE(out, (uint16_t) value, 2);
+		}
+	}
+	return out.good();
+}
+
+// Adds a tone burst with a raised cosine envelope, centred on the given time
+static void AddClick(std::vector<float> & samples, double time,
+		double frequency, double amplitude)
+{
+	ssize_t start = lrint((time - 0.5 * clickDuration) * sampleRate);
+	ssize_t length = lrint(clickDuration * sampleRate);
+	for (ssize_t k = 0; k != length; ++k)
+	{
+		ssize_t pos = start + k;
+		if (pos >= 0 && pos < (ssize_t) samples.size())
+		{
+			double envelope = 0.5 - 0.5 * cos(2.0 * MathConstants::Pi * k /
+					length);
+			samples[pos] += amplitude * envelope *
+					sin(GetPhase(frequency, pos));
+		}
+	}
+}
+
+static FadeSection BuildSection(double bpm, size_t firstBeat)
+{
+	FadeSection section;
+	section.SetTime(GetBeatTime(bpm, firstBeat));
+	section.SetInstantaneousTempo(bpm);
+	section.GetBeatgrid().SetBPMBeatgrid(std::vector<double>(fadeBeats, bpm));
+	section.GetBeatgrid().SetHasGrid(true);
+	return section;
+}
+
+// Writes a click track and its beatgrid file.  The fade-in section starts on
+// the first beat and the fade-out section ends on the last one.  The file is
+// cut short after the given length, unless it is zero.
+static bool WriteTrack(const std::string & filename, double bpm,
+		double clickFrequency, double length)
+{
+	std::vector<float> samples((size_t) (trackDuration * sampleRate));
+	for (size_t k = 0; k != samples.size(); ++k)
+	{
+		samples[k] = toneAmplitude * sin(GetPhase(toneFrequency, k));
+	}
+	size_t numBeats = GetNumBeats(bpm);
+	for (size_t beat = 0; beat != numBeats; ++beat)
+	{
+		AddClick(samples, GetBeatTime(bpm, beat), clickFrequency,
+				clickAmplitude);
+	}
+
+	std::vector<FadeSection> sections(2);
+	sections[BeatgridFileReader::FADE_IN_SECTION] = BuildSection(bpm, 0);
+	sections[BeatgridFileReader::FADE_OUT_SECTION] =
+			BuildSection(bpm, numBeats - 1 - fadeBeats);
+	BeatgridFileReader writer;
+	writer.SetSections(std::move(sections));
+
+	// A binary file left over from an earlier run could be read in place of
+	// the text file, so it is converted as well
+	size_t numWritten = length > 0.0 ? std::min(samples.size(),
+			(size_t) (length * sampleRate)) : samples.size();
+	return WriteWavFile(filename, samples, numWritten) &&
+			writer.WriteText(BeatgridFileReader::GetTextFilename(filename)) &&
+			BeatgridFileReader::ConvertTextFile(filename);
+}
+
+// Collects everything that the sink puts out, mixed down to mono, along with
+// the positions of the seams where click removal was applied.  The limiter
+// delays the stream after the seams are marked, so they are moved by its
+// latency.
+class CaptureReceiver : public AudioReceiver
+{
+	std::vector<float> m_Samples;
+	std::vector<size_t> m_Seams;
+public:
+	CaptureReceiver() {}
+	virtual ~CaptureReceiver() {}
+
+	void OnAudioInput(const std::shared_ptr<AudioBlock> & blk)
+	{
+		if (blk->isClickRemovalSet())
+		{
+			m_Seams.push_back(m_Samples.size() +
+					AudioSink::Instance().getLatency());
+		}
+		for (size_t k = 0; k != blk->getNumSamples(); ++k)
+		{
+			float sum = 0.0f;
+			for (int ch = 0; ch != numChannels; ++ch)
+			{
+				sum += blk->getSampleAtPosition(ch, k);
+			}
+			m_Samples.push_back(sum / numChannels);
+		}
+	}
+
+	const std::vector<float> & GetSamples() const { return m_Samples; }
+	const std::vector<size_t> & GetSeams() const { return m_Seams; }
+};
+
+class HarnessRequestQueue : public RequestQueue
+{
+	HarnessRequestQueue() : RequestQueue(), m_SetupTime(0.0),
+		m_HasCrossfade(false), m_WasDJCrossfade(false)
+	{
+		m_Origins[0] = m_Origins[1] = 0.0;
+	}
+
+	double m_SetupTime;
+	bool m_HasCrossfade;
+	bool m_WasDJCrossfade;
+	CrossfadeSchedule m_Schedules[2];
+	double m_Origins[2];
+public:
+	virtual ~HarnessRequestQueue() {}
+
+	static HarnessRequestQueue & Instance()
+	{
+		static HarnessRequestQueue inst;
+		return inst;
+	}
+
+	void Reset()
+	{
+		m_SetupTime = 0.0;
+		m_HasCrossfade = false;
+		m_WasDJCrossfade = false;
+	}
+
+	void OnCrossfadePrepared(const Crossfader & crossfader)
+	{
+		m_SetupTime = crossfader.getSetupTime();
+	}
+
+	// The crossfader is gone once the queue is idle, so everything that is
+	// needed to analyze the crossfade is copied here
+	void OnCrossfadeFinished(const Crossfader & crossfader)
+	{
+		m_HasCrossfade = true;
+		m_WasDJCrossfade = crossfader.isAllowingDJCrossfade();
+		for (int k = 0; k != 2; ++k)
+		{
+			bool fadeOut = k == 0;
+			m_Schedules[k] = crossfader.GetSchedule(fadeOut);
+			m_Origins[k] = crossfader.GetScheduleOrigin(fadeOut);
+		}
+	}
+
+	double GetSetupTime() const { return m_SetupTime; }
+	bool HasCrossfade() const { return m_HasCrossfade; }
+	bool WasDJCrossfade() const { return m_WasDJCrossfade; }
+
+	const CrossfadeSchedule & GetSchedule(bool fadeOut) const
+	{
+		return m_Schedules[fadeOut ? 0 : 1];
+	}
+
+	double GetScheduleOrigin(bool fadeOut) const
+	{
+		return m_Origins[fadeOut ? 0 : 1];
+	}
+};
+
+// The level of the tone burst of the given frequency, demodulated and
+// averaged over the detector time
+static std::vector<double> ComputeEnvelope(const std::vector<float> & samples,
+		double frequency)
+{
+	size_t length = (size_t) lrint(detectorAverageTime * sampleRate);
+	std::vector<double> rv(samples.size(), 0.0);
+	double sumI = 0.0, sumQ = 0.0;
+	std::vector<double> valI(samples.size()), valQ(samples.size());
+	for (size_t k = 0; k != samples.size(); ++k)
+	{
+		double phase = GetPhase(frequency, k);
+		valI[k] = samples[k] * cos(phase);
+		valQ[k] = samples[k] * sin(phase);
+		sumI += valI[k];
+		sumQ += valQ[k];
+		if (k >= length)
+		{
+			sumI -= valI[k - length];
+			sumQ -= valQ[k - length];
+		}
+		// Centre the average on the sample
+		if (k >= length / 2)
+		{
+			rv[k - length / 2] = 2.0 * sqrt(sumI * sumI + sumQ * sumQ) / length;
+		}
+	}
+	return rv;
+}
+
+struct Click
+{
+	double m_OutputTime;
+	double m_Level;
+	double m_SourceTime;
+	double m_ExpectedGain;
+};
+
+// Finds the peaks of the envelope that rise above the floor, keeping only the
+// highest one within the refractory time
+static std::vector<Click> DetectClicks(const std::vector<double> & envelope,
+		double floor)
+{
+	std::vector<Click> rv;
+	size_t refractory = (size_t) (detectorRefractoryTime * sampleRate);
+	size_t peakPos = 0;
+	double peak = 0.0;
+	for (size_t k = 0; k <= envelope.size(); ++k)
+	{
+		double value = k != envelope.size() ? envelope[k] : 0.0;
+		if (value > floor)
+		{
+			if (value > peak)
+			{
+				peak = value;
+				peakPos = k;
+			}
+		}
+		else if (peak > 0.0)
+		{
+			Click click;
+			click.m_OutputTime = (double) peakPos / sampleRate;
+			click.m_Level = peak;
+			click.m_SourceTime = 0.0;
+			click.m_ExpectedGain = 0.0;
+			if (!rv.empty() && (peakPos - (size_t) lrint(
+					rv.back().m_OutputTime * sampleRate)) < refractory)
+			{
+				if (peak > rv.back().m_Level)
+				{
+					rv.back() = click;
+				}
+			}
+			else
+			{
+				rv.push_back(click);
+			}
+			peak = 0.0;
+		}
+	}
+	return rv;
+}
+
+// Envelope peak of a single click at full level, which detected levels are
+// measured against
+static double GetNominalClickLevel(double frequency)
+{
+	std::vector<float> samples((size_t) (4.0 * clickDuration * sampleRate));
+	AddClick(samples, 2.0 * clickDuration, frequency, clickAmplitude);
+	std::vector<double> envelope = ComputeEnvelope(samples, frequency);
+	return *std::max_element(envelope.begin(), envelope.end());
+}
+
+// Assigns beats to the detected clicks of a track, counting forward from the
+// first click (for the fade-out track) or back from the last one (for the
+// fade-in track).  Counting stops at the first gap that is too long to be a
+// single beat, which is where the track has faded below the detector floor.
+static void IndexClicks(std::vector<Click> & clicks, double bpm, bool fadeOut,
+		const CrossfadeSchedule & schedule, double origin, double maxGap)
+{
+	size_t numBeats = GetNumBeats(bpm);
+	size_t numIndexed = 0;
+	for (size_t k = 0; k != clicks.size() && numIndexed < numBeats; ++k)
+	{
+		size_t pos = fadeOut ? k : clicks.size() - 1 - k;
+		size_t prev = fadeOut ? pos - 1 : pos + 1;
+		if (k != 0 && std::fabs(clicks[pos].m_OutputTime -
+				clicks[prev].m_OutputTime) > maxGap)
+		{
+			break;
+		}
+		size_t beat = fadeOut ? k : numBeats - 1 - k;
+		clicks[pos].m_SourceTime = GetBeatTime(bpm, beat);
+		clicks[pos].m_ExpectedGain =
+				schedule.GetGainAtTime(clicks[pos].m_SourceTime - origin);
+		++numIndexed;
+	}
+	if (fadeOut)
+	{
+		clicks.resize(numIndexed);
+	}
+	else
+	{
+		clicks.erase(clicks.begin(), clicks.end() - numIndexed);
+	}
+}
+
+struct Stats
+{
+	size_t m_Count;
+	double m_Sum;
+	double m_SumSquares;
+	double m_MaxAbs;
+
+	Stats() : m_Count(0), m_Sum(0.0), m_SumSquares(0.0), m_MaxAbs(0.0) {}
+
+	void Add(double value)
+	{
+		++m_Count;
+		m_Sum += value;
+		m_SumSquares += value * value;
+		m_MaxAbs = std::max(m_MaxAbs, std::fabs(value));
+	}
+
+	std::string ToJson() const
+	{
+		return StrUtil::format("{ \"count\": %zu, \"mean\": %.6f, "
+				"\"rms\": %.6f, \"maxAbs\": %.6f }", m_Count,
+				m_Count != 0 ? m_Sum / m_Count : 0.0,
+				m_Count != 0 ? sqrt(m_SumSquares / m_Count) : 0.0, m_MaxAbs);
+	}
+};
+
+struct ScenarioResult
+{
+	bool m_Completed;
+	bool m_Crossfaded;
+	bool m_DJCrossfade;
+	double m_SetupTime;
+	double m_CPUTime;
+	double m_WallTime;
+	double m_RenderedTime;
+	size_t m_NumFadeOutClicks;
+	size_t m_NumFadeInClicks;
+	Stats m_Alignment;
+	Stats m_FadeOutLevel;
+	Stats m_FadeInLevel;
+	size_t m_NumSeams;
+	double m_MaxSeamStep;
+	double m_MaxSeamRatio;
+
+	ScenarioResult()
+	: m_Completed(false), m_Crossfaded(false), m_DJCrossfade(false),
+	  m_SetupTime(0.0), m_CPUTime(0.0), m_WallTime(0.0), m_RenderedTime(0.0),
+	  m_NumFadeOutClicks(0), m_NumFadeInClicks(0), m_NumSeams(0),
+	  m_MaxSeamStep(0.0), m_MaxSeamRatio(0.0)
+	{
+	}
+};
+
+// Compares the step across each seam with the largest step in the audio
+// around it.  A ratio well above one is an audible click.
+static void MeasureSeams(const CaptureReceiver & capture,
+		ScenarioResult & result)
+{
+	const std::vector<float> & samples = capture.GetSamples();
+	const std::vector<size_t> & seams = capture.GetSeams();
+	size_t halfWidth = (size_t) (seamNeighbourhoodTime * sampleRate);
+	for (auto it = seams.begin(); it != seams.end(); ++it)
+	{
+		size_t pos = *it;
+		if (pos == 0 || pos >= samples.size())
+		{
+			continue;
+		}
+		double step = std::fabs(samples[pos] - samples[pos - 1]);
+		double localMax = 0.0;
+		size_t begin = pos > halfWidth ? pos - halfWidth : 1;
+		size_t end = std::min(samples.size(), pos + halfWidth);
+		for (size_t k = begin; k != end; ++k)
+		{
+			if (k != pos)
+			{
+				localMax = std::max(localMax,
+						(double) std::fabs(samples[k] - samples[k - 1]));
+			}
+		}
+		++result.m_NumSeams;
+		result.m_MaxSeamStep = std::max(result.m_MaxSeamStep, step);
+		if (localMax > 0.0)
+		{
+			result.m_MaxSeamRatio = std::max(result.m_MaxSeamRatio,
+					step / localMax);
+		}
+	}
+}
+
+static void AnalyzeCapture(const Scenario & scenario,
+		const HarnessRequestQueue & queue, const CaptureReceiver & capture,
+		ScenarioResult & result)
+{
+	const std::vector<float> & samples = capture.GetSamples();
+	result.m_RenderedTime = (double) samples.size() / sampleRate;
+	MeasureSeams(capture, result);
+	if (!result.m_Crossfaded)
+	{
+		return;
+	}
+
+	const CrossfadeSchedule & fadeOutSchedule = queue.GetSchedule(true);
+	const CrossfadeSchedule & fadeInSchedule = queue.GetSchedule(false);
+	double maxDeviation = std::max(fadeOutSchedule.GetMaxRatioDeviation(),
+			fadeInSchedule.GetMaxRatioDeviation());
+	double maxGap = 1.5 * (1.0 + maxDeviation) *
+			60.0 / std::min(scenario.m_FromBPM, scenario.m_ToBPM);
+
+	double fadeOutNominal = GetNominalClickLevel(fadeOutClickFrequency);
+	double fadeInNominal = GetNominalClickLevel(fadeInClickFrequency);
+	std::vector<Click> fadeOutClicks = DetectClicks(
+			ComputeEnvelope(samples, fadeOutClickFrequency),
+			detectorFloor * fadeOutNominal);
+	std::vector<Click> fadeInClicks = DetectClicks(
+			ComputeEnvelope(samples, fadeInClickFrequency),
+			detectorFloor * fadeInNominal);
+	IndexClicks(fadeOutClicks, scenario.m_FromBPM, true, fadeOutSchedule,
+			queue.GetScheduleOrigin(true), maxGap);
+	IndexClicks(fadeInClicks, scenario.m_ToBPM, false, fadeInSchedule,
+			queue.GetScheduleOrigin(false), maxGap);
+	result.m_NumFadeOutClicks = fadeOutClicks.size();
+	result.m_NumFadeInClicks = fadeInClicks.size();
+
+	for (auto it = fadeOutClicks.begin(); it != fadeOutClicks.end(); ++it)
+	{
+		if (it->m_ExpectedGain >= levelMinGain)
+		{
+			result.m_FadeOutLevel.Add(
+					it->m_Level / fadeOutNominal - it->m_ExpectedGain);
+		}
+	}
+	for (auto it = fadeInClicks.begin(); it != fadeInClicks.end(); ++it)
+	{
+		if (it->m_ExpectedGain >= levelMinGain)
+		{
+			result.m_FadeInLevel.Add(
+					it->m_Level / fadeInNominal - it->m_ExpectedGain);
+		}
+	}
+
+	// Only a DJ crossfade lines up the beats.  Each beat of the fade-in track
+	// is paired with the nearest beat of the fade-out track, as long as both
+	// are loud enough to be heard.
+	if (result.m_DJCrossfade && !fadeOutClicks.empty())
+	{
+		for (auto it = fadeInClicks.begin(); it != fadeInClicks.end(); ++it)
+		{
+			auto nearest = std::lower_bound(fadeOutClicks.begin(),
+					fadeOutClicks.end(), it->m_OutputTime,
+					[] (const Click & click, double time)
+					{
+						return click.m_OutputTime < time;
+					});
+			if (nearest == fadeOutClicks.end() ||
+					(nearest != fadeOutClicks.begin() &&
+					 it->m_OutputTime - (nearest - 1)->m_OutputTime <
+					 nearest->m_OutputTime - it->m_OutputTime))
+			{
+				--nearest;
+			}
+			if (it->m_ExpectedGain >= alignmentMinGain &&
+					nearest->m_ExpectedGain >= alignmentMinGain)
+			{
+				result.m_Alignment.Add(
+						1000.0 * (it->m_OutputTime - nearest->m_OutputTime));
+			}
+		}
+	}
+}
+
+static bool IsAligned(const Scenario & scenario, const ScenarioResult & result)
+{
+	return scenario.m_MaxAlignmentMs == 0.0 || (result.m_DJCrossfade &&
+			result.m_Alignment.m_Count != 0 &&
+			result.m_Alignment.m_MaxAbs <= scenario.m_MaxAlignmentMs);
+}
+
+static void ConfigureQueue(HarnessRequestQueue & queue,
+		const Scenario & scenario)
+{
+	StretchMode mode = scenario.m_Mode;
+	queue.SetDJXfadeEnabled(mode != MODE_NORMAL);
+	queue.SetNormalXfadeEnabled(true);
+	queue.SetVarispeedEnabled(mode == MODE_VARISPEED);
+	// A negative band forces RubberBand, even where the tempos match
+	queue.SetNativeStretchBand(mode == MODE_NATIVE ? 1.0 :
+			mode == MODE_RUBBERBAND ? -1.0 :
+			RequestQueue::GetDefaultNativeStretchBand());
+	// The tone and the clicks all lie in the mid band, whose curve is the
+	// one the levels are checked against
+	queue.SetBandSplitEnabled(scenario.m_BandSplit);
+}
+
+static ScenarioResult RunScenario(const Scenario & scenario,
+		const std::string & directory)
+{
+	ScenarioResult result;
+	HarnessRequestQueue & queue = HarnessRequestQueue::Instance();
+	CaptureReceiver capture;
+	std::vector<std::string> files;
+	files.push_back(GetTrackFilename(directory, scenario.m_FromBPM, true,
+			0.0));
+	files.push_back(GetTrackFilename(directory, scenario.m_ToBPM, false,
+			scenario.m_FadeInLength));
+
+	ConfigureQueue(queue, scenario);
+	queue.Reset();
+	if (!AudioSink::Instance().StartCapture(capture))
+	{
+		std::cerr << "Could not capture the output of the sink" << std::endl;
+	}
+	else
+	{
+		// The CPU time is that of the whole process, so it includes the
+		// decoding and stretching threads
+		std::clock_t cpuStart = std::clock();
+		result.m_WallTime = TimeLoop([&]()
+		{
+			queue.PlayAll(files);
+			queue.WaitUntilIdle();
+			AudioSink::Instance().StopCapture();
+		});
+		result.m_CPUTime = (double) (std::clock() - cpuStart) / CLOCKS_PER_SEC;
+
+		result.m_Completed = true;
+		result.m_Crossfaded = queue.HasCrossfade();
+		result.m_DJCrossfade = queue.WasDJCrossfade();
+		result.m_SetupTime = queue.GetSetupTime();
+		AnalyzeCapture(scenario, queue, capture, result);
+	}
+	return result;
+}
+
+static std::string ScenarioToJson(const Scenario & scenario,
+		const ScenarioResult & result)
+{
+	std::ostringstream out;
+	out << "    {" << std::endl
+		<< "      \"name\": \"" << scenario.m_Name << "\"," << std::endl
+		<< "      \"mode\": \"" << GetModeName(scenario.m_Mode) << "\","
+		<< std::endl
+		<< "      \"bandSplit\": " << (scenario.m_BandSplit ? "true" : "false")
+		<< "," << std::endl
+		<< StrUtil::format("      \"fromBpm\": %.2f,\n"
+				"      \"toBpm\": %.2f,\n", scenario.m_FromBPM,
+				scenario.m_ToBPM)
+		<< "      \"completed\": " << (result.m_Completed ? "true" : "false")
+		<< "," << std::endl
+		<< "      \"crossfaded\": " << (result.m_Crossfaded ? "true" : "false")
+		<< "," << std::endl
+		<< "      \"djCrossfade\": "
+		<< (result.m_DJCrossfade ? "true" : "false") << "," << std::endl
+		<< StrUtil::format("      \"setupTimeMs\": %.3f,\n"
+				"      \"cpuTimeS\": %.3f,\n"
+				"      \"wallTimeS\": %.3f,\n"
+				"      \"renderedS\": %.3f,\n",
+				1000.0 * result.m_SetupTime, result.m_CPUTime,
+				result.m_WallTime, result.m_RenderedTime)
+		<< StrUtil::format("      \"fadeOutClicks\": %zu,\n"
+				"      \"fadeInClicks\": %zu,\n", result.m_NumFadeOutClicks,
+				result.m_NumFadeInClicks)
+		<< "      \"beatAlignmentMs\": " << result.m_Alignment.ToJson()
+		<< "," << std::endl
+		<< "      \"aligned\": "
+		<< (IsAligned(scenario, result) ? "true" : "false") << "," << std::endl
+		<< "      \"fadeOutGainDeviation\": " << result.m_FadeOutLevel.ToJson()
+		<< "," << std::endl
+		<< "      \"fadeInGainDeviation\": " << result.m_FadeInLevel.ToJson()
+		<< "," << std::endl
+		<< StrUtil::format("      \"seams\": { \"count\": %zu, "
+				"\"maxStep\": %.6f, \"maxRatio\": %.3f }\n",
+				result.m_NumSeams, result.m_MaxSeamStep,
+				result.m_MaxSeamRatio)
+		<< "    }";
+	return out.str();
+}
+
+// Applies a gain ramp along the whole curve, once through the virtual call of
+// the fade map and once through its table, and compares the two
+static std::string BenchmarkFadeCurve(const char * setting)
+{
+	std::unique_ptr<FadeMap> fadeMap = FadeMap::CreateFromSetting(setting);
+	const FadeMap & theMap = *fadeMap;
+	const FadeCurveTable & table = theMap.GetCurveTable();
+	std::vector<float> input = BuildBenchmarkSignal(fadeCurveFrames);
+	std::vector<float> output(fadeCurveFrames);
+	double volumeStep = 1.0 / fadeCurveFrames;
+
+	double checksum = 0.0;
+	double virtualSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k != fadeCurveFrames; ++k)
+		{
+			output[k] = input[k] * theMap.MapCrossfadeVolume(k * volumeStep);
+		}
+	}, output.data(), fadeCurveFrames, checksum);
+	double tableSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k != fadeCurveFrames; ++k)
+		{
+			output[k] = input[k] * table(k * volumeStep);
+		}
+	}, output.data(), fadeCurveFrames, checksum);
+
+	double maxError = 0.0;
+	for (size_t k = 0; k <= fadeCurveErrorPoints; ++k)
+	{
+		double volume = (double) k / fadeCurveErrorPoints;
+		maxError = std::max(maxError, std::fabs(
+				theMap.MapCrossfadeVolume(volume) - table(volume)));
+	}
+
+	return StrUtil::format("    { \"curve\": \"%s\", "
+			"\"virtualNsPerSample\": %.3f, \"tableNsPerSample\": %.3f, "
+			"\"maxTableError\": %.2e, \"checksum\": %.3g }", setting,
+			1e9 * virtualSeconds / fadeCurveFrames,
+			1e9 * tableSeconds / fadeCurveFrames, maxError, checksum);
+}
+
+// Times a low-pass FIR filter of the given size, a block at a time and a
+// sample at a time.  Throughput is given as the floating-point operations
+// that the direct form would need (one multiply and one add per tap and
+// sample), per second.
+static std::string BenchmarkFIRFilter(size_t filterSize)
+{
+	std::vector<float> input = BuildBenchmarkSignal(firFilterFrames);
+	std::vector<float> output(firFilterFrames);
+	double flops = 2.0 * filterSize * firFilterFrames;
+
+	double checksum = 0.0;
+	LowPassFIRFilter blockFilter(filterSize, firCutoff);
+	double blockSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k < firFilterFrames; k += firBlockSize)
+		{
+			blockFilter.ProcessBlock(&input[k], &output[k],
+					std::min(firBlockSize, firFilterFrames - k));
+		}
+	}, output.data(), firFilterFrames, checksum);
+	LowPassFIRFilter sampleFilter(filterSize, firCutoff);
+	double sampleSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k != firFilterFrames; ++k)
+		{
+			output[k] = sampleFilter.ProcessSample(input[k]);
+		}
+	}, output.data(), firFilterFrames, checksum);
+
+	return StrUtil::format("    { \"taps\": %u, \"engine\": \"%s\", "
+			"\"blockMflops\": %.0f, \"sampleMflops\": %.0f, "
+			"\"checksum\": %.3g }", (unsigned) filterSize,
+			blockFilter.IsUsingFFT() ? "fft" : "direct",
+			1e-6 * flops / blockSeconds, 1e-6 * flops / sampleSeconds,
+			checksum);
+}
+
+// The way the sink smoothed seams before filters took whole seams:  a
+// virtual call and a division for every sample of every channel
+static void ProcessSeamBySample(CubicInterpFilter & filter, AudioBlock & left,
+		AudioBlock & right)
+{
+	size_t numSamples = (size_t) (filter.GetTimeInterval() * sampleRate);
+	size_t leftNumSamples = numSamples >> 1;
+	size_t rightNumSamples = (numSamples + 1) >> 1;
+	size_t leftBlockSize = left.getNumSamples();
+	Filter & theFilter = filter;
+	for (size_t ch = 0; ch < (size_t) numChannels; ++ch)
+	{
+		CubicInterpFilter * cif = dynamic_cast<CubicInterpFilter*>(&theFilter);
+		if (cif != nullptr)
+		{
+			cif->Reset();
+			cif->GetLeftBlockInformation(left, ch);
+			cif->GetRightBlockInformation(right, ch);
+		}
+		size_t leftStart = leftBlockSize - leftNumSamples;
+		for (size_t k = leftStart; k < leftBlockSize; ++k)
+		{
+			float t = (k - leftStart) / ((double) numSamples);
+			left.setSampleAtPosition(ch, k, theFilter.ProcessSample(
+					left.getSampleAtPosition(ch, k), t));
+		}
+		for (size_t k = 0; k < rightNumSamples; ++k)
+		{
+			float t = (k + leftNumSamples) / ((double) numSamples);
+			right.setSampleAtPosition(ch, k, theFilter.ProcessSample(
+					right.getSampleAtPosition(ch, k), t));
+		}
+	}
+}
+
+// Times the click removal filter on seams of the given length, a seam at a
+// time and a sample at a time
+static std::string BenchmarkSeam(double timeInterval)
+{
+	std::vector<float> samples = BuildBenchmarkSignal(seamBlockSize);
+	AudioBlock left, right;
+	for (int ch = 0; ch != numChannels; ++ch)
+	{
+		left.pushChannelData(samples.data(), seamBlockSize);
+		right.pushChannelData(samples.data(), seamBlockSize);
+	}
+	CubicInterpFilter filter;
+	filter.SetTimeInterval(timeInterval);
+
+	// Both ways smooth the seam to the same curve, so the blocks end up
+	// the same after the first seam either way
+	double checksum = 0.0;
+	double sampleSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k != seamRepetitions; ++k)
+		{
+			ProcessSeamBySample(filter, left, right);
+		}
+	}, left.getChannelData(0), seamBlockSize, checksum);
+	double seamSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k != seamRepetitions; ++k)
+		{
+			filter.ProcessSeam(left, right);
+		}
+	}, left.getChannelData(0), seamBlockSize, checksum);
+
+	return StrUtil::format("    { \"timeIntervalMs\": %.2f, "
+			"\"bySampleNsPerSeam\": %.1f, \"seamNsPerSeam\": %.1f, "
+			"\"checksum\": %.3g }", 1000.0 * timeInterval,
+			1e9 * sampleSeconds / seamRepetitions,
+			1e9 * seamSeconds / seamRepetitions, checksum);
+}
+
+// The limiter runs on every block that the sink puts out, so it is timed per
+// channel, as a fraction of a core for a stream in real time
+static std::string BenchmarkLimiter(size_t numLimiterChannels)
+{
+	std::vector<float> samples(limiterFrames);
+	for (size_t k = 0; k != limiterFrames; ++k)
+	{
+		samples[k] = limiterToneAmplitude *
+				(sin(GetPhase(fadeOutClickFrequency, k)) +
+				 sin(GetPhase(fadeInClickFrequency, k)));
+	}
+	std::vector<AudioBlock> blocks((limiterFrames + limiterBlockSize - 1) /
+			limiterBlockSize);
+	for (size_t k = 0; k != blocks.size(); ++k)
+	{
+		size_t start = k * limiterBlockSize;
+		for (size_t ch = 0; ch != numLimiterChannels; ++ch)
+		{
+			blocks[k].pushChannelData(&samples[start],
+					std::min(limiterBlockSize, limiterFrames - start));
+		}
+	}
+
+	TruePeakLimiter limiter(numLimiterChannels, sampleRate);
+	double seconds = TimeLoop([&]()
+	{
+		for (auto it = blocks.begin(); it != blocks.end(); ++it)
+		{
+			limiter.Process(*it);
+		}
+	});
+
+	float outputPeak = 0.0f;
+	for (auto it = blocks.begin(); it != blocks.end(); ++it)
+	{
+		const float * data = it->getChannelData(0);
+		for (size_t k = 0; k != it->getNumSamples(); ++k)
+		{
+			outputPeak = std::max(outputPeak, std::fabs(data[k]));
+		}
+	}
+
+	return StrUtil::format("    { \"channels\": %zu, \"latencyMs\": %.3f, "
+			"\"nsPerFramePerChannel\": %.1f, "
+			"\"cpuPercentPerChannel\": %.3f, \"outputPeak\": %.4f }",
+			numLimiterChannels, 1000.0 * limiter.GetLatency() / sampleRate,
+			1e9 * seconds / (limiterFrames * numLimiterChannels),
+			100.0 * seconds * sampleRate /
+				(limiterFrames * numLimiterChannels),
+			outputPeak);
+}
+
+// The same octave bands, measured on Hann-windowed frames, one hop apart,
+// scaled to mean squares like those of the filterbank
+static void ComputeSTFTBandEnergies(const std::vector<float> & input,
+		const FilterBankProcessor & filterBank, std::vector<float> & energies)
+{
+	size_t numBands = filterBank.GetNumBands();
+	std::shared_ptr<const Window> window = WindowCache::Instance().Get(
+			WindowCache::WINDOW_HANN, stftFrameSize);
+	double windowEnergy = 0.0;
+	for (size_t n = 0; n != stftFrameSize; ++n)
+	{
+		windowEnergy += window->At(n) * window->At(n);
+	}
+	float scale = (float) (2.0 / (stftFrameSize * windowEnergy));
+	std::vector<size_t> bandStarts(numBands + 1, 0);
+	for (size_t b = 0; b + 1 != numBands; ++b)
+	{
+		bandStarts[b] = (size_t) (filterBank.GetUpperEdge(b + 1) *
+				stftFrameSize);
+	}
+	bandStarts[numBands] = stftFrameSize >> 1;
+
+	fft_plan_t plan;
+	std::vector<float> fftData(stftFrameSize);
+	std::vector<float> fftCache(plan_cache_size(stftFrameSize));
+	setup_plan(&plan, fftData.data(), fftCache.data(), stftFrameSize);
+	for (size_t start = 0; start + stftFrameSize <= input.size();
+			start += filterBankHopSize)
+	{
+		float * data = plan_samples(&plan);
+		for (size_t n = 0; n != stftFrameSize; ++n)
+		{
+			data[n] = window->At(n) * input[start + n];
+		}
+		r2hc(&plan);
+		data = plan_samples(&plan);
+
+		// Band 0 is the highest, and the last band reaches down to DC
+		for (size_t b = 0; b != numBands; ++b)
+		{
+			size_t first = b + 1 == numBands ? 1 : bandStarts[b];
+			size_t last = b == 0 ? bandStarts[numBands] : bandStarts[b - 1];
+			float sum = 0.0f;
+			for (size_t k = first; k != last; ++k)
+			{
+				sum += data[k] * data[k] +
+						data[stftFrameSize - k] * data[stftFrameSize - k];
+			}
+			energies.push_back(scale * sum);
+		}
+	}
+}
+
+// The filterbank runs on every sample of a track, so it is timed per sample,
+// against the STFT band energies that it replaces.  Both measure the same
+// steady tones, so their long-term band energies are compared as well.
+static std::string BenchmarkFilterBank(size_t numBands)
+{
+	std::vector<float> input(filterBankFrames);
+	for (size_t k = 0; k != filterBankFrames; ++k)
+	{
+		input[k] = toneAmplitude * sin(GetPhase(toneFrequency, k)) +
+				clickAmplitude * (sin(GetPhase(fadeOutClickFrequency, k)) +
+				sin(GetPhase(fadeInClickFrequency, k)));
+	}
+
+	FilterBankProcessor filterBank(numBands, filterBankHopSize);
+	std::vector<float> bankEnergies;
+	double bankSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k < filterBankFrames; k += filterBankBlockSize)
+		{
+			filterBank.Process(&input[k],
+					std::min(filterBankBlockSize, filterBankFrames - k),
+					bankEnergies);
+		}
+	});
+	std::vector<float> stftEnergies;
+	double stftSeconds = TimeLoop([&]()
+	{
+		ComputeSTFTBandEnergies(input, filterBank, stftEnergies);
+	});
+
+	// Bands that carry next to none of the signal are left out
+	size_t numBankHops = bankEnergies.size() / numBands;
+	size_t numStftHops = stftEnergies.size() / numBands;
+	std::vector<double> bankMeans(numBands, 0.0), stftMeans(numBands, 0.0);
+	for (size_t b = 0; b != numBands; ++b)
+	{
+		for (size_t h = 0; h != numBankHops; ++h)
+		{
+			bankMeans[b] += bankEnergies[h * numBands + b] / numBankHops;
+		}
+		for (size_t h = 0; h != numStftHops; ++h)
+		{
+			stftMeans[b] += stftEnergies[h * numBands + b] / numStftHops;
+		}
+	}
+	double total = std::accumulate(stftMeans.begin(), stftMeans.end(), 0.0);
+	double maxErrorDb = 0.0;
+	for (size_t b = 0; b != numBands; ++b)
+	{
+		if (stftMeans[b] > 1e-3 * total)
+		{
+			maxErrorDb = std::max(maxErrorDb,
+					std::fabs(10.0 * log10(bankMeans[b] / stftMeans[b])));
+		}
+	}
+
+	return StrUtil::format("    { \"bands\": %zu, \"hopSize\": %zu, "
+			"\"filterBankNsPerSample\": %.2f, \"stftNsPerSample\": %.2f, "
+			"\"speedup\": %.1f, \"maxBandErrorDb\": %.2f }",
+			numBands, filterBank.GetHopSize(),
+			1e9 * bankSeconds / filterBankFrames,
+			1e9 * stftSeconds / filterBankFrames,
+			bankSeconds > 0.0 ? stftSeconds / bankSeconds : 0.0, maxErrorDb);
+}
+
+static std::vector<double> BuildSwingingTempos(size_t numBeats)
+{
+	std::vector<double> rv(numBeats);
+	for (size_t k = 0; k != numBeats; ++k)
+	{
+		rv[k] = beatgridTempo + beatgridTempoSwing *
+				sin(2.0 * MathConstants::Pi * k / beatgridSwingBeats);
+	}
+	return rv;
+}
+
+// Walks the section from time to beat to percentage and back to time, once
+// through the beat time table and once summing up the beat lengths from the
+// first beat, as the crossfade calculators did before they kept the table
+static std::string BenchmarkBeatgrid(size_t numBeats)
+{
+	std::vector<double> bpms = BuildSwingingTempos(numBeats);
+	Beatgrid grid;
+	grid.SetBPMBeatgrid(bpms);
+	double duration = grid.GetTimeOffsetAtBeat(numBeats);
+	double chunkTime = (double) beatgridChunkFrames / sampleRate;
+	size_t numChunks = (size_t) ceil(duration / chunkTime);
+
+	std::vector<double> tablePercents(numChunks);
+	double tableMaxError = 0.0;
+	double tableSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k != numChunks; ++k)
+		{
+			double time = k * chunkTime;
+			size_t beat = grid.FindBeatAtTimeOffset(time);
+			double percent = (beat + (time - grid.GetTimeOffsetAtBeat(beat)) *
+					grid.at(beat) / 60.0) / numBeats;
+			double dBeat = percent * numBeats;
+			size_t backBeat = std::min((size_t) dBeat, numBeats - 1);
+			double backTime = grid.GetTimeOffsetAtBeat(backBeat) +
+					60.0 * (dBeat - backBeat) / grid.at(backBeat);
+			tablePercents[k] = percent;
+			tableMaxError = std::max(tableMaxError,
+					std::fabs(backTime - time));
+		}
+	});
+
+	double maxPercentDifference = 0.0;
+	double linearMaxError = 0.0;
+	double linearSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; k != numChunks; ++k)
+		{
+			double time = k * chunkTime;
+			size_t beat = 0;
+			double beatStart = 0.0;
+			while (beat + 1 < numBeats &&
+					beatStart + 60.0 / bpms[beat] <= time)
+			{
+				beatStart += 60.0 / bpms[beat];
+				++beat;
+			}
+			double percent = (beat + (time - beatStart) * bpms[beat] / 60.0) /
+					numBeats;
+			double dBeat = percent * numBeats;
+			size_t backBeat = std::min((size_t) dBeat, numBeats - 1);
+			double backTime = 0.0;
+			for (size_t b = 0; b != backBeat; ++b)
+			{
+				backTime += 60.0 / bpms[b];
+			}
+			backTime += 60.0 * (dBeat - backBeat) / bpms[backBeat];
+			maxPercentDifference = std::max(maxPercentDifference,
+					std::fabs(percent - tablePercents[k]));
+			linearMaxError = std::max(linearMaxError,
+					std::fabs(backTime - time));
+		}
+	});
+
+	return StrUtil::format("    { \"beats\": %zu, \"chunks\": %zu, "
+			"\"tableNsPerChunk\": %.1f, \"linearNsPerChunk\": %.1f, "
+			"\"speedup\": %.1f, \"maxPercentDifference\": %.3g, "
+			"\"tableRoundTripErrorMs\": %.3g, "
+			"\"linearRoundTripErrorMs\": %.3g }",
+			numBeats, numChunks, 1e9 * tableSeconds / numChunks,
+			1e9 * linearSeconds / numChunks,
+			tableSeconds > 0.0 ? linearSeconds / tableSeconds : 0.0,
+			maxPercentDifference, 1000.0 * tableMaxError,
+			1000.0 * linearMaxError);
+}
+
+// Writes a beatgrid file with two sections of the given length in both
+// formats, and times reading each.  Every beat has a tempo of its own, so the
+// text file has a line for every beat.  The text file keeps six decimals of
+// each tempo, so the beat times of the two differ a little.
+static std::string BenchmarkBeatgridFile(size_t numBeats,
+		const std::string & directory, bool & passed)
+{
+	std::string filename = StrUtil::format("%s/beatgrid-%zu.wav",
+			directory.c_str(), numBeats);
+	std::vector<FadeSection> sections(2);
+	for (size_t k = 0; k != sections.size(); ++k)
+	{
+		sections[k].SetTime(firstBeatTime);
+		sections[k].SetInstantaneousTempo(beatgridTempo);
+		sections[k].GetBeatgrid().SetBPMBeatgrid(
+				BuildSwingingTempos(numBeats));
+	}
+	BeatgridFileReader writer;
+	writer.SetSections(std::move(sections));
+	bool ok = writer.WriteText(BeatgridFileReader::GetTextFilename(filename)) &&
+			writer.WriteBinary(
+				BeatgridFileReader::GetBinaryFilename(filename));
+
+	BeatgridFileReader textReader;
+	double textSeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; ok && k != beatgridFileReads; ++k)
+		{
+			ok = textReader.ReadText(
+					BeatgridFileReader::GetTextFilename(filename));
+		}
+	});
+	BeatgridFileReader binaryReader;
+	double binarySeconds = TimeLoop([&]()
+	{
+		for (size_t k = 0; ok && k != beatgridFileReads; ++k)
+		{
+			ok = binaryReader.ReadBinary(
+					BeatgridFileReader::GetBinaryFilename(filename));
+		}
+	});
+
+	double maxDifference = 0.0;
+	ok = ok && textReader.GetSections().size() ==
+			binaryReader.GetSections().size();
+	for (size_t k = 0; ok && k != textReader.GetSections().size(); ++k)
+	{
+		const std::vector<double> & textTimes =
+				textReader.GetSection(k).GetBeatgrid().GetTimeBeatgrid();
+		const std::vector<double> & binaryTimes =
+				binaryReader.GetSection(k).GetBeatgrid().GetTimeBeatgrid();
+		ok = textTimes.size() == binaryTimes.size();
+		for (size_t b = 0; ok && b != textTimes.size(); ++b)
+		{
+			maxDifference = std::max(maxDifference,
+					std::fabs(textTimes[b] - binaryTimes[b]));
+		}
+	}
+
+	// A binary file converted right after its text file was written is
+	// current, however coarse the clock of the file system is
+	bool converted = ok && BeatgridFileReader::ConvertTextFile(filename) &&
+			BeatgridFileReader::IsBinaryFileCurrent(filename);
+
+	passed = ok && converted;
+	return StrUtil::format("    { \"beatsPerSection\": %zu, "
+			"\"textUsPerRead\": %.1f, \"binaryUsPerRead\": %.1f, "
+			"\"speedup\": %.1f, \"maxBeatTimeDifferenceMs\": %.3g, "
+			"\"read\": %s, \"converted\": %s }",
+			numBeats, 1e6 * textSeconds / beatgridFileReads,
+			1e6 * binarySeconds / beatgridFileReads,
+			binarySeconds > 0.0 ? textSeconds / binarySeconds : 0.0,
+			1000.0 * maxDifference, ok ? "true" : "false",
+			converted ? "true" : "false");
+}
+
+static const char * GetEngineName(AudioStretcher::EngineType engine)
+{
+	const char * rv;
+	switch (engine)
+	{
+	case AudioStretcher::ENGINE_NATIVE:
+		rv = "native";
+		break;
+	case AudioStretcher::ENGINE_VARISPEED:
+		rv = "varispeed";
+		break;
+	default:
+		rv = "rubberband";
+		break;
+	}
+	return rv;
+}
+
+// Fits a sinusoid of the given frequency to a Hann-windowed stretch of
+// samples by least squares, and adds up the windowed energy of the fit and
+// of what is left over
+static void FitTone(const float * samples, const std::vector<float> & window,
+		double frequency, double & signal, double & residual)
+{
+	double cc = 0.0, ss = 0.0, cs = 0.0, xc = 0.0, xs = 0.0;
+	for (size_t k = 0; k != window.size(); ++k)
+	{
+		double c = cos(GetPhase(frequency, k));
+		double s = sin(GetPhase(frequency, k));
+		cc += window[k] * c * c;
+		ss += window[k] * s * s;
+		cs += window[k] * c * s;
+		xc += window[k] * samples[k] * c;
+		xs += window[k] * samples[k] * s;
+	}
+	double det = cc * ss - cs * cs;
+	double a = (xc * ss - xs * cs) / det;
+	double b = (xs * cc - xc * cs) / det;
+	for (size_t k = 0; k != window.size(); ++k)
+	{
+		double fit = a * cos(GetPhase(frequency, k)) +
+				b * sin(GetPhase(frequency, k));
+		signal += window[k] * fit * fit;
+		residual += window[k] * (samples[k] - fit) * (samples[k] - fit);
+	}
+}
+
+// Stretches a click track through the given engine, over a ratio that ramps
+// from unity to the given one and then holds, and measures how far the
+// clicks come out from where the ratio curve puts them, how cleanly the tone
+// between them comes through where the ratio holds (as the energy of the
+// best fitting sinusoid over that of the rest), and the time it takes, as a
+// fraction of a core for a stream in real time.  Varispeed shifts the pitch
+// along with the tempo, so its tone is fitted at the shifted frequency.
+static std::string BenchmarkStretchEngine(AudioStretcher::EngineType engine,
+		double ratio, bool & passed)
+{
+	size_t numFrames = (size_t) (stretchDuration * sampleRate);
+	std::vector<float> samples(numFrames);
+	for (size_t k = 0; k != numFrames; ++k)
+	{
+		samples[k] = toneAmplitude * sin(GetPhase(toneFrequency, k));
+	}
+	std::vector<double> clickTimes;
+	for (double time = firstBeatTime; time < stretchDuration - trackTail;
+			time += stretchBeatInterval)
+	{
+		AddClick(samples, time, fadeOutClickFrequency, clickAmplitude);
+		clickTimes.push_back(time);
+	}
+
+	RatioCurve curve;
+	curve.AddPoint(0.0, 1.0);
+	curve.AddPoint(stretchRampDuration * sampleRate, ratio);
+	AudioStretcher stretcher;
+	stretcher.SelectEngine(engine);
+	stretcher.SetRatioCurve(curve);
+
+	// The producer waits while too many chunks are outstanding, so it runs
+	// on a thread of its own, as it does in the crossfader
+	std::thread producer([&]()
+	{
+		std::vector<float> frame(numChannels);
+		for (size_t pos = 0; pos < numFrames; pos += stretchChunkFrames)
+		{
+			size_t end = std::min(numFrames, pos + stretchChunkFrames);
+			AudioStretchInfo & info = stretcher.BeginAudioStretchInfo();
+			info.Clear();
+			for (size_t k = pos; k != end; ++k)
+			{
+				std::fill(frame.begin(), frame.end(), samples[k]);
+				info.AppendSample(frame.data());
+			}
+			info.SetTimeRatio(curve.GetRatioAt(pos));
+			info.SetLastOne(end == numFrames);
+			stretcher.SubmitAudioStretchInfo();
+		}
+	});
+
+	std::vector<float> output;
+	double seconds = TimeLoop([&]()
+	{
+		bool eos = false;
+		while (!eos)
+		{
+			size_t numReceived, refPos, compRefPos;
+			const std::vector<float> & stretched =
+					stretcher.getStretchedAudio(
+						stretchChunkFrames * numChannels, numReceived,
+						refPos, compRefPos, eos);
+			for (size_t k = 0; k != numReceived; ++k)
+			{
+				output.push_back(stretched[k * numChannels]);
+			}
+		}
+	});
+	producer.join();
+
+	std::vector<Click> clicks = DetectClicks(
+			ComputeEnvelope(output, fadeOutClickFrequency),
+			detectorFloor * GetNominalClickLevel(fadeOutClickFrequency));
+	// Each click is matched with the detected click nearest to where it
+	// should come out, if that is within half a beat
+	size_t numFound = 0;
+	double maxAlignment = 0.0;
+	auto detected = clicks.begin();
+	for (auto it = clickTimes.begin(); it != clickTimes.end(); ++it)
+	{
+		double expected = curve.GetOutputPosAt(*it * sampleRate) / sampleRate;
+		while (detected + 1 != clicks.end() &&
+				std::fabs((detected + 1)->m_OutputTime - expected) <
+				std::fabs(detected->m_OutputTime - expected))
+		{
+			++detected;
+		}
+		double alignment = detected != clicks.end() ?
+				std::fabs(detected->m_OutputTime - expected) : HUGE_VAL;
+		if (alignment < 0.5 * stretchBeatInterval)
+		{
+			++numFound;
+			maxAlignment = std::max(maxAlignment, alignment);
+		}
+	}
+
+	std::vector<float> window;
+	WindowCache::Instance().Get(WindowCache::WINDOW_HANN, stretchToneWindow)
+			->AssignWindow(window);
+	double frequency = engine == AudioStretcher::ENGINE_VARISPEED ?
+			toneFrequency / ratio : toneFrequency;
+	double signal = 0.0, residual = 0.0;
+	for (size_t k = 0; k + 1 < clickTimes.size(); ++k)
+	{
+		size_t middle = (size_t) (curve.GetOutputPosAt(0.5 * sampleRate *
+				(clickTimes[k] + clickTimes[k + 1])));
+		if (clickTimes[k] >= stretchRampDuration &&
+				middle + stretchToneWindow / 2 <= output.size())
+		{
+			FitTone(&output[middle - stretchToneWindow / 2], window,
+					frequency, signal, residual);
+		}
+	}
+
+	passed = numFound == clickTimes.size() &&
+			1000.0 * maxAlignment <= stretchMaxAlignmentMs;
+	return StrUtil::format("    { \"engine\": \"%s\", \"ratio\": %.3f, "
+			"\"clicks\": %zu, \"clicksFound\": %zu, "
+			"\"maxAlignmentMs\": %.3f, \"toneSnrDb\": %.1f, "
+			"\"cpuPercent\": %.3f, \"passed\": %s }",
+			GetEngineName(engine), ratio, clickTimes.size(), numFound,
+			1000.0 * maxAlignment,
+			10.0 * log10(signal / std::max(residual, 1e-30)),
+			100.0 * seconds * sampleRate / std::max(output.size(),
+				(size_t) 1), passed ? "true" : "false");
+}
+
+// The tone passes if its own pitch class gets the largest share of the
+// chroma
+static std::string CheckChromaTone(int pitch, double cents, bool & passed)
+{
+	double frequency = 440.0 * pow(2.0, (pitch - 69 + cents / 100.0) / 12.0);
+	int analysisRate = KeyAnalyzer::getAnalysisSampleRate();
+	std::vector<float> samples((size_t) (chromaToneDuration * analysisRate));
+	for (size_t k = 0; k != samples.size(); ++k)
+	{
+		samples[k] = toneAmplitude * sin(2.0 * MathConstants::Pi *
+				fmod(frequency * k / analysisRate, 1.0));
+	}
+
+	KeyAnalyzer analyzer;
+	analyzer.SubmitSamples(samples.data(), samples.size());
+	analyzer.Finish();
+	const std::vector<double> & chroma = analyzer.getChroma();
+	int expected = pitch % 12;
+	int found = (int) (std::max_element(chroma.begin(), chroma.end()) -
+			chroma.begin());
+	passed = found == expected;
+	return StrUtil::format("    { \"pitch\": %d, \"cents\": %.0f, "
+			"\"pitchClass\": %d, \"expected\": %d, \"share\": %.3f, "
+			"\"passed\": %s }", pitch, cents, found, expected,
+			chroma[expected], passed ? "true" : "false");
+}
+
+static void PrintUsage(const char * program)
+{
+	std::cerr << "Usage: " << program << " [-d directory] [-o report]"
+			<< std::endl
+			<< "  -d directory  where the click tracks are written "
+			   "(default: .)" << std::endl
+			<< "  -o report     where the JSON report is written "
+			   "(default: standard output)" << std::endl;
+}
+
+int main(int argc, char ** argv)
+{
+	int rv = EXIT_FAILURE;
+	std::string directory = ".";
+	std::string reportFilename;
+	bool validArgs = true;
+
+	for (int k = 1; validArgs && k < argc; ++k)
+	{
+		if (strcmp(argv[k], "-d") == 0 && k + 1 < argc)
+		{
+			directory = argv[++k];
+		}
+		else if (strcmp(argv[k], "-o") == 0 && k + 1 < argc)
+		{
+			reportFilename = argv[++k];
+		}
+		else
+		{
+			validArgs = false;
+		}
+	}
+
+	const size_t numScenarios = sizeof(scenarios) / sizeof(*scenarios);
+	bool ok = validArgs;
+	for (size_t k = 0; ok && k != numScenarios; ++k)
+	{
+		ok = WriteTrack(GetTrackFilename(directory, scenarios[k].m_FromBPM,
+				true, 0.0), scenarios[k].m_FromBPM, fadeOutClickFrequency,
+				0.0) &&
+			WriteTrack(GetTrackFilename(directory, scenarios[k].m_ToBPM,
+				false, scenarios[k].m_FadeInLength), scenarios[k].m_ToBPM,
+				fadeInClickFrequency, scenarios[k].m_FadeInLength);
+		if (!ok)
+		{
+			std::cerr << "Could not write the click tracks to " << directory
+					<< std::endl;
+		}
+	}
+
+	if (!validArgs)
+	{
+		PrintUsage(argv[0]);
+	}
+	else if (ok)
+	{
+		std::unique_ptr<CubicInterpFilter> filter(new CubicInterpFilter);
+		filter->SetTimeInterval(0.0005);
+		AudioSink::Instance().takeClickRemovalFilter(std::move(filter));
+		std::unique_ptr<TruePeakLimiter> limiter(
+				new TruePeakLimiter(numChannels, sampleRate));
+		AudioSink::Instance().takeLimiter(std::move(limiter));
+
+		HarnessRequestQueue & queue = HarnessRequestQueue::Instance();
+		std::unique_ptr<KneeFadeMap> fadeMap(new KneeFadeMap);
+		queue.TakeFadeMap(std::move(fadeMap));
+		AudioFile::InitializeAvformat();
+		queue.StartRequestProcessor();
+
+		// Every scenario is run even if an earlier one fails, so that the
+		// report is complete
+		std::ostringstream report;
+		std::clock_t cpuStart = std::clock();
+		report << "{" << std::endl << "  \"scenarios\": [" << std::endl;
+		for (size_t k = 0; k != numScenarios; ++k)
+		{
+			ScenarioResult result = RunScenario(scenarios[k], directory);
+			bool passed = result.m_Completed && result.m_Crossfaded &&
+					IsAligned(scenarios[k], result);
+			ok = ok && passed;
+			report << ScenarioToJson(scenarios[k], result)
+					<< (k + 1 != numScenarios ? "," : "") << std::endl;
+			std::cerr << scenarios[k].m_Name << ": "
+					<< (passed ? "done" : "FAILED") << std::endl;
+		}
+		report << "  ]," << std::endl
+				<< StrUtil::format("  \"totalCpuTimeS\": %.3f,",
+				   (double) (std::clock() - cpuStart) / CLOCKS_PER_SEC)
+				<< std::endl;
+		queue.StopRequestProcessor();
+
+		const size_t numCurves =
+				sizeof(fadeCurveSettings) / sizeof(*fadeCurveSettings);
+		report << "  \"fadeCurves\": [" << std::endl;
+		for (size_t k = 0; k != numCurves; ++k)
+		{
+			report << BenchmarkFadeCurve(fadeCurveSettings[k])
+					<< (k + 1 != numCurves ? "," : "") << std::endl;
+		}
+		report << "  ]," << std::endl;
+
+		const size_t numFilters =
+				sizeof(firFilterSizes) / sizeof(*firFilterSizes);
+		report << "  \"firFilters\": [" << std::endl;
+		for (size_t k = 0; k != numFilters; ++k)
+		{
+			report << BenchmarkFIRFilter(firFilterSizes[k])
+					<< (k + 1 != numFilters ? "," : "") << std::endl;
+		}
+		report << "  ]," << std::endl;
+
+		const size_t numSeams =
+				sizeof(seamTimeIntervals) / sizeof(*seamTimeIntervals);
+		report << "  \"seams\": [" << std::endl;
+		for (size_t k = 0; k != numSeams; ++k)
+		{
+			report << BenchmarkSeam(seamTimeIntervals[k])
+					<< (k + 1 != numSeams ? "," : "") << std::endl;
+		}
+		report << "  ]," << std::endl;
+
+		const size_t numLimiters =
+				sizeof(limiterChannelCounts) / sizeof(*limiterChannelCounts);
+		report << "  \"limiter\": [" << std::endl;
+		for (size_t k = 0; k != numLimiters; ++k)
+		{
+			report << BenchmarkLimiter(limiterChannelCounts[k])
+					<< (k + 1 != numLimiters ? "," : "") << std::endl;
+		}
+		report << "  ]," << std::endl;
+
+		const size_t numFilterBanks =
+				sizeof(filterBankBandCounts) / sizeof(*filterBankBandCounts);
+		report << "  \"filterBanks\": [" << std::endl;
+		for (size_t k = 0; k != numFilterBanks; ++k)
+		{
+			report << BenchmarkFilterBank(filterBankBandCounts[k])
+					<< (k + 1 != numFilterBanks ? "," : "") << std::endl;
+		}
+		report << "  ]," << std::endl;
+
+		const size_t numSections =
+				sizeof(beatgridSectionBeats) / sizeof(*beatgridSectionBeats);
+		report << "  \"beatgrids\": [" << std::endl;
+		for (size_t k = 0; k != numSections; ++k)
+		{
+			report << BenchmarkBeatgrid(beatgridSectionBeats[k])
+					<< (k + 1 != numSections ? "," : "") << std::endl;
+		}
+		report << "  ]," << std::endl;
+
+		report << "  \"beatgridFiles\": [" << std::endl;
+		for (size_t k = 0; k != numSections; ++k)
+		{
+			bool passed = false;
+			report << BenchmarkBeatgridFile(beatgridSectionBeats[k],
+					directory, passed)
+					<< (k + 1 != numSections ? "," : "") << std::endl;
+			ok = ok && passed;
+		}
+		report << "  ]," << std::endl;
+
+		const size_t numEngines =
+				sizeof(stretchEngines) / sizeof(*stretchEngines);
+		const size_t numRatios =
+				sizeof(stretchRatios) / sizeof(*stretchRatios);
+		report << "  \"stretchEngines\": [" << std::endl;
+		for (size_t k = 0; k != numEngines * numRatios; ++k)
+		{
+			bool passed = false;
+			report << BenchmarkStretchEngine(stretchEngines[k / numRatios],
+					stretchRatios[k % numRatios], passed)
+					<< (k + 1 != numEngines * numRatios ? "," : "")
+					<< std::endl;
+			ok = ok && passed;
+		}
+		report << "  ]," << std::endl;
+
+		const size_t numPitches =
+				sizeof(chromaTonePitches) / sizeof(*chromaTonePitches);
+		const size_t numCents =
+				sizeof(chromaToneCents) / sizeof(*chromaToneCents);
+		report << "  \"chromaTones\": [" << std::endl;
+		for (size_t k = 0; k != numPitches * numCents; ++k)
+		{
+			bool passed = false;
+			report << CheckChromaTone(chromaTonePitches[k / numCents],
+					chromaToneCents[k % numCents], passed)
+					<< (k + 1 != numPitches * numCents ? "," : "")
+					<< std::endl;
+			ok = ok && passed;
+		}
+		report << "  ]" << std::endl << "}" << std::endl;
+
+		if (reportFilename.empty())
+		{
+			std::cout << report.str();
+		}
+		else
+		{
+			std::ofstream out(reportFilename.c_str());
+			out << report.str();
+			ok = ok && out.good();
+		}
+
+		if (ok)
+		{
+			rv = EXIT_SUCCESS;
+		}
+	}
+
+	return rv;
+}
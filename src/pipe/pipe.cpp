@@ -10,6 +10,7 @@
 #include "../backend/core/xfade/DJCrossfadeCalculator.h"
 #include "../backend/core/xfade/fademaps/KneeFadeMap.h"
 #include "../backend/core/filters/CubicInterpFilter.h"
+#include "../backend/core/filters/TruePeakLimiter.h"
 #include "../backend/util/StrUtil.h"
 
 class MyRequestQueue : public RequestQueue
@@ -79,12 +80,24 @@ int main(void)
                 filter->SetTimeInterval(0.0005);
                 AudioSink::Instance().takeClickRemovalFilter(std::move(filter));
 
-                std::unique_ptr<KneeFadeMap> fadeMap(new KneeFadeMap);
+                std::unique_ptr<TruePeakLimiter> limiter(new TruePeakLimiter(
+                                AudioSink::Instance().getNumChannels(),
+                                AudioSink::Instance().getSampleRate()));
+                AudioSink::Instance().takeLimiter(std::move(limiter));
+
+                std::unique_ptr<FadeMap> fadeMap = FadeMap::CreateFromSetting(
+                                RequestQueue::GetFadeCurveSetting());
+                if (fadeMap == nullptr)
+                {
+                        // The setting is not understood
+                        fadeMap.reset(new KneeFadeMap);
+                }
                 reqQueue.TakeFadeMap(std::move(fadeMap));
 
                 AudioFile::InitializeAvformat();
                 reqQueue.StartRequestProcessor();
                 reqQueue.SetDJXfadeEnabled(true);
+                reqQueue.SetLoudnessNormalizationEnabled(true);
 	}
 
 	for (;;)